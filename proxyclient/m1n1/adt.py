@@ -1,5 +1,5 @@
 # SPDX-License-Identifier: MIT
-import itertools, fnmatch, sys
+import itertools, fnmatch, hashlib, os, os.path, pickle, sys
 from construct import *
 import sys
 
@@ -7,6 +7,46 @@ from .utils import AddrLookup, FourCC, SafeGreedyRange
 
 __all__ = ["load_adt"]
 
+# On-disk cache for ADT blobs and parsed trees, keyed by content. Blobs are
+# stored under the device-computed xxhash64 (see ProxyUtils.get_adt), parsed
+# trees under a local hash of the blob, so a shell session on an unchanged
+# device skips both the multi-MB transfer and the construct parse. Bump the
+# version when the parsed representation changes incompatibly.
+ADT_CACHE_VERSION = 1
+
+def _cache_path(name):
+    base = os.environ.get("M1N1_CACHE_DIR")
+    if not base:
+        base = os.path.join(os.path.expanduser("~"), ".cache", "m1n1")
+    return os.path.join(base, name)
+
+def _cache_read(name):
+    try:
+        with open(_cache_path(name), "rb") as fd:
+            return fd.read()
+    except OSError:
+        return None
+
+def _cache_write(name, data):
+    path = _cache_path(name)
+    try:
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        tmp = f"{path}.{os.getpid()}"
+        with open(tmp, "wb") as fd:
+            fd.write(data)
+        os.replace(tmp, path)
+    except OSError:
+        pass
+
+def adt_cache_load(hash, size):
+    data = _cache_read(f"adt-{hash:016x}.bin")
+    if data is not None and len(data) != size:
+        return None
+    return data
+
+def adt_cache_store(hash, data):
+    _cache_write(f"adt-{hash:016x}.bin", data)
+
 ADTPropertyStruct = Struct(
     "name" / PaddedString(32, "ascii"),
     "size" / Int32ul,
@@ -792,8 +832,26 @@ class ADTNode:
         self[name] = node
         return node
 
-def load_adt(data):
-    return ADTNode(ADTNodeStruct.parse(data))
+def load_adt(data, cache=True):
+    if not cache:
+        return ADTNode(ADTNodeStruct.parse(data))
+
+    key = hashlib.sha256(data).hexdigest()[:32]
+    name = f"adt-v{ADT_CACHE_VERSION}-{key}.pickle"
+    cached = _cache_read(name)
+    if cached is not None:
+        try:
+            return pickle.loads(cached)
+        except Exception:
+            pass
+
+    node = ADTNode(ADTNodeStruct.parse(data))
+    try:
+        _cache_write(name, pickle.dumps(node, pickle.HIGHEST_PROTOCOL))
+    except Exception:
+        # Not everything construct hands us is picklable; just reparse next time
+        pass
+    return node
 
 if __name__ == "__main__":
     import sys, argparse, pathlib
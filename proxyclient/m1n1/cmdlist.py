@@ -0,0 +1,93 @@
+# SPDX-License-Identifier: MIT
+"""Builder for device-side command lists (src/cmdlist.c).
+
+Multi-step hardware pokes scripted from the shell pay a USB round trip per
+register access; a CmdList batches the whole sequence (calls, register
+writes, masked updates, polls, delays) into one buffer that the device
+interprets at local speed. Results come back in submission order.
+
+    cl = CmdList()
+    cl.mask32(gpio_base + 0x00, 0x3, 0x1)
+    cl.poll32(phy_base + 0x08, 0x1, 0x1, timeout_us=10000)
+    idx = cl.read32(phy_base + 0x0c)
+    results = cl.run(u)
+    print(hex(results[idx]))
+"""
+
+import struct
+
+__all__ = ["CmdList", "CmdListError"]
+
+class CmdListError(Exception):
+    def __init__(self, msg, index, results):
+        super().__init__(msg)
+        self.index = index
+        self.results = results
+
+class CmdList:
+    END = 0
+    CALL = 1
+    WRITE32 = 2
+    WRITE64 = 3
+    READ32 = 4
+    READ64 = 5
+    MASK32 = 6
+    MASK64 = 7
+    POLL32 = 8
+    UDELAY = 9
+
+    _FMT = "<II5QQ"
+    CMD_SIZE = struct.calcsize(_FMT)
+    MAX_CMDS = 1024
+
+    def __init__(self):
+        self.cmds = []
+
+    def _op(self, op, *args):
+        assert len(self.cmds) < self.MAX_CMDS
+        args = list(args) + [0] * (5 - len(args))
+        self.cmds.append((op, args))
+        return len(self.cmds) - 1
+
+    def call(self, func, *args):
+        assert len(args) <= 4
+        return self._op(self.CALL, func, *args)
+    def write32(self, addr, val):
+        return self._op(self.WRITE32, addr, val)
+    def write64(self, addr, val):
+        return self._op(self.WRITE64, addr, val)
+    def read32(self, addr):
+        return self._op(self.READ32, addr)
+    def read64(self, addr):
+        return self._op(self.READ64, addr)
+    def mask32(self, addr, clear, set):
+        return self._op(self.MASK32, addr, clear, set)
+    def mask64(self, addr, clear, set):
+        return self._op(self.MASK64, addr, clear, set)
+    def poll32(self, addr, mask, target, timeout_us=100000):
+        return self._op(self.POLL32, addr, mask, target, timeout_us)
+    def udelay(self, usec):
+        return self._op(self.UDELAY, usec)
+
+    def build(self):
+        return b"".join(struct.pack(self._FMT, op, 0, *args, 0)
+                        for op, args in self.cmds)
+
+    def run(self, u):
+        """Upload and run the list; returns the per-command results.
+        Raises CmdListError if a command fails (its index and the partial
+        results are attached to the exception)."""
+        data = self.build()
+        if not data:
+            return []
+
+        with u.heap.guarded_malloc(len(data)) as addr:
+            u.iface.writemem(addr, data)
+            ran = u.proxy.cmdlist_run(addr, len(self.cmds))
+            buf = u.iface.readmem(addr, len(data))
+
+        results = [struct.unpack_from(self._FMT, buf, i * self.CMD_SIZE)[7]
+                   for i in range(len(self.cmds))]
+        if ran < len(self.cmds):
+            raise CmdListError(f"command {ran} failed", ran, results)
+        return results
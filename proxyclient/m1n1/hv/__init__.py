@@ -12,6 +12,7 @@ from ..adt import load_adt
 from .. import xnutools, shell
 
 from .gdbserver import *
+from .snapshot import *
 from .types import *
 from .virtutils import *
 from .virtio import *
@@ -21,6 +22,8 @@ __all__ = ["HV"]
 class HV(Reloadable):
     PAC_MASK = 0xfffff00000000000
 
+    HVCALL_PVTIME = 0x54494d45 # 'TIME': returns the pvtime page address in x0
+
     PTE_VALID               = 1 << 0
 
     PTE_MEMATTR_UNCHANGED   = 0b1111 << 2
@@ -32,6 +35,7 @@ class HV(Reloadable):
     SPTE_TRACE_READ         = 1 << 63
     SPTE_TRACE_WRITE        = 1 << 62
     SPTE_TRACE_UNBUF        = 1 << 61
+    SPTE_WC                 = 1 << 60
     SPTE_MAP                = 0 << 50
     SPTE_HOOK               = 1 << 50
     SPTE_PROXY_HOOK_R       = 2 << 50
@@ -111,6 +115,7 @@ class HV(Reloadable):
         self.started = False
         self.ctx = None
         self.hvcall_handlers = {}
+        self.pvtime_base = None
         self.switching_context = False
         self.show_timestamps = False
         self.virtio_devs = {}
@@ -180,10 +185,14 @@ class HV(Reloadable):
         #print(f"map_sw {ipa:#x} -> {pa:#x} [{size:#x}]")
         assert self.p.hv_map(ipa, pa | self.SPTE_MAP, size, 1) >= 0
 
-    def map_hook(self, ipa, size, read=None, write=None, **kwargs):
+    def map_hook(self, ipa, size, read=None, write=None, wc=False, **kwargs):
+        # wc: write-combining; adjacent writes coalesce device-side into one
+        # host event (write-only hooks, delays delivery until the run breaks)
+        assert not (wc and read is not None)
         index = len(self.vm_hooks)
         self.vm_hooks.append((read, write, ipa, kwargs))
-        self.map_hook_idx(ipa, size, index, read is not None, write is not None)
+        self.map_hook_idx(ipa, size, index, read is not None, write is not None,
+                          flags=self.SPTE_WC if wc else 0)
 
     def map_hook_idx(self, ipa, size, index, read=False, write=False, flags=0):
         if read:
@@ -217,6 +226,30 @@ class HV(Reloadable):
 
             return buffer.getvalue()
 
+    def readmem_gather(self, extents):
+        '''read a list of (va, size) extents from virtual memory in one
+        proxy round trip; translation happens on-device. Returns the list
+        of per-extent byte strings, or None if any page failed to
+        translate (the gather stops short at the first fault).'''
+        total = sum(size for va, size in extents)
+        lbuf = self.u.malloc(len(extents) * 16 + total)
+        dbuf = lbuf + len(extents) * 16
+        try:
+            self.iface.writemem(lbuf, b"".join(
+                struct.pack("<QQ", va, size) for va, size in extents))
+            if self.p.hv_gather(lbuf, len(extents), dbuf, total) < total:
+                return None
+            data = self.iface.readmem(dbuf, total)
+        finally:
+            self.u.free(lbuf)
+
+        out = []
+        pos = 0
+        for va, size in extents:
+            out.append(data[pos:pos + size])
+            pos += size
+        return out
+
     def writemem(self, va, data):
         '''write to virtual memory'''
         written = 0
@@ -434,6 +467,19 @@ class HV(Reloadable):
         self._gdbserver.shutdown()
         self._gdbserver = None
 
+    def snapshot(self, path, parent=None):
+        '''Save guest RAM and vCPU state to path while stopped at an
+        exception. Pass parent= (a previous snapshot) to save only pages
+        dirtied since then via stage-2 dirty tracking. Device-side state
+        (in-flight IRQs, timers mid-countdown, DMA) is not captured, so
+        snapshot at quiesced points. Single-vCPU guests only.'''
+        save_snapshot(self, path, parent)
+
+    def restore_snapshot(self, path):
+        '''Restore guest RAM and vCPU state saved by snapshot(). Follows
+        the parent chain of incremental snapshots automatically.'''
+        load_snapshot(self, path)
+
     def handle_mmiotrace(self, data):
         evt = EvtMMIOTrace.parse(data)
 
@@ -578,6 +624,34 @@ class HV(Reloadable):
     def handle_vm_hook(self, ctx):
         data = self.iface.readstruct(ctx.data, VMProxyHookData)
 
+        if data.flags.WC:
+            # Device-coalesced run of adjacent writes: one host round trip
+            # was paid for the whole run; split it back into aligned
+            # power-of-two accesses and deliver them locally, in order.
+            blob = b"".join(struct.pack("<Q", d) for d in data.data)
+            blob = blob[:data.flags.WC_NLEN + 1]
+            off = 0
+            while off < len(blob):
+                addr = data.addr + off
+                width = 3
+                while width and (addr & ((1 << width) - 1) or len(blob) - off < 1 << width):
+                    width -= 1
+                chunk = Container(
+                    flags = data.flags.copy(),
+                    id = data.id,
+                    addr = addr,
+                    data = [int.from_bytes(blob[off:off + (1 << width)], "little")] + [0] * 7,
+                )
+                chunk.flags.WC = 0
+                chunk.flags.WC_NLEN = 0
+                chunk.flags.WIDTH = width
+                self.handle_vm_hook_data(ctx, chunk)
+                off += 1 << width
+            return True
+
+        return self.handle_vm_hook_data(ctx, data)
+
+    def handle_vm_hook_data(self, ctx, data):
         if data.id == 0:
             return self.handle_vm_hook_mapped(ctx, data)
 
@@ -846,6 +920,23 @@ class HV(Reloadable):
     def add_hvcall(self, callid, handler):
         self.hvcall_handlers[callid] = handler
 
+    def setup_pvtime(self):
+        # Publish the paravirtual time page (struct hv_pvtime) and map it into
+        # the guest 1:1. Guests discover it with HV call HVCALL_PVTIME and then
+        # read the time offset seqlock-style, so host-side time adjustments no
+        # longer need to interrupt vCPUs to resync.
+        if self.pvtime_base is None:
+            self.pvtime_base = self.u.memalign(0x4000, 0x4000)
+            self.p.memset32(self.pvtime_base, 0, 0x4000)
+            self.p.hv_pvtime(self.pvtime_base)
+            self.map_hw(self.pvtime_base, self.pvtime_base, 0x4000)
+            self.log(f"PV time page at {self.pvtime_base:#x}")
+        return self.pvtime_base
+
+    def hvcall_pvtime(self, ctx):
+        ctx.regs[0] = self.setup_pvtime()
+        return True
+
     def handle_brk(self, ctx):
         iss = ctx.esr.ISS
         if iss != 0x4242:
@@ -1069,7 +1160,17 @@ class HV(Reloadable):
         self.virtio_ctx = info = self.iface.readstruct(ctx.data, VirtioExcInfo)
 
         try:
-            handled = self.virtio_devs[info.devbase].handle_exc(info)
+            # info.idx/info.count describe a batch of avail ring slots; walk the
+            # ring ourselves and hand each descriptor chain to the device.
+            ring = struct.unpack(f"<{info.size}H",
+                                 self.iface.readmem(info.availbase + 4, 2 * info.size))
+            first = info.idx
+            handled = True
+            for i in range(info.count):
+                info.idx = ring[(first + i) % info.size]
+                handled = self.virtio_devs[info.devbase].handle_exc(info)
+                if not handled:
+                    break
         except:
             self.log(f"Python exception from within virtio handler")
             traceback.print_exc()
@@ -1137,6 +1238,22 @@ class HV(Reloadable):
         self._switch_context()
         self.p.hv_pin_cpu(0xffffffffffffffff)
 
+    def step_batch(self, count, stop=None):
+        # Run up to count single steps entirely at EL2, recording each PC;
+        # only the final step (or the one that reaches stop) bounces through
+        # the host, so scripted instruction tracing runs at device speed
+        # instead of one proxy round trip per instruction.
+        # Returns the list of PCs executed.
+        buf = self.u.malloc((count + 1) * 8)
+        try:
+            self.p.hv_step_batch(count, buf, stop or 0)
+            self.step()
+            taken = self.p.read64(buf)
+            data = self.iface.readmem(buf + 8, taken * 8)
+            return list(struct.unpack(f"<{taken}Q", data))
+        finally:
+            self.u.free(buf)
+
     def _switch_context(self, exit=EXC_RET.HANDLED):
         # Flush current CPU context out to HV
         self._commit_context()
@@ -1387,6 +1504,9 @@ class HV(Reloadable):
         self.iface.set_event_handler(EVENT.MMIOTRACE, self.handle_mmiotrace)
         self.iface.set_event_handler(EVENT.IRQTRACE, self.handle_irqtrace)
 
+        # The pvtime page is allocated lazily, on the first guest request
+        self.add_hvcall(self.HVCALL_PVTIME, self.hvcall_pvtime)
+
         # Map MMIO ranges as HW by default
         for r in self.adt["/arm-io"].ranges:
             print(f"Mapping MMIO range: {r.parent_addr:#x} .. {r.parent_addr + r.size:#x}")
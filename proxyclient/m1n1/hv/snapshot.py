@@ -0,0 +1,179 @@
+# SPDX-License-Identifier: MIT
+import json, os, struct
+
+from ..utils import lz4_decompress
+from ..sysreg import sysreg_fwd
+
+__all__ = ["save_snapshot", "load_snapshot"]
+
+SNAP_MAGIC = b"M1N1SNAP"
+SNAP_VERSION = 1
+PAGE_SIZE = 0x4000
+RAMDUMP_MAGIC = 0x34504d44
+
+# Device buffer for dump_compressed requests
+CHUNK_SIZE = 0x10000000
+# Dirty runs below this are fetched raw instead of spinning up the compressor
+COMP_THRESHOLD = 0x400000
+
+# Guest EL1/EL0 system registers captured alongside the exception context.
+# Accessed through their *_EL12/*_EL02 aliases since the HV runs VHE.
+GUEST_SYSREGS = [
+    "SCTLR_EL12", "TTBR0_EL12", "TTBR1_EL12", "TCR_EL12",
+    "MAIR_EL12", "AMAIR_EL12", "VBAR_EL12", "CPACR_EL12",
+    "ESR_EL12", "FAR_EL12", "ELR_EL12", "SPSR_EL12",
+    "AFSR0_EL12", "AFSR1_EL12", "CONTEXTIDR_EL12", "CNTKCTL_EL12",
+    "CNTV_CTL_EL02", "CNTV_CVAL_EL02", "CNTP_CTL_EL02", "CNTP_CVAL_EL02",
+    "SP_EL1", "TPIDR_EL1", "TPIDR_EL0", "TPIDRRO_EL0",
+    "CSSELR_EL1", "PAR_EL1", "MDSCR_EL1",
+]
+
+def _write_record(fd, pa, raw_len, comp_len, data):
+    fd.write(struct.pack("<3Q", pa, raw_len, comp_len))
+    fd.write(data)
+
+def _dump_range(hv, fd, base, size):
+    '''Dump [base, base+size) as records via the on-device LZ4 compressor.'''
+    dst_max = CHUNK_SIZE + CHUNK_SIZE // 128 + 0x10000
+
+    with hv.u.heap.guarded_malloc(dst_max) as dst:
+        pos = base
+        end = base + size
+        while pos < end:
+            chunk = min(CHUNK_SIZE, end - pos)
+
+            if chunk < COMP_THRESHOLD:
+                _write_record(fd, pos, chunk, 0, hv.iface.readmem(pos, chunk))
+                pos += chunk
+                continue
+
+            ret = hv.p.dump_compressed(pos, chunk, dst, dst_max)
+            assert ret > 0
+
+            magic, nslices = struct.unpack("<II", hv.iface.readmem(dst, 8))
+            assert magic == RAMDUMP_MAGIC
+            slices = hv.iface.readmem(dst + 8, nslices * 24)
+
+            off = pos
+            for i in range(nslices):
+                raw_len, comp_len, offset = struct.unpack_from("<3Q", slices, i * 24)
+                length = comp_len or raw_len
+                _write_record(fd, off, raw_len, comp_len,
+                              hv.iface.readmem(dst + offset, length))
+                off += raw_len
+
+            pos += chunk
+
+def _dirty_runs(bitmap, npages):
+    '''Yield (page, count) runs of set bits.'''
+    page = 0
+    while page < npages:
+        word = bitmap[page // 64]
+        if not word:
+            page = (page // 64 + 1) * 64
+            continue
+        if not (word >> (page % 64)) & 1:
+            page += 1
+            continue
+        start = page
+        while page < npages and (bitmap[page // 64] >> (page % 64)) & 1:
+            page += 1
+        yield start, page - start
+
+def save_snapshot(hv, path, parent=None):
+    assert hv.ctx is not None, "guest must be stopped at an exception"
+    if len(hv.started_cpus) > 1:
+        raise Exception("snapshots only support single-vCPU guests")
+
+    ram_base = hv.phys_base
+    ram_size = hv.u.ba.phys_base + hv.u.ba.mem_size - hv.phys_base
+    npages = ram_size // PAGE_SIZE
+
+    hv._commit_context()
+
+    sysregs = {}
+    for name in GUEST_SYSREGS:
+        sysregs[name] = hv.u.mrs(sysreg_fwd[name], silent=True)
+
+    meta = {
+        "version": SNAP_VERSION,
+        "parent": os.path.basename(parent) if parent else None,
+        "ram_base": ram_base,
+        "ram_size": ram_size,
+        "cpu_id": hv.ctx.cpu_id,
+        "context": hv._info_data.hex(),
+        "sysregs": sysregs,
+        "sysreg_shadow": [[list(k), v] for k, v in hv.sysreg[hv.ctx.cpu_id].items()],
+    }
+    meta_blob = json.dumps(meta).encode()
+
+    with open(path, "wb") as fd:
+        fd.write(SNAP_MAGIC)
+        fd.write(struct.pack("<II", SNAP_VERSION, len(meta_blob)))
+        fd.write(meta_blob)
+
+        if parent is None:
+            _dump_range(hv, fd, ram_base, ram_size)
+        else:
+            words = (npages + 63) // 64
+            with hv.u.heap.guarded_malloc(words * 8) as buf:
+                count = hv.p.hv_dirty_collect(buf)
+                assert count != 0xffffffffffffffff, "dirty tracking is not active"
+                bitmap = struct.unpack(f"<{words}Q", hv.iface.readmem(buf, words * 8))
+
+            for page, num in _dirty_runs(bitmap, npages):
+                _dump_range(hv, fd, ram_base + page * PAGE_SIZE, num * PAGE_SIZE)
+
+    # Arm (or re-arm) dirty tracking so the next snapshot can be incremental
+    hv.p.hv_dirty_track(ram_base, ram_size)
+
+def _read_snapshot(path):
+    with open(path, "rb") as fd:
+        assert fd.read(8) == SNAP_MAGIC
+        version, meta_len = struct.unpack("<II", fd.read(8))
+        assert version == SNAP_VERSION
+        meta = json.loads(fd.read(meta_len))
+
+        records = []
+        while True:
+            hdr = fd.read(24)
+            if len(hdr) < 24:
+                break
+            pa, raw_len, comp_len = struct.unpack("<3Q", hdr)
+            records.append((pa, raw_len, comp_len, fd.read(comp_len or raw_len)))
+
+    return meta, records
+
+def load_snapshot(hv, path):
+    assert hv.ctx is not None, "guest must be stopped at an exception"
+
+    # Walk the parent chain, then apply from the full snapshot forward
+    chain = []
+    p = path
+    while p is not None:
+        meta, records = _read_snapshot(p)
+        chain.append((meta, records))
+        p = os.path.join(os.path.dirname(p), meta["parent"]) if meta["parent"] else None
+
+    leaf = chain[0][0]
+    if leaf["cpu_id"] != hv.ctx.cpu_id:
+        raise Exception(f"snapshot is for CPU {leaf['cpu_id']}, stopped on {hv.ctx.cpu_id}")
+
+    for meta, records in reversed(chain):
+        for pa, raw_len, comp_len, data in records:
+            if comp_len:
+                data = lz4_decompress(data, raw_len)
+            hv.u.compressed_writemem(pa, data)
+
+    hv.p.ic_ivau(leaf["ram_base"], leaf["ram_size"])
+
+    hv.iface.writemem(hv.exc_info, bytes.fromhex(leaf["context"]))
+    hv._load_context()
+
+    for name, val in leaf["sysregs"].items():
+        hv.u.msr(sysreg_fwd[name], val, silent=True)
+    hv.sysreg[hv.ctx.cpu_id] = {tuple(k): v for k, v in leaf["sysreg_shadow"]}
+
+    # The restore itself bypasses stage 2, so the dirty bitmap is untouched;
+    # re-arm tracking so further snapshots stay incremental
+    hv.p.hv_dirty_track(leaf["ram_base"], leaf["ram_size"])
@@ -6,16 +6,19 @@ from ..utils import *
 
 __all__ = [
     "MMIOTraceFlags", "EvtMMIOTrace", "EvtIRQTrace", "HV_EVENT",
-    "VMProxyHookData", "TraceMode",
+    "VMProxyHookData", "TraceMode", "TraceFilterEnt", "TRACE_FILTER_R",
+    "TRACE_FILTER_W", "VcpuStats",
 ]
 
 class MMIOTraceFlags(Register32):
     ATTR = 31, 24
     CPU = 23, 16
     SH = 15, 14
+    WC_NLEN = 13, 8
     WIDTH = 4, 0
     WRITE = 5
     MULTI = 6
+    WC = 7
 
 EvtMMIOTrace = Struct(
     "flags" / RegAdapter(MMIOTraceFlags),
@@ -31,6 +34,42 @@ EvtIRQTrace = Struct(
     "num" / Int16ul,
 )
 
+TRACE_FILTER_R = 1 << 0
+TRACE_FILTER_W = 1 << 1
+
+TraceFilterEnt = Struct(
+    "start" / Hex(Int64ul),
+    "end" / Hex(Int64ul),
+    "mask" / Hex(Int64ul),
+    "value" / Hex(Int64ul),
+    "flags" / Int32ul,
+    "_pad" / Default(Int32ul, 0),
+)
+
+HV_EXIT_HIST_BUCKETS = 24
+
+HV_EXIT_CLASSES = [
+    "sysreg", "sysreg_fast", "dabort", "sync_other",
+    "timer", "ipi", "fiq_other", "irq", "serror",
+]
+
+ExitClassStats = Struct(
+    "count" / Int64ul,
+    "cycles" / Int64ul,
+    # log2(CNTPCT cycles) buckets, last bucket is a catch-all
+    "hist" / Array(HV_EXIT_HIST_BUCKETS, Int64ul),
+)
+
+VcpuStats = Struct(
+    "sync" / Int64ul,
+    "irq" / Int64ul,
+    "fiq" / Int64ul,
+    "serror" / Int64ul,
+    "fast_exits" / Int64ul,
+    "exit_cycles" / Int64ul,
+    "classes" / Array(len(HV_EXIT_CLASSES), ExitClassStats),
+)
+
 class HV_EVENT(IntEnum):
     HOOK_VM = 1
     VTIMER = 2
@@ -1,7 +1,10 @@
 # SPDX-License-Identifier: MIT
 from construct import Struct, Int8ul, Int16ul, Int32sl, Int32ul, Int64ul
 from subprocess import Popen, PIPE
+import errno
 import pathlib
+import shutil
+import stat as stat_m
 import struct
 import os
 import sys
@@ -33,8 +36,10 @@ VirtioExcInfo = Struct(
     "devbase" / Int64ul,
     "qu" / Int16ul,
     "idx" / Int16ul,
-    "pad" / Int32ul, 
+    "count" / Int16ul,
+    "size" / Int16ul,
     "descbase" / Int64ul,
+    "availbase" / Int64ul,
 )
 
 class VirtioDev:
@@ -48,6 +53,31 @@ class VirtioDev:
         off = VirtioDesc.sizeof() * idx
         return self.hv.iface.readstruct(ctx.descbase + off, VirtioDesc)
 
+    def read_descs(self, ctx):
+        # Snapshot the whole descriptor table with a single proxy round
+        # trip; chain walks then index the local copy instead of paying
+        # one round trip per descriptor.
+        dsize = VirtioDesc.sizeof()
+        data = self.hv.iface.readmem(ctx.descbase, dsize * ctx.size)
+        return [VirtioDesc.parse(data[off:off + dsize])
+                for off in range(0, dsize * ctx.size, dsize)]
+
+    def read_bufs(self, descs):
+        # One proxy read per run of physically contiguous descriptors;
+        # bulk transfers usually queue their data pages back to back.
+        buf = bytearray()
+        addr = length = 0
+        for desc in descs:
+            if length and desc.addr == addr + length:
+                length += desc.len
+                continue
+            if length:
+                buf += self.hv.iface.readmem(addr, length)
+            addr, length = desc.addr, desc.len
+        if length:
+            buf += self.hv.iface.readmem(addr, length)
+        return buf
+
     @property
     def config_data(self):
         return b""
@@ -64,16 +94,322 @@ class VirtioDev:
     def feats(self):
         return 0
 
+class P9Error(Exception):
+    def __init__(self, msg, err=errno.EIO):
+        super().__init__(msg)
+        self.err = err
+
+class P9Server:
+    '''Minimal in-process 9P2000.u server over a host directory.
+
+    Replaces the external u9fs dependency for the common case: the guest
+    mounts with -o trans=virtio,version=9p2000.u and reads straight out of
+    the host tree. Requests arrive as complete 9P messages from the virtio
+    queue (one bulk proxy transfer each), so the server only has to be fast
+    at turning Tread into file data; sequential reads are served from a
+    per-fid readahead buffer refilled in large preads, keeping module-sized
+    files at one pread per few requests.'''
+
+    NOTAG = 0xffff
+    NOFID = 0xffffffff
+    QTDIR = 0x80
+    QTSYMLINK = 0x02
+    QTFILE = 0x00
+    DMDIR = 0x80000000
+    DMSYMLINK = 0x02000000
+    MAXWELEM = 16
+    READAHEAD = 1 << 17
+
+    def __init__(self, root, msize=1 << 20):
+        self.root = os.path.realpath(root)
+        self.max_msize = msize
+        self.msize = msize
+        self.fids = {}
+
+    # wire format helpers
+
+    def _s(self, s):
+        if isinstance(s, str):
+            s = s.encode("utf-8")
+        return struct.pack("<H", len(s)) + s
+
+    def _rd_s(self, buf, off):
+        n, = struct.unpack_from("<H", buf, off)
+        return buf[off + 2:off + 2 + n].decode("utf-8"), off + 2 + n
+
+    def _qid(self, st):
+        if stat_m.S_ISDIR(st.st_mode):
+            t = self.QTDIR
+        elif stat_m.S_ISLNK(st.st_mode):
+            t = self.QTSYMLINK
+        else:
+            t = self.QTFILE
+        return struct.pack("<BIQ", t, st.st_mtime_ns & 0xffffffff, st.st_ino)
+
+    def _stat(self, path):
+        st = os.lstat(path)
+        mode = st.st_mode & 0o777
+        ext = b""
+        if stat_m.S_ISDIR(st.st_mode):
+            mode |= self.DMDIR
+        elif stat_m.S_ISLNK(st.st_mode):
+            mode |= self.DMSYMLINK
+            ext = os.readlink(path).encode("utf-8")
+        name = os.path.basename(path) or "/"
+        body = struct.pack("<HI", 0, 0)
+        body += self._qid(st)
+        body += struct.pack("<IIIQ", mode, int(st.st_atime), int(st.st_mtime),
+                            0 if stat_m.S_ISDIR(st.st_mode) else st.st_size)
+        body += self._s(name) + self._s("") + self._s("") + self._s("")
+        body += self._s(ext)
+        body += struct.pack("<III", st.st_uid, st.st_gid, st.st_uid)
+        return struct.pack("<H", len(body)) + body
+
+    # fid helpers
+
+    def _fid(self, fid):
+        try:
+            return self.fids[fid]
+        except KeyError:
+            raise P9Error("unknown fid", errno.EBADF)
+
+    def _resolve(self, path, name):
+        if "/" in name or name == "":
+            raise P9Error("invalid path element", errno.EINVAL)
+        if name == "..":
+            if path == self.root:
+                return path
+            return os.path.dirname(path)
+        return os.path.join(path, name)
+
+    def _clunk(self, fid):
+        f = self.fids.pop(fid, None)
+        if f and f.get("fd") is not None:
+            os.close(f["fd"])
+
+    # request handlers (type -> (reply type = type + 1))
+
+    def _t_version(self, tag, buf, off):
+        msize, = struct.unpack_from("<I", buf, off)
+        version, off = self._rd_s(buf, off + 4)
+        for fid in list(self.fids):
+            self._clunk(fid)
+        self.msize = min(msize, self.max_msize)
+        if not version.startswith("9P2000"):
+            return struct.pack("<I", self.msize) + self._s("unknown")
+        version = "9P2000.u" if version.startswith("9P2000.u") else "9P2000"
+        return struct.pack("<I", self.msize) + self._s(version)
+
+    def _t_attach(self, tag, buf, off):
+        fid, afid = struct.unpack_from("<II", buf, off)
+        self._clunk(fid)
+        self.fids[fid] = {"path": self.root, "fd": None}
+        return self._qid(os.lstat(self.root))
+
+    def _t_walk(self, tag, buf, off):
+        fid, newfid, nwname = struct.unpack_from("<IIH", buf, off)
+        off += 10
+        if nwname > self.MAXWELEM:
+            raise P9Error("too many path elements", errno.EINVAL)
+        path = self._fid(fid)["path"]
+        qids = b""
+        for i in range(nwname):
+            name, off = self._rd_s(buf, off)
+            walked = self._resolve(path, name)
+            try:
+                st = os.lstat(walked)
+            except OSError as e:
+                if i == 0:
+                    raise
+                break
+            path = walked
+            qids += self._qid(st)
+        else:
+            if newfid != fid:
+                self._clunk(newfid)
+            self.fids[newfid] = {"path": path, "fd": None}
+            return struct.pack("<H", nwname) + qids
+        return struct.pack("<H", len(qids) // 13) + qids
+
+    def _open_fid(self, f, flags):
+        st = os.lstat(f["path"])
+        if stat_m.S_ISDIR(st.st_mode):
+            data = b""
+            for name in sorted(os.listdir(f["path"])):
+                try:
+                    data += self._stat(os.path.join(f["path"], name))
+                except OSError:
+                    continue
+            f["dirdata"] = data
+        else:
+            f["fd"] = os.open(f["path"], flags)
+            f["ra_off"] = f["ra_buf"] = None
+        return self._qid(st)
+
+    def _t_open(self, tag, buf, off):
+        fid, mode = struct.unpack_from("<IB", buf, off)
+        f = self._fid(fid)
+        flags = [os.O_RDONLY, os.O_WRONLY, os.O_RDWR, os.O_RDONLY][mode & 3]
+        if mode & 0x10:
+            flags |= os.O_TRUNC
+        qid = self._open_fid(f, flags)
+        return qid + struct.pack("<I", self.msize - 24)
+
+    def _t_create(self, tag, buf, off):
+        fid, = struct.unpack_from("<I", buf, off)
+        name, off = self._rd_s(buf, off + 4)
+        perm, mode = struct.unpack_from("<IB", buf, off)
+        off += 5
+        ext, off = self._rd_s(buf, off)
+        f = self._fid(fid)
+        path = self._resolve(f["path"], name)
+        if perm & self.DMDIR:
+            os.mkdir(path, perm & 0o777)
+        elif perm & self.DMSYMLINK:
+            os.symlink(ext, path)
+        else:
+            os.close(os.open(path, os.O_CREAT | os.O_EXCL, perm & 0o777))
+        f["path"] = path
+        flags = [os.O_RDONLY, os.O_WRONLY, os.O_RDWR, os.O_RDONLY][mode & 3]
+        qid = self._open_fid(f, flags)
+        return qid + struct.pack("<I", self.msize - 24)
+
+    def _t_read(self, tag, buf, off):
+        fid, offset, count = struct.unpack_from("<IQI", buf, off)
+        f = self._fid(fid)
+        count = min(count, self.msize - 11)
+        if "dirdata" in f:
+            data = f["dirdata"][offset:]
+            n = 0
+            while n + 2 <= len(data):
+                esz, = struct.unpack_from("<H", data, n)
+                if n + esz + 2 > count:
+                    break
+                n += esz + 2
+            data = data[:n]
+        elif f.get("fd") is None:
+            raise P9Error("fid not open", errno.EBADF)
+        else:
+            data = self._pread_ra(f, offset, count)
+        return struct.pack("<I", len(data)) + data
+
+    def _pread_ra(self, f, offset, count):
+        buf, base = f["ra_buf"], f["ra_off"]
+        if buf is None or offset < base or offset + count > base + len(buf):
+            f["ra_buf"] = buf = os.pread(f["fd"], max(count, self.READAHEAD), offset)
+            f["ra_off"] = base = offset
+        return buf[offset - base:offset - base + count]
+
+    def _t_write(self, tag, buf, off):
+        fid, offset, count = struct.unpack_from("<IQI", buf, off)
+        f = self._fid(fid)
+        if f.get("fd") is None:
+            raise P9Error("fid not open", errno.EBADF)
+        data = buf[off + 16:off + 16 + count]
+        n = os.pwrite(f["fd"], data, offset)
+        f["ra_buf"] = f["ra_off"] = None
+        return struct.pack("<I", n)
+
+    def _t_clunk(self, tag, buf, off):
+        fid, = struct.unpack_from("<I", buf, off)
+        self._fid(fid)
+        self._clunk(fid)
+        return b""
+
+    def _t_remove(self, tag, buf, off):
+        fid, = struct.unpack_from("<I", buf, off)
+        f = self._fid(fid)
+        path = f["path"]
+        self._clunk(fid)
+        if os.path.isdir(path) and not os.path.islink(path):
+            os.rmdir(path)
+        else:
+            os.unlink(path)
+        return b""
+
+    def _t_stat(self, tag, buf, off):
+        fid, = struct.unpack_from("<I", buf, off)
+        st = self._stat(self._fid(fid)["path"])
+        return struct.pack("<H", len(st)) + st
+
+    def _t_wstat(self, tag, buf, off):
+        fid, = struct.unpack_from("<I", buf, off)
+        f = self._fid(fid)
+        off += 6 # fid + outer stat size
+        size, mtype, dev = struct.unpack_from("<HHI", buf, off)
+        off += 8 + 13 # header + qid
+        mode, atime, mtime, length = struct.unpack_from("<IIIQ", buf, off)
+        off += 20
+        name, off = self._rd_s(buf, off)
+        if mode != 0xffffffff:
+            os.chmod(f["path"], mode & 0o777)
+        if length != 0xffffffffffffffff:
+            os.truncate(f["path"], length)
+            f["ra_buf"] = f["ra_off"] = None
+        if name:
+            newpath = self._resolve(os.path.dirname(f["path"]), name)
+            os.rename(f["path"], newpath)
+            f["path"] = newpath
+        return b""
+
+    def _t_flush(self, tag, buf, off):
+        return b""
+
+    handlers = {
+        100: _t_version,
+        104: _t_attach,
+        108: _t_flush,
+        110: _t_walk,
+        112: _t_open,
+        114: _t_create,
+        116: _t_read,
+        118: _t_write,
+        120: _t_clunk,
+        122: _t_remove,
+        124: _t_stat,
+        126: _t_wstat,
+    }
+
+    def _reply(self, rtype, tag, body):
+        return struct.pack("<IBH", 7 + len(body), rtype, tag) + body
+
+    def handle(self, req):
+        size, mtype, tag = struct.unpack_from("<IBH", req)
+        try:
+            handler = self.handlers.get(mtype)
+            if handler is None:
+                raise P9Error("operation not supported", errno.ENOSYS)
+            return self._reply(mtype + 1, tag, handler(self, tag, req, 7))
+        except OSError as e:
+            err = e.errno if e.errno else errno.EIO
+            body = self._s(os.strerror(err)) + struct.pack("<I", err)
+            return self._reply(107, tag, body)
+        except P9Error as e:
+            body = self._s(str(e)) + struct.pack("<I", e.err)
+            return self._reply(107, tag, body)
+
 class Virtio9PTransport(VirtioDev):
-    def __init__(self, tag="m1n1", root=None):
-        p_stdin, self.fin = os.pipe()
-        self.fout, p_stdout = os.pipe()
+    def __init__(self, tag="m1n1", root=None, server=None):
         if root is None:
             root = str(pathlib.Path(__file__).resolve().parents[3])
         if type(tag) is str:
             self.tag = tag.encode("ascii")
         else:
             self.tag = tag
+
+        # Prefer u9fs when installed (it has the longer track record); fall
+        # back to the in-process server so the common case needs no extra
+        # binary.
+        if server is None:
+            server = "u9fs" if shutil.which("u9fs") else "builtin"
+
+        self.fs = None
+        if server == "builtin":
+            self.fs = P9Server(root)
+            return
+
+        p_stdin, self.fin = os.pipe()
+        self.fout, p_stdout = os.pipe()
         self.p = Popen([
             "u9fs",
             "-a", "none", # no auth
@@ -99,6 +435,8 @@ class Virtio9PTransport(VirtioDev):
         return 1
 
     def call(self, req):
+        if self.fs is not None:
+            return self.fs.handle(req)
         os.write(self.fin, req)
         resp = os.read(self.fout, 4)
         length = int.from_bytes(resp, byteorder="little")
@@ -106,18 +444,20 @@ class Virtio9PTransport(VirtioDev):
         return resp
 
     def handle_exc(self, ctx):
-        head = self.read_desc(ctx, ctx.idx)
+        descs = self.read_descs(ctx)
+        head = descs[ctx.idx]
         assert not head.flags.WRITE
 
-        req = bytearray()
+        chain = []
 
         while not head.flags.WRITE:
-            req += self.read_buf(head)
+            chain.append(head)
 
             if not head.flags.NEXT:
                 break
-            head = self.read_desc(ctx, head.next)
+            head = descs[head.next]
 
+        req = self.read_bufs(chain)
         resp = self.call(bytes(req))
         resplen = len(resp)
 
@@ -126,7 +466,7 @@ class Virtio9PTransport(VirtioDev):
             resp = resp[head.len:]
             if not head.flags.NEXT:
                 break
-            head = self.read_desc(ctx, head.next)
+            head = descs[head.next]
 
         self.hv.p.virtio_put_buffer(ctx.devbase, ctx.qu, ctx.idx, resplen)
 
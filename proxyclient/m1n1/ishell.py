@@ -3,11 +3,6 @@ import builtins
 import sys
 
 import __main__
-from IPython import embed
-from traitlets.config import get_config
-
-c = get_config()
-c.InteractiveShellEmbed.colors = "Linux"
 from inspect import signature
 
 from . import sysreg
@@ -94,6 +89,14 @@ def help_cmd(arg=None):
 # InteractiveConsole with. It adds in the callables
 # in proxy utils iface and sysreg into commands
 def run_ishell(commands, msg=""):
+    # IPython is slow to import; do it here so merely importing this module
+    # (e.g. from tools that only might drop to a shell) stays cheap.
+    from IPython import embed
+    from traitlets.config import get_config
+
+    c = get_config()
+    c.InteractiveShellEmbed.colors = "Linux"
+
     saved_display = sys.displayhook
     try:
 
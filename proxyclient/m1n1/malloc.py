@@ -1,9 +1,16 @@
 # SPDX-License-Identifier: MIT
+import bisect
 from contextlib import contextmanager
 
 __all__ = ["Heap"]
 
 class Heap(object):
+    """Host-side bookkeeping for a device heap region. Allocations never
+    touch the device: malloc/free only pick ranges, so scripts can allocate
+    thousands of scratch buffers without per-call USB latency. Free space is
+    tracked as sorted runs and used blocks in a dict, keeping each call
+    proportional to the number of free runs rather than every allocation
+    ever made."""
     def __init__(self, start, end, block=64):
         if start%block:
             raise ValueError("heap start not aligned")
@@ -11,40 +18,49 @@ class Heap(object):
             raise ValueError("heap end not aligned")
         self.offset = start
         self.count = (end - start) // block
-        self.blocks = [(self.count,False)]
         self.block = block
+        # Sorted, non-adjacent runs of free space, in block units
+        self.free_pos = [0]
+        self.free_len = [self.count]
+        self.used = {}
+
+    def _carve(self, i, pos, size):
+        # Take [pos, pos + size) out of free run i
+        rpos = self.free_pos[i]
+        head = pos - rpos
+        tail = rpos + self.free_len[i] - (pos + size)
+        if head:
+            self.free_len[i] = head
+            if tail:
+                self.free_pos.insert(i + 1, pos + size)
+                self.free_len.insert(i + 1, tail)
+        elif tail:
+            self.free_pos[i] = pos + size
+            self.free_len[i] = tail
+        else:
+            del self.free_pos[i]
+            del self.free_len[i]
+        self.used[pos] = size
+        return self.offset + self.block * pos
 
     def malloc(self, size):
         size = (size + self.block - 1) // self.block
-        pos = 0
-        for i, (bsize, full) in enumerate(self.blocks):
-            if not full and bsize >= size:
-                self.blocks[i] = (size, True)
-                if bsize > size:
-                    self.blocks.insert(i+1, (bsize - size, False))
-                return self.offset + self.block * pos
-            pos += bsize
+        for i, rlen in enumerate(self.free_len):
+            if rlen >= size:
+                return self._carve(i, self.free_pos[i], size)
         raise Exception("Out of memory")
 
     def memalign(self, align, size):
         assert (align & (align - 1)) == 0
         align = max(align, self.block) // self.block
         size = (size + self.block - 1) // self.block
-        pos = self.offset // self.block
-        for i, (bsize, full) in enumerate(self.blocks):
-            if not full:
-                offset = 0
-                if pos % align:
-                    offset = align - (pos % align)
-                if bsize >= (size + offset):
-                    if offset:
-                        self.blocks.insert(i, (offset, False))
-                        i += 1
-                    self.blocks[i] = (size, True)
-                    if bsize > (size + offset):
-                        self.blocks.insert(i+1, (bsize - size - offset, False))
-                    return self.block * (pos + offset)
-            pos += bsize
+        base = self.offset // self.block
+        for i, rpos in enumerate(self.free_pos):
+            pos = rpos
+            if (base + pos) % align:
+                pos += align - ((base + pos) % align)
+            if pos + size <= rpos + self.free_len[i]:
+                return self._carve(i, pos, size)
         raise Exception("Out of memory")
 
     def free(self, addr):
@@ -56,33 +72,32 @@ class Heap(object):
         addr //= self.block
         if addr>=self.count:
             raise ValueError("free address after heap")
-        pos = 0
-        for i, (bsize, used) in enumerate(self.blocks):
-            if pos > addr:
-                raise ValueError("bad free address")
-            if pos == addr:
-                if used == False:
-                    raise ValueError("block already free")
-                if i!=0 and self.blocks[i-1][1] == False:
-                    bsize += self.blocks[i-1][0]
-                    del self.blocks[i]
-                    i -= 1
-                if i!=(len(self.blocks)-1) and self.blocks[i+1][1] == False:
-                    bsize += self.blocks[i+1][0]
-                    del self.blocks[i]
-                self.blocks[i] = (bsize, False)
-                return
-            pos += bsize
-        raise ValueError("bad free address")
+        size = self.used.pop(addr, None)
+        if size is None:
+            i = bisect.bisect_right(self.free_pos, addr) - 1
+            if i >= 0 and self.free_pos[i] == addr:
+                raise ValueError("block already free")
+            raise ValueError("bad free address")
+        i = bisect.bisect_right(self.free_pos, addr)
+        # Coalesce with adjacent runs on either side
+        merge_prev = i > 0 and self.free_pos[i-1] + self.free_len[i-1] == addr
+        merge_next = i < len(self.free_pos) and addr + size == self.free_pos[i]
+        if merge_prev and merge_next:
+            self.free_len[i-1] += size + self.free_len[i]
+            del self.free_pos[i]
+            del self.free_len[i]
+        elif merge_prev:
+            self.free_len[i-1] += size
+        elif merge_next:
+            self.free_pos[i] = addr
+            self.free_len[i] += size
+        else:
+            self.free_pos.insert(i, addr)
+            self.free_len.insert(i, size)
 
     def check(self):
-        free = 0
-        inuse = 0
-        for i, (bsize, used) in enumerate(self.blocks):
-            if used:
-                inuse += bsize
-            else:
-                free += bsize
+        free = sum(self.free_len)
+        inuse = sum(self.used.values())
         if free + inuse != self.count:
             raise Exception("Total block size is inconsistent")
         print("Heap stats:")
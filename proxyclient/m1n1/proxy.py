@@ -1,5 +1,5 @@
 # SPDX-License-Identifier: MIT
-import platform, os, sys, struct, serial, time
+import platform, os, select, sys, struct, serial, time
 from construct import *
 from enum import IntEnum, IntFlag
 from serial.tools.miniterm import Miniterm
@@ -34,10 +34,13 @@ class UartRemoteError(UartError):
 
 class Feature(IntFlag):
     DISABLE_DATA_CSUMS = 0x01  # Data transfers don't use checksums
+    EVENT_CHANNEL = 0x04       # Events arrive on a dedicated USB pipe
+    PROXY_BATCH = 0x08         # Jumbo frames carrying batched proxy requests
 
     @classmethod
     def get_all(cls):
-        return cls.DISABLE_DATA_CSUMS
+        # EVENT_CHANNEL is only negotiated when an event device is attached
+        return cls.DISABLE_DATA_CSUMS | cls.PROXY_BATCH
 
     def __str__(self):
         return ", ".join(feature.name for feature in self.__class__
@@ -80,6 +83,14 @@ class DART(IntEnum):
     T8110 = 1
     T6000 = 2
 
+class BENCH(IntEnum):
+    MEMCPY = 0
+    MEMSET = 1
+    CACHE_FLUSH = 2
+    ADT_LOOKUP = 3
+    EXC_BRK = 4
+    DART_MAP = 5
+
 ExcInfo = Struct(
     "regs" / Array(32, Int64ul),
     "spsr" / RegAdapter(SPSR),
@@ -117,6 +128,7 @@ class UartInterface(Reloadable):
     REQ_MEMWRITE = 0x03AA55FF
     REQ_BOOT = 0x04AA55FF
     REQ_EVENT = 0x05AA55FF
+    REQ_PROXY_BATCH = 0x09AA55FF
 
     CHECKSUM_SENTINEL = 0xD0DECADE
     DATA_END_SENTINEL = 0xB0CACC10
@@ -165,6 +177,11 @@ class UartInterface(Reloadable):
         self.evt_handlers = {}
         self.enabled_features = Feature(0)
 
+        self.event_dev = None
+        event_device = os.environ.get("M1N1EVENTDEV", None)
+        if event_device:
+            self.open_event_channel(event_device)
+
     def checksum(self, data):
         sum = 0xDEADBEEF;
         for c in data:
@@ -325,8 +342,62 @@ class UartInterface(Reloadable):
     def set_event_handler(self, event_id, handler):
         self.evt_handlers[event_id] = handler
 
+    def open_event_channel(self, device):
+        '''Attach the serial device for the out-of-band event channel.
+        The channel is only used once the target acks Feature.EVENT_CHANNEL
+        in nop(); until then events keep arriving in-band.'''
+        if isinstance(device, str):
+            device = Serial(device, self.baudrate)
+        device.timeout = self.dev.timeout
+        device.flushInput()
+        self.event_dev = device
+
+    def _event_readfull(self, size):
+        d = b''
+        while len(d) < size:
+            block = self.event_dev.read(size - len(d))
+            if not block:
+                raise UartTimeout("Expected %d event bytes, got %d bytes"%(size, len(d)))
+            d += block
+        return d
+
+    def poll_events(self):
+        '''Drain and dispatch pending frames from the event channel.
+        The channel fd can be select()ed/epoll()ed on; call this when it
+        becomes readable. Returns the number of events handled.'''
+        handled = 0
+        if self.event_dev is None:
+            return handled
+
+        magic = struct.pack("<I", self.REQ_EVENT)
+        while self.event_dev.in_waiting >= self.EVENT_HDR_LEN:
+            sync = self._event_readfull(4)
+            while sync != magic:
+                sync = sync[1:] + self._event_readfull(1)
+            hdr = sync + self._event_readfull(self.EVENT_HDR_LEN - 4)
+            data_len, event_type = struct.unpack("<HH", hdr[4:])
+            frame = hdr + self._event_readfull(data_len + 4)
+            if self.debug:
+                print("EV", hexdump(frame))
+            checksum = struct.unpack("<I", frame[-4:])[0]
+            ccsum = self.data_checksum(frame[:-4])
+            if checksum != ccsum:
+                print("Event checksum error: Expected 0x%08x, got 0x%08x"%(checksum, ccsum))
+                continue
+            self.handle_event(EVENT(event_type), frame[self.EVENT_HDR_LEN:-4])
+            handled += 1
+        return handled
+
     def wait_boot(self):
         try:
+            # While waiting on the target, react to out-of-band events as
+            # soon as they arrive instead of after the next proxy read.
+            while self.event_dev is not None:
+                rfds, _, _ = select.select([self.dev, self.event_dev], [], [])
+                if self.event_dev in rfds:
+                    self.poll_events()
+                if self.dev in rfds:
+                    break
             return self.reply(self.REQ_BOOT)
         except:
             # Over USB, reboots cause a reconnect
@@ -351,6 +422,8 @@ class UartInterface(Reloadable):
 
     def nop(self):
         features = Feature.get_all()
+        if self.event_dev is not None:
+            features |= Feature.EVENT_CHANNEL
 
         # Send the supported feature flags in the NOP message (has no effect
         # if the target does not support it)
@@ -377,6 +450,42 @@ class UartInterface(Reloadable):
         else:
             return self.reply(self.REQ_PROXY)
 
+    def proxyreq_pipelined(self, reqs):
+        '''Issue a batch of proxy requests back to back, then collect the
+        replies. The target processes requests serially off the link, so
+        completions come back in issue order and the whole batch costs one
+        link round trip instead of one per request; callers tag the opcode
+        high bits to detect desync.'''
+        for req in reqs:
+            self.cmd(self.REQ_PROXY, req)
+        return [self.reply(self.REQ_PROXY) for _ in reqs]
+
+    PROXY_REQ_LEN = 56
+    PROXY_REPLY_LEN = 24
+    PROXY_BATCH_MAX = 1024
+
+    def proxyreq_batch(self, reqs):
+        '''Send a batch of proxy requests as one jumbo frame and read the
+        dense reply array back, so frame and checksum overhead is paid once
+        per batch instead of once per request. Needs Feature.PROXY_BATCH.
+        Returns (completed, replies): the target stops early if a request
+        fails or exits the proxy.'''
+        assert len(reqs) <= self.PROXY_BATCH_MAX
+        data = b''.join(reqs)
+        assert len(data) == len(reqs) * self.PROXY_REQ_LEN
+        req = struct.pack("<II", len(reqs), self.data_checksum(data))
+        self.cmd(self.REQ_PROXY_BATCH, req)
+        self.dev.write(data)
+        reply = self.reply(self.REQ_PROXY_BATCH)
+        completed, checksum = struct.unpack("<II", reply[:8])
+        rdata = self.readfull(completed * self.PROXY_REPLY_LEN)
+        ccsum = self.data_checksum(rdata)
+        if checksum != ccsum:
+            raise UartChecksumError("Batch reply data checksum error: "
+                "Expected 0x%08x, got 0x%08x"%(checksum, ccsum))
+        return completed, [rdata[i * self.PROXY_REPLY_LEN:(i + 1) * self.PROXY_REPLY_LEN]
+                           for i in range(completed)]
+
     def writemem(self, addr, data, progress=False):
         checksum = self.data_checksum(data)
         size = len(data)
@@ -399,6 +508,36 @@ class UartInterface(Reloadable):
         # should automatically report a CRC failure
         self.reply(self.REQ_MEMWRITE)
 
+    def writemem_stream(self, addr, f, size, chunk_size=0x100000, progress=False):
+        '''Stream size bytes from file object f straight to addr, without
+        buffering the whole image in host memory. Needs the
+        DISABLE_DATA_CSUMS feature (the default), since the protocol
+        otherwise sends a checksum of the full data up front; without it,
+        this falls back to a buffered writemem().'''
+        if not (self.enabled_features & Feature.DISABLE_DATA_CSUMS):
+            self.writemem(addr, f.read(size), progress)
+            return
+
+        req = struct.pack("<QQI", addr, size, self.CHECKSUM_SENTINEL)
+        self.cmd(self.REQ_MEMWRITE, req)
+        left = size
+        while left:
+            chunk = f.read(min(chunk_size, left))
+            if not chunk:
+                raise UartError("Short read while streaming data")
+            self.dev.write(chunk)
+            left -= len(chunk)
+            if progress:
+                sys.stdout.write(".")
+                sys.stdout.flush()
+        if progress:
+            print()
+        # Extra sentinel after the data to make sure no data is lost
+        self.dev.write(struct.pack("<I", self.DATA_END_SENTINEL))
+
+        # should automatically report a CRC failure
+        self.reply(self.REQ_MEMWRITE)
+
     def readmem(self, addr, size):
         if size == 0:
             return b""
@@ -494,6 +633,10 @@ class M1N1Proxy(Reloadable):
     P_PUT_SIMD_STATE = 0x00f
     P_REBOOT = 0x010
     P_SLEEP = 0x011
+    P_GXF_BATCH_BEGIN = 0x012
+    P_GXF_BATCH_END = 0x013
+    P_LOG_SET_LEVEL = 0x014
+    P_LOG_BINARY = 0x015
 
     P_WRITE64 = 0x100
     P_WRITE32 = 0x101
@@ -519,6 +662,7 @@ class M1N1Proxy(Reloadable):
     P_WRITEREAD32 = 0x115
     P_WRITEREAD16 = 0x116
     P_WRITEREAD8 = 0x117
+    P_MEMSWEEP = 0x118
 
     P_MEMCPY64 = 0x200
     P_MEMCPY32 = 0x201
@@ -528,6 +672,7 @@ class M1N1Proxy(Reloadable):
     P_MEMSET32 = 0x205
     P_MEMSET16 = 0x206
     P_MEMSET8 = 0x207
+    P_MEMSET_FAST = 0x208
 
     P_IC_IALLUIS = 0x300
     P_IC_IALLU = 0x301
@@ -548,6 +693,9 @@ class M1N1Proxy(Reloadable):
 
     P_XZDEC = 0x400
     P_GZDEC = 0x401
+    P_HASH_RANGE = 0x402
+    P_HASH_CHUNKS = 0x403
+    P_MACHO_FLATTEN = 0x404
 
     P_SMP_START_SECONDARIES = 0x500
     P_SMP_CALL = 0x501
@@ -564,7 +712,10 @@ class M1N1Proxy(Reloadable):
     P_HEAPBLOCK_ALLOC = 0x600
     P_MALLOC = 0x601
     P_MEMALIGN = 0x602
-    P_FREE = 0x602
+    P_FREE = 0x603
+    P_HEAPBLOCK_MARK = 0x604
+    P_HEAPBLOCK_RELEASE = 0x605
+    P_MALLOC_STATS = 0x606
 
     P_KBOOT_BOOT = 0x700
     P_KBOOT_SET_CHOSEN = 0x701
@@ -592,6 +743,8 @@ class M1N1Proxy(Reloadable):
     P_DART_SHUTDOWN = 0xb01
     P_DART_MAP = 0xb02
     P_DART_UNMAP = 0xb03
+    P_DART_TLB_BATCH_BEGIN = 0xb04
+    P_DART_TLB_BATCH_END = 0xb05
 
     P_HV_INIT = 0xc00
     P_HV_MAP = 0xc01
@@ -610,6 +763,18 @@ class M1N1Proxy(Reloadable):
     P_VIRTIO_PUT_BUFFER = 0xc0e
     P_HV_EXIT_CPU = 0xc0f
     P_HV_ADD_TIME = 0xc10
+    P_HV_TRACE_RING = 0xc11
+    P_HV_DIRTY_TRACK = 0xc12
+    P_HV_DIRTY_COLLECT = 0xc13
+    P_HV_SET_TIMER_PASSTHROUGH = 0xc14
+    P_HV_TRACE_FILTER = 0xc15
+    P_HV_CPU_STATS = 0xc16
+    P_HV_PVTIME = 0xc17
+    P_HV_STEP_BATCH = 0xc18
+    P_HV_MMIO_REPLAY = 0xc19
+    P_HV_GATHER = 0xc1a
+    P_HV_OUTPUT_BOUNDED = 0xc1b
+    P_HV_SYSREG_RAZ_WI = 0xc1c
 
     P_FB_INIT = 0xd00
     P_FB_SHUTDOWN = 0xd01
@@ -620,6 +785,8 @@ class M1N1Proxy(Reloadable):
     P_FB_DISPLAY_LOGO = 0xd06
     P_FB_RESTORE_LOGO = 0xd07
     P_FB_IMPROVE_LOGO = 0xd08
+    P_FB_CAPTURE = 0xd09
+    P_FB_SCROLLBACK = 0xd0a
 
     P_PCIE_INIT = 0xe00
     P_PCIE_SHUTDOWN = 0xe01
@@ -630,6 +797,7 @@ class M1N1Proxy(Reloadable):
     P_NVME_FLUSH = 0xf03
 
     P_MCC_GET_CARVEOUTS = 0x1000
+    P_MCC_BENCHMARK = 0x1001
 
     P_DISPLAY_INIT = 0x1100
     P_DISPLAY_CONFIGURE = 0x1101
@@ -641,6 +809,39 @@ class M1N1Proxy(Reloadable):
     P_DAPF_INIT = 0x1201
 
     P_CPUFREQ_INIT = 0x1300
+    P_CPUFREQ_SET_PSTATE = 0x1301
+
+    P_EVTLOG_GET = 0x1400
+    P_BOOT_PROFILE_GET = 0x1401
+    P_TRIPWIRE_GET = 0x1402
+    P_CONSOLE_RING_GET = 0x1403
+    P_CHICKENS_GET = 0x1404
+    P_TELEMETRY_GET = 0x1405
+    P_AFK_STATS_GET = 0x1406
+    P_PLOG_GET = 0x1407
+
+    P_PMU_START = 0x1500
+    P_PMU_STOP = 0x1501
+    P_PMU_READ = 0x1502
+
+    P_KCACHE_INIT = 0x1600
+    P_KCACHE_STORE = 0x1601
+    P_KCACHE_LOAD = 0x1602
+    P_KCACHE_LOAD_ASYNC = 0x1603
+    P_KCACHE_LOAD_POLL = 0x1604
+
+    P_BENCH_RUN = 0x1700
+    P_BENCH_QUIESCE = 0x1701
+
+    P_MEMTEST_RUN = 0x1800
+    P_MEMTEST_GET = 0x1801
+
+    P_DUMP_COMPRESSED = 0x1900
+
+    P_CMDLIST_RUN = 0x1a00
+
+    P_MEMDIFF_RUN = 0x1b00
+    P_MEMDIFF_GET = 0x1b01
 
     def __init__(self, iface, debug=False):
         self.debug = debug
@@ -695,6 +896,69 @@ class M1N1Proxy(Reloadable):
             for i in free:
                 self.heap.free(i)
 
+    def request_pipelined(self, reqs, window=64, signed=False):
+        '''Issue a list of (opcode, *args) requests pipelined and return the
+        list of retvals. Each request carries a tag in the opcode high bits;
+        the target echoes it, so a lost or reordered reply raises instead of
+        silently mismatching. Bulk register sweeps pipeline to one link round
+        trip per window instead of one per access.'''
+        ret_fmt = "q" if signed else "Q"
+        results = []
+        for base in range(0, len(reqs), window):
+            batch = []
+            for tag, r in enumerate(reqs[base:base + window]):
+                opcode, *args = r
+                if len(args) > 6:
+                    raise ValueError("Too many arguments")
+                args = list(args) + [0] * (6 - len(args))
+                batch.append(struct.pack("<7Q", opcode | (tag << 32), *args))
+            for tag, reply in enumerate(self.iface.proxyreq_pipelined(batch)):
+                opcode = reqs[base + tag][0]
+                rop, status, retval = struct.unpack("<Qq" + ret_fmt, reply)
+                if rop != opcode | (tag << 32):
+                    raise ProxyReplyError("Pipelined reply mismatch: Expected 0x%x, got 0x%x"%(opcode | (tag << 32), rop))
+                if status != self.S_OK:
+                    if status == self.S_BADCMD:
+                        raise ProxyCommandError("Reply error: Bad Command")
+                    else:
+                        raise ProxyRemoteError("Reply error: Unknown error (%d)"%status)
+                results.append(retval)
+        return results
+
+    def request_batch(self, reqs, signed=False):
+        '''Like request_pipelined(), but ships the whole batch in a single
+        jumbo frame when the target negotiated Feature.PROXY_BATCH, so a
+        thousand-request sweep costs two bulk transfers instead of a frame
+        pair per request. Falls back to request_pipelined() otherwise.'''
+        if not (self.iface.enabled_features & Feature.PROXY_BATCH):
+            return self.request_pipelined(reqs, signed=signed)
+        ret_fmt = "q" if signed else "Q"
+        results = []
+        window = self.iface.PROXY_BATCH_MAX
+        for base in range(0, len(reqs), window):
+            batch = []
+            for tag, r in enumerate(reqs[base:base + window]):
+                opcode, *args = r
+                if len(args) > 6:
+                    raise ValueError("Too many arguments")
+                args = list(args) + [0] * (6 - len(args))
+                batch.append(struct.pack("<7Q", opcode | (tag << 32), *args))
+            completed, replies = self.iface.proxyreq_batch(batch)
+            for tag, reply in enumerate(replies):
+                opcode = reqs[base + tag][0]
+                rop, status, retval = struct.unpack("<Qq" + ret_fmt, reply)
+                if rop != opcode | (tag << 32):
+                    raise ProxyReplyError("Batch reply mismatch: Expected 0x%x, got 0x%x"%(opcode | (tag << 32), rop))
+                if status != self.S_OK:
+                    if status == self.S_BADCMD:
+                        raise ProxyCommandError("Reply error: Bad Command")
+                    else:
+                        raise ProxyRemoteError("Reply error: Unknown error (%d)"%status)
+                results.append(retval)
+            if completed != len(batch):
+                raise ProxyReplyError("Batch stopped early: %d/%d"%(completed, len(batch)))
+        return results
+
     def nop(self):
         self.request(self.P_NOP)
     def exit(self, retval=0):
@@ -760,6 +1024,21 @@ class M1N1Proxy(Reloadable):
         self.request(self.P_REBOOT, no_reply=True)
     def sleep(self, deep=False):
         self.request(self.P_SLEEP, deep, no_reply=True)
+    def gxf_batch_begin(self):
+        self.request(self.P_GXF_BATCH_BEGIN)
+    def gxf_batch_end(self):
+        self.request(self.P_GXF_BATCH_END)
+    def log_set_level(self, subsys, level):
+        '''Set the runtime log level for a subsystem (enum log_subsys /
+        enum log_level in log.h). Messages above the compile-time floor
+        are not present in the binary regardless.'''
+        return self.request(self.P_LOG_SET_LEVEL, subsys, level)
+    def log_binary(self, buf, entries):
+        '''Arm the binary console log (struct log_bin_ring at buf with
+        entries slots, power of two): debug_printf() then pushes format
+        string pointers plus raw arguments for host-side rendering instead
+        of formatting on-device. buf=0 returns to text output.'''
+        return self.request(self.P_LOG_BINARY, buf, entries)
 
     def write64(self, addr, data):
         '''write 8 byte value to given address'''
@@ -874,6 +1153,15 @@ class M1N1Proxy(Reloadable):
     def writeread8(self, addr, data):
         return self.request(self.P_WRITEREAD8, addr, data)
 
+    MEMSWEEP_FAULT = 0xacce5515abad1dea
+
+    def memsweep(self, buf, base, count, stride, width=4):
+        '''On-device guarded read sweep: reads count locations of width
+        bytes, stride apart, starting at base, into the u64 array at buf.
+        Faulted reads store MEMSWEEP_FAULT. Returns the number of reads
+        that did not fault.'''
+        return self.request(self.P_MEMSWEEP, buf, base, count, stride, width)
+
     def memcpy64(self, dst, src, size):
         if src & 7 or dst & 7:
             raise AlignmentError()
@@ -903,6 +1191,15 @@ class M1N1Proxy(Reloadable):
         self.request(self.P_MEMSET16, dst, src, size)
     def memset8(self, dst, src, size):
         self.request(self.P_MEMSET8, dst, src, size)
+    def memset_fast(self, dst, src, size, chunk=512 * 1024 * 1024):
+        if dst & 7:
+            raise AlignmentError()
+        # Chunked so huge fills report progress and don't trip the port timeout
+        while size > 0:
+            blk = min(size, chunk)
+            self.request(self.P_MEMSET_FAST, dst, src, blk)
+            dst += blk
+            size -= blk
 
     def ic_ialluis(self):
         self.request(self.P_IC_IALLUIS)
@@ -946,6 +1243,24 @@ class M1N1Proxy(Reloadable):
         return self.request(self.P_GZDEC, inbuf, insize, outbuf,
                             outsize, signed=True)
 
+    def hash_range(self, addr, size, seed=0):
+        '''xxHash64 of an address range, computed on-device. Verifies an
+        upload with one 8-byte reply instead of reading the range back.'''
+        return self.request(self.P_HASH_RANGE, addr, size, seed)
+
+    def hash_chunks(self, addr, size, chunk_size, outbuf):
+        '''xxHash64 of an address range in fixed-size chunks (the last one
+        may be short), computed on-device into a u64 array at outbuf.
+        Returns the number of chunks hashed.'''
+        return self.request(self.P_HASH_CHUNKS, addr, size, chunk_size, outbuf)
+
+    def macho_flatten(self, inbuf, insize, outbuf, outsize, entry=0):
+        '''Flatten a Mach-O image on-device: segment placement and zero-fill
+        at outbuf, entry point (a u64 virtual address, if the image has an
+        LC_UNIXTHREAD command) stored at entry. Returns the flattened size.'''
+        return self.request(self.P_MACHO_FLATTEN, inbuf, insize, outbuf, outsize,
+                            entry, signed=True)
+
     def smp_start_secondaries(self):
         self.request(self.P_SMP_START_SECONDARIES)
     def smp_call(self, cpu, addr, *args):
@@ -989,6 +1304,17 @@ class M1N1Proxy(Reloadable):
         return self.request(self.P_MEMALIGN, align, size)
     def free(self, ptr):
         self.request(self.P_FREE, ptr)
+    def heapblock_mark(self):
+        return self.request(self.P_HEAPBLOCK_MARK)
+    def heapblock_release(self, mark):
+        '''Roll the heapblock back to a mark. Allocations made since the mark
+        must all be dead (strictly LIFO use).'''
+        self.request(self.P_HEAPBLOCK_RELEASE, mark)
+    def malloc_stats(self, buf):
+        '''Fill a struct malloc_stats at buf: allocation counters, footprint,
+        free/used chunk census (fragmentation), request-size histogram and
+        per-callsite tallies. See sysinc/malloc.h for the layout.'''
+        self.request(self.P_MALLOC_STATS, buf)
 
     def kboot_boot(self, kernel):
         self.request(self.P_KBOOT_BOOT, kernel)
@@ -1040,6 +1366,10 @@ class M1N1Proxy(Reloadable):
         return self.request(self.P_DART_MAP, dart, iova, bfr, len)
     def dart_unmap(self, dart, iova, len):
         return self.request(self.P_DART_UNMAP, dart, iova, len)
+    def dart_tlb_batch_begin(self, dart):
+        return self.request(self.P_DART_TLB_BATCH_BEGIN, dart)
+    def dart_tlb_batch_end(self, dart):
+        return self.request(self.P_DART_TLB_BATCH_END, dart)
 
     def hv_init(self):
         return self.request(self.P_HV_INIT)
@@ -1077,6 +1407,64 @@ class M1N1Proxy(Reloadable):
         return self.request(self.P_HV_EXIT_CPU, cpu)
     def hv_add_time(self, time):
         return self.request(self.P_HV_ADD_TIME, time)
+    def hv_tracering_init(self, buf, num_events):
+        return self.request(self.P_HV_TRACE_RING, buf, num_events)
+    def hv_dirty_track(self, ipa=0, size=0):
+        '''Start dirty-page tracking on [ipa, ipa+size); size=0 stops it.'''
+        return self.request(self.P_HV_DIRTY_TRACK, ipa, size)
+    def hv_dirty_collect(self, bitmap=0):
+        '''Fetch-and-clear the dirty bitmap (one bit per 16K page) into
+        bitmap, re-protecting dirty pages. Returns the dirty page count.'''
+        return self.request(self.P_HV_DIRTY_COLLECT, bitmap)
+    def hv_set_timer_passthrough(self, enabled=True):
+        '''Stop (or resume) trapping guest timer registers. Only valid while
+        no tracer or time adjustment needs the timer exits.'''
+        return self.request(self.P_HV_SET_TIMER_PASSTHROUGH, int(bool(enabled)))
+    def hv_trace_filter(self, buf=0, count=0):
+        '''Install an MMIO trace filter table (count hv_trace_filter_ent
+        entries at buf): only matching accesses are emitted, everything else
+        resumes at EL2 without an event. buf=0 removes the filter.'''
+        return self.request(self.P_HV_TRACE_FILTER, buf, count)
+    def hv_cpu_stats(self, cpu, buf, reset=False):
+        '''Copy the per-vCPU exit statistics (hv_vcpu_stats) for cpu into
+        buf, optionally resetting them afterwards.'''
+        return self.request(self.P_HV_CPU_STATS, cpu, buf, int(bool(reset)))
+    def hv_pvtime(self, buf=0):
+        '''Publish the paravirtual time page (struct hv_pvtime) at buf; map
+        buf into the guest so it can read the time offset seqlock-style
+        instead of relying on exits for resyncs. buf=0 unpublishes it.'''
+        return self.request(self.P_HV_PVTIME, buf)
+    def hv_step_batch(self, count, buf, stop=0):
+        '''Arm the EL2 single-step engine: consume up to count single-step
+        exceptions on-device, recording the PC of each into buf (a running
+        u64 count followed by the PCs), until the budget is exhausted or
+        ELR reaches stop; only the final step is proxied to the host.'''
+        return self.request(self.P_HV_STEP_BATCH, count, buf, stop)
+    HV_REPLAY_TIMED = 1 << 0
+    HV_REPLAY_CONTINUE = 1 << 1
+    def hv_mmio_replay(self, buf, count, flags=0):
+        '''Replay count recorded MMIO trace events (EvtMMIOTrace records at
+        buf) against the hardware on-device, preserving recorded timing if
+        HV_REPLAY_TIMED. Reads overwrite each record's data field with the
+        observed value; returns the index of the first divergence, or count
+        if the device behaved as recorded.'''
+        return self.request(self.P_HV_MMIO_REPLAY, buf, count, flags)
+    def hv_gather(self, list_buf, count, buf, size, signed=True):
+        '''Gather count (guest VA, length) pairs at list_buf into buf
+        (at most size bytes), translating through the guest page tables
+        on-device. Returns the number of bytes gathered; translation
+        faults stop the copy short.'''
+        return self.request(self.P_HV_GATHER, list_buf, count, buf, size, signed=signed)
+    def hv_output_bounded(self, enable=True):
+        '''Bound console/trace output latency: drop events and defer console
+        bytes to the RAM ring instead of blocking vCPUs when the iodev is
+        saturated. Returns the address of the per-CPU event drop counters
+        (u64 per CPU).'''
+        return self.request(self.P_HV_OUTPUT_BOUNDED, int(enable))
+    def hv_sysreg_raz_wi(self, iss, enable=True):
+        '''Whitelist a sysreg ISS encoding as read-zero/write-ignore in the
+        EL2 vector fast path. Returns the total number of fast exits so far.'''
+        return self.request(self.P_HV_SYSREG_RAZ_WI, iss, int(enable))
 
     def fb_init(self):
         return self.request(self.P_FB_INIT)
@@ -1096,6 +1484,17 @@ class M1N1Proxy(Reloadable):
         return self.request(self.P_FB_RESTORE_LOGO)
     def fb_improve_logo(self):
         return self.request(self.P_FB_IMPROVE_LOGO)
+    def fb_capture(self, info):
+        '''Snapshot the scanout buffer into a stable RAM copy if it changed
+        since the last capture, filling a struct fb_capture_info at info
+        (address/size/geometry of the snapshot). Returns 1 on a new frame,
+        0 if unchanged; read the snapshot with readmem at your leisure.'''
+        return self.request(self.P_FB_CAPTURE, info)
+    def fb_scrollback(self, info):
+        '''Fill a struct fb_scrollback_info at info with the location and
+        geometry of the console scrollback ring (space-padded lines that
+        scrolled off the screen); read the lines with readmem.'''
+        return self.request(self.P_FB_SCROLLBACK, info)
 
     def pcie_init(self):
         return self.request(self.P_PCIE_INIT)
@@ -1104,8 +1503,10 @@ class M1N1Proxy(Reloadable):
 
     def nvme_init(self):
         return self.request(self.P_NVME_INIT)
-    def nvme_shutdown(self):
-        return self.request(self.P_NVME_SHUTDOWN)
+    def nvme_shutdown(self, force=False):
+        '''Releases one client reference; the ANS stays warm until a forced
+        shutdown, so init/shutdown cycles don't re-pay the RTKit boot.'''
+        return self.request(self.P_NVME_SHUTDOWN, int(force))
     def nvme_read(self, nsid, lba, bfr):
         return self.request(self.P_NVME_READ, nsid, lba, bfr)
     def nvme_flush(self, nsid):
@@ -1113,6 +1514,10 @@ class M1N1Proxy(Reloadable):
 
     def mcc_get_carveouts(self):
         return self.request(self.P_MCC_GET_CARVEOUTS)
+    def mcc_benchmark(self, buffer, size, results):
+        '''Run the DRAM/SLC benchmark over a buffer: results receives two u64s,
+        triad bandwidth in MB/s and pointer-chase latency in picoseconds.'''
+        return self.request(self.P_MCC_BENCHMARK, buffer, size, results, signed=True)
 
     def display_init(self):
         return self.request(self.P_DISPLAY_INIT)
@@ -1132,6 +1537,93 @@ class M1N1Proxy(Reloadable):
 
     def cpufreq_init(self):
         return self.request(self.P_CPUFREQ_INIT)
+    def cpufreq_set_pstate(self, cluster, pstate):
+        return self.request(self.P_CPUFREQ_SET_PSTATE, cluster, pstate)
+
+    def evtlog_get(self):
+        return self.request(self.P_EVTLOG_GET)
+    def boot_profile_get(self):
+        return self.request(self.P_BOOT_PROFILE_GET)
+    def tripwire_get(self):
+        return self.request(self.P_TRIPWIRE_GET)
+    def console_ring_get(self):
+        return self.request(self.P_CONSOLE_RING_GET)
+    def chickens_get(self):
+        return self.request(self.P_CHICKENS_GET)
+    def telemetry_get(self):
+        '''Returns the address of the telemetry page; poll it with bulk
+        reads, no further proxy requests needed.'''
+        return self.request(self.P_TELEMETRY_GET)
+    def afk_stats_get(self):
+        return self.request(self.P_AFK_STATS_GET)
+    def plog_get(self):
+        '''Returns the address of the persistent console log header
+        (0 if unavailable).'''
+        return self.request(self.P_PLOG_GET)
+
+    def pmu_start(self, events=0):
+        '''Program and start the core PMCs. PMC0/PMC1 count cycles and
+        instructions; each byte of events selects an event for PMC2-9.'''
+        return self.request(self.P_PMU_START, events)
+    def pmu_stop(self):
+        return self.request(self.P_PMU_STOP)
+    def pmu_read(self, idx):
+        return self.request(self.P_PMU_READ, idx)
+
+    def kcache_init(self, nsid, base_lba, num_blocks):
+        return self.request(self.P_KCACHE_INIT, nsid, base_lba, num_blocks)
+    def kcache_store(self, hash, buf, size):
+        return self.request(self.P_KCACHE_STORE, hash, buf, size)
+    def kcache_load(self, hash, buf):
+        '''Returns the image size, or -1 if hash is not cached. Combine with
+        a vector call to boot a cached image without re-uploading it.'''
+        return self.request(self.P_KCACHE_LOAD, hash, buf)
+    def kcache_load_async(self, hash, buf):
+        '''Returns the image size with the NVMe reads left streaming, so
+        other proxy calls (e.g. kboot_prepare_dt) can overlap the IO.'''
+        return self.request(self.P_KCACHE_LOAD_ASYNC, hash, buf, signed=True)
+    def kcache_load_poll(self):
+        '''1 = buffer complete, 0 = still streaming, -1 = error.'''
+        return self.request(self.P_KCACHE_LOAD_POLL, signed=True)
+
+    def bench_run(self, bench, iters, arg0=0, arg1=0, arg2=0):
+        '''Returns total CNTPCT ticks for iters runs, or -1 on failure.'''
+        return self.request(self.P_BENCH_RUN, bench, iters, arg0, arg1, arg2,
+                            signed=True)
+
+    def bench_quiesce(self, enable=True, pstate=0):
+        '''Pin all clusters to pstate (0 = leave alone) and mask AIC
+        sources for low-variance timing runs; enable=False undoes it.'''
+        return self.request(self.P_BENCH_QUIESCE, int(enable), pstate,
+                            signed=True)
+
+    def memtest_run(self, base, size, passes=3):
+        '''Parallel DRAM test over [base, base+size). Returns the error
+        count, or -1 on bad arguments. Destroys the tested range.'''
+        return self.request(self.P_MEMTEST_RUN, base, size, passes,
+                            signed=True)
+    def memtest_get(self):
+        return self.request(self.P_MEMTEST_GET)
+
+    def dump_compressed(self, src, size, dst, dst_max):
+        '''LZ4-compress [src, src+size) into dst in parallel. Returns the
+        total output size including the slice header, or -1 on failure.'''
+        return self.request(self.P_DUMP_COMPRESSED, src, size, dst, dst_max,
+                            signed=True)
+
+    def memdiff_run(self, a, b, size):
+        '''Compare [a, a+size) against [b, b+size) on-device in parallel.
+        Returns the differing byte count, or -1 on bad arguments; the
+        differing extents are read via memdiff_get().'''
+        return self.request(self.P_MEMDIFF_RUN, a, b, size, signed=True)
+    def memdiff_get(self):
+        return self.request(self.P_MEMDIFF_GET)
+
+    def cmdlist_run(self, cmds, count):
+        '''Runs a device-side command list (see m1n1.cmdlist.CmdList).
+        Returns the number of commands run; less than count means the
+        command at that index failed.'''
+        return self.request(self.P_CMDLIST_RUN, cmds, count, signed=True)
 
 __all__.extend(k for k, v in globals().items()
                if (callable(v) or isinstance(v, type)) and v.__module__ == __name__)
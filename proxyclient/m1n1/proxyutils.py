@@ -87,6 +87,8 @@ class ProxyUtils(Reloadable):
 
         self.inst_cache = {}
 
+        self.delta_cache = {}
+
         self.exec_modes = {
             None: (self.proxy.call, REGION_RX_EL1),
             "el2": (self.proxy.call, REGION_RX_EL1),
@@ -157,6 +159,19 @@ class ProxyUtils(Reloadable):
         if self.proxy.get_exc_count():
             raise ProxyError("Exception occurred")
 
+    def sweep(self, base, count, stride=4, width=4):
+        '''Guarded on-device read sweep of an MMIO block: returns a list of
+        (addr, value) for every location that read without faulting. The
+        whole range costs one proxy round trip plus one bulk readback,
+        instead of one guarded read per register.'''
+        with GuardedHeap(self.heap) as heap:
+            buf = heap.malloc(count * 8)
+            self.proxy.memsweep(buf, base, count, stride, width)
+            data = self.iface.readmem(buf, count * 8)
+        return [(base + i * stride, val)
+                for i, val in enumerate(struct.unpack(f"<{count}Q", data))
+                if val != self.proxy.MEMSWEEP_FAULT]
+
     def mrs(self, reg, *, silent=False, call=None):
         '''read system register reg'''
         op0, op1, CRn, CRm, op2 = sysreg_parse(reg)
@@ -245,13 +260,132 @@ class ProxyUtils(Reloadable):
 
             assert decompressed_size == len(data)
 
+    SPARSE_BLOCK_SIZE = 0x4000
+
+    def sparse_writemem(self, dest, data, block_size=SPARSE_BLOCK_SIZE, progress=False):
+        '''Upload data to dest, skipping zero runs: non-zero extents are
+        coalesced and streamed literally, and the holes between them are
+        zero-filled on-device (DC ZVA for the cache-line-aligned bulk), so
+        images that are mostly padding upload in proportion to their payload
+        bytes.'''
+        data = bytes(data)
+        size = len(data)
+        if not size:
+            return
+
+        def fill_zero(addr, length):
+            # dc_zva_range rounds to whole cache lines; keep it inside
+            start = (addr + 63) & ~63
+            end = (addr + length) & ~63
+            if start >= end:
+                self.proxy.memset8(addr, 0, length)
+                return
+            if start > addr:
+                self.proxy.memset8(addr, 0, start - addr)
+            self.proxy.dc_zva(start, end - start)
+            if addr + length > end:
+                self.proxy.memset8(end, 0, addr + length - end)
+
+        zero = bytes(block_size)
+        extents = []
+        for i in range((size + block_size - 1) // block_size):
+            chunk = data[i * block_size:(i + 1) * block_size]
+            if chunk == zero[:len(chunk)]:
+                continue
+            off = i * block_size
+            if extents and extents[-1][0] + extents[-1][1] == off:
+                extents[-1][1] += len(chunk)
+            else:
+                extents.append([off, len(chunk)])
+
+        pos = 0
+        for off, length in extents:
+            if off > pos:
+                fill_zero(dest + pos, off - pos)
+            self.iface.writemem(dest + off, data[off:off + length], progress)
+            pos = off + length
+        if pos < size:
+            fill_zero(dest + pos, size - pos)
+
+    def macho_writemem(self, dest, data, image_size, progress=None):
+        '''Upload a Mach-O file and flatten it to dest on-device: one bulk
+        transfer of the file, with segment placement, zero-fill and cache
+        maintenance done locally. image_size is the in-memory (vmax - vmin)
+        size. Returns the entry point virtual address, or None.'''
+        with self.heap.guarded_malloc(len(data)) as src_addr, \
+                self.heap.guarded_malloc(8) as entry_addr:
+            self.compressed_writemem(src_addr, data, progress)
+            self.iface.writemem(entry_addr, struct.pack("<Q", 0))
+            flat_size = self.proxy.macho_flatten(src_addr, len(data), dest,
+                                                 image_size, entry_addr)
+            assert flat_size == image_size
+            entry = struct.unpack("<Q", self.iface.readmem(entry_addr, 8))[0]
+            return entry or None
+
+    DELTA_CHUNK_SIZE = 0x4000
+
+    def delta_writemem(self, dest, data, chunk_size=DELTA_CHUNK_SIZE, progress=None):
+        '''Upload data to dest, sending only the chunks that differ from the
+        previous upload to the same address. Device-side chunk hashes verify
+        that the resident copy is still intact; on a mismatch (or first
+        upload) this falls back to a full compressed upload.'''
+        data = bytes(data)
+        size = len(data)
+        if not size:
+            return
+
+        nchunks = (size + chunk_size - 1) // chunk_size
+
+        def fetch_hashes():
+            with self.heap.guarded_malloc(nchunks * 8) as hashbuf:
+                count = self.proxy.hash_chunks(dest, size, chunk_size, hashbuf)
+                assert count == nchunks
+                return list(struct.unpack(f"<{nchunks}Q",
+                                          self.iface.readmem(hashbuf, nchunks * 8)))
+
+        cached = self.delta_cache.get(dest)
+        if cached is None or cached[1] != chunk_size or len(cached[0]) != size \
+                or fetch_hashes() != cached[2]:
+            self.compressed_writemem(dest, data, progress)
+            self.delta_cache[dest] = (data, chunk_size, fetch_hashes())
+            return
+
+        old = cached[0]
+        sent = 0
+        i = 0
+        while i < nchunks:
+            if data[i * chunk_size:(i + 1) * chunk_size] == old[i * chunk_size:(i + 1) * chunk_size]:
+                i += 1
+                continue
+            j = i + 1
+            while j < nchunks and \
+                    data[j * chunk_size:(j + 1) * chunk_size] != old[j * chunk_size:(j + 1) * chunk_size]:
+                j += 1
+            start = i * chunk_size
+            end = min(j * chunk_size, size)
+            self.iface.writemem(dest + start, data[start:end], progress)
+            sent += end - start
+            i = j
+
+        self.delta_cache[dest] = (data, chunk_size, fetch_hashes())
+
     def get_adt(self):
         if self.adt_data is not None:
             return self.adt_data
         adt_base = (self.ba.devtree - self.ba.virt_base + self.ba.phys_base) & 0xffffffffffffffff
         adt_size = self.ba.devtree_size
+        try:
+            adt_hash = self.proxy.hash_range(adt_base, adt_size)
+        except ProxyRemoteError:
+            adt_hash = None # m1n1 without P_HASH_RANGE
+        if adt_hash is not None:
+            self.adt_data = adt.adt_cache_load(adt_hash, adt_size)
+            if self.adt_data is not None:
+                return self.adt_data
         print(f"Fetching ADT ({adt_size} bytes)...")
         self.adt_data = self.iface.readmem(adt_base, self.ba.devtree_size)
+        if adt_hash is not None:
+            adt.adt_cache_store(adt_hash, self.adt_data)
         return self.adt_data
 
     def push_adt(self):
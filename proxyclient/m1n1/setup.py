@@ -1,7 +1,6 @@
 # SPDX-License-Identifier: MIT
 import os, struct, sys, time
 
-from .hv import HV
 from .proxy import *
 from .proxyutils import *
 from .sysreg import *
@@ -22,7 +21,26 @@ bootstrap_port(iface, p)
 u = ProxyUtils(p)
 # Build a Register Monitoring object on Proxy Interface
 mon = RegMonitor(u)
-hv = HV(iface, p, u)
+
+class _LazyHV:
+    '''Defer the m1n1.hv import (it drags in the whole construct/tracer
+    stack, most of the shell's startup time) until the hypervisor is
+    actually touched.'''
+    _hv = None
+
+    def _get(self):
+        if _LazyHV._hv is None:
+            from .hv import HV
+            _LazyHV._hv = HV(iface, p, u)
+        return _LazyHV._hv
+
+    def __getattr__(self, attr):
+        return getattr(self._get(), attr)
+
+    def __dir__(self):
+        return dir(self._get())
+
+hv = _LazyHV()
 
 fb = u.ba.video.base
 
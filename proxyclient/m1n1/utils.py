@@ -1017,6 +1017,39 @@ def crc16USB(crc, data):
         crc = (crc >> 8) ^ _crc16_table[(crc ^ x) & 0xff]
     return crc
 
+def lz4_decompress(data, uncompressed_size):
+    '''Pure-python LZ4 block decoder, for when python-lz4 is unavailable.'''
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        token = data[i]; i += 1
+        lit = token >> 4
+        if lit == 15:
+            while data[i] == 255:
+                lit += 255; i += 1
+            lit += data[i]; i += 1
+        out += data[i:i + lit]; i += lit
+        if i >= len(data):
+            break
+        off = data[i] | (data[i + 1] << 8); i += 2
+        mlen = (token & 15) + 4
+        if (token & 15) == 15:
+            while data[i] == 255:
+                mlen += 255; i += 1
+            mlen += data[i]; i += 1
+        pos = len(out) - off
+        for _ in range(mlen):
+            out.append(out[pos]); pos += 1
+    assert len(out) == uncompressed_size
+    return bytes(out)
+
+try:
+    import lz4.block
+    def lz4_decompress(data, uncompressed_size):
+        return lz4.block.decompress(data, uncompressed_size=uncompressed_size)
+except ImportError:
+    pass
+
 __all__.extend(k for k, v in globals().items()
                if (callable(v) or isinstance(v, type)) and v.__module__ == __name__)
 
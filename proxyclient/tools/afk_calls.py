@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import argparse, json, struct
+
+parser = argparse.ArgumentParser(description='Dump per-method AFK/EPIC call statistics')
+parser.add_argument('-j', '--json', action="store_true", help="Output JSON for diffing")
+parser.add_argument('-H', '--hist', action="store_true", help="Show latency histograms")
+args = parser.parse_args()
+
+from m1n1.setup import *
+
+AFK_STATS_MAGIC = 0x534b4641
+AFK_STATS_BUCKETS = 16
+
+tfreq = u.mrs(CNTFRQ_EL0)
+
+def us(ticks):
+    return ticks / tfreq * 1000000
+
+addr = p.afk_stats_get()
+magic, num_slots, ent_size, dropped = struct.unpack("<4I", iface.readmem(addr, 16))
+assert magic == AFK_STATS_MAGIC
+
+calls = []
+data = iface.readmem(addr + 16, num_slots * ent_size)
+for i in range(num_slots):
+    fields = struct.unpack_from(f"<II5Q{AFK_STATS_BUCKETS}Q", data, i * ent_size)
+    ep, ctype, count, errors, total, tmin, tmax = fields[:7]
+    if not count:
+        continue
+    calls.append({
+        "ep": ep,
+        "type": ctype,
+        "calls": count,
+        "errors": errors,
+        "total": total,
+        "min": tmin,
+        "max": tmax,
+        "hist": list(fields[7:]),
+    })
+
+calls.sort(key=lambda c: c["total"], reverse=True)
+
+if args.json:
+    print(json.dumps({"tfreq": tfreq, "dropped": dropped, "calls": calls}, indent=2))
+else:
+    print(f"{'EP':<5}{'Call':>7}{'Count':>8}{'Err':>5}{'Total (us)':>12}"
+          f"{'Avg (us)':>10}{'Min (us)':>10}{'Max (us)':>10}")
+    for c in calls:
+        print(f"{c['ep']:<#5x}{c['type']:>#7x}{c['calls']:>8}{c['errors']:>5}"
+              f"{us(c['total']):>12.1f}{us(c['total'] / c['calls']):>10.1f}"
+              f"{us(c['min']):>10.1f}{us(c['max']):>10.1f}")
+        if args.hist:
+            for b, n in enumerate(c["hist"]):
+                if n:
+                    print(f"      <{us(2 << b):>10.1f}us: {n}")
+    if dropped:
+        print(f"({dropped} calls dropped: out of slots)")
@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import argparse
+
+parser = argparse.ArgumentParser(description='Run m1n1 on-device microbenchmarks')
+parser.add_argument('-i', '--iters', type=int, default=1000, help="Iterations per benchmark")
+parser.add_argument('-s', '--size', type=int, default=0x100000, help="Buffer size for memory benchmarks")
+args = parser.parse_args()
+
+from m1n1.setup import *
+
+tfreq = u.mrs(CNTFRQ_EL0)
+buf = u.memalign(0x4000, args.size)
+
+def run(name, bench, *bargs, unit_bytes=0):
+    ticks = p.bench_run(bench, args.iters, *bargs)
+    if ticks < 0:
+        print(f"{name:<12} failed")
+        return
+    ns = ticks / tfreq * 1e9 / args.iters
+    line = f"{name:<12}{ns:>12.1f} ns/op"
+    if unit_bytes:
+        line += f"{unit_bytes * args.iters / (ticks / tfreq) / 1e9:>10.2f} GB/s"
+    print(line)
+
+run("memcpy", BENCH.MEMCPY, buf, args.size, unit_bytes=args.size // 2)
+run("memset", BENCH.MEMSET, buf, args.size, unit_bytes=args.size)
+run("cache_flush", BENCH.CACHE_FLUSH, buf, args.size, unit_bytes=args.size)
+run("adt_lookup", BENCH.ADT_LOOKUP)
+run("exc_brk", BENCH.EXC_BRK)
+
+u.free(buf)
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import argparse, re, struct, time
+
+parser = argparse.ArgumentParser(description='Tail the m1n1 binary console log, rendering on the host')
+parser.add_argument('-e', '--entries', type=int, default=1024, help="Ring size in entries (power of two)")
+args = parser.parse_args()
+
+from m1n1.setup import *
+
+ENTRY_SIZE = 64
+HDR_SIZE = 16
+MAX_ARGS = 7
+
+FMT_RE = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|z|t)?([diouxXcsp])")
+
+fmt_cache = {}
+
+def read_cstr(addr):
+    s = b""
+    while True:
+        chunk = iface.readmem(addr + len(s), 64)
+        nul = chunk.find(b"\0")
+        if nul >= 0:
+            return (s + chunk[:nul]).decode("utf-8", "replace")
+        s += chunk
+
+def get_fmt(addr):
+    fmt = fmt_cache.get(addr)
+    if fmt is None:
+        fmt = fmt_cache[addr] = read_cstr(addr)
+    return fmt
+
+def render(fmt, log_args):
+    it = iter(log_args)
+
+    def sub(m):
+        flags, width, prec, length, conv = m.groups()
+        if width == "*":
+            width = str(next(it) & 0xffffffff)
+        if prec == "*":
+            prec = str(next(it) & 0xffffffff)
+        val = next(it)
+        if conv == "s":
+            val = read_cstr(val)
+        elif conv == "c":
+            val = val & 0xff
+        elif conv == "p":
+            conv = "x"
+            flags += "#"
+        else:
+            bits = 64 if length in ("l", "ll", "z", "t") else 32
+            val &= (1 << bits) - 1
+            if conv in "di" and val >= 1 << (bits - 1):
+                val -= 1 << bits
+        spec = "%" + flags + (width or "") + (("." + prec) if prec else "") + conv
+        return spec % val
+
+    # render each %%-delimited chunk separately so literal %s survive
+    return "%".join(FMT_RE.sub(sub, part) for part in fmt.split("%%"))
+
+base = u.malloc(HDR_SIZE + args.entries * ENTRY_SIZE)
+p.log_binary(base, args.entries)
+print(f"Binary log ring at {base:#x} ({args.entries} entries); Ctrl-C to stop")
+
+rptr = 0
+drops = 0
+try:
+    while True:
+        wptr, _, num, new_drops = struct.unpack("<4I", iface.readmem(base, HDR_SIZE))
+        if new_drops != drops:
+            print(f"binlog: {new_drops - drops} messages dropped")
+            drops = new_drops
+        if rptr == wptr:
+            time.sleep(0.01)
+            continue
+        while rptr != wptr:
+            # read the contiguous stretch up to the end of the ring in one go
+            idx = rptr & (num - 1)
+            count = min(wptr - rptr, num - idx)
+            data = iface.readmem(base + HDR_SIZE + idx * ENTRY_SIZE, count * ENTRY_SIZE)
+            for i in range(count):
+                ent = struct.unpack("<8Q", data[i * ENTRY_SIZE:(i + 1) * ENTRY_SIZE])
+                try:
+                    print(render(get_fmt(ent[0]), ent[1:]), end="")
+                except Exception as e:
+                    print(f"binlog: render failed for fmt @{ent[0]:#x}: {e}")
+            rptr += count
+            p.write32(base + 4, rptr)
+except KeyboardInterrupt:
+    pass
+finally:
+    p.log_binary(0, 0)
+    u.free(base)
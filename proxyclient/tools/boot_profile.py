@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import argparse, json, struct
+
+parser = argparse.ArgumentParser(description='Dump the m1n1 boot stage profile')
+parser.add_argument('-j', '--json', action="store_true", help="Output JSON for diffing")
+args = parser.parse_args()
+
+from m1n1.setup import *
+
+BOOTPROFILE_MAGIC = 0x464f5250
+
+tfreq = u.mrs(CNTFRQ_EL0)
+
+addr = p.boot_profile_get()
+magic, max_stages, ent_size, count = struct.unpack("<4I", iface.readmem(addr, 16))
+assert magic == BOOTPROFILE_MAGIC
+
+stages = []
+data = iface.readmem(addr + 16, count * ent_size)
+for i in range(count):
+    tag, start, duration = struct.unpack_from("<8sQQ", data, i * ent_size)
+    stages.append({
+        "tag": tag.rstrip(b"\0").decode(),
+        "start": start,
+        "duration": duration,
+    })
+
+if args.json:
+    print(json.dumps({"tfreq": tfreq, "stages": stages}, indent=2))
+else:
+    base = stages[0]["start"] if stages else 0
+    print(f"{'Stage':<10}{'Start (ms)':>12}{'Duration (ms)':>15}")
+    for stage in stages:
+        start_ms = (stage["start"] - base) / tfreq * 1000
+        dur_ms = stage["duration"] / tfreq * 1000
+        print(f"{stage['tag']:<10}{start_ms:>12.3f}{dur_ms:>15.3f}")
@@ -12,6 +12,8 @@ parser.add_argument('-c', '--call', action="store_true", help="Use call mode")
 parser.add_argument('-r', '--raw', action="store_true", help="Image is raw")
 parser.add_argument('-E', '--entry-point', action="store", type=int, help="Entry point for the raw image", default=0x800)
 parser.add_argument('-x', '--xnu', action="store_true", help="Set up for chainloading XNU")
+parser.add_argument('-u', '--usb-handoff', action="store_true",
+                    help="Ask the next m1n1 stage to adopt the live USB controllers")
 parser.add_argument('payload', type=pathlib.Path)
 parser.add_argument('boot_args', default=[], nargs="*")
 args = parser.parse_args()
@@ -35,6 +37,10 @@ else:
     entry -= macho.vmin
     entry += new_base
 
+if args.usb_handoff:
+    # Splice the variable in ahead of the zero terminator
+    image = image[:-4] + b"usb_handoff=1\n" + image[-4:]
+
 if args.quiet:
     p.iodev_set_usage(IODEV.FB, 0)
 
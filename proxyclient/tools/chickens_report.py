@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import argparse, json, struct
+
+parser = argparse.ArgumentParser(description='Dump per-core CPU init (chickens) timing')
+parser.add_argument('-j', '--json', action="store_true", help="Output JSON for diffing")
+args = parser.parse_args()
+
+from m1n1.setup import *
+
+CHICKEN_REPORT_MAGIC = 0x4e4b4843
+
+tfreq = u.mrs(CNTFRQ_EL0)
+
+addr = p.chickens_get()
+magic, num_cpus, ent_size, _ = struct.unpack("<4I", iface.readmem(addr, 16))
+assert magic == CHICKEN_REPORT_MAGIC
+
+cores = []
+data = iface.readmem(addr + 16, num_cpus * ent_size)
+for i in range(num_cpus):
+    part, rev, common, chickens, tail = struct.unpack_from("<IIQQQ", data, i * ent_size)
+    if not (common or chickens or tail):
+        continue
+    cores.append({
+        "cpu": i,
+        "part": part,
+        "rev": rev,
+        "common": common,
+        "chickens": chickens,
+        "tail": tail,
+    })
+
+if args.json:
+    print(json.dumps({"tfreq": tfreq, "cores": cores}, indent=2))
+else:
+    print(f"{'CPU':<5}{'Part':>6}{'Rev':>5}{'Common (us)':>13}{'Chickens (us)':>15}{'Tail (us)':>11}")
+    for core in cores:
+        common_us = core["common"] / tfreq * 1000000
+        chickens_us = core["chickens"] / tfreq * 1000000
+        tail_us = core["tail"] / tfreq * 1000000
+        print(f"{core['cpu']:<5}{core['part']:>#6x}{core['rev']:>#5x}"
+              f"{common_us:>13.1f}{chickens_us:>15.1f}{tail_us:>11.1f}")
@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import argparse, struct, time
+
+parser = argparse.ArgumentParser(description='Tail the m1n1 console ring via shared memory')
+parser.add_argument('-i', '--interval', type=float, default=0.05,
+                    help="Poll interval in seconds")
+args = parser.parse_args()
+
+from m1n1.setup import *
+
+CONSOLE_RING_MAGIC = 0x534e4f43
+
+addr = p.console_ring_get()
+magic, size, wptr = struct.unpack("<IIQ", iface.readmem(addr, 16))
+assert magic == CONSOLE_RING_MAGIC
+
+buf = addr + 16
+rptr = wptr
+
+try:
+    while True:
+        wptr = struct.unpack("<Q", iface.readmem(addr + 8, 8))[0]
+        if wptr == rptr:
+            time.sleep(args.interval)
+            continue
+
+        # The ring keeps the newest size bytes; if we fell behind, skip ahead
+        if wptr - rptr > size:
+            sys.stdout.write(f"\n<console_tail: lost {wptr - rptr - size} bytes>\n")
+            rptr = wptr - size
+
+        while rptr < wptr:
+            pos = rptr % size
+            block = min(wptr - rptr, size - pos)
+            data = iface.readmem(buf + pos, block)
+            sys.stdout.buffer.write(data)
+            rptr += block
+        sys.stdout.flush()
+except KeyboardInterrupt:
+    pass
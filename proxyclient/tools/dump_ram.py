@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import argparse, struct, time
+
+parser = argparse.ArgumentParser(description='Dump a RAM range via on-device LZ4 compression')
+parser.add_argument('base', type=lambda x: int(x, 0), help="Physical base address")
+parser.add_argument('size', type=lambda x: int(x, 0), help="Size in bytes")
+parser.add_argument('output', help="Output file (decompressed image)")
+parser.add_argument('-c', '--chunk', type=lambda x: int(x, 0), default=0x10000000,
+                    help="Per-request chunk size")
+args = parser.parse_args()
+
+from m1n1.setup import *
+from m1n1.utils import lz4_decompress
+
+RAMDUMP_MAGIC = 0x34504d44
+
+# Worst case per 32MB slice plus the header, rounded up generously
+dst_max = args.chunk + args.chunk // 128 + 0x10000
+dst = u.malloc(dst_max)
+
+total_comp = 0
+start = time.time()
+
+with open(args.output, "wb") as fd:
+    pos = args.base
+    end = args.base + args.size
+    while pos < end:
+        size = min(args.chunk, end - pos)
+
+        ret = p.dump_compressed(pos, size, dst, dst_max)
+        if ret < 0:
+            print("dump_compressed failed")
+            sys.exit(1)
+
+        magic, nslices = struct.unpack("<II", iface.readmem(dst, 8))
+        assert magic == RAMDUMP_MAGIC
+        slices = iface.readmem(dst + 8, nslices * 24)
+
+        for i in range(nslices):
+            raw_len, comp_len, offset = struct.unpack_from("<3Q", slices, i * 24)
+            if comp_len:
+                data = lz4_decompress(iface.readmem(dst + offset, comp_len), raw_len)
+                total_comp += comp_len
+            else:
+                data = iface.readmem(dst + offset, raw_len)
+                total_comp += raw_len
+            fd.write(data)
+
+        pos += size
+        done = pos - args.base
+        print(f"\r{done >> 20}/{args.size >> 20} MB "
+              f"(ratio {total_comp / done:.2f})", end="", flush=True)
+
+elapsed = time.time() - start
+print(f"\nDumped {args.size >> 20} MB in {elapsed:.1f}s "
+      f"({args.size / elapsed / (1 << 20):.1f} MB/s effective)")
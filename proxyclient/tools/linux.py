@@ -38,12 +38,14 @@ else:
 payload = args.payload.read_bytes()
 dtb = args.dtb.read_bytes()
 if args.initramfs is not None:
-    initramfs = args.initramfs.read_bytes()
-    initramfs_size = len(initramfs)
+    initramfs_size = args.initramfs.stat().st_size
 else:
-    initramfs = None
     initramfs_size = 0
 
+# Large initramfs images stream straight from the file to their final
+# location instead of being buffered and scanned on the host first
+INITRAMFS_STREAM_THRESHOLD = 128 * 1024 * 1024
+
 if args.bootargs is not None:
     print('Setting boot args: "{}"'.format(args.bootargs))
     p.kboot_set_chosen("bootargs", args.bootargs)
@@ -68,10 +70,15 @@ print("Kernel_base: 0x%x" % kernel_base)
 
 assert not (kernel_base & 0xffff)
 
-if initramfs is not None:
+if args.initramfs is not None:
     initramfs_base = u.memalign(65536, initramfs_size)
-    print("Loading %d initramfs bytes to 0x%x..." % (initramfs_size, initramfs_base))
-    iface.writemem(initramfs_base, initramfs, True)
+    if initramfs_size >= INITRAMFS_STREAM_THRESHOLD:
+        print("Streaming %d initramfs bytes to 0x%x..." % (initramfs_size, initramfs_base))
+        with args.initramfs.open("rb") as f:
+            iface.writemem_stream(initramfs_base, f, initramfs_size, progress=True)
+    else:
+        print("Loading %d initramfs bytes to 0x%x..." % (initramfs_size, initramfs_base))
+        u.sparse_writemem(initramfs_base, args.initramfs.read_bytes(), progress=True)
     p.kboot_set_initrd(initramfs_base, initramfs_size)
 
 
@@ -87,7 +94,7 @@ if args.u_boot:
     bootenv = str(bootenv_old, "ascii").split("\x00")
     bootenv = list(filter(lambda x: not (x.startswith("baudrate") or x.startswith("boot_") or x.startswith("distro_bootcmd")), bootenv))
 
-    if initramfs is not None:
+    if args.initramfs is not None:
         bootcmd = "distro_bootcmd=booti 0x%x 0x%x:0x%x $fdtcontroladdr" % (kernel_base, initramfs_base, initramfs_size)
     else:
         bootcmd = "distro_bootcmd=booti 0x%x - $fdtcontroladdr" % (kernel_base)
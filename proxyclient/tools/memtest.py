@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import argparse, struct
+
+parser = argparse.ArgumentParser(description='Run the m1n1 parallel DRAM test')
+parser.add_argument('base', type=lambda x: int(x, 0), help="Physical base address")
+parser.add_argument('size', type=lambda x: int(x, 0), help="Size in bytes")
+parser.add_argument('-p', '--passes', type=lambda x: int(x, 0), default=3,
+                    help="Pass mask: 1 = inversion patterns, 2 = address-in-address")
+parser.add_argument('-c', '--chunk', type=lambda x: int(x, 0), default=0x80000000,
+                    help="Per-request chunk size")
+args = parser.parse_args()
+
+from m1n1.setup import *
+
+MEMTEST_MAGIC = 0x5453544d
+PASS_NAMES = ["0xaa..", "0x55..", "addr"]
+
+tfreq = u.mrs(CNTFRQ_EL0)
+addr = p.memtest_get()
+
+total_errors = 0
+total_ticks = 0
+
+pos = args.base
+end = args.base + args.size
+while pos < end:
+    size = min(args.chunk, end - pos)
+    print(f"Testing 0x{pos:x}..0x{pos + size:x}...")
+
+    errors = p.memtest_run(pos, size, args.passes)
+    if errors < 0:
+        print("memtest_run failed (arguments must be 64-byte aligned)")
+        sys.exit(1)
+
+    magic, ent_size, max_errors, count, tested, elapsed = \
+        struct.unpack("<4IQQ", iface.readmem(addr, 32))
+    assert magic == MEMTEST_MAGIC
+
+    data = iface.readmem(addr + 64, count * ent_size)
+    for i in range(count):
+        eaddr, expected, actual, pass_id = struct.unpack_from("<4Q", data, i * ent_size)
+        name = PASS_NAMES[pass_id] if pass_id < len(PASS_NAMES) else str(pass_id)
+        print(f"  FAIL @0x{eaddr:x} ({name}): expected 0x{expected:016x}, "
+              f"got 0x{actual:016x} (bits 0x{expected ^ actual:016x})")
+
+    total_errors += errors
+    total_ticks += elapsed
+    pos += size
+
+secs = total_ticks / tfreq
+rate = args.size / secs / (1 << 30) if secs else 0
+print(f"{args.size >> 20} MB tested in {secs:.2f}s ({rate:.1f} GB/s): "
+      f"{total_errors} error(s)")
+if total_errors:
+    sys.exit(1)
@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import argparse, struct
+
+parser = argparse.ArgumentParser(
+    description="Dump the persistent console log ring (survives warm reboots)")
+parser.add_argument("--all", action="store_true",
+                    help="include output from the current m1n1 session")
+args = parser.parse_args()
+
+from m1n1.setup import *
+
+hdr = p.plog_get()
+if not hdr:
+    print("Persistent log not available")
+    sys.exit(1)
+
+magic, version, size, _, wptr, boot_wptr, crc, _ = struct.unpack(
+    "<IIIIQQII", iface.readmem(hdr, 40))
+
+data = iface.readmem(hdr + 40, size)
+
+end = wptr if args.all else boot_wptr
+start = max(0, wptr - size)
+if start > 0:
+    print(f"[{start} earlier bytes lost]", file=sys.stderr)
+
+out = bytearray()
+for pos in range(start, end):
+    out.append(data[pos % size])
+
+sys.stdout.write(out.decode("utf-8", "replace"))
@@ -0,0 +1,27 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import struct
+
+from m1n1.setup import *
+
+info = u.malloc(24)
+try:
+    if p.fb_scrollback(info) < 0:
+        print("No scrollback available (fb console not initialized)")
+        sys.exit(1)
+
+    addr, lines, line_len, max_lines = struct.unpack("<QIII", iface.readmem(info, 20))
+finally:
+    u.free(info)
+
+if lines > max_lines:
+    print(f"[{lines - max_lines} earlier lines lost]")
+
+first = max(0, lines - max_lines)
+data = iface.readmem(addr, max_lines * line_len)
+for n in range(first, lines):
+    off = (n % max_lines) * line_len
+    print(data[off:off + line_len].decode("ascii", "replace").rstrip())
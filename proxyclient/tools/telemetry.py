@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import argparse, json, struct, time
+
+parser = argparse.ArgumentParser(description='Poll the m1n1 telemetry page')
+parser.add_argument('-i', '--interval', type=float, default=1.0,
+                    help="Polling interval in seconds")
+parser.add_argument('-w', '--watch', action="store_true", help="Poll continuously")
+parser.add_argument('-j', '--json', action="store_true", help="Output JSON per sample")
+args = parser.parse_args()
+
+from m1n1.setup import *
+
+TELEMETRY_MAGIC = 0x4d4c4554
+
+FIELDS = [
+    "proxy_requests",
+    "heap_alloc_count", "heap_free_count", "heap_footprint",
+    "heap_used_bytes", "heap_free_bytes", "heap_largest_free",
+    "hv_exits", "hv_fast_exits", "hv_exit_cycles",
+    "samples", "sample_ticks",
+]
+PAGE_SIZE = 16 + 8 * len(FIELDS)
+
+addr = p.telemetry_get()
+
+def sample():
+    # seqlock: retry while a writer is mid-update or the page changed under us
+    while True:
+        data = iface.readmem(addr, PAGE_SIZE)
+        magic, version, seq, _ = struct.unpack_from("<4I", data)
+        assert magic == TELEMETRY_MAGIC
+        seq2 = struct.unpack("<I", iface.readmem(addr + 8, 4))[0]
+        if seq == seq2 and not seq & 1:
+            break
+    values = struct.unpack_from(f"<{len(FIELDS)}Q", data, 16)
+    return dict(zip(FIELDS, values))
+
+while True:
+    s = sample()
+    if args.json:
+        print(json.dumps(s))
+    else:
+        print(" ".join(f"{k}={v}" for k, v in s.items()))
+    if not args.watch:
+        break
+    time.sleep(args.interval)
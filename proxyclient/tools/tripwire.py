@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+import sys, pathlib
+sys.path.append(str(pathlib.Path(__file__).resolve().parents[1]))
+
+import argparse, json, struct
+
+parser = argparse.ArgumentParser(description='Dump the m1n1 latency tripwire log')
+parser.add_argument('-j', '--json', action="store_true", help="Output JSON")
+args = parser.parse_args()
+
+from m1n1.setup import *
+
+TRIPWIRE_MAGIC = 0x50495254
+
+tfreq = u.mrs(CNTFRQ_EL0)
+
+addr = p.tripwire_get()
+magic, ent_size, max_hits, count = struct.unpack("<4I", iface.readmem(addr, 16))
+assert magic == TRIPWIRE_MAGIC
+
+hits = []
+data = iface.readmem(addr + 16, min(count, max_hits) * ent_size)
+for i in range(min(count, max_hits)):
+    tag, start, duration, caller = struct.unpack_from("<8sQQQ", data, i * ent_size)
+    hits.append({
+        "tag": tag.rstrip(b"\0").decode(),
+        "start": start,
+        "duration": duration,
+        "caller": caller,
+    })
+
+# The ring keeps the newest max_hits entries; put them in arrival order
+if count > max_hits:
+    pos = count % max_hits
+    hits = hits[pos:] + hits[:pos]
+
+if args.json:
+    print(json.dumps({"tfreq": tfreq, "total": count, "hits": hits}, indent=2))
+else:
+    print(f"{count} hit(s) total")
+    print(f"{'Region':<10}{'Duration (us)':>15}  Caller")
+    for hit in hits:
+        dur_us = hit["duration"] / tfreq * 1000000
+        print(f"{hit['tag']:<10}{dur_us:>15.1f}  0x{hit['caller']:x}")
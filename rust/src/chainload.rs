@@ -39,22 +39,28 @@ fn load_image(spec: &str) -> Result<Vec<u8>, Error> {
     let uuid = Uuid::parse_str(args.next().ok_or(Error::BadArgs)?).or(Err(Error::BadArgs))?;
     let path = args.next().ok_or(Error::BadArgs)?;
 
-    let part = {
-        let storage = nvme::NVMEStorage::new(1, 0);
-        let mut pt = gpt::GPT::new(storage)?;
+    let mut storage = nvme::NVMEStorage::new(1, 0);
+    // GPT header at LBA 1 with the entry array right behind it: have the
+    // whole scan in flight before it starts.
+    storage.seed_readahead(1);
+    let mut pt = gpt::GPT::new(storage)?;
 
-        //println!("Partitions:");
-        //pt.dump();
+    //println!("Partitions:");
+    //pt.dump();
 
-        println!("Searching for partition UUID: {}", uuid);
-        pt.find_by_partuuid(uuid)?.ok_or(Error::PartitionNotFound)?
-    };
+    println!("Searching for partition UUID: {}", uuid);
+    let part = pt.find_by_partuuid(uuid)?.ok_or(Error::PartitionNotFound)?;
 
     let offset = part.get_starting_lba();
 
     println!("Partition offset: {}", offset);
 
-    let storage = nvme::NVMEStorage::new(1, offset);
+    let mut storage = nvme::NVMEStorage::new(1, offset);
+    // The boot sector and FAT metadata reads come next; get them queued
+    // while the GPT storage's leftover readahead drains.
+    storage.seed_readahead(0);
+    drop(pt);
+
     let opts = FsOptions::new().update_accessed_date(false);
 
     let fs = FileSystem::new(storage, opts)?;
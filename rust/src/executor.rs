@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: MIT
+
+//! Minimal polling executor for overlapping NVMe commands.
+//!
+//! The NVMe completion queue is polled, not interrupt-driven, so wakers have
+//! nothing to do: block_on() simply re-polls the future until it is ready,
+//! and every pending NVMe future checks its completion slot on each poll.
+//! That is all that is needed to keep several commands in flight across
+//! otherwise sequential boot phases; there is no spawning and no task queue.
+
+use core::future::Future;
+use core::pin::{pin, Pin};
+use core::task::{Context, Poll, RawWaker, RawWakerVTable, Waker};
+
+fn noop_raw_waker() -> RawWaker {
+    fn clone(_: *const ()) -> RawWaker {
+        noop_raw_waker()
+    }
+    fn noop(_: *const ()) {}
+    static VTABLE: RawWakerVTable = RawWakerVTable::new(clone, noop, noop, noop);
+    RawWaker::new(core::ptr::null(), &VTABLE)
+}
+
+/// Drive a future to completion by polling it in a tight loop.
+pub fn block_on<F: Future>(fut: F) -> F::Output {
+    let waker = unsafe { Waker::from_raw(noop_raw_waker()) };
+    let mut cx = Context::from_waker(&waker);
+    let mut fut = pin!(fut);
+    loop {
+        if let Poll::Ready(out) = fut.as_mut().poll(&mut cx) {
+            return out;
+        }
+    }
+}
+
+/// Run two futures concurrently and return both results. With NVMe futures
+/// this means both commands sit in the IO queue together instead of back to
+/// back.
+pub fn join<A: Future, B: Future>(a: A, b: B) -> Join<A, B> {
+    Join {
+        a,
+        b,
+        ra: None,
+        rb: None,
+    }
+}
+
+pub struct Join<A: Future, B: Future> {
+    a: A,
+    b: B,
+    ra: Option<A::Output>,
+    rb: Option<B::Output>,
+}
+
+impl<A: Future, B: Future> Future for Join<A, B> {
+    type Output = (A::Output, B::Output);
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Self::Output> {
+        // Safety: the fields are never moved out of the pinned struct; only
+        // the Option results are taken.
+        let this = unsafe { self.get_unchecked_mut() };
+        if this.ra.is_none() {
+            if let Poll::Ready(v) = unsafe { Pin::new_unchecked(&mut this.a) }.poll(cx) {
+                this.ra = Some(v);
+            }
+        }
+        if this.rb.is_none() {
+            if let Poll::Ready(v) = unsafe { Pin::new_unchecked(&mut this.b) }.poll(cx) {
+                this.rb = Some(v);
+            }
+        }
+        if this.ra.is_some() && this.rb.is_some() {
+            Poll::Ready((this.ra.take().unwrap(), this.rb.take().unwrap()))
+        } else {
+            Poll::Pending
+        }
+    }
+}
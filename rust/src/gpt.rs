@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: MIT
 
 use crate::println;
+use alloc::vec::Vec;
 use core::convert::TryInto;
 use core::result::Result;
 use fatfs::{Read, Seek};
@@ -64,6 +65,7 @@ impl TableHeader {
     }
 }
 
+#[derive(Clone)]
 pub struct PartitionEntry {
     bytes: [u8; Self::SIZE],
 }
@@ -101,9 +103,18 @@ impl PartitionEntry {
     }
 }
 
+// Entry with the GUIDs pre-decoded for lookups. Names stay as raw bytes in
+// the entry until someone calls get_name().
+struct CachedEntry {
+    type_guid: Uuid,
+    partition_guid: Uuid,
+    entry: PartitionEntry,
+}
+
 pub struct GPT<T: fatfs::ReadWriteSeek> {
     disk: T,
     hdr: TableHeader,
+    cache: Option<Vec<CachedEntry>>,
 }
 
 impl<IO: fatfs::ReadWriteSeek> GPT<IO> {
@@ -112,7 +123,11 @@ impl<IO: fatfs::ReadWriteSeek> GPT<IO> {
 
         let hdr = TableHeader::read(&mut disk, 1)?;
 
-        let gpt = Self { disk, hdr };
+        let gpt = Self {
+            disk,
+            hdr,
+            cache: None,
+        };
         Ok(gpt)
     }
 
@@ -120,23 +135,53 @@ impl<IO: fatfs::ReadWriteSeek> GPT<IO> {
         self.hdr.get_partition_entry_count()
     }
 
+    // Parse the whole entry array once; repeated lookups hit the cache
+    // instead of re-reading it from disk.
+    fn entries(&mut self) -> Result<&[CachedEntry], Error<IO::Error>> {
+        if self.cache.is_none() {
+            let count = self.count();
+            let mut entries = Vec::with_capacity(count);
+            for i in 0..count {
+                let off = (self.hdr.get_partition_entry_lba() as usize * SECTOR_SIZE)
+                    + i * self.hdr.get_partition_entry_size();
+                let entry = PartitionEntry::read(&mut self.disk, off)?;
+                entries.push(CachedEntry {
+                    type_guid: entry.get_type_guid(),
+                    partition_guid: entry.get_partition_guid(),
+                    entry,
+                });
+            }
+            self.cache = Some(entries);
+        }
+        Ok(self.cache.as_deref().unwrap())
+    }
+
     pub fn index(&mut self, index: usize) -> Result<PartitionEntry, Error<IO::Error>> {
-        let off = (self.hdr.get_partition_entry_lba() as usize * SECTOR_SIZE)
-            + index * self.hdr.get_partition_entry_size();
-        PartitionEntry::read(&mut self.disk, off)
+        Ok(self.entries()?[index].entry.clone())
     }
 
     pub fn find_by_partuuid(
         &mut self,
         uuid: Uuid,
     ) -> Result<Option<PartitionEntry>, Error<IO::Error>> {
-        for i in 0..self.count() {
-            let part = self.index(i)?;
-            if part.get_type_guid().is_nil() {
+        for ent in self.entries()? {
+            if ent.type_guid.is_nil() {
                 continue;
             }
-            if part.get_partition_guid() == uuid {
-                return Ok(Some(part));
+            if ent.partition_guid == uuid {
+                return Ok(Some(ent.entry.clone()));
+            }
+        }
+        Ok(None)
+    }
+
+    pub fn find_by_type_guid(
+        &mut self,
+        uuid: Uuid,
+    ) -> Result<Option<PartitionEntry>, Error<IO::Error>> {
+        for ent in self.entries()? {
+            if ent.type_guid == uuid {
+                return Ok(Some(ent.entry.clone()));
             }
         }
         Ok(None)
@@ -9,6 +9,7 @@ extern crate alloc;
 
 pub mod chainload;
 pub mod dlmalloc;
+pub mod executor;
 pub mod gpt;
 pub mod nvme;
 pub mod print;
@@ -1,16 +1,31 @@
 // SPDX-License-Identifier: MIT
+use crate::executor;
 use crate::println;
 use alloc::boxed::Box;
+use alloc::vec::Vec;
 use core::cmp::min;
 use core::ffi::c_void;
+use core::future::Future;
+use core::pin::Pin;
+use core::task::{Context, Poll};
 use fatfs::SeekFrom;
 
 extern "C" {
     fn nvme_read(nsid: u32, lba: u64, buffer: *mut c_void) -> bool;
+    fn nvme_read_async(nsid: u32, lba: u64, buffer: *mut c_void) -> i32;
+    fn nvme_poll_async(tag: i32) -> i32;
+    fn nvme_write_blocks(nsid: u32, lba: u64, count: u32, buffer: *mut c_void) -> bool;
+    fn nvme_flush(nsid: u32) -> bool;
 }
 
 const SECTOR_SIZE: usize = 4096;
 
+// Up to 256 KiB of contiguous writes are combined into one NVMe command
+const BATCH_SECTORS: usize = 64;
+
+// Sectors kept in flight ahead of a sequential reader
+const READAHEAD_DEPTH: usize = 8;
+
 pub type Error = ();
 
 #[repr(C, align(4096))]
@@ -22,12 +37,52 @@ fn alloc_sector_buf() -> Box<SectorBuffer> {
     p
 }
 
+#[repr(C, align(4096))]
+struct BatchBuffer([u8; SECTOR_SIZE * BATCH_SECTORS]);
+
+struct WriteBatch {
+    // Partition-relative LBA of the first sector in the buffer
+    start_lba: u64,
+    // High-water mark of valid bytes (written, or prefilled from disk)
+    valid: usize,
+    buf: Box<BatchBuffer>,
+}
+
+// A single in-flight sector read. Completion is discovered by polling the
+// NVMe completion queue; the executor's wakers are no-ops.
+struct AsyncRead {
+    tag: i32,
+}
+
+impl Future for AsyncRead {
+    type Output = bool;
+
+    fn poll(self: Pin<&mut Self>, _cx: &mut Context<'_>) -> Poll<bool> {
+        match unsafe { nvme_poll_async(self.tag) } {
+            0 => Poll::Pending,
+            1 => Poll::Ready(true),
+            _ => Poll::Ready(false),
+        }
+    }
+}
+
+struct Prefetch {
+    // Partition-relative LBA the in-flight command will fill
+    lba: u64,
+    fut: AsyncRead,
+    buf: Box<SectorBuffer>,
+}
+
 pub struct NVMEStorage {
     nsid: u32,
     offset: u64,
     lba: Option<u64>,
     buf: Box<SectorBuffer>,
     pos: u64,
+    batch: Option<WriteBatch>,
+    prefetch: Vec<Prefetch>,
+    spare: Vec<Box<SectorBuffer>>,
+    last_lba: Option<u64>,
 }
 
 impl NVMEStorage {
@@ -38,7 +93,147 @@ impl NVMEStorage {
             lba: None,
             buf: alloc_sector_buf(),
             pos: 0,
+            batch: None,
+            prefetch: Vec::new(),
+            spare: Vec::new(),
+            last_lba: None,
+        }
+    }
+
+    fn drain_prefetch(&mut self) {
+        while let Some(p) = self.prefetch.pop() {
+            executor::block_on(p.fut);
+            self.spare.push(p.buf);
+        }
+    }
+
+    // Keep up to READAHEAD_DEPTH sequential sectors in flight past `lba`
+    fn top_up_prefetch(&mut self, lba: u64) {
+        self.top_up_prefetch_from(lba + 1)
+    }
+
+    fn top_up_prefetch_from(&mut self, first: u64) {
+        let mut next = self.prefetch.last().map_or(first, |p| p.lba + 1);
+
+        while self.prefetch.len() < READAHEAD_DEPTH {
+            let mut buf = self.spare.pop().unwrap_or_else(alloc_sector_buf);
+            let tag = unsafe {
+                nvme_read_async(self.nsid, next + self.offset, buf.0.as_mut_ptr() as *mut c_void)
+            };
+            if tag < 0 {
+                self.spare.push(buf);
+                break;
+            }
+            self.prefetch.push(Prefetch {
+                lba: next,
+                fut: AsyncRead { tag },
+                buf,
+            });
+            next += 1;
+        }
+    }
+
+    // Seed the readahead queue starting at `lba` before a known access
+    // pattern begins (filesystem metadata at the head of a partition, the
+    // GPT header and entry array, ...), so even the first reads of a phase
+    // are served from commands already in flight.
+    pub fn seed_readahead(&mut self, lba: u64) {
+        self.top_up_prefetch_from(lba)
+    }
+
+    // Load `lba` into the sector cache, serving it from the readahead queue
+    // when possible. Sequential access keeps the IO queue full.
+    fn fill_sector(&mut self, lba: u64) -> Result<(), Error> {
+        let mut hit = false;
+
+        if let Some(i) = self.prefetch.iter().position(|p| p.lba == lba) {
+            let mut p = self.prefetch.remove(i);
+            let ok = executor::block_on(p.fut);
+            core::mem::swap(&mut self.buf, &mut p.buf);
+            self.spare.push(p.buf);
+            if !ok {
+                println!("nvme: prefetch of lba {} failed", lba + self.offset);
+                return Err(());
+            }
+            hit = true;
+        }
+
+        if !hit {
+            // A miss means the reader went elsewhere; in-flight sectors are
+            // stale, reclaim their buffers.
+            self.drain_prefetch();
+            self.read_sector(lba, self.buf.0.as_mut_ptr())?;
         }
+
+        self.lba = Some(lba);
+
+        if hit || self.last_lba.map_or(false, |l| l + 1 == lba) {
+            self.top_up_prefetch(lba);
+        }
+        self.last_lba = Some(lba);
+
+        Ok(())
+    }
+
+    fn read_sector(&mut self, lba: u64, buf: *mut u8) -> Result<(), Error> {
+        let lba = lba + self.offset;
+        if !unsafe { nvme_read(self.nsid, lba, buf as *mut c_void) } {
+            println!("nvme_read({}, {}) failed", self.nsid, lba);
+            return Err(());
+        }
+        Ok(())
+    }
+
+    // Write the accumulated batch out as a single NVMe command. This does
+    // not issue a device flush; fatfs::Write::flush() does.
+    fn commit_batch(&mut self) -> Result<(), Error> {
+        let Some(mut batch) = self.batch.take() else {
+            return Ok(());
+        };
+
+        // In-flight prefetches may cover sectors this write changes
+        self.drain_prefetch();
+
+        let sectors = batch.valid.div_ceil(SECTOR_SIZE);
+        let tail = batch.valid % SECTOR_SIZE;
+        if tail != 0 {
+            // Preserve the rest of the last sector (read-modify-write)
+            let tail_lba = batch.start_lba + (sectors - 1) as u64;
+            let scratch = self.buf.0.as_mut_ptr();
+            self.read_sector(tail_lba, scratch)?;
+            self.lba = None;
+            let off = (sectors - 1) * SECTOR_SIZE;
+            batch.buf.0[off + tail..off + SECTOR_SIZE]
+                .copy_from_slice(&self.buf.0[tail..SECTOR_SIZE]);
+        }
+
+        let lba = batch.start_lba + self.offset;
+        if !unsafe {
+            nvme_write_blocks(
+                self.nsid,
+                lba,
+                sectors as u32,
+                batch.buf.0.as_mut_ptr() as *mut c_void,
+            )
+        } {
+            println!("nvme_write_blocks({}, {}, {}) failed", self.nsid, lba, sectors);
+            return Err(());
+        }
+
+        // Invalidate the read cache if it overlaps the written range
+        if let Some(cached) = self.lba {
+            if cached >= batch.start_lba && cached < batch.start_lba + sectors as u64 {
+                self.lba = None;
+            }
+        }
+        Ok(())
+    }
+}
+
+impl Drop for NVMEStorage {
+    fn drop(&mut self) {
+        // Commands must not stay in flight against freed buffers
+        self.drain_prefetch();
     }
 }
 
@@ -50,17 +245,15 @@ impl fatfs::Read for NVMEStorage {
     fn read(&mut self, mut buf: &mut [u8]) -> Result<usize, Self::Error> {
         let mut read = 0;
 
+        // Batched writes must hit the medium before we read through it
+        self.commit_batch()?;
+
         while !buf.is_empty() {
             let lba = self.pos / SECTOR_SIZE as u64;
             let off = self.pos as usize % SECTOR_SIZE;
 
             if Some(lba) != self.lba {
-                self.lba = Some(lba);
-                let lba = lba + self.offset;
-                if !unsafe { nvme_read(self.nsid, lba, self.buf.0.as_mut_ptr() as *mut c_void) } {
-                    println!("nvme_read({}, {}) failed", self.nsid, lba);
-                    return Err(());
-                }
+                self.fill_sector(lba)?;
             }
             let copy_len = min(SECTOR_SIZE - off, buf.len());
             buf[..copy_len].copy_from_slice(&self.buf.0[off..off + copy_len]);
@@ -73,11 +266,56 @@ impl fatfs::Read for NVMEStorage {
 }
 
 impl fatfs::Write for NVMEStorage {
-    fn write(&mut self, _buf: &[u8]) -> Result<usize, Self::Error> {
-        Err(())
+    fn write(&mut self, mut buf: &[u8]) -> Result<usize, Self::Error> {
+        let written = buf.len();
+
+        while !buf.is_empty() {
+            // Writes that extend or overwrite the current batch are merged;
+            // anything discontiguous commits the batch and starts a new one.
+            if let Some(batch) = &self.batch {
+                let base = batch.start_lba * SECTOR_SIZE as u64;
+                let cap = (SECTOR_SIZE * BATCH_SECTORS) as u64;
+                if self.pos < base || self.pos > base + batch.valid as u64
+                    || self.pos >= base + cap
+                {
+                    self.commit_batch()?;
+                }
+            }
+
+            if self.batch.is_none() {
+                let start_lba = self.pos / SECTOR_SIZE as u64;
+                let off = self.pos as usize % SECTOR_SIZE;
+                let mut batch = WriteBatch {
+                    start_lba,
+                    valid: 0,
+                    buf: unsafe { Box::new_zeroed().assume_init() },
+                };
+                if off != 0 {
+                    // Preserve the start of the first sector
+                    self.read_sector(start_lba, batch.buf.0.as_mut_ptr())?;
+                    batch.valid = off;
+                }
+                self.batch = Some(batch);
+            }
+
+            let batch = self.batch.as_mut().unwrap();
+            let dst = (self.pos - batch.start_lba * SECTOR_SIZE as u64) as usize;
+            let copy_len = min(SECTOR_SIZE * BATCH_SECTORS - dst, buf.len());
+            batch.buf.0[dst..dst + copy_len].copy_from_slice(&buf[..copy_len]);
+            batch.valid = batch.valid.max(dst + copy_len);
+            buf = &buf[copy_len..];
+            self.pos += copy_len as u64;
+        }
+        Ok(written)
     }
+
     fn flush(&mut self) -> Result<(), Self::Error> {
-        Err(())
+        self.commit_batch()?;
+        if !unsafe { nvme_flush(self.nsid) } {
+            println!("nvme_flush({}) failed", self.nsid);
+            return Err(());
+        }
+        Ok(())
     }
 }
 
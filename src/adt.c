@@ -55,6 +55,39 @@ int adt_check_header(const void *adt)
     return _adt_check_node_offset(adt, 0);
 }
 
+/*
+ * The ADT is effectively immutable (adt_setprop() only patches values in
+ * place), so repeated lookups can be served out of a small direct-mapped cache
+ * keyed by (tree, node offset, name hash). Hits are verified against the
+ * actual name, so a collision only costs falling back to the linear scan.
+ */
+#define ADT_CACHE_SIZE 256
+
+struct adt_cache_entry {
+    const void *adt;
+    u32 hash;
+    int offset;
+    int value;
+};
+
+static struct adt_cache_entry adt_prop_cache[ADT_CACHE_SIZE];
+static struct adt_cache_entry adt_node_cache[ADT_CACHE_SIZE];
+
+static u32 _adt_name_hash(const char *name, size_t len)
+{
+    u32 hash = 0x811c9dc5;
+
+    while (len--)
+        hash = (hash ^ (u8)*name++) * 0x01000193;
+
+    return hash ? hash : 1;
+}
+
+static struct adt_cache_entry *_adt_cache_slot(struct adt_cache_entry *cache, int offset, u32 hash)
+{
+    return &cache[(hash ^ (u32)offset) % ADT_CACHE_SIZE];
+}
+
 static int _adt_string_eq(const char *a, const char *b, size_t len)
 {
     return (strlen(a) == len) && (memcmp(a, b, len) == 0);
@@ -78,16 +111,146 @@ const struct adt_property *adt_get_property_namelen(const void *adt, int offset,
 {
     dprintf("adt_get_property_namelen(%p, %d, \"%s\", %u)\n", adt, offset, name, namelen);
 
+    u32 hash = _adt_name_hash(name, namelen);
+    struct adt_cache_entry *ent = _adt_cache_slot(adt_prop_cache, offset, hash);
+
+    if (ent->adt == adt && ent->offset == offset && ent->hash == hash) {
+        const struct adt_property *prop = ADT_PROP(adt, ent->value);
+        if (_adt_string_eq(prop->name, name, namelen))
+            return prop;
+    }
+
     ADT_FOREACH_PROPERTY(adt, offset, prop)
     {
         dprintf(" off=0x%x name=\"%s\"\n", offset, prop->name);
-        if (_adt_string_eq(prop->name, name, namelen))
+        if (_adt_string_eq(prop->name, name, namelen)) {
+            ent->adt = adt;
+            ent->hash = hash;
+            ent->offset = offset;
+            ent->value = (int)((const u8 *)prop - (const u8 *)adt);
             return prop;
+        }
     }
 
     return NULL;
 }
 
+/* Named lookups performed, for the kboot DT prep self-profile */
+u64 adt_lookup_count;
+
+/*
+ * Flattened node index (see adt.h). Static storage so it works before the
+ * heap is up; if the tree is too large or too deep, the index is marked
+ * unusable and everything falls back to the blob walks.
+ */
+#define ADT_INDEX_MAX   4096
+#define ADT_INDEX_DEPTH 16
+
+static struct adt_index_ent adt_index[ADT_INDEX_MAX];
+static int adt_index_count; // 0 = not built, -1 = unusable
+static const void *adt_index_tree;
+
+u32 adt_name_hash(const char *name, size_t len)
+{
+    return _adt_name_hash(name, len);
+}
+
+static int adt_index_build(const void *adt)
+{
+    struct {
+        int parent;
+        u32 remaining;
+    } stack[ADT_INDEX_DEPTH];
+
+    if (adt_check_header(adt))
+        return -ADT_ERR_BADOFFSET;
+
+    int sp = 0;
+    int offset = 0;
+    int count = 0;
+
+    stack[0].parent = -1;
+    stack[0].remaining = 1;
+
+    while (sp >= 0) {
+        if (count == ADT_INDEX_MAX)
+            return -ADT_ERR_BADLENGTH;
+
+        const struct adt_node_hdr *node = ADT_NODE(adt, offset);
+        const char *name = adt_get_name(adt, offset);
+
+        struct adt_index_ent *ent = &adt_index[count];
+        ent->offset = offset;
+        ent->parent = stack[sp].parent;
+        ent->depth = sp;
+        ent->_pad = 0;
+
+        /* Hash the name up to any @unit-address, since lookups may omit it */
+        if (name) {
+            const char *at = memchr(name, '@', strlen(name));
+            ent->name_hash = _adt_name_hash(name, at ? (size_t)(at - name) : strlen(name));
+        } else {
+            ent->name_hash = 0;
+        }
+
+        stack[sp].remaining--;
+
+        /* In the pre-order blob layout, the next node always follows the
+         * current node's properties */
+        int next = adt_first_child_offset(adt, offset);
+
+        if (node->child_count) {
+            if (sp == ADT_INDEX_DEPTH - 1)
+                return -ADT_ERR_BADOFFSET;
+            sp++;
+            stack[sp].parent = count;
+            stack[sp].remaining = node->child_count;
+        } else {
+            while (sp >= 0 && !stack[sp].remaining)
+                sp--;
+        }
+
+        offset = next;
+        count++;
+    }
+
+    return count;
+}
+
+const struct adt_index_ent *adt_index_get(const void *adt, int *count)
+{
+    if (adt_index_tree != adt) {
+        adt_index_tree = adt;
+        adt_index_count = adt_index_build(adt);
+    }
+
+    if (adt_index_count <= 0)
+        return NULL;
+
+    if (count)
+        *count = adt_index_count;
+    return adt_index;
+}
+
+/* Binary search the index (sorted by offset) for a node offset */
+static int adt_index_find(int offset)
+{
+    int lo = 0, hi = adt_index_count;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (adt_index[mid].offset < offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo < adt_index_count && adt_index[lo].offset == offset)
+        return lo;
+
+    return -1;
+}
+
 const struct adt_property *adt_get_property(const void *adt, int nodeoffset, const char *name)
 {
     return adt_get_property_namelen(adt, nodeoffset, name, strlen(name));
@@ -98,6 +261,7 @@ const void *adt_getprop_namelen(const void *adt, int nodeoffset, const char *nam
 {
     const struct adt_property *prop;
 
+    adt_lookup_count++;
     prop = adt_get_property_namelen(adt, nodeoffset, name, namelen);
 
     if (!prop)
@@ -191,12 +355,56 @@ int adt_subnode_offset_namelen(const void *adt, int offset, const char *name, si
 {
     ADT_CHECK_HEADER(adt);
 
+    adt_lookup_count++;
+
+    u32 hash = _adt_name_hash(name, namelen);
+    int parent = offset;
+    struct adt_cache_entry *ent = _adt_cache_slot(adt_node_cache, parent, hash);
+
+    if (ent->adt == adt && ent->offset == parent && ent->hash == hash) {
+        const char *cname = adt_get_name(adt, ent->value);
+        if (cname && _adt_nodename_eq(cname, name, namelen))
+            return ent->value;
+    }
+
+    /*
+     * Try the flattened index: scan the parent's subtree entries (contiguous
+     * in the array) for a child with a matching name hash. A miss falls
+     * through to the blob walk, so a stale or overflowed index cannot cause
+     * a wrong NOTFOUND.
+     */
+    int icount;
+    const struct adt_index_ent *index = adt_index_get(adt, &icount);
+    if (index) {
+        int pidx = adt_index_find(parent);
+        const char *at = memchr(name, '@', namelen);
+        u32 bhash = _adt_name_hash(name, at ? (size_t)(at - name) : namelen);
+
+        for (int i = pidx + 1; pidx >= 0 && i < icount && index[i].depth > index[pidx].depth; i++) {
+            if (index[i].parent != pidx || index[i].name_hash != bhash)
+                continue;
+            const char *cname = adt_get_name(adt, index[i].offset);
+            if (cname && _adt_nodename_eq(cname, name, namelen)) {
+                ent->adt = adt;
+                ent->hash = hash;
+                ent->offset = parent;
+                ent->value = index[i].offset;
+                return index[i].offset;
+            }
+        }
+    }
+
     ADT_FOREACH_CHILD(adt, offset)
     {
         const char *cname = adt_get_name(adt, offset);
 
-        if (_adt_nodename_eq(cname, name, namelen))
+        if (_adt_nodename_eq(cname, name, namelen)) {
+            ent->adt = adt;
+            ent->hash = hash;
+            ent->offset = parent;
+            ent->value = offset;
             return offset;
+        }
     }
 
     return -ADT_ERR_NOTFOUND;
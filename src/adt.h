@@ -19,6 +19,9 @@
 
 extern void *adt;
 
+/* Named node/property lookups performed, for the kboot DT prep self-profile */
+extern u64 adt_lookup_count;
+
 struct adt_property {
     char name[32];
     u32 size;
@@ -94,6 +97,27 @@ int adt_getprop_copy(const void *adt, int nodeoffset, const char *name, void *ou
 int adt_get_reg(const void *adt, int *path, const char *prop, int idx, u64 *addr, u64 *size);
 bool adt_is_compatible(const void *adt, int nodeoffset, const char *compat);
 
+/*
+ * Flattened node index: one linear pre-order pass over the blob produces an
+ * array of (offset, parent, depth, name hash) entries, sorted by offset.
+ * Whole-tree consumers can scan this array instead of pointer-chasing the
+ * blob with adt_first_child_offset()/adt_next_sibling_offset(), and child
+ * lookups become a forward scan of contiguous entries. The index is built
+ * lazily and is purely an accelerator: lookups that miss fall back to the
+ * blob walk, so a stale index (e.g. after the host pushes a new ADT) only
+ * costs the fallback.
+ */
+struct adt_index_ent {
+    int offset;
+    int parent; // index into the array, -1 for the root
+    u16 depth;
+    u16 _pad;
+    u32 name_hash;
+};
+
+u32 adt_name_hash(const char *name, size_t len);
+const struct adt_index_ent *adt_index_get(const void *adt, int *count);
+
 #define ADT_FOREACH_CHILD(adt, node)                                                               \
     for (int _child_count = adt_get_child_count(adt, node); _child_count; _child_count = 0)        \
         for (node = adt_first_child_offset(adt, node); _child_count--;                             \
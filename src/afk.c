@@ -3,6 +3,7 @@
 #include "afk.h"
 #include "assert.h"
 #include "malloc.h"
+#include "pool.h"
 #include "string.h"
 #include "utils.h"
 
@@ -106,6 +107,9 @@ struct afk_epic_ep {
     bool started;
     u16 seq;
 
+    u32 tx_batch;
+    bool tx_pending;
+
     u32 num_channels;
 
     const afk_epic_service_ops_t *ops;
@@ -232,6 +236,17 @@ static int afk_epic_poll(afk_epic_t *afk, int endpoint, bool block)
                 return -1;
 
             if (epic->rx.ready && epic->tx.ready) {
+                /*
+                 * Reserve message wrappers from the negotiated ring size now:
+                 * the std-service path allocates a reply and a TX wrapper per
+                 * message, and growing the pools mid-burst during a DCP
+                 * display reconfiguration is exactly when we can least afford
+                 * a trip into heapblock. Oversized messages still grow the
+                 * larger classes on demand.
+                 */
+                u32 depth = epic->rx.bufsz >> BLOCK_SHIFT;
+                pool_alloc_reserve(SZ_2K, 2 * min(depth, 16u));
+
                 msg.msg = FIELD_PREP(RBEP_TYPE, RBEP_START);
                 if (!rtkit_send(epic->afk->rtk, &msg)) {
                     printf("EPIC: failed to send start\n");
@@ -294,6 +309,21 @@ static int afk_epic_rx(afk_epic_ep_t *epic, struct afk_qe **qe)
     return 1;
 }
 
+static int afk_epic_send_wptr(afk_epic_ep_t *epic, u32 wptr)
+{
+    struct rtkit_message msg = {
+        epic->ep,
+        FIELD_PREP(RBEP_TYPE, RBEP_SEND) | FIELD_PREP(SEND_WPTR, wptr),
+    };
+
+    if (!rtkit_send(epic->afk->rtk, &msg)) {
+        printf("EPIC: failed to send TX WPTR message\n");
+        return -1;
+    }
+
+    return 1;
+}
+
 static int afk_epic_tx(afk_epic_ep_t *epic, u32 channel, u32 type, void *data, size_t size)
 {
     struct afk_rb *rb = &epic->tx;
@@ -337,17 +367,13 @@ static int afk_epic_tx(afk_epic_ep_t *epic, u32 channel, u32 type, void *data, s
     rb->hdr->wptr = wptr;
     dma_wmb();
 
-    struct rtkit_message msg = {
-        epic->ep,
-        FIELD_PREP(RBEP_TYPE, RBEP_SEND) | FIELD_PREP(SEND_WPTR, wptr),
-    };
-
-    if (!rtkit_send(epic->afk->rtk, &msg)) {
-        printf("EPIC: failed to send TX WPTR message\n");
-        return -1;
+    /* Inside a batch, queue entries and ring the doorbell once at the end */
+    if (epic->tx_batch) {
+        epic->tx_pending = true;
+        return 1;
     }
 
-    return 1;
+    return afk_epic_send_wptr(epic, wptr);
 
 buffer_full:
     printf("EPIC: TX ring buffer is full\n");
@@ -373,6 +399,27 @@ static void afk_epic_rx_ack(afk_epic_ep_t *epic)
     rb->hdr->rptr = rptr;
 }
 
+/*
+ * Doorbell batching: the IOP consumes every queued entry up to WPTR on a
+ * single doorbell, so a burst of messages only needs one mailbox send for the
+ * final WPTR. Batches nest; the doorbell fires when the outermost one ends.
+ */
+void afk_epic_tx_batch_begin(afk_epic_ep_t *epic)
+{
+    epic->tx_batch++;
+}
+
+int afk_epic_tx_batch_end(afk_epic_ep_t *epic)
+{
+    assert(epic->tx_batch);
+
+    if (--epic->tx_batch || !epic->tx_pending)
+        return 0;
+
+    epic->tx_pending = false;
+    return afk_epic_send_wptr(epic, epic->tx.hdr->wptr);
+}
+
 int afk_epic_work(afk_epic_t *afk, int endpoint)
 {
     int i = 0;
@@ -449,21 +496,27 @@ static int afk_epic_handle_std_service(afk_epic_ep_t *epic, int channel, u8 cate
 
         if (!service->ops->call)
             return 0;
-        reply = calloc(payload_size, 1);
+        reply = pool_alloc(payload_size);
         if (!reply)
             return -1;
+        memset(reply, 0, payload_size);
 
         ret = service->ops->call(service, call->type, payload + sizeof(*call), call_size,
                                  reply + sizeof(*call), call_size);
         if (ret) {
-            free(reply);
+            pool_free(reply);
             return ret;
         }
 
         memcpy(reply, call, sizeof(*call));
 
         size_t tx_size = sizeof(struct epic_hdr) + sizeof(struct epic_sub_hdr) + payload_size;
-        void *msg = calloc(tx_size, 1);
+        void *msg = pool_alloc(tx_size);
+        if (!msg) {
+            pool_free(reply);
+            return -1;
+        }
+        memset(msg, 0, tx_size);
 
         struct epic_hdr *hdr = msg;
         struct epic_sub_hdr *sub = msg + sizeof(struct epic_hdr);
@@ -482,8 +535,8 @@ static int afk_epic_handle_std_service(afk_epic_ep_t *epic, int channel, u8 cate
         memcpy(msg + sizeof(struct epic_hdr) + sizeof(struct epic_sub_hdr), reply, payload_size);
 
         afk_epic_tx(epic, channel, TYPE_NOTIFY_ACK, msg, tx_size);
-        free(reply);
-        free(msg);
+        pool_free(reply);
+        pool_free(msg);
 
         return 0;
     }
@@ -493,8 +546,51 @@ static int afk_epic_handle_std_service(afk_epic_ep_t *epic, int channel, u8 cate
     return -1;
 }
 
-int afk_epic_command(afk_epic_ep_t *epic, int channel, u16 sub_type, void *txbuf, size_t txsize,
-                     void *rxbuf, size_t *rxsize)
+struct afk_stats afk_stats = {
+    .magic = AFK_STATS_MAGIC,
+    .num_slots = AFK_STATS_SLOTS,
+    .ent_size = sizeof(struct afk_call_stat),
+};
+
+static void afk_stats_record(u32 ep, u32 type, u64 ticks, bool error)
+{
+    struct afk_call_stat *st = NULL;
+
+    for (u32 i = 0; i < AFK_STATS_SLOTS; i++) {
+        if (!afk_stats.slot[i].calls || (afk_stats.slot[i].ep == ep && afk_stats.slot[i].type == type)) {
+            st = &afk_stats.slot[i];
+            break;
+        }
+    }
+
+    if (!st) {
+        afk_stats.dropped++;
+        return;
+    }
+
+    if (!st->calls) {
+        st->ep = ep;
+        st->type = type;
+        st->min_ticks = ticks;
+    }
+
+    st->calls++;
+    if (error)
+        st->errors++;
+    st->total_ticks += ticks;
+    if (ticks < st->min_ticks)
+        st->min_ticks = ticks;
+    if (ticks > st->max_ticks)
+        st->max_ticks = ticks;
+
+    int bucket = ticks ? 63 - __builtin_clzll(ticks) : 0;
+    if (bucket >= AFK_STATS_BUCKETS)
+        bucket = AFK_STATS_BUCKETS - 1;
+    st->hist[bucket]++;
+}
+
+static int afk_epic_docommand(afk_epic_ep_t *epic, int channel, u16 sub_type, void *txbuf,
+                              size_t txsize, void *rxbuf, size_t *rxsize)
 {
     struct {
         struct epic_hdr hdr;
@@ -588,6 +684,16 @@ int afk_epic_command(afk_epic_ep_t *epic, int channel, u16 sub_type, void *txbuf
     return 0;
 }
 
+int afk_epic_command(afk_epic_ep_t *epic, int channel, u16 sub_type, void *txbuf, size_t txsize,
+                     void *rxbuf, size_t *rxsize)
+{
+    u64 start = get_ticks();
+    int ret = afk_epic_docommand(epic, channel, sub_type, txbuf, txsize, rxbuf, rxsize);
+
+    afk_stats_record(epic->ep, sub_type, get_ticks() - start, ret < 0);
+    return ret;
+}
+
 static void afk_epic_notify_handler(afk_epic_ep_t *epic)
 {
     struct afk_qe *rmsg;
@@ -725,8 +831,8 @@ int afk_epic_start_interface(afk_epic_ep_t *epic, void *intf, int expected, size
 
     while (!timeout_expired(timeout)) {
         s64 epic_unit = -1;
-        char *epic_name = NULL;
-        char *epic_class = NULL;
+        char epic_name[64] = "";
+        char epic_class[64] = "";
         const char *service_name = NULL;
 
         int ret = afk_epic_work(epic->afk, epic->ep);
@@ -777,7 +883,8 @@ int afk_epic_start_interface(afk_epic_ep_t *epic, void *intf, int expected, size
                 afk_epic_rx_ack(epic);
                 continue;
             }
-            ret = parse_epic_service_init(&ctx, &epic_name, &epic_class, &epic_unit);
+            ret = parse_epic_service_init(&ctx, epic_name, sizeof(epic_name), epic_class,
+                                          sizeof(epic_class), &epic_unit);
             if (ret) {
                 printf("AFK[ep:%02x]: failed to extract init props (len=%zu): %d\n", epic->ep,
                        props_size, ret);
@@ -809,8 +916,6 @@ int afk_epic_start_interface(afk_epic_ep_t *epic, void *intf, int expected, size
         ops->init(service, epic_name, service_name, epic_unit);
         dprintf("AFK[ep:%02x]: new service %s on channel %d\n", epic->ep, service_name,
                 msg->channel);
-        free(epic_name);
-        free(epic_class);
 
         afk_epic_rx_ack(epic);
         if (++services >= expected)
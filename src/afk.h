@@ -48,4 +48,40 @@ int afk_epic_start_interface(afk_epic_ep_t *epic, void *intf, int expected, size
 int afk_epic_command(afk_epic_ep_t *epic, int channel, u16 sub_type, void *txbuf, size_t txsize,
                      void *rxbuf, size_t *rxsize);
 
+/* Coalesce the TX WPTR doorbell across several queued messages */
+void afk_epic_tx_batch_begin(afk_epic_ep_t *epic);
+int afk_epic_tx_batch_end(afk_epic_ep_t *epic);
+
+/*
+ * Per-method EPIC command accounting, keyed by (endpoint, call type).
+ * Every afk_epic_command() round trip lands in a slot with call counts and
+ * a log2 latency histogram, so a display bring-up regression after a DCP
+ * firmware update can be pinned on the specific call that got slower.
+ * Exported raw via P_AFK_STATS_GET; times are CNTPCT ticks.
+ */
+#define AFK_STATS_MAGIC   0x534b4641 // 'AFKS'
+#define AFK_STATS_SLOTS   64
+#define AFK_STATS_BUCKETS 16
+
+struct afk_call_stat {
+    u32 ep;
+    u32 type;
+    u64 calls;
+    u64 errors;
+    u64 total_ticks;
+    u64 min_ticks;
+    u64 max_ticks;
+    u64 hist[AFK_STATS_BUCKETS]; // bucket i: latency in [2^i, 2^(i+1)) ticks
+};
+
+struct afk_stats {
+    u32 magic;
+    u32 num_slots;
+    u32 ent_size;
+    u32 dropped; // calls that found no free slot
+    struct afk_call_stat slot[AFK_STATS_SLOTS];
+};
+
+extern struct afk_stats afk_stats;
+
 #endif
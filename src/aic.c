@@ -91,8 +91,8 @@ static int aic2_init(int node)
             u8 target = ext_intr_config[i + 2];
             assert(die < aic->nr_die);
             assert(irq < aic->nr_irq);
-            mask32(aic->base + aic->regs.config + die * aic->die_stride + 4 * irq,
-                   AIC2_IRQ_CFG_TARGET, FIELD_PREP(AIC2_IRQ_CFG_TARGET, target));
+            upd32(aic->base + aic->regs.config + die * aic->die_stride + 4 * irq,
+                  FIELD_UPD(AIC2_IRQ_CFG_TARGET, target));
         }
     }
 
@@ -151,3 +151,62 @@ uint32_t aic_ack(void)
 {
     return read32(aic->base + aic->regs.event);
 }
+
+int aic_ack_batch(uint32_t *events, int max)
+{
+    int n = 0;
+
+    while (n < max) {
+        u32 evt = read32(aic->base + aic->regs.event);
+        if (!evt)
+            break;
+        events[n++] = evt;
+    }
+
+    return n;
+}
+
+// MASK_SET reads back the current mask state on both AIC1 and AIC2
+static u32 saved_mask[AIC_MAX_DIES][AIC_MAX_HW_NUM >> 5];
+static bool saved_mask_valid;
+
+void aic_mask_all(void)
+{
+    if (!aic)
+        return;
+
+    for (u32 die = 0; die < aic->nr_die; die++) {
+        for (u32 i = 0; i < aic->max_irq >> 5; i++) {
+            u64 off = die * aic->die_stride + 4 * i;
+            saved_mask[die][i] = read32(aic->base + aic->regs.mask_set + off);
+            write32(aic->base + aic->regs.mask_set + off, ~0u);
+        }
+    }
+
+    saved_mask_valid = true;
+}
+
+void aic_restore_mask(void)
+{
+    if (!aic || !saved_mask_valid)
+        return;
+
+    for (u32 die = 0; die < aic->nr_die; die++)
+        for (u32 i = 0; i < aic->max_irq >> 5; i++)
+            write32(aic->base + aic->regs.mask_clr + die * aic->die_stride + 4 * i,
+                    ~saved_mask[die][i]);
+
+    saved_mask_valid = false;
+}
+
+void aic_set_affinity(int irq, int cpu)
+{
+    u32 die = irq / aic->max_irq;
+    irq = irq % aic->max_irq;
+
+    if (aic->version == 1)
+        write32(aic->base + aic->regs.tgt_cpu + 4 * irq, BIT(cpu));
+    else
+        upd32(aic->base + aic->regs.config + die * aic->die_stride + 4 * irq,
+              FIELD_UPD(AIC2_IRQ_CFG_TARGET, cpu));
+}
@@ -36,5 +36,12 @@ extern struct aic *aic;
 void aic_init(void);
 void aic_set_sw(int irq, bool active);
 uint32_t aic_ack(void);
+/* Drain up to max pending events in one go; each slot is an AIC_EVENT word */
+int aic_ack_batch(uint32_t *events, int max);
+/* Route an IRQ to a specific AIC CPU target instead of the boot CPU */
+void aic_set_affinity(int irq, int cpu);
+/* Save the current mask state and mask every HW IRQ source / undo that */
+void aic_mask_all(void);
+void aic_restore_mask(void);
 
 #endif
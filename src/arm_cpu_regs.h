@@ -24,6 +24,10 @@
 #define CNTHCTL_EL0VCTEN BIT(1)
 #define CNTHCTL_EL0PCTEN BIT(0)
 
+#define CNTKCTL_EVNTI   GENMASK(7, 4)
+#define CNTKCTL_EVNTDIR BIT(3)
+#define CNTKCTL_EVNTEN  BIT(2)
+
 #define SYS_CNTV_CTL_EL0  sys_reg(3, 3, 14, 3, 1)
 #define SYS_CNTV_CTL_EL02 sys_reg(3, 5, 14, 3, 1)
 #define SYS_CNTP_CTL_EL0  sys_reg(3, 3, 14, 2, 1)
@@ -3,6 +3,7 @@
 #include "adt.h"
 #include "asc.h"
 #include "malloc.h"
+#include "tripwire.h"
 #include "utils.h"
 
 #define ASC_CPU_CONTROL       0x44
@@ -103,10 +104,28 @@ bool asc_recv(asc_dev_t *asc, struct asc_message *msg)
 bool asc_recv_timeout(asc_dev_t *asc, struct asc_message *msg, u32 delay_usec)
 {
     u64 timeout = timeout_calculate(delay_usec);
+
+    if (asc_recv(asc, msg))
+        return true;
+
+    /*
+     * Long waits for IOP replies (DCP/SMC operations take milliseconds) used
+     * to spin on the mailbox status register. Sleep in WFE between polls
+     * instead; the event stream bounds the wakeup latency.
+     */
+    enable_event_stream();
+
+    trip_arm("ascrecv", 1000);
+
     while (!timeout_expired(timeout)) {
-        if (asc_recv(asc, msg))
+        sysop("wfe");
+        if (asc_recv(asc, msg)) {
+            trip_disarm();
             return true;
+        }
     }
+
+    trip_disarm();
     return false;
 }
 
@@ -0,0 +1,152 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "bench.h"
+#include "adt.h"
+#include "aic.h"
+#include "cpufreq.h"
+#include "dart.h"
+#include "exception.h"
+#include "memory.h"
+#include "string.h"
+#include "utils.h"
+
+// Keep results observable so the compiler cannot elide the measured work
+static volatile u64 bench_sink;
+
+static u64 bench_memcpy(u32 iters, void *buf, size_t size)
+{
+    u8 *dst = buf;
+    u8 *src = dst + size / 2;
+
+    u64 start = mrs(CNTPCT_EL0);
+    for (u32 i = 0; i < iters; i++)
+        memcpy(dst, src, size / 2);
+    return mrs(CNTPCT_EL0) - start;
+}
+
+static u64 bench_memset(u32 iters, void *buf, size_t size)
+{
+    u64 start = mrs(CNTPCT_EL0);
+    for (u32 i = 0; i < iters; i++)
+        memset(buf, i & 0xff, size);
+    return mrs(CNTPCT_EL0) - start;
+}
+
+static u64 bench_cache_flush(u32 iters, void *buf, size_t size)
+{
+    u64 start = mrs(CNTPCT_EL0);
+    for (u32 i = 0; i < iters; i++)
+        dc_civac_range(buf, size);
+    return mrs(CNTPCT_EL0) - start;
+}
+
+static u64 bench_adt_lookup(u32 iters)
+{
+    u64 start = mrs(CNTPCT_EL0);
+    for (u32 i = 0; i < iters; i++)
+        bench_sink = adt_path_offset(adt, "/arm-io/uart0");
+    return mrs(CNTPCT_EL0) - start;
+}
+
+static u64 bench_exc_brk(u32 iters)
+{
+    enum exc_guard_t guard = exc_guard;
+    exc_guard = GUARD_SKIP | GUARD_SILENT;
+
+    u64 start = mrs(CNTPCT_EL0);
+    for (u32 i = 0; i < iters; i++)
+        sysop("brk #0");
+    u64 elapsed = mrs(CNTPCT_EL0) - start;
+
+    exc_guard = guard;
+    return elapsed;
+}
+
+static s64 bench_dart_map(u32 iters, dart_dev_t *dart, uintptr_t iova, void *buf)
+{
+    u64 start = mrs(CNTPCT_EL0);
+    for (u32 i = 0; i < iters; i++) {
+        if (dart_map(dart, iova, buf, SZ_16K) < 0)
+            return -1;
+        dart_unmap(dart, iova, SZ_16K);
+    }
+    return mrs(CNTPCT_EL0) - start;
+}
+
+/*
+ * DVFS decisions and stray device interrupts are the main sources of
+ * run-to-run variance for the benchmarks above. Quiesce mode pins every
+ * cluster to one P-state and masks all AIC sources for the duration of a
+ * measurement session. Secondary CPUs already park in WFE when idle, so no
+ * extra parking is needed.
+ */
+#define MAX_BENCH_CLUSTERS 8
+
+static struct {
+    bool active;
+    int num_clusters;
+    int pstate[MAX_BENCH_CLUSTERS];
+} quiesce;
+
+int bench_quiesce(u32 pstate)
+{
+    if (quiesce.active)
+        return -1;
+
+    if (pstate) {
+        int i;
+        for (i = 0; i < MAX_BENCH_CLUSTERS; i++) {
+            int cur = cpufreq_get_pstate(i);
+            if (cur < 0)
+                break;
+            quiesce.pstate[i] = cur;
+            if (cpufreq_set_pstate(i, pstate) < 0) {
+                while (i--)
+                    cpufreq_set_pstate(i, quiesce.pstate[i]);
+                return -1;
+            }
+        }
+        quiesce.num_clusters = i;
+    }
+
+    aic_mask_all();
+    quiesce.active = true;
+    return 0;
+}
+
+int bench_unquiesce(void)
+{
+    if (!quiesce.active)
+        return -1;
+
+    aic_restore_mask();
+
+    for (int i = 0; i < quiesce.num_clusters; i++)
+        cpufreq_set_pstate(i, quiesce.pstate[i]);
+    quiesce.num_clusters = 0;
+    quiesce.active = false;
+    return 0;
+}
+
+s64 bench_run(u32 id, u32 iters, u64 arg0, u64 arg1, u64 arg2)
+{
+    if (!iters)
+        return -1;
+
+    switch (id) {
+        case BENCH_MEMCPY:
+            return bench_memcpy(iters, (void *)arg0, arg1);
+        case BENCH_MEMSET:
+            return bench_memset(iters, (void *)arg0, arg1);
+        case BENCH_CACHE_FLUSH:
+            return bench_cache_flush(iters, (void *)arg0, arg1);
+        case BENCH_ADT_LOOKUP:
+            return bench_adt_lookup(iters);
+        case BENCH_EXC_BRK:
+            return bench_exc_brk(iters);
+        case BENCH_DART_MAP:
+            return bench_dart_map(iters, (dart_dev_t *)arg0, arg1, (void *)arg2);
+        default:
+            return -1;
+    }
+}
@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "types.h"
+
+/*
+ * On-device microbenchmarks, invoked via P_BENCH_RUN. Each benchmark runs
+ * the primitive `iters` times and returns the total elapsed CNTPCT ticks,
+ * so primitives can be compared in-situ across SoC generations.
+ */
+
+enum bench_id {
+    BENCH_MEMCPY = 0,    // arg0 = buffer, arg1 = size (copies size/2)
+    BENCH_MEMSET,        // arg0 = buffer, arg1 = size
+    BENCH_CACHE_FLUSH,   // arg0 = buffer, arg1 = size (dc civac by VA)
+    BENCH_ADT_LOOKUP,    // full-path ADT node lookup
+    BENCH_EXC_BRK,       // brk exception entry/return round trip
+    BENCH_DART_MAP,      // arg0 = dart_dev_t *, arg1 = iova, arg2 = buffer
+    BENCH_MAX,
+};
+
+s64 bench_run(u32 id, u32 iters, u64 arg0, u64 arg1, u64 arg2);
+
+/*
+ * Quiesce mode for low run-to-run variance: pins every CPU cluster to the
+ * given P-state and masks all AIC interrupt sources until bench_unquiesce().
+ * pstate == 0 leaves cluster frequencies untouched (mask-only).
+ */
+int bench_quiesce(u32 pstate);
+int bench_unquiesce(void);
+
+#endif
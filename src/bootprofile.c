@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "bootprofile.h"
+#include "string.h"
+#include "utils.h"
+
+struct boot_profile boot_profile = {
+    .magic = BOOTPROFILE_MAGIC,
+    .max_stages = BOOTPROFILE_MAX_STAGES,
+    .ent_size = sizeof(struct boot_stage),
+};
+
+void bootprofile_begin(const char *tag)
+{
+    if (boot_profile.count >= BOOTPROFILE_MAX_STAGES)
+        return;
+
+    struct boot_stage *stage = &boot_profile.stages[boot_profile.count];
+
+    memset(stage->tag, 0, sizeof(stage->tag));
+    strncpy(stage->tag, tag, sizeof(stage->tag) - 1);
+    stage->start = mrs(CNTPCT_EL0);
+    stage->duration = 0;
+
+    boot_profile.count++;
+}
+
+void bootprofile_end(const char *tag)
+{
+    // Close the most recent open stage with this tag. Stages a function
+    // bailed out of early keep duration = 0.
+    for (u32 i = boot_profile.count; i > 0; i--) {
+        struct boot_stage *stage = &boot_profile.stages[i - 1];
+
+        if (stage->duration || strncmp(stage->tag, tag, sizeof(stage->tag)))
+            continue;
+
+        stage->duration = mrs(CNTPCT_EL0) - stage->start;
+        return;
+    }
+}
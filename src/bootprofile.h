@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef BOOTPROFILE_H
+#define BOOTPROFILE_H
+
+#include "types.h"
+
+/*
+ * Coarse boot stage timing: a fixed array of {tag, start, duration} records
+ * for the expensive init stages, complementing the raw evtlog ring. The host
+ * grabs it via P_BOOT_PROFILE_GET and can diff profiles across builds by tag.
+ *
+ * Stages are only recorded on the boot CPU, so no locking is needed.
+ */
+
+#define BOOTPROFILE_MAGIC      0x464f5250 // 'PROF'
+#define BOOTPROFILE_MAX_STAGES 32
+
+struct boot_stage {
+    char tag[8];
+    u64 start;
+    u64 duration;
+};
+
+struct boot_profile {
+    u32 magic;
+    u32 max_stages;
+    u32 ent_size;
+    u32 count;
+    struct boot_stage stages[BOOTPROFILE_MAX_STAGES];
+};
+
+extern struct boot_profile boot_profile;
+
+void bootprofile_begin(const char *tag);
+void bootprofile_end(const char *tag);
+
+#endif
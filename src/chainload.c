@@ -4,9 +4,12 @@
 
 #include "chainload.h"
 #include "adt.h"
+#include "hash.h"
 #include "malloc.h"
+#include "measure.h"
 #include "memory.h"
 #include "nvme.h"
+#include "smp.h"
 #include "string.h"
 #include "types.h"
 #include "utils.h"
@@ -19,6 +22,59 @@ int rust_load_image(const char *spec, void **image, size_t *size);
 extern u8 _chainload_stub_start[];
 extern u8 _chainload_stub_end[];
 
+/*
+ * The image and SEPFW moves are multi-megabyte streaming copies we will never
+ * read back before rebooting into the new stage, so use non-temporal
+ * load/store pairs for the bulk and keep the cache for live data. Since the
+ * next stage has no way to tell a corrupted image from a good one, checksum
+ * the source and verify the copy before handing over; the CRC32 instructions
+ * make this far cheaper than the copy itself, and when a secondary core is
+ * up the source pass runs there, concurrently with the copy.
+ */
+static u64 chainload_crc32(u64 addr, u64 len)
+{
+    return crc32((void *)addr, len);
+}
+
+static int copy_stream(void *dst, const void *src, size_t size, const char *what)
+{
+    size_t bulk = size & ~(size_t)63;
+    u32 want = 0;
+    int crc_cpu = -1;
+
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++) {
+        if (cpu != boot_cpu_idx && smp_is_alive(cpu)) {
+            crc_cpu = cpu;
+            break;
+        }
+    }
+
+    /*
+     * Secondaries run with their caches off, so push the source to PoC
+     * before handing it over; the clean is much cheaper than serializing
+     * the whole CRC pass in front of the copy.
+     */
+    if (crc_cpu >= 0) {
+        dc_cvac_range((void *)src, size);
+        smp_call2(crc_cpu, chainload_crc32, (u64)src, size);
+    } else {
+        want = crc32(src, size);
+    }
+
+    memcpy_stnp(dst, (void *)src, bulk);
+    memcpy(dst + bulk, src + bulk, size - bulk);
+
+    if (crc_cpu >= 0)
+        want = smp_wait(crc_cpu);
+
+    if (crc32(dst, size) != want) {
+        printf("chainload: %s copy failed verification\n", what);
+        return -1;
+    }
+
+    return 0;
+}
+
 int chainload_image(void *image, size_t size, char **vars, size_t var_cnt)
 {
     u64 new_base = (u64)_base;
@@ -26,9 +82,17 @@ int chainload_image(void *image, size_t size, char **vars, size_t var_cnt)
 
     printf("chainload: Preparing image...\n");
 
+    /*
+     * Tell the next stage the USB controllers are being handed over live, so
+     * it can adopt them instead of power cycling the ports (which would force
+     * the host into a full cold re-enumeration and drop its proxy session).
+     */
+    static const char usb_handoff_var[] = "usb_handoff=1";
+
     // m1n1 variables
     for (size_t i = 0; i < var_cnt; i++)
         image_size += strlen(vars[i]) + 1;
+    image_size += sizeof(usb_handoff_var);
 
     // pad to end payload
     image_size += 4;
@@ -63,7 +127,13 @@ int chainload_image(void *image, size_t size, char **vars, size_t var_cnt)
     void *new_image = malloc(image_size + stub_size);
 
     // Copy m1n1
-    memcpy(new_image, image, size);
+    if (copy_stream(new_image, image, size, "image")) {
+        free(new_image);
+        return -1;
+    }
+
+    // Record the next stage's digest while we still have idle cores
+    measure_payload(image, size);
 
     // Add vars
     u8 *p = new_image + size;
@@ -75,11 +145,18 @@ int chainload_image(void *image, size_t size, char **vars, size_t var_cnt)
         p += len + 1;
     }
 
+    memcpy(p, usb_handoff_var, sizeof(usb_handoff_var) - 1);
+    p[sizeof(usb_handoff_var) - 1] = '\n';
+    p += sizeof(usb_handoff_var);
+
     // Add end padding
     memset(p, 0, 4);
 
     // Copy SEPFW
-    memcpy(new_image + sepfw_off, (void *)sepfw[0], sepfw[1]);
+    if (copy_stream(new_image + sepfw_off, (void *)sepfw[0], sepfw[1], "SEPFW")) {
+        free(new_image);
+        return -1;
+    }
 
     // Adjust ADT SEPFW address
     sepfw[0] = new_base + sepfw_off;
@@ -29,6 +29,12 @@
 #define MIDR_PART     GENMASK(15, 4)
 #define MIDR_REV_HIGH GENMASK(23, 20)
 
+struct chicken_report chicken_report = {
+    .magic = CHICKEN_REPORT_MAGIC,
+    .num_cpus = MAX_CPUS,
+    .ent_size = sizeof(struct chicken_timing),
+};
+
 void init_m1_icestorm(void);
 void init_t8103_firestorm(int rev);
 void init_t6000_firestorm(int rev);
@@ -46,6 +52,10 @@ const char *init_cpu(void)
 {
     const char *cpu = "Unknown";
 
+    int idx = smp_id();
+    struct chicken_timing *ct = &chicken_report.cpu[idx >= 0 && idx < MAX_CPUS ? idx : 0];
+    u64 t0 = get_ticks();
+
     msr(OSLAR_EL1, 0);
 
     /* This is performed unconditionally on all cores (necessary?) */
@@ -60,12 +70,18 @@ const char *init_cpu(void)
         reg_set(SYS_IMP_APL_HID14, HID14_ENABLE_NEX_POWER_GATING);
     }
 
+    ct->common_ticks = get_ticks() - t0;
+
     uint64_t midr = mrs(MIDR_EL1);
     int part = FIELD_GET(MIDR_PART, midr);
     int rev = (FIELD_GET(MIDR_REV_HIGH, midr) << 4) | FIELD_GET(MIDR_REV_LOW, midr);
 
     printf("  CPU part: 0x%x rev: 0x%x\n", part, rev);
 
+    ct->midr_part = part;
+    ct->midr_rev = rev;
+    u64 t1 = get_ticks();
+
     switch (part) {
         case MIDR_PART_T8103_FIRESTORM:
             cpu = "M1 Firestorm";
@@ -142,6 +158,9 @@ const char *init_cpu(void)
             break;
     }
 
+    ct->chicken_ticks = get_ticks() - t1;
+    u64 t2 = get_ticks();
+
     int core = mrs(MPIDR_EL1) & 0xff;
 
     // Unknown, related to SMP?
@@ -162,5 +181,7 @@ const char *init_cpu(void)
     /* Enable branch prediction state retention across ACC sleep */
     reg_mask(SYS_IMP_APL_ACC_CFG, ACC_CFG_BP_SLEEP_MASK, ACC_CFG_BP_SLEEP(3));
 
+    ct->tail_ticks = get_ticks() - t2;
+
     return cpu;
 }
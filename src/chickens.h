@@ -3,6 +3,36 @@
 #ifndef __CHICKENS_H__
 #define __CHICKENS_H__
 
+#include "smp.h"
+#include "types.h"
+
+/*
+ * Per-core timing of init_cpu(), captured with CNTPCT around each phase: the
+ * unconditional pre-chickens, the per-part chicken function, and the common
+ * SMP/power setup tail. Every core fills its own slot during bring-up; the
+ * host grabs the table via P_CHICKENS_REPORT and attributes bring-up latency
+ * per chicken group and SoC stepping offline.
+ */
+#define CHICKEN_REPORT_MAGIC 0x4e4b4843 // 'CHKN'
+
+struct chicken_timing {
+    u32 midr_part;
+    u32 midr_rev;
+    u64 common_ticks;
+    u64 chicken_ticks;
+    u64 tail_ticks;
+};
+
+struct chicken_report {
+    u32 magic;
+    u32 num_cpus;
+    u32 ent_size;
+    u32 reserved;
+    struct chicken_timing cpu[MAX_CPUS];
+};
+
+extern struct chicken_report chicken_report;
+
 const char *init_cpu(void);
 
 #endif
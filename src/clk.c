@@ -149,6 +149,13 @@ void clk_set_pdm_gates(void)
 
 void clk_init(void)
 {
+    static bool initialized = false;
+
+    /* The mux and gate setup sticks; skip it when a retried boot re-runs this */
+    if (initialized)
+        return;
+
     clk_set_mca_muxes();
     clk_set_pdm_gates();
+    initialized = true;
 }
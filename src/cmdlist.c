@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "cmdlist.h"
+#include "utils.h"
+
+s64 cmdlist_run(struct cmdlist_cmd *cmds, u32 count)
+{
+    if (!cmds || count > CMDLIST_MAX_CMDS)
+        return -1;
+
+    for (u32 i = 0; i < count; i++) {
+        struct cmdlist_cmd *cmd = &cmds[i];
+        u64 *a = cmd->args;
+
+        switch (cmd->op) {
+            case CL_END:
+                return i;
+            case CL_CALL: {
+                generic_func *f = (generic_func *)a[0];
+                cmd->result = f(a[1], a[2], a[3], a[4], 0);
+                break;
+            }
+            case CL_WRITE32:
+                write32(a[0], a[1]);
+                break;
+            case CL_WRITE64:
+                write64(a[0], a[1]);
+                break;
+            case CL_READ32:
+                cmd->result = read32(a[0]);
+                break;
+            case CL_READ64:
+                cmd->result = read64(a[0]);
+                break;
+            case CL_MASK32:
+                cmd->result = mask32(a[0], a[1], a[2]);
+                break;
+            case CL_MASK64:
+                cmd->result = mask64(a[0], a[1], a[2]);
+                break;
+            case CL_POLL32:
+                if (poll32(a[0], a[1], a[2], a[3]) < 0) {
+                    cmd->result = read32(a[0]);
+                    return i;
+                }
+                cmd->result = read32(a[0]);
+                break;
+            case CL_UDELAY:
+                udelay(a[0]);
+                break;
+            default:
+                return i;
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef CMDLIST_H
+#define CMDLIST_H
+
+#include "types.h"
+
+/*
+ * Device-side command lists. Multi-step hardware pokes scripted from the host
+ * (GPIO/PHY bring-up sequences) used to pay a proxy round trip per register
+ * access; a command list batches the whole sequence into one buffer that the
+ * device interprets at local speed. Results (return values, read data, the
+ * last polled value) are written back into the submitted buffer, so the host
+ * uploads the list, runs it with a single request, and reads it back.
+ *
+ * Runtime is bounded: the list length is capped, every poll carries its own
+ * timeout, and execution stops at the first failed command.
+ */
+#define CMDLIST_MAX_CMDS 1024
+
+enum cmdlist_op {
+    CL_END = 0,  // stop; always succeeds
+    CL_CALL,     // func, a0, a1, a2, a3; result = return value
+    CL_WRITE32,  // addr, val
+    CL_WRITE64,  // addr, val
+    CL_READ32,   // addr; result = value
+    CL_READ64,   // addr; result = value
+    CL_MASK32,   // addr, clear, set; result = new value
+    CL_MASK64,   // addr, clear, set; result = new value
+    CL_POLL32,   // addr, mask, target, timeout_us; result = last value; fails on timeout
+    CL_UDELAY,   // usec
+};
+
+struct cmdlist_cmd {
+    u32 op;
+    u32 flags; // reserved
+    u64 args[5];
+    u64 result;
+};
+
+/* Returns the number of commands run: == count means full success, less
+ * means the command at that index failed. Negative on invalid input. */
+s64 cmdlist_run(struct cmdlist_cmd *cmds, u32 count);
+
+#endif
@@ -432,7 +432,14 @@
 #define PMCR0_PMI_SHIFT   12
 #define PMCR0_CNT_MASK    (PMCR0_CNT_EN_MASK | (PMCR0_CNT_EN_MASK << PMCR0_PMI_SHIFT))
 
-#define SYS_IMP_APL_PMCR1 sys_reg(3, 1, 15, 1, 0)
+#define SYS_IMP_APL_PMCR1       sys_reg(3, 1, 15, 1, 0)
+#define PMCR1_COUNT_A32_EL0_0_7 GENMASK(7, 0)
+#define PMCR1_COUNT_A64_EL0_0_7 GENMASK(15, 8)
+#define PMCR1_COUNT_A64_EL1_0_7 GENMASK(23, 16)
+#define PMCR1_COUNT_A64_EL2_0_7 GENMASK(31, 24)
+#define PMCR1_COUNT_A64_EL0_8_9 GENMASK(41, 40)
+#define PMCR1_COUNT_A64_EL1_8_9 GENMASK(49, 48)
+#define PMCR1_COUNT_A64_EL2_8_9 GENMASK(57, 56)
 #define SYS_IMP_APL_PMCR2 sys_reg(3, 1, 15, 2, 0)
 #define SYS_IMP_APL_PMCR3 sys_reg(3, 1, 15, 3, 0)
 #define SYS_IMP_APL_PMCR4 sys_reg(3, 1, 15, 4, 0)
@@ -125,7 +125,7 @@ void cpufreq_fixup_cluster(const struct cluster_t *cluster)
     // firmwares it supported (don't touch anything newer, which includes newer devices).
     // Also clear the CLUSTER_PSTATE_DESIRED2 field since it doesn't seem to do anything, and isn't
     // used on newer chips.
-    if (os_firmware.version != V_UNKNOWN && os_firmware.version <= V13_3) {
+    if (fw_caps & FW_CAP_CLUSTER_PSTATE_FIXUP) {
         u64 bits = 0;
         switch (chip_id) {
             case T8103:
@@ -268,6 +268,40 @@ const struct feat_t *cpufreq_get_features(void)
     }
 }
 
+int cpufreq_set_pstate(unsigned int cluster, u32 pstate)
+{
+    const struct cluster_t *clusters = cpufreq_get_clusters();
+
+    if (!clusters)
+        return -1;
+
+    if (pstate & ~CLUSTER_PSTATE_DESIRED1) {
+        printf("cpufreq: P-State %d out of range\n", pstate);
+        return -1;
+    }
+
+    for (unsigned int i = 0; clusters[i].base; i++)
+        if (i == cluster)
+            return set_pstate(&clusters[i], pstate);
+
+    printf("cpufreq: Cluster %d out of range\n", cluster);
+    return -1;
+}
+
+int cpufreq_get_pstate(unsigned int cluster)
+{
+    const struct cluster_t *clusters = cpufreq_get_clusters();
+
+    if (!clusters)
+        return -1;
+
+    for (unsigned int i = 0; clusters[i].base; i++)
+        if (i == cluster)
+            return FIELD_GET(CLUSTER_PSTATE_DESIRED1, read64(clusters[i].base + CLUSTER_PSTATE));
+
+    return -1;
+}
+
 int cpufreq_init(void)
 {
     printf("cpufreq: Initializing clusters\n");
@@ -3,7 +3,11 @@
 #ifndef CPUFREQ_H
 #define CPUFREQ_H
 
+#include "types.h"
+
 int cpufreq_init(void);
+int cpufreq_set_pstate(unsigned int cluster, u32 pstate);
+int cpufreq_get_pstate(unsigned int cluster);
 void cpufreq_fixup(void);
 
 #endif
@@ -9,6 +9,41 @@
 #include "string.h"
 #include "utils.h"
 
+/*
+ * Reprogramming a DAPF means an ADT walk, a compatible match and a
+ * field-by-field decode per filter entry, and the proxy re-runs this when
+ * reconfiguring pass-through devices. The ADT never changes at runtime, so
+ * each instance's configuration is compiled into a flat write program on
+ * first use and replayed with a tight loop afterwards. The programs preserve
+ * the per-entry write order exactly.
+ */
+struct dapf_write {
+    u64 addr;
+    u64 val;
+    u8 width;
+};
+
+struct dapf_program {
+    char path[64];
+    int index;
+    bool pwr;
+    u32 n_writes;
+    struct dapf_write *writes;
+};
+
+#define DAPF_MAX_PROGRAMS 8
+
+static struct dapf_program dapf_programs[DAPF_MAX_PROGRAMS];
+static u32 dapf_n_programs;
+
+static struct dapf_write *dapf_emit(struct dapf_write *w, u64 addr, u64 val, u8 width)
+{
+    w->addr = addr;
+    w->val = val;
+    w->width = width;
+    return w + 1;
+}
+
 struct dapf_t8020_config {
     u64 start;
     u64 end;
@@ -19,7 +54,7 @@ struct dapf_t8020_config {
     u32 r4;
 } PACKED;
 
-static int dapf_init_t8020(const char *path, u64 base, int node)
+static int dapf_compile_t8020(const char *path, u64 base, int node, struct dapf_program *prog)
 {
     u32 length;
     const char *prop = "filter-data-instance-0";
@@ -32,13 +67,19 @@ static int dapf_init_t8020(const char *path, u64 base, int node)
 
     int count = length / sizeof(*config);
 
+    struct dapf_write *w = malloc(count * 4 * sizeof(*w));
+    if (!w)
+        return -1;
+    prog->writes = w;
+
     for (int i = 0; i < count; i++) {
-        write32(base + 0x04, config[i].r4);
-        write64(base + 0x08, config[i].start);
-        write64(base + 0x10, config[i].end);
-        write32(base + 0x00, (config[i].r0_hi << 4) | config[i].r0_lo);
+        w = dapf_emit(w, base + 0x04, config[i].r4, 4);
+        w = dapf_emit(w, base + 0x08, config[i].start, 8);
+        w = dapf_emit(w, base + 0x10, config[i].end, 8);
+        w = dapf_emit(w, base + 0x00, (config[i].r0_hi << 4) | config[i].r0_lo, 4);
         base += 0x40;
     }
+    prog->n_writes = w - prog->writes;
     return 0;
 }
 
@@ -55,7 +96,7 @@ struct dapf_t8110_config {
     u8 unk4;
 } PACKED;
 
-static int dapf_init_t8110(const char *path, u64 base, int node)
+static int dapf_compile_t8110(const char *path, u64 base, int node, struct dapf_program *prog)
 {
     u32 length;
     const char *prop = "dapf-instance-0";
@@ -73,57 +114,111 @@ static int dapf_init_t8110(const char *path, u64 base, int node)
 
     int count = length / sizeof(*config);
 
+    struct dapf_write *w = malloc(count * 5 * sizeof(*w));
+    if (!w)
+        return -1;
+    prog->writes = w;
+
     for (int i = 0; i < count; i++) {
-        write32(base + 0x04, config[i].r4);
-        write64(base + 0x08, config[i].start);
-        write64(base + 0x10, config[i].end);
-        write32(base + 0x00, (config[i].r0_hi << 4) | config[i].r0_lo);
-        write32(base + 0x20, config[i].r20);
+        w = dapf_emit(w, base + 0x04, config[i].r4, 4);
+        w = dapf_emit(w, base + 0x08, config[i].start, 8);
+        w = dapf_emit(w, base + 0x10, config[i].end, 8);
+        w = dapf_emit(w, base + 0x00, (config[i].r0_hi << 4) | config[i].r0_lo, 4);
+        w = dapf_emit(w, base + 0x20, config[i].r20, 4);
         base += 0x40;
     }
+    prog->n_writes = w - prog->writes;
     return 0;
 }
 
-int dapf_init(const char *path, int index)
+static void dapf_replay(const struct dapf_program *prog)
+{
+    const struct dapf_write *w = prog->writes;
+
+    for (u32 i = 0; i < prog->n_writes; i++, w++) {
+        if (w->width == 8)
+            write64(w->addr, w->val);
+        else
+            write32(w->addr, w->val);
+    }
+}
+
+static struct dapf_program *dapf_compile(const char *path, int index)
 {
+    struct dapf_program prog = {.index = index};
     int ret;
+
     int dart_path[8];
     int node = adt_path_offset_trace(adt, path, dart_path);
     if (node < 0) {
         printf("dapf: Error getting DAPF %s node.\n", path);
-        return -1;
+        return NULL;
     }
 
     u32 pwr;
-    if (!adt_getprop(adt, node, "clock-gates", &pwr))
-        pwr = 0;
-    if (pwr && (pmgr_adt_power_enable(path) < 0))
-        return -1;
+    prog.pwr = !!adt_getprop(adt, node, "clock-gates", &pwr);
 
     u64 base;
     if (adt_get_reg(adt, dart_path, "reg", index, &base, NULL) < 0) {
         printf("dapf: Error getting DAPF %s base address.\n", path);
-        return -1;
+        return NULL;
     }
 
     if (adt_is_compatible(adt, node, "dart,t8020")) {
-        ret = dapf_init_t8020(path, base, node);
+        ret = dapf_compile_t8020(path, base, node, &prog);
     } else if (adt_is_compatible(adt, node, "dart,t6000")) {
-        ret = dapf_init_t8020(path, base, node);
+        ret = dapf_compile_t8020(path, base, node, &prog);
     } else if (adt_is_compatible(adt, node, "dart,t8110")) {
-        ret = dapf_init_t8110(path, base, node);
+        ret = dapf_compile_t8110(path, base, node, &prog);
     } else {
         printf("dapf: DAPF %s at 0x%lx is of an unknown type\n", path, base);
-        return -1;
+        return NULL;
     }
 
-    if (pwr)
+    if (ret)
+        return NULL;
+
+    if (dapf_n_programs >= DAPF_MAX_PROGRAMS || strlen(path) >= sizeof(prog.path)) {
+        /* Does not fit the cache: replay once and throw it away */
+        static struct dapf_program tmp;
+        free(tmp.writes);
+        tmp = prog;
+        strncpy(tmp.path, path, sizeof(tmp.path) - 1);
+        return &tmp;
+    }
+
+    strcpy(prog.path, path);
+    dapf_programs[dapf_n_programs] = prog;
+    return &dapf_programs[dapf_n_programs++];
+}
+
+int dapf_init(const char *path, int index)
+{
+    struct dapf_program *prog = NULL;
+
+    for (u32 i = 0; i < dapf_n_programs; i++) {
+        if (dapf_programs[i].index == index && !strcmp(dapf_programs[i].path, path)) {
+            prog = &dapf_programs[i];
+            break;
+        }
+    }
+
+    if (!prog)
+        prog = dapf_compile(path, index);
+    if (!prog)
+        return -1;
+
+    if (prog->pwr && (pmgr_adt_power_enable(path) < 0))
+        return -1;
+
+    dapf_replay(prog);
+
+    if (prog->pwr)
         pmgr_adt_power_disable(path);
 
-    if (!ret)
-        printf("dapf: Initialized %s\n", path);
+    printf("dapf: Initialized %s\n", path);
 
-    return ret;
+    return 0;
 }
 
 struct entry {
@@ -4,13 +4,20 @@
 #include "adt.h"
 #include "assert.h"
 #include "devicetree.h"
+#include "evtlog.h"
+#include "log.h"
 #include "malloc.h"
 #include "memory.h"
+#include "pool.h"
 #include "string.h"
+#include "task.h"
+#include "tripwire.h"
 #include "utils.h"
 
 #include "libfdt/libfdt.h"
 
+#define LOG_SUBSYS LOG_DART
+
 #define DART_T8020_CONFIG      0x60
 #define DART_T8020_CONFIG_LOCK BIT(15)
 
@@ -81,6 +88,14 @@
 #define DART_T8110_PROTECT          0x200
 #define DART_T8110_PROTECT_TTBR_TCR BIT(0)
 
+#define DART_T8110_ERROR        0x100
+#define DART_T8110_ERROR_FLAG   BIT(31)
+#define DART_T8110_ERROR_STREAM GENMASK(27, 20)
+#define DART_T8110_ERROR_CODE   GENMASK(14, 0)
+
+#define DART_T8110_ERROR_ADDR_LO 0x170
+#define DART_T8110_ERROR_ADDR_HI 0x174
+
 #define DART_T8110_ENABLE_STREAMS  0xc00
 #define DART_T8110_DISABLE_STREAMS 0xc20
 
@@ -106,9 +121,28 @@ struct dart_params {
     u64 ttbr_off;
     int ttbr_count;
 
+    u64 error_off;
+    u64 error_flag;
+    u64 error_stream;
+    u64 error_addr_lo_off;
+    u64 error_addr_hi_off;
+
     void (*tlb_invalidate)(dart_dev_t *dart);
 };
 
+/*
+ * Free-space index: a sorted list of IOVA extents mapped through dart_map().
+ * dart_find_iova() uses it to skip allocated space in O(extents) instead of
+ * walking page tables page by page; the table walk remains as verification,
+ * since locked DARTs inherit mappings from iBoot that this list cannot see.
+ */
+#define DART_MAX_EXTENTS 64
+
+struct dart_extent {
+    u64 iova;
+    u64 len;
+};
+
 struct dart_dev {
     bool locked;
     bool keep;
@@ -119,8 +153,136 @@ struct dart_dev {
     u64 vm_base;
 
     u64 *l1[DART_MAX_TTBR_COUNT];
+
+    u32 num_extents;
+    bool extents_overflow;
+    struct dart_extent extents[DART_MAX_EXTENTS];
+
+    int tlb_batch_depth;
+    bool tlb_dirty;
 };
 
+/*
+ * TLB invalidations can be batched across many dart_map()/dart_unmap() calls
+ * with dart_tlb_batch_begin()/dart_tlb_batch_end(); the flush then happens
+ * once at the end of the (possibly nested) batch.
+ */
+static void dart_tlb_invalidate(dart_dev_t *dart)
+{
+    if (dart->tlb_batch_depth) {
+        dart->tlb_dirty = true;
+        return;
+    }
+
+    trip_arm("darttlb", 100);
+    dart->params->tlb_invalidate(dart);
+    trip_disarm();
+}
+
+void dart_tlb_batch_begin(dart_dev_t *dart)
+{
+    dart->tlb_batch_depth++;
+}
+
+void dart_tlb_batch_end(dart_dev_t *dart)
+{
+    if (!dart->tlb_batch_depth || --dart->tlb_batch_depth)
+        return;
+
+    if (dart->tlb_dirty) {
+        dart->tlb_dirty = false;
+        trip_arm("darttlb", 100);
+        dart->params->tlb_invalidate(dart);
+        trip_disarm();
+    }
+}
+
+static void dart_extent_add(dart_dev_t *dart, u64 iova, u64 len)
+{
+    if (dart->extents_overflow || !len)
+        return;
+
+    u32 i = 0;
+    while (i < dart->num_extents && dart->extents[i].iova + dart->extents[i].len < iova)
+        i++;
+
+    // Merge into the extent at i if adjacent/overlapping
+    if (i < dart->num_extents && dart->extents[i].iova <= iova + len) {
+        u64 start = min(dart->extents[i].iova, iova);
+        u64 end = max(dart->extents[i].iova + dart->extents[i].len, iova + len);
+        dart->extents[i].iova = start;
+        dart->extents[i].len = end - start;
+
+        // Possibly absorb the following extent too
+        while (i + 1 < dart->num_extents &&
+               dart->extents[i + 1].iova <= dart->extents[i].iova + dart->extents[i].len) {
+            u64 nend = dart->extents[i + 1].iova + dart->extents[i + 1].len;
+            if (nend > dart->extents[i].iova + dart->extents[i].len)
+                dart->extents[i].len = nend - dart->extents[i].iova;
+            memmove(&dart->extents[i + 1], &dart->extents[i + 2],
+                    (dart->num_extents - i - 2) * sizeof(struct dart_extent));
+            dart->num_extents--;
+        }
+        return;
+    }
+
+    if (dart->num_extents == DART_MAX_EXTENTS) {
+        // Too fragmented to track; fall back to pure table scans
+        dart->extents_overflow = true;
+        dart->num_extents = 0;
+        return;
+    }
+
+    memmove(&dart->extents[i + 1], &dart->extents[i],
+            (dart->num_extents - i) * sizeof(struct dart_extent));
+    dart->extents[i].iova = iova;
+    dart->extents[i].len = len;
+    dart->num_extents++;
+}
+
+static void dart_extent_del(dart_dev_t *dart, u64 iova, u64 len)
+{
+    if (dart->extents_overflow || !len)
+        return;
+
+    for (u32 i = 0; i < dart->num_extents;) {
+        u64 start = dart->extents[i].iova;
+        u64 end = start + dart->extents[i].len;
+
+        if (end <= iova || start >= iova + len) {
+            i++;
+            continue;
+        }
+
+        if (start < iova && end > iova + len) {
+            // Hole in the middle: split
+            if (dart->num_extents == DART_MAX_EXTENTS) {
+                dart->extents_overflow = true;
+                dart->num_extents = 0;
+                return;
+            }
+            memmove(&dart->extents[i + 1], &dart->extents[i],
+                    (dart->num_extents - i) * sizeof(struct dart_extent));
+            dart->num_extents++;
+            dart->extents[i].len = iova - start;
+            dart->extents[i + 1].iova = iova + len;
+            dart->extents[i + 1].len = end - (iova + len);
+            return;
+        } else if (start < iova) {
+            dart->extents[i].len = iova - start;
+            i++;
+        } else if (end > iova + len) {
+            dart->extents[i].iova = iova + len;
+            dart->extents[i].len = end - (iova + len);
+            i++;
+        } else {
+            memmove(&dart->extents[i], &dart->extents[i + 1],
+                    (dart->num_extents - i - 1) * sizeof(struct dart_extent));
+            dart->num_extents--;
+        }
+    }
+}
+
 static void dart_t8020_tlb_invalidate(dart_dev_t *dart)
 {
     write32(dart->regs + DART_T8020_STREAM_SELECT, BIT(dart->device));
@@ -130,7 +292,7 @@ static void dart_t8020_tlb_invalidate(dart_dev_t *dart)
     write32(dart->regs + DART_T8020_STREAM_COMMAND, DART_T8020_STREAM_COMMAND_INVALIDATE);
 
     if (poll32(dart->regs + DART_T8020_STREAM_COMMAND, DART_T8020_STREAM_COMMAND_BUSY, 0, 100))
-        printf("dart: DART_T8020_STREAM_COMMAND_BUSY did not clear.\n");
+        log_err("dart: DART_T8020_STREAM_COMMAND_BUSY did not clear.\n");
 }
 
 static void dart_t8110_tlb_invalidate(dart_dev_t *dart)
@@ -142,7 +304,7 @@ static void dart_t8110_tlb_invalidate(dart_dev_t *dart)
                 FIELD_PREP(DART_T8110_TLB_CMD_STREAM, dart->device));
 
     if (poll32(dart->regs + DART_T8110_TLB_CMD_OP, DART_T8110_TLB_CMD_BUSY, 0, 100))
-        printf("dart: DART_T8110_TLB_CMD_BUSY did not clear.\n");
+        log_err("dart: DART_T8110_TLB_CMD_BUSY did not clear.\n");
 }
 
 const struct dart_params dart_t8020 = {
@@ -158,6 +320,11 @@ const struct dart_params dart_t8020 = {
     .ttbr_shift = DART_T8020_TTBR_SHIFT,
     .ttbr_off = DART_T8020_TTBR_OFF,
     .ttbr_count = 4,
+    .error_off = DART_T8020_ERROR,
+    .error_flag = DART_T8020_ERROR_FLAG,
+    .error_stream = (u64)DART_T8020_ERROR_STREAM_MASK << DART_T8020_ERROR_STREAM_SHIFT,
+    .error_addr_lo_off = DART_T8020_ERROR_ADDR_LO,
+    .error_addr_hi_off = DART_T8020_ERROR_ADDR_HI,
     .tlb_invalidate = dart_t8020_tlb_invalidate,
 };
 
@@ -174,6 +341,11 @@ const struct dart_params dart_t6000 = {
     .ttbr_shift = DART_T8020_TTBR_SHIFT,
     .ttbr_off = DART_T8020_TTBR_OFF,
     .ttbr_count = 4,
+    .error_off = DART_T8020_ERROR,
+    .error_flag = DART_T8020_ERROR_FLAG,
+    .error_stream = (u64)DART_T8020_ERROR_STREAM_MASK << DART_T8020_ERROR_STREAM_SHIFT,
+    .error_addr_lo_off = DART_T8020_ERROR_ADDR_LO,
+    .error_addr_hi_off = DART_T8020_ERROR_ADDR_HI,
     .tlb_invalidate = dart_t8020_tlb_invalidate,
 };
 
@@ -190,9 +362,97 @@ const struct dart_params dart_t8110 = {
     .ttbr_shift = DART_T8110_TTBR_SHIFT,
     .ttbr_off = DART_T8110_TTBR_OFF,
     .ttbr_count = 1,
+    .error_off = DART_T8110_ERROR,
+    .error_flag = DART_T8110_ERROR_FLAG,
+    .error_stream = DART_T8110_ERROR_STREAM,
+    .error_addr_lo_off = DART_T8110_ERROR_ADDR_LO,
+    .error_addr_hi_off = DART_T8110_ERROR_ADDR_HI,
     .tlb_invalidate = dart_t8110_tlb_invalidate,
 };
 
+/* Page tables are recycled through a pool to keep map/unmap cycles off dlmalloc */
+static struct pool dart_pt_pool;
+
+static u64 *dart_pt_alloc(void)
+{
+    if (!dart_pt_pool.obj_size)
+        pool_init(&dart_pt_pool, "dart-pt", SZ_16K, SZ_16K, 8);
+
+    u64 *pt = pool_get(&dart_pt_pool);
+    if (pt)
+        memset(pt, 0, SZ_16K);
+    return pt;
+}
+
+/*
+ * Fault telemetry: these DARTs expose no architected performance counters,
+ * but they do latch the first translation fault (error code, stream and
+ * faulting DVA) in the error registers until it is acknowledged. A background
+ * task samples every live DART into the instrumentation ring and the console,
+ * so IOMMU faults show up in production captures instead of just stalling the
+ * client device. Shared-register DARTs (multiple devices on one register
+ * block) only need one sampler, so registration is keyed on the base address.
+ */
+#define DART_MAX_LIVE 16
+
+static uintptr_t dart_live[DART_MAX_LIVE];
+static const struct dart_params *dart_live_params[DART_MAX_LIVE];
+
+static void dart_poll_faults(void)
+{
+    for (int i = 0; i < DART_MAX_LIVE; i++) {
+        const struct dart_params *params = dart_live_params[i];
+        if (!dart_live[i])
+            continue;
+
+        u32 err = read32(dart_live[i] + params->error_off);
+        if (!(err & params->error_flag))
+            continue;
+
+        u64 addr = read32(dart_live[i] + params->error_addr_lo_off) |
+                   ((u64)read32(dart_live[i] + params->error_addr_hi_off) << 32);
+
+        EVT(DART_FAULT, err);
+        EVT(DART_FAULT_ADDR, addr >> 14); // page number; DVAs are < 46 bits
+        log_warn("dart: DART at 0x%lx fault: dva 0x%lx, stream %ld, error 0x%x\n", dart_live[i],
+                 addr, FIELD_GET(params->error_stream, (u64)err), err);
+
+        /* acknowledge (W1C) so the next fault gets latched */
+        write32(dart_live[i] + params->error_off, err);
+    }
+}
+
+static void dart_live_add(dart_dev_t *dart)
+{
+    static bool task_registered = false;
+    int slot = -1;
+
+    for (int i = 0; i < DART_MAX_LIVE; i++) {
+        if (dart_live[i] == dart->regs)
+            return;
+        if (!dart_live[i] && slot < 0)
+            slot = i;
+    }
+
+    if (slot < 0)
+        return; // not fatal, just unsampled
+
+    dart_live_params[slot] = dart->params;
+    dart_live[slot] = dart->regs;
+
+    if (!task_registered) {
+        task_register("dart-faults", dart_poll_faults, 100000);
+        task_registered = true;
+    }
+}
+
+static void dart_live_remove(dart_dev_t *dart)
+{
+    for (int i = 0; i < DART_MAX_LIVE; i++)
+        if (dart_live[i] == dart->regs)
+            dart_live[i] = 0;
+}
+
 dart_dev_t *dart_init(uintptr_t base, u8 device, bool keep_pts, enum dart_type_t type)
 {
     dart_dev_t *dart = calloc(1, sizeof(*dart));
@@ -216,7 +476,7 @@ dart_dev_t *dart_init(uintptr_t base, u8 device, bool keep_pts, enum dart_type_t
     }
 
     if (device >= dart->params->sid_count) {
-        printf("dart: device %d is too big for this DART type\n", device);
+        log_err("dart: device %d is too big for this DART type\n", device);
         free(dart);
         return NULL;
     }
@@ -250,26 +510,30 @@ dart_dev_t *dart_init(uintptr_t base, u8 device, bool keep_pts, enum dart_type_t
         if (dart->l1[i])
             continue;
 
-        dart->l1[i] = memalign(SZ_16K, SZ_16K);
+        dart->l1[i] = dart_pt_alloc();
         if (!dart->l1[i])
             goto error;
-        memset(dart->l1[i], 0, SZ_16K);
 
-        write32(DART_TTBR(dart, i),
-                dart->params->ttbr_valid |
-                    FIELD_PREP(dart->params->ttbr_addr,
-                               ((uintptr_t)dart->l1[i]) >> dart->params->ttbr_shift));
+        write32_relaxed(DART_TTBR(dart, i),
+                        dart->params->ttbr_valid |
+                            FIELD_PREP(dart->params->ttbr_addr,
+                                       ((uintptr_t)dart->l1[i]) >> dart->params->ttbr_shift));
     }
 
     if (!dart->locked && !keep_pts)
-        write32(DART_TCR(dart), dart->params->tcr_enabled);
+        write32_relaxed(DART_TCR(dart), dart->params->tcr_enabled);
 
+    /* TTBR/TCR writes must land before the TLB flush command */
+    mmio_sync();
     dart->params->tlb_invalidate(dart);
+
+    dart_live_add(dart);
     return dart;
 
 error:
-    if (!dart->locked)
-        free(dart->l1);
+    for (int i = 0; i < dart->params->ttbr_count; i++)
+        if (dart->l1[i] && is_heap(dart->l1[i]))
+            pool_put(&dart_pt_pool, dart->l1[i]);
     free(dart);
     return NULL;
 }
@@ -279,13 +543,13 @@ dart_dev_t *dart_init_adt(const char *path, int instance, int device, bool keep_
     int dart_path[8];
     int node = adt_path_offset_trace(adt, path, dart_path);
     if (node < 0) {
-        printf("dart: Error getting DART node %s\n", path);
+        log_err("dart: Error getting DART node %s\n", path);
         return NULL;
     }
 
     u64 base;
     if (adt_get_reg(adt, dart_path, "reg", instance, &base, NULL) < 0) {
-        printf("dart: Error getting DART %s base address.\n", path);
+        log_err("dart: Error getting DART %s base address.\n", path);
         return NULL;
     }
 
@@ -302,7 +566,7 @@ dart_dev_t *dart_init_adt(const char *path, int instance, int device, bool keep_
         type = DART_T8110;
         type_s = "t8110";
     } else {
-        printf("dart: dart %s at 0x%lx is of an unknown type\n", path, base);
+        log_err("dart: dart %s at 0x%lx is of an unknown type\n", path, base);
         return NULL;
     }
 
@@ -311,13 +575,13 @@ dart_dev_t *dart_init_adt(const char *path, int instance, int device, bool keep_
     if (!dart)
         return NULL;
 
-    printf("dart: dart %s at 0x%lx is a %s%s\n", path, base, type_s,
-           dart->locked ? " (locked)" : "");
+    log_info("dart: dart %s at 0x%lx is a %s%s\n", path, base, type_s,
+             dart->locked ? " (locked)" : "");
 
     if (adt_getprop(adt, node, "real-time", NULL)) {
         for (int i = 0; i < dart->params->ttbr_count; i++) {
-            printf("dart: dart %s.%d.%d L1 %d is real-time at %p\n", path, instance, device, i,
-                   dart->l1[i]);
+            log_info("dart: dart %s.%d.%d L1 %d is real-time at %p\n", path, instance, device, i,
+                     dart->l1[i]);
         }
     }
     u32 len;
@@ -332,7 +596,7 @@ dart_dev_t *dart_init_adt(const char *path, int instance, int device, bool keep_
             memcpy(&tmp, prop, sizeof(tmp));
             dart->vm_base = tmp;
         } else {
-            printf("dart: unexpected length of vm-base property: %u\n", len);
+            log_err("dart: unexpected length of vm-base property: %u\n", len);
         }
     }
     if (dart->locked)
@@ -346,13 +610,13 @@ void dart_lock_adt(const char *path, int instance)
     int dart_path[8];
     int node = adt_path_offset_trace(adt, path, dart_path);
     if (node < 0) {
-        printf("dart: Error getting DART node %s\n", path);
+        log_err("dart: Error getting DART node %s\n", path);
         return;
     }
 
     u64 base;
     if (adt_get_reg(adt, dart_path, "reg", instance, &base, NULL) < 0) {
-        printf("dart: Error getting DART %s base address.\n", path);
+        log_err("dart: Error getting DART %s base address.\n", path);
         return;
     }
 
@@ -363,7 +627,7 @@ void dart_lock_adt(const char *path, int instance)
         if (!(read32(base + DART_T8110_PROTECT) & DART_T8110_PROTECT_TTBR_TCR))
             set32(base + DART_T8110_PROTECT, DART_T8110_PROTECT_TTBR_TCR);
     } else {
-        printf("dart: dart %s at 0x%lx is of an unknown type\n", path, base);
+        log_err("dart: dart %s at 0x%lx is of an unknown type\n", path, base);
     }
 }
 
@@ -371,7 +635,7 @@ dart_dev_t *dart_init_fdt(void *dt, u32 phandle, int device, bool keep_pts)
 {
     int node = fdt_node_offset_by_phandle(dt, phandle);
     if (node < 0) {
-        printf("FDT: node for phandle %u not found\n", phandle);
+        log_err("FDT: node for phandle %u not found\n", phandle);
         return NULL;
     }
 
@@ -393,7 +657,7 @@ dart_dev_t *dart_init_fdt(void *dt, u32 phandle, int device, bool keep_pts)
         type = DART_T8110;
         type_s = "t8110";
     } else {
-        printf("dart: dart %s at 0x%lx is of an unknown type\n", name, base);
+        log_err("dart: dart %s at 0x%lx is of an unknown type\n", name, base);
         return NULL;
     }
 
@@ -402,8 +666,8 @@ dart_dev_t *dart_init_fdt(void *dt, u32 phandle, int device, bool keep_pts)
     if (!dart)
         return NULL;
 
-    printf("dart: dart %s at 0x%lx is a %s%s\n", name, base, type_s,
-           dart->locked ? " (locked)" : "");
+    log_info("dart: dart %s at 0x%lx is a %s%s\n", name, base, type_s,
+             dart->locked ? " (locked)" : "");
 
     return dart;
 }
@@ -412,7 +676,7 @@ int dart_setup_pt_region(dart_dev_t *dart, const char *path, int device, u64 vm_
 {
     int node = adt_path_offset(adt, path);
     if (node < 0) {
-        printf("dart: Error getting DART node %s\n", path);
+        log_err("dart: Error getting DART node %s\n", path);
         return -1;
     }
     char pt_region_str[24];
@@ -426,8 +690,8 @@ int dart_setup_pt_region(dart_dev_t *dart, const char *path, int device, u64 vm_
         memcpy(region, pt_region->value, sizeof(region));
         u64 tbl_count = (region[1] - region[0]) / SZ_16K;
         if (tbl_count > 64) {
-            printf("dart: dart %s ignoring large %s, %lu L2 tables\n", path, pt_region_str,
-                   tbl_count);
+            log_err("dart: dart %s ignoring large %s, %lu L2 tables\n", path, pt_region_str,
+                    tbl_count);
             return -1;
         }
         /* first index may or may not be the l1 table? */
@@ -457,7 +721,7 @@ int dart_setup_pt_region(dart_dev_t *dart, const char *path, int device, u64 vm_
 
                 for (int j = 0; j < 2048; j++) {
                     if (j != idx && dart->l1[ttbr][j] == dart->l1[ttbr][idx]) {
-                        printf("dart: clearing clobbered L1 PTE at %d, %d\n", ttbr, idx);
+                        log_debug("dart: clearing clobbered L1 PTE at %d, %d\n", ttbr, idx);
                         dart->l1[ttbr][idx] = 0;
                         break;
                     }
@@ -466,10 +730,10 @@ int dart_setup_pt_region(dart_dev_t *dart, const char *path, int device, u64 vm_
                 continue;
             }
 
-            printf("dart: allocating L2 tbl at %d, %d to 0x%lx\n", ttbr, idx, l2_free);
+            log_debug("dart: allocating L2 tbl at %d, %d to 0x%lx\n", ttbr, idx, l2_free);
 
             if (l2_free >= l2_free_end) {
-                printf("dart: out of prealloc page tables\n");
+                log_err("dart: out of prealloc page tables\n");
                 return -1;
             }
 
@@ -483,7 +747,7 @@ int dart_setup_pt_region(dart_dev_t *dart, const char *path, int device, u64 vm_
         u64 l2_tt[2] = {region[0], 2};
         int ret = adt_setprop(adt, node, l2_tt_str, &l2_tt, sizeof(l2_tt));
         if (ret < 0) {
-            printf("dart: failed to update '%s/%s'\n", path, l2_tt_str);
+            log_err("dart: failed to update '%s/%s'\n", path, l2_tt_str);
         }
 
         dart->params->tlb_invalidate(dart);
@@ -503,12 +767,10 @@ static u64 *dart_get_l2(dart_dev_t *dart, u32 idx)
         return (u64 *)off;
     }
 
-    u64 *tbl = memalign(SZ_16K, SZ_16K);
+    u64 *tbl = dart_pt_alloc();
     if (!tbl)
         return NULL;
 
-    memset(tbl, 0, SZ_16K);
-
     u64 offset = FIELD_PREP(dart->params->offset_mask, ((u64)tbl) >> DART_PTE_OFFSET_SHIFT);
 
     dart->l1[ttbr][idx] = offset | DART_PTE_VALID;
@@ -516,29 +778,6 @@ static u64 *dart_get_l2(dart_dev_t *dart, u32 idx)
     return tbl;
 }
 
-static int dart_map_page(dart_dev_t *dart, uintptr_t iova, uintptr_t paddr, u32 flags)
-{
-    u32 l1_index = (iova >> 25) & 0x1fff;
-    u32 l2_index = (iova >> 14) & 0x7ff;
-
-    u64 *l2 = dart_get_l2(dart, l1_index);
-    if (!l2) {
-        printf("dart: couldn't create l2 for iova %lx\n", iova);
-        return -1;
-    }
-
-    if (l2[l2_index] & DART_PTE_VALID) {
-        printf("dart: iova %lx already has a valid PTE: %lx\n", iova, l2[l2_index]);
-        return -1;
-    }
-
-    u64 offset = FIELD_PREP(dart->params->offset_mask, paddr >> DART_PTE_OFFSET_SHIFT);
-
-    l2[l2_index] = offset | dart->params->pte_flags | flags;
-
-    return 0;
-}
-
 int dart_map_flags(dart_dev_t *dart, uintptr_t iova, void *bfr, size_t len, u32 flags)
 {
     uintptr_t paddr = (uintptr_t)bfr;
@@ -551,18 +790,44 @@ int dart_map_flags(dart_dev_t *dart, uintptr_t iova, void *bfr, size_t len, u32
     if (iova % SZ_16K)
         return -1;
 
+    /*
+     * Buffers are physically contiguous, so fill PTEs one L2 table at a
+     * time: resolve the L1 entry once per 32MB run instead of re-walking
+     * it for every 16KB page. Large shared buffers (framebuffers, DCP
+     * surfaces) map with a handful of L1 lookups this way.
+     */
     while (offset < len) {
-        int ret = dart_map_page(dart, iova + offset, paddr + offset, flags);
-
-        if (ret) {
+        uintptr_t va = iova + offset;
+        u32 l1_index = (va >> 25) & 0x1fff;
+        u32 l2_base = (va >> 14) & 0x7ff;
+        u64 run = min(len - offset, (u64)(0x800 - l2_base) << 14);
+
+        u64 *l2 = dart_get_l2(dart, l1_index);
+        if (!l2) {
+            log_err("dart: couldn't create l2 for iova %lx\n", va);
             dart_unmap(dart, iova, offset);
-            return ret;
+            return -1;
         }
 
-        offset += SZ_16K;
+        for (u64 pg = 0; pg < run >> 14; pg++) {
+            u32 idx = l2_base + pg;
+
+            if (l2[idx] & DART_PTE_VALID) {
+                log_err("dart: iova %lx already has a valid PTE: %lx\n", va + (pg << 14), l2[idx]);
+                dart_unmap(dart, iova, offset + (pg << 14));
+                return -1;
+            }
+
+            l2[idx] = FIELD_PREP(dart->params->offset_mask,
+                                 (paddr + offset + (pg << 14)) >> DART_PTE_OFFSET_SHIFT) |
+                      dart->params->pte_flags | flags;
+        }
+
+        offset += run;
     }
 
-    dart->params->tlb_invalidate(dart);
+    dart_extent_add(dart, iova, len);
+    dart_tlb_invalidate(dart);
     return 0;
 }
 
@@ -591,6 +856,8 @@ void dart_unmap(dart_dev_t *dart, uintptr_t iova, size_t len)
     if (iova % SZ_16K)
         return;
 
+    dart_extent_del(dart, iova, len);
+
     while (len) {
         dart_unmap_page(dart, iova);
 
@@ -598,13 +865,13 @@ void dart_unmap(dart_dev_t *dart, uintptr_t iova, size_t len)
         iova += SZ_16K;
     }
 
-    dart->params->tlb_invalidate(dart);
+    dart_tlb_invalidate(dart);
 }
 
 void dart_free_l2(dart_dev_t *dart, uintptr_t iova)
 {
     if (iova & ((1 << 25) - 1)) {
-        printf("dart: %08lx is not at the start of L2 table\n", iova);
+        log_err("dart: %08lx is not at the start of L2 table\n", iova);
         return;
     }
 
@@ -618,12 +885,12 @@ void dart_free_l2(dart_dev_t *dart, uintptr_t iova)
 
     for (u32 idx = 0; idx < 2048; idx++) {
         if (l2[idx] & DART_PTE_VALID) {
-            printf("dart: %08lx is still mapped\n", iova + (idx << 14));
+            log_err("dart: %08lx is still mapped\n", iova + (idx << 14));
             return;
         }
     }
     dart->l1[ttbr][l1_index] = 0;
-    free(l2);
+    pool_put(&dart_pt_pool, l2);
 }
 
 static void *dart_translate_internal(dart_dev_t *dart, uintptr_t iova, int silent)
@@ -632,19 +899,19 @@ static void *dart_translate_internal(dart_dev_t *dart, uintptr_t iova, int silen
     u32 l1_index = (iova >> 25) & 0x7ff;
 
     if ((int)ttbr >= dart->params->ttbr_count) {
-        printf("dart[%lx %u]: ttbr out of range: %d\n", dart->regs, dart->device, ttbr);
+        log_err("dart[%lx %u]: ttbr out of range: %d\n", dart->regs, dart->device, ttbr);
         return NULL;
     }
 
     if (!dart->l1[ttbr]) {
-        printf("dart[%lx %u]: l1[%u] is not set\n", dart->regs, dart->device, ttbr);
+        log_err("dart[%lx %u]: l1[%u] is not set\n", dart->regs, dart->device, ttbr);
         return NULL;
     }
 
     if (!(dart->l1[ttbr][l1_index] & DART_PTE_VALID)) {
         if (!silent)
-            printf("dart[%lx %u]: l1 translation failure %x %lx\n", dart->regs, dart->device,
-                   l1_index, iova);
+            log_debug("dart[%lx %u]: l1 translation failure %x %lx\n", dart->regs, dart->device,
+                      l1_index, iova);
         return NULL;
     }
 
@@ -654,8 +921,8 @@ static void *dart_translate_internal(dart_dev_t *dart, uintptr_t iova, int silen
 
     if (!(l2[l2_index] & DART_PTE_VALID)) {
         if (!silent)
-            printf("dart[%lx %u]: l2 translation failure %x:%x %lx\n", dart->regs, dart->device,
-                   l1_index, l2_index, iova);
+            log_debug("dart[%lx %u]: l2 translation failure %x:%x %lx\n", dart->regs, dart->device,
+                      l1_index, l2_index, iova);
         return NULL;
     }
 
@@ -712,6 +979,19 @@ u64 dart_find_iova(dart_dev_t *dart, s64 start, size_t len)
     uintptr_t iova = start;
 
     while (iova + len <= end) {
+        // Jump over space the extent index knows is allocated
+        bool skipped = false;
+        for (u32 i = 0; i < dart->num_extents; i++) {
+            const struct dart_extent *ext = &dart->extents[i];
+
+            if (ext->iova < iova + len && iova < ext->iova + ext->len) {
+                iova = ALIGN_UP(ext->iova + ext->len, SZ_16K);
+                skipped = true;
+                break;
+            }
+        }
+        if (skipped)
+            continue;
 
         if (dart_translate_internal(dart, iova, 1) == NULL) {
             size_t size;
@@ -730,8 +1010,42 @@ u64 dart_find_iova(dart_dev_t *dart, s64 start, size_t len)
     return DART_PTR_ERR;
 }
 
+/*
+ * Window remap service: alias a (possibly high) buffer into low IOVA space
+ * for engines with 32-bit address limits, avoiding bounce copies. The buffer
+ * need not be page aligned; the returned IOVA carries the same in-page
+ * offset and is what dart_unmap_window() expects back.
+ */
+u64 dart_map_window(dart_dev_t *dart, void *buf, size_t len)
+{
+    u64 offset = (u64)buf & (SZ_16K - 1);
+    size_t map_len = ALIGN_UP(offset + len, SZ_16K);
+
+    u64 iova = dart_find_iova(dart, 0, map_len);
+    if (DART_IS_ERR(iova))
+        return iova;
+
+    // The point of the window is a low alias; fail if none is left
+    if (iova + map_len > BIT(32))
+        return DART_PTR_ERR;
+
+    if (dart_map(dart, iova, (void *)((u64)buf - offset), map_len) < 0)
+        return DART_PTR_ERR;
+
+    return iova + offset;
+}
+
+void dart_unmap_window(dart_dev_t *dart, u64 iova, size_t len)
+{
+    u64 offset = iova & (SZ_16K - 1);
+
+    dart_unmap(dart, iova - offset, ALIGN_UP(offset + len, SZ_16K));
+}
+
 void dart_shutdown(dart_dev_t *dart)
 {
+    dart_live_remove(dart);
+
     if (!dart->locked && !dart->keep)
         write32(DART_TCR(dart), dart->params->tcr_disabled);
 
@@ -744,7 +1058,7 @@ void dart_shutdown(dart_dev_t *dart)
             if (dart->l1[ttbr][i] & DART_PTE_VALID) {
                 void *l2 = dart_get_l2(dart, i);
                 if (is_heap(l2)) {
-                    free(l2);
+                    pool_put(&dart_pt_pool, l2);
                     dart->l1[ttbr][i] = 0;
                 }
             }
@@ -755,7 +1069,7 @@ void dart_shutdown(dart_dev_t *dart)
 
     for (int i = 0; i < dart->params->ttbr_count; ++i)
         if (is_heap(dart->l1[i]))
-            free(dart->l1[i]);
+            pool_put(&dart_pt_pool, dart->l1[i]);
     free(dart);
 }
 
@@ -24,11 +24,16 @@ int dart_setup_pt_region(dart_dev_t *dart, const char *path, int device, u64 vm_
 int dart_map(dart_dev_t *dart, uintptr_t iova, void *bfr, size_t len);
 int dart_map_flags(dart_dev_t *dart, uintptr_t iova, void *bfr, size_t len, u32 flags);
 void dart_unmap(dart_dev_t *dart, uintptr_t iova, size_t len);
+void dart_tlb_batch_begin(dart_dev_t *dart);
+void dart_tlb_batch_end(dart_dev_t *dart);
 void dart_free_l2(dart_dev_t *dart, uintptr_t iova);
 void *dart_translate(dart_dev_t *dart, uintptr_t iova);
 void *dart_translate_silent(dart_dev_t *dart, uintptr_t iova);
 u64 dart_search(dart_dev_t *dart, void *paddr);
 u64 dart_find_iova(dart_dev_t *dart, s64 start, size_t len);
+/* Alias a buffer into a sub-4G IOVA window / undo it (offset-preserving) */
+u64 dart_map_window(dart_dev_t *dart, void *buf, size_t len);
+void dart_unmap_window(dart_dev_t *dart, u64 iova, size_t len);
 void dart_shutdown(dart_dev_t *dart);
 u64 dart_vm_base(dart_dev_t *dart);
 
@@ -149,7 +149,7 @@ dcp_dev_t *dcp_init(const display_config_t *cfg)
     u32 sid;
 
     if (cfg && cfg->dptx_phy[0]) {
-        if (os_firmware.version != V13_5) {
+        if (!(fw_caps & FW_CAP_DCP_DPTX)) {
             printf("dcp: dtpx-port is only supported with V13_5 OS firmware.\n");
             return NULL;
         }
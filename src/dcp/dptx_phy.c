@@ -21,10 +21,14 @@ typedef struct dptx_phy {
     enum dptx_type type;
     u32 dcp_index;
     u32 active_lanes;
+    u32 configured_link_rate;
 } dptx_phy_t;
 
 int dptx_phy_activate(dptx_phy_t *phy)
 {
+    /* this resets the PHY, any previously programmed link rate is gone */
+    phy->configured_link_rate = 0;
+
     // MMIO: R.4   0x23c500010 (dptx-phy[1], offset 0x10) = 0x0
     // MMIO: W.4   0x23c500010 (dptx-phy[1], offset 0x10) = 0x0
     read32(phy->regs[1] + 0x10);
@@ -252,9 +256,17 @@ int dptx_phy_set_active_lane_count(dptx_phy_t *phy, u32 num_lanes)
 
 int dptx_phy_set_link_rate(dptx_phy_t *phy, u32 link_rate)
 {
-    UNUSED(link_rate);
     u32 sts_1008, sts_1014;
 
+    /*
+     * The sequence below is rate-independent as far as the traces show, but
+     * running it drops and re-locks the link PLL. DCP re-requests the current
+     * rate on hotplug/retrain cycles, so skip the reprogramming when the PHY
+     * is already running at the requested rate.
+     */
+    if (link_rate && link_rate == phy->configured_link_rate)
+        return 0;
+
     // MMIO: R.4   0x23c544004 (dptx-phy[0], offset 0x4004) = 0x49
     // MMIO: W.4   0x23c544004 (dptx-phy[0], offset 0x4004) = 0x49
     set32(phy->regs[0] + 0x4004, 0x08);
@@ -444,6 +456,8 @@ int dptx_phy_set_link_rate(dptx_phy_t *phy, u32 link_rate)
     // MMIO: W.4   0x23c544004 (dptx-phy[0], offset 0x4004) = 0x48
     clear32(phy->regs[0] + 0x4004, 0x01);
 
+    phy->configured_link_rate = link_rate;
+
     return 0;
 }
 
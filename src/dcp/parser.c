@@ -1,7 +1,6 @@
 // SPDX-License-Identifier: GPL-2.0-only OR MIT
 /* Copyright 2021 Alyssa Rosenzweig <alyssa@rosenzweig.io> */
 
-#include "malloc.h"
 #include "parser.h"
 #include "string.h"
 
@@ -113,12 +112,15 @@ static int skip(struct dcp_parse_ctx *handle)
     }
 }
 
-/* Caller must free the result */
-static char *parse_string(struct dcp_parse_ctx *handle)
+/*
+ * Zero-copy view of a string in the received blob. The bytes are not
+ * guaranteed to be NUL-terminated and only live as long as the message
+ * buffer, so use string_view_is()/parse_string_buf() to consume them.
+ */
+static const char *parse_string_view(struct dcp_parse_ctx *handle, size_t *len)
 {
     struct dcp_parse_tag *tag = parse_tag_of_type(handle, DCP_TYPE_STRING);
     const char *in;
-    char *out;
 
     if (!tag)
         return NULL;
@@ -127,11 +129,33 @@ static char *parse_string(struct dcp_parse_ctx *handle)
     if (!in)
         return NULL;
 
-    out = calloc(tag->size + 1, 1);
+    *len = tag->size;
+    return in;
+}
+
+/* Serialized strings sometimes include their trailing NUL in the size */
+static bool string_view_is(const char *view, size_t len, const char *str)
+{
+    size_t slen = strlen(str);
+
+    if (len < slen || memcmp(view, str, slen))
+        return false;
+
+    return len == slen || view[slen] == '\0';
+}
+
+static int parse_string_buf(struct dcp_parse_ctx *handle, char *buf, size_t size)
+{
+    size_t len;
+    const char *view = parse_string_view(handle, &len);
+
+    if (!view)
+        return -1;
 
-    memcpy(out, in, tag->size);
-    out[tag->size] = '\0';
-    return out;
+    len = min(len, size - 1);
+    memcpy(buf, view, len);
+    buf[len] = '\0';
+    return 0;
 }
 
 static int parse_int(struct dcp_parse_ctx *handle, s64 *value)
@@ -210,7 +234,8 @@ int parse(void *blob, size_t size, struct dcp_parse_ctx *ctx)
     return 0;
 }
 
-int parse_epic_service_init(struct dcp_parse_ctx *handle, char **name, char **class, s64 *unit)
+int parse_epic_service_init(struct dcp_parse_ctx *handle, char *name, size_t name_size, char *class,
+                            size_t class_size, s64 *unit)
 {
     int ret = 0;
     struct iterator it;
@@ -218,31 +243,25 @@ int parse_epic_service_init(struct dcp_parse_ctx *handle, char **name, char **cl
     bool parsed_name = false;
     bool parsed_class = false;
 
-    *name = NULL;
-    *class = NULL;
-
     dcp_parse_foreach_in_dict(handle, it)
     {
-        char *key = parse_string(it.handle);
+        size_t key_len;
+        const char *key = parse_string_view(it.handle, &key_len);
 
         if (!key) {
             ret = -1;
             break;
         }
 
-        if (!strcmp(key, "EPICName")) {
-            *name = parse_string(it.handle);
-            if (!*name)
-                ret = -1;
-            else
+        if (string_view_is(key, key_len, "EPICName")) {
+            ret = parse_string_buf(it.handle, name, name_size);
+            if (!ret)
                 parsed_name = true;
-        } else if (!strcmp(key, "EPICProviderClass")) {
-            *class = parse_string(it.handle);
-            if (!*class)
-                ret = -1;
-            else
+        } else if (string_view_is(key, key_len, "EPICProviderClass")) {
+            ret = parse_string_buf(it.handle, class, class_size);
+            if (!ret)
                 parsed_class = true;
-        } else if (!strcmp(key, "EPICUnit")) {
+        } else if (string_view_is(key, key_len, "EPICUnit")) {
             ret = parse_int(it.handle, unit);
             if (!ret)
                 parsed_unit = true;
@@ -250,7 +269,6 @@ int parse_epic_service_init(struct dcp_parse_ctx *handle, char **name, char **cl
             skip(it.handle);
         }
 
-        free(key);
         if (ret)
             break;
     }
@@ -258,16 +276,5 @@ int parse_epic_service_init(struct dcp_parse_ctx *handle, char **name, char **cl
     if (!parsed_unit || !parsed_name || !parsed_class)
         ret = -1;
 
-    if (ret) {
-        if (*name) {
-            free(*name);
-            *name = NULL;
-        }
-        if (*class) {
-            free(*class);
-            *class = NULL;
-        }
-    }
-
     return ret;
 }
@@ -13,6 +13,7 @@ struct dcp_parse_ctx {
 
 int parse(void *blob, size_t size, struct dcp_parse_ctx *ctx);
 
-int parse_epic_service_init(struct dcp_parse_ctx *handle, char **name, char **class, s64 *unit);
+int parse_epic_service_init(struct dcp_parse_ctx *handle, char *name, size_t name_size, char *class,
+                            size_t class_size, s64 *unit);
 
 #endif
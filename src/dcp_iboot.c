@@ -282,7 +282,7 @@ static int swap_set_layer_v13_3(dcp_iboot_if_t *iboot, int layer_id, dcp_layer_t
 int dcp_ib_swap_set_layer(dcp_iboot_if_t *iboot, int layer_id, dcp_layer_t *layer,
                           dcp_rect_t *src_rect, dcp_rect_t *dst_rect)
 {
-    if (os_firmware.version < V13_3)
+    if (!(fw_caps & FW_CAP_DCP_SWAP_V13_3))
         return swap_set_layer_v12_3(iboot, layer_id, layer, src_rect, dst_rect);
     else
         return swap_set_layer_v13_3(iboot, layer_id, layer, src_rect, dst_rect);
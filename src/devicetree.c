@@ -1,6 +1,8 @@
 /* SPDX-License-Identifier: MIT */
 
 #include "devicetree.h"
+#include "string.h"
+#include "utils.h"
 
 #include "libfdt/libfdt.h"
 
@@ -42,6 +44,179 @@ u64 dt_translate(struct dt_ranges_tbl *ranges, const fdt64_t *reg)
     return addr;
 }
 
+void dt_build_start(void *fdt, int node, struct dt_builder *b)
+{
+    b->fdt = fdt;
+    b->node = node;
+    b->err = 0;
+    b->nprops = 0;
+    b->used = 0;
+}
+
+void dt_build_prop(struct dt_builder *b, const char *name, const void *data, size_t len)
+{
+    if (b->err)
+        return;
+
+    if (b->nprops >= DT_BUILD_MAX_PROPS || b->used + ALIGN_UP(len, 4) > DT_BUILD_BUF_SIZE) {
+        b->err = -FDT_ERR_NOSPACE;
+        return;
+    }
+
+    b->props[b->nprops].name = name;
+    b->props[b->nprops].off = b->used;
+    b->props[b->nprops].len = len;
+    memcpy(b->buf + b->used, data, len);
+    b->used += ALIGN_UP(len, 4);
+    b->nprops++;
+}
+
+void dt_build_prop_u32(struct dt_builder *b, const char *name, u32 val)
+{
+    fdt32_t v = cpu_to_fdt32(val);
+
+    dt_build_prop(b, name, &v, sizeof(v));
+}
+
+void dt_build_prop_u64(struct dt_builder *b, const char *name, u64 val)
+{
+    fdt64_t v = cpu_to_fdt64(val);
+
+    dt_build_prop(b, name, &v, sizeof(v));
+}
+
+void dt_build_prop_string(struct dt_builder *b, const char *name, const char *str)
+{
+    dt_build_prop(b, name, str, strlen(str) + 1);
+}
+
+static int dt_find_string(const void *fdt, const char *name)
+{
+    const char *strtab = (const char *)fdt + fdt_off_dt_strings(fdt);
+    u32 size = fdt_size_dt_strings(fdt);
+    size_t len = strlen(name) + 1;
+    u32 off = 0;
+
+    while (off + len <= size) {
+        if (!memcmp(strtab + off, name, len))
+            return off;
+        off += strlen(strtab + off) + 1;
+    }
+
+    return -1;
+}
+
+int dt_build_commit(struct dt_builder *b)
+{
+    void *fdt = b->fdt;
+
+    if (b->err)
+        return b->err;
+    if (!b->nprops)
+        return 0;
+
+    u32 struct_off = fdt_off_dt_struct(fdt);
+    u32 struct_size = fdt_size_dt_struct(fdt);
+    u32 strings_off = fdt_off_dt_strings(fdt);
+    u32 strings_size = fdt_size_dt_strings(fdt);
+
+    // The splice below assumes the standard fdt_open_into() layout with the
+    // strings block last; fall back to one-at-a-time setprop otherwise.
+    if (strings_off < struct_off + struct_size ||
+        strings_off + strings_size > fdt_totalsize(fdt)) {
+        for (u32 i = 0; i < b->nprops; i++) {
+            int ret = fdt_setprop(fdt, b->node, b->props[i].name, b->buf + b->props[i].off,
+                                  b->props[i].len);
+            if (ret)
+                return ret;
+        }
+        return 0;
+    }
+
+    // Resolve name offsets, planning appends for names not in the table yet
+    int nameoff[DT_BUILD_MAX_PROPS];
+    const char *added[DT_BUILD_MAX_PROPS];
+    u32 n_added = 0, name_bytes = 0, prop_bytes = 0;
+
+    for (u32 i = 0; i < b->nprops; i++) {
+        int off = dt_find_string(fdt, b->props[i].name);
+
+        if (off < 0) {
+            u32 new_off = strings_size;
+
+            for (u32 j = 0; j < n_added; j++) {
+                if (!strcmp(added[j], b->props[i].name)) {
+                    off = new_off;
+                    break;
+                }
+                new_off += strlen(added[j]) + 1;
+            }
+            if (off < 0) {
+                added[n_added++] = b->props[i].name;
+                name_bytes += strlen(b->props[i].name) + 1;
+                off = new_off;
+            }
+        }
+
+        nameoff[i] = off;
+        prop_bytes += sizeof(struct fdt_property) + ALIGN_UP(b->props[i].len, 4);
+    }
+
+    if (strings_off + strings_size + prop_bytes + name_bytes > fdt_totalsize(fdt))
+        return -FDT_ERR_NOSPACE;
+
+    // Find the insertion point: after the node's existing properties
+    int off = b->node, next;
+
+    if (fdt_next_tag(fdt, off, &next) != FDT_BEGIN_NODE)
+        return -FDT_ERR_BADOFFSET;
+
+    int insert = next;
+
+    for (off = next;; off = next) {
+        u32 tag = fdt_next_tag(fdt, off, &next);
+
+        if (tag != FDT_PROP && tag != FDT_NOP)
+            break;
+        insert = next;
+    }
+
+    // One tail move covers the rest of the struct block and the strings block
+    u8 *point = (u8 *)fdt + struct_off + insert;
+    u32 tail = strings_off + strings_size - (struct_off + insert);
+
+    memmove(point + prop_bytes, point, tail);
+
+    // Emit the accumulated properties into the hole
+    for (u32 i = 0; i < b->nprops; i++) {
+        struct fdt_property *prop = (void *)point;
+        u32 len = b->props[i].len;
+
+        prop->tag = cpu_to_fdt32(FDT_PROP);
+        prop->len = cpu_to_fdt32(len);
+        prop->nameoff = cpu_to_fdt32(nameoff[i]);
+        memset(prop->data, 0, ALIGN_UP(len, 4));
+        memcpy(prop->data, b->buf + b->props[i].off, len);
+        point += sizeof(*prop) + ALIGN_UP(len, 4);
+    }
+
+    // Append the new names to the (now shifted) strings block
+    char *name_end = (char *)fdt + strings_off + prop_bytes + strings_size;
+
+    for (u32 i = 0; i < n_added; i++) {
+        size_t len = strlen(added[i]) + 1;
+
+        memcpy(name_end, added[i], len);
+        name_end += len;
+    }
+
+    fdt_set_size_dt_struct(fdt, struct_size + prop_bytes);
+    fdt_set_off_dt_strings(fdt, strings_off + prop_bytes);
+    fdt_set_size_dt_strings(fdt, strings_size + name_bytes);
+
+    return 0;
+}
+
 u64 dt_get_address(void *dt, int node)
 {
     int parent = fdt_parent_offset(dt, node);
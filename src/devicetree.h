@@ -19,4 +19,36 @@ void dt_parse_ranges(void *dt, int node, struct dt_ranges_tbl *ranges);
 u64 dt_translate(struct dt_ranges_tbl *ranges, const fdt64_t *reg);
 u64 dt_get_address(void *dt, int node);
 
+/*
+ * Node builder: accumulate properties for one node and commit them with a
+ * single tail move. Every fdt_setprop() memmoves the rest of the tree, so
+ * setting N properties on a node costs N tail moves; the builder splices all
+ * of them in at once. Unlike fdt_setprop() this never replaces: the
+ * properties must not already exist on the node. Errors are sticky: add
+ * properties without checking and test the result of dt_build_commit().
+ */
+#define DT_BUILD_MAX_PROPS 16
+#define DT_BUILD_BUF_SIZE  512
+
+struct dt_builder {
+    void *fdt;
+    int node;
+    int err;
+    u32 nprops;
+    u32 used;
+    struct {
+        const char *name;
+        u32 off;
+        u32 len;
+    } props[DT_BUILD_MAX_PROPS];
+    u8 buf[DT_BUILD_BUF_SIZE];
+};
+
+void dt_build_start(void *fdt, int node, struct dt_builder *b);
+void dt_build_prop(struct dt_builder *b, const char *name, const void *data, size_t len);
+void dt_build_prop_u32(struct dt_builder *b, const char *name, u32 val);
+void dt_build_prop_u64(struct dt_builder *b, const char *name, u64 val);
+void dt_build_prop_string(struct dt_builder *b, const char *name, const char *str);
+int dt_build_commit(struct dt_builder *b);
+
 #endif
@@ -8,6 +8,7 @@
 #include "dcp.h"
 #include "dcp_iboot.h"
 #include "fb.h"
+#include "hash.h"
 #include "memory.h"
 #include "soc.h"
 #include "string.h"
@@ -32,6 +33,19 @@ static u64 fb_size;
 bool display_is_external;
 bool display_is_dptx;
 
+/*
+ * Last negotiated mode, keyed by a fingerprint of the advertised mode lists
+ * (we never see the raw EDID here) plus the requested config. Lets repeated
+ * display_configure() calls skip the expensive set_mode round trip to DCP
+ * when the same display is still scanning out the mode we already chose.
+ */
+static struct {
+    u64 fingerprint;
+    dcp_timing_mode_t tbest;
+    dcp_color_mode_t cbest;
+    bool valid;
+} mode_cache;
+
 static const display_config_t display_config_m1 = {
     .dcp = "/arm-io/dcp",
     .dcp_dart = "/arm-io/dart-dcp",
@@ -450,7 +464,6 @@ int display_configure(const char *config)
         return -1;
     }
     assert(ret == timing_cnt);
-    display_choose_timing_mode(tmodes, timing_cnt, &tbest, &want);
 
     dcp_color_mode_t *cmodes, cbest;
     if ((ret = dcp_ib_get_color_modes(iboot, &cmodes)) < 0) {
@@ -458,16 +471,58 @@ int display_configure(const char *config)
         return -1;
     }
     assert(ret == color_cnt);
-    display_choose_color_mode(cmodes, color_cnt, &cbest);
-
-    // Set mode
-    if ((ret = dcp_ib_set_mode(iboot, &tbest, &cbest)) < 0) {
-        printf("display: failed to set mode. trying again...\n");
-        mdelay(500);
-        if ((ret = dcp_ib_set_mode(iboot, &tbest, &cbest)) < 0) {
-            printf("display: failed to set mode twice.\n");
-            return ret;
+
+    u64 fingerprint = xxh64(&want, sizeof(want), 0);
+    fingerprint = xxh64(tmodes, timing_cnt * sizeof(*tmodes), fingerprint);
+    fingerprint = xxh64(cmodes, color_cnt * sizeof(*cmodes), fingerprint);
+
+    bool need_modeset = true;
+
+    if (mode_cache.valid && mode_cache.fingerprint == fingerprint &&
+        cur_boot_args.video.width == mode_cache.tbest.width &&
+        cur_boot_args.video.height == mode_cache.tbest.height &&
+        cur_boot_args.video.stride == mode_cache.tbest.width * 4) {
+        printf("display: mode unchanged, skipping modeset\n");
+        tbest = mode_cache.tbest;
+        cbest = mode_cache.cbest;
+        need_modeset = false;
+    } else {
+        display_choose_timing_mode(tmodes, timing_cnt, &tbest, &want);
+        display_choose_color_mode(cmodes, color_cnt, &cbest);
+
+        /*
+         * A different requested config can still resolve to the mode the
+         * display is already scanning out (common during resolution sweeps).
+         * The surface swap below retimes the plane in place, so when the
+         * chosen mode matches what we last programmed and the framebuffer
+         * geometry still agrees, skip set_mode and its blanking period and
+         * keep the fb contents live throughout.
+         */
+        if (mode_cache.valid && cur_boot_args.video.width == tbest.width &&
+            cur_boot_args.video.height == tbest.height &&
+            cur_boot_args.video.stride == tbest.width * 4 &&
+            !memcmp(&tbest, &mode_cache.tbest, sizeof(tbest)) &&
+            !memcmp(&cbest, &mode_cache.cbest, sizeof(cbest))) {
+            printf("display: chosen mode already active, swap-only reconfigure\n");
+            need_modeset = false;
         }
+
+        if (need_modeset) {
+            // Set mode
+            if ((ret = dcp_ib_set_mode(iboot, &tbest, &cbest)) < 0) {
+                printf("display: failed to set mode. trying again...\n");
+                mdelay(500);
+                if ((ret = dcp_ib_set_mode(iboot, &tbest, &cbest)) < 0) {
+                    printf("display: failed to set mode twice.\n");
+                    return ret;
+                }
+            }
+        }
+
+        mode_cache.fingerprint = fingerprint;
+        mode_cache.tbest = tbest;
+        mode_cache.cbest = cbest;
+        mode_cache.valid = true;
     }
 
     u64 fb_pa = cur_boot_args.video.base;
@@ -545,8 +600,12 @@ int display_configure(const char *config)
     printf("display: swapped! (swap_id=%d)\n", ret);
 
     // Wait until the swap completes before powering down DCP
-    // 50ms is too low, 100 works, 150 for good measure
-    mdelay(150);
+    // 50ms is too low, 100 works, 150 for good measure. A swap-only
+    // reconfigure has no mode switch to settle; one frame is enough.
+    if (need_modeset)
+        mdelay(150);
+    else
+        mdelay((((1000 << 16) + tbest.fps - 1) / tbest.fps) + 1);
 
     bool reinit = false;
     if (fb_pa != cur_boot_args.video.base || cur_boot_args.video.stride != stride ||
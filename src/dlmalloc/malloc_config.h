@@ -5,6 +5,8 @@
 #include "../heapblock.h"
 #include "../utils.h"
 
+#define USE_DL_PREFIX      // the public API lives in ../malloc.c
+#define MALLOC_INSPECT_ALL 1 // heap walk for malloc_get_stats()
 #define HAVE_MORECORE 1
 #define HAVE_MMAP     0
 #define MORECORE      sbrk
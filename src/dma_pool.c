@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "dma_pool.h"
+#include "malloc.h"
+#include "string.h"
+#include "utils.h"
+
+#define DMA_POOL_SLOTS 32
+
+struct dma_buf {
+    void *ptr;
+    size_t size;
+    bool used;
+};
+
+static struct dma_buf dma_bufs[DMA_POOL_SLOTS];
+
+void *dma_pool_alloc(size_t size)
+{
+    struct dma_buf *spare = NULL;
+
+    size = ALIGN_UP(size, SZ_16K);
+
+    for (int i = 0; i < DMA_POOL_SLOTS; i++) {
+        struct dma_buf *buf = &dma_bufs[i];
+        if (!buf->ptr) {
+            if (!spare)
+                spare = buf;
+            continue;
+        }
+        if (!buf->used && buf->size == size) {
+            buf->used = true;
+            memset(buf->ptr, 0, size);
+            return buf->ptr;
+        }
+    }
+
+    if (!spare) {
+        printf("dma_pool: out of slots for %ld byte buffer\n", size);
+        return NULL;
+    }
+
+    spare->ptr = memalign(SZ_16K, size);
+    if (!spare->ptr)
+        return NULL;
+
+    spare->size = size;
+    spare->used = true;
+    memset(spare->ptr, 0, size);
+    return spare->ptr;
+}
+
+void dma_pool_free(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    for (int i = 0; i < DMA_POOL_SLOTS; i++) {
+        if (dma_bufs[i].ptr == ptr) {
+            dma_bufs[i].used = false;
+            return;
+        }
+    }
+
+    printf("dma_pool: free of unknown buffer %p\n", ptr);
+}
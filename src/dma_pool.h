@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef DMA_POOL_H
+#define DMA_POOL_H
+
+#include "types.h"
+
+/*
+ * Recycling allocator for DMA buffers. DMA on these SoCs is cache-coherent,
+ * but drivers that come and go across proxy sessions (NVMe, USB) used to
+ * memalign()/free() their queue and transfer buffers on every init/shutdown
+ * cycle. Recycling whole buffers by size class keeps the addresses stable
+ * across restarts and spares the main heap repeated large aligned blocks.
+ *
+ * All buffers are 16K-aligned (the strictest alignment any DMA user needs)
+ * and returned zeroed.
+ */
+
+void *dma_pool_alloc(size_t size);
+void dma_pool_free(void *ptr);
+
+#endif
@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "evtlog.h"
+#include "utils.h"
+
+struct evtlog evtlog = {
+    .magic = EVTLOG_MAGIC,
+    .num_cpus = MAX_CPUS,
+    .ring_size = EVTLOG_RING_SIZE,
+    .ent_size = sizeof(struct evt_entry),
+};
+
+void evt_log(u32 id, u32 arg)
+{
+    struct evt_cpulog *log = &evtlog.cpu[smp_id()];
+    struct evt_entry *ent = &log->ring[log->wptr & (EVTLOG_RING_SIZE - 1)];
+
+    ent->ts = mrs(CNTPCT_EL0);
+    ent->id = id;
+    ent->arg = arg;
+    log->wptr++;
+}
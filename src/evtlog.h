@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef EVTLOG_H
+#define EVTLOG_H
+
+#include "smp.h"
+#include "types.h"
+
+/*
+ * Lightweight always-on boot instrumentation: a per-CPU ring of
+ * {CNTPCT timestamp, event id, argument} records. The hot path is a counter
+ * read and one store, so events are cheap enough to leave in release builds.
+ * The host grabs the whole thing via P_EVTLOG_GET and attributes boot time
+ * offline.
+ */
+
+#define EVTLOG_MAGIC     0x4c545645 // 'EVTL'
+#define EVTLOG_RING_SIZE 128
+
+enum evt_id {
+    EVT_NONE = 0,
+    /* startup / main */
+    EVT_MAIN_START,
+    EVT_HEAP_READY,
+    EVT_MMU_READY,
+    EVT_PMGR_READY,
+    EVT_DISPLAY_READY,
+    EVT_INIT_DONE,
+    EVT_NEXT_STAGE,
+    /* payload */
+    EVT_PAYLOAD_SCAN,
+    EVT_DECOMPRESS_START,
+    EVT_DECOMPRESS_DONE,
+    /* kboot */
+    EVT_KBOOT_DT_START,
+    EVT_KBOOT_DT_DONE,
+    EVT_KBOOT_BOOT,
+    /* smp */
+    EVT_SMP_START,
+    EVT_SMP_CPU_UP,
+    EVT_SMP_DONE,
+    /* dart: latched translation fault (error word, then faulting page) */
+    EVT_DART_FAULT,
+    EVT_DART_FAULT_ADDR,
+};
+
+struct evt_entry {
+    u64 ts;
+    u32 id;
+    u32 arg;
+};
+
+struct evt_cpulog {
+    u64 wptr;
+    struct evt_entry ring[EVTLOG_RING_SIZE];
+} ALIGNED(64);
+
+struct evtlog {
+    u32 magic;
+    u32 num_cpus;
+    u32 ring_size;
+    u32 ent_size;
+    struct evt_cpulog cpu[MAX_CPUS];
+};
+
+extern struct evtlog evtlog;
+
+void evt_log(u32 id, u32 arg);
+
+#define EVT(id, arg) evt_log(EVT_##id, (u32)(arg))
+
+#endif
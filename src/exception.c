@@ -21,6 +21,67 @@ extern char _el1_vectors_start[0];
 volatile enum exc_guard_t exc_guard = GUARD_OFF;
 volatile int exc_count = 0;
 
+/* Pre-armed resume address for the probe primitives, 0 when disarmed */
+static volatile u64 exc_fixup = 0;
+
+/*
+ * The probe primitives arm exc_fixup with a local resume label; on a fault
+ * the handlers redirect there with the register state from the fault point,
+ * so the pre-zeroed flag register reads back as set by the resume stub. The
+ * dsb after the access keeps async external aborts (the usual response from
+ * unmapped MMIO holes) inside the armed window.
+ */
+#define PROBE_READ(name, type, insn, reg)                                                          \
+    int name(u64 addr, type *val)                                                                  \
+    {                                                                                              \
+        u64 fault;                                                                                 \
+        type v;                                                                                    \
+        asm volatile("adr %0, 1f\n"                                                                \
+                     "\tstr %0, %2\n"                                                              \
+                     "\tmov %0, #0\n"                                                              \
+                     "\t" insn " %" reg "1, [%3]\n"                                                \
+                     "\tdsb sy\n"                                                                  \
+                     "\tb 2f\n"                                                                    \
+                     "1:\n"                                                                        \
+                     "\tmov %0, #1\n"                                                              \
+                     "2:\n"                                                                        \
+                     : "=&r"(fault), "=&r"(v), "+m"(exc_fixup)                                     \
+                     : "r"(addr)                                                                   \
+                     : "memory");                                                                  \
+        exc_fixup = 0;                                                                             \
+        if (fault)                                                                                 \
+            return -1;                                                                             \
+        *val = v;                                                                                  \
+        return 0;                                                                                  \
+    }
+
+#define PROBE_WRITE(name, type, insn, reg)                                                         \
+    int name(u64 addr, type val)                                                                   \
+    {                                                                                              \
+        u64 fault;                                                                                 \
+        asm volatile("adr %0, 1f\n"                                                                \
+                     "\tstr %0, %1\n"                                                              \
+                     "\tmov %0, #0\n"                                                              \
+                     "\t" insn " %" reg "2, [%3]\n"                                                \
+                     "\tdsb sy\n"                                                                  \
+                     "\tb 2f\n"                                                                    \
+                     "1:\n"                                                                        \
+                     "\tmov %0, #1\n"                                                              \
+                     "2:\n"                                                                        \
+                     : "=&r"(fault), "+m"(exc_fixup)                                               \
+                     : "r"(val), "r"(addr)                                                         \
+                     : "memory");                                                                  \
+        exc_fixup = 0;                                                                             \
+        return fault ? -1 : 0;                                                                     \
+    }
+
+PROBE_READ(probe_read8, u8, "ldrb", "w")
+PROBE_READ(probe_read16, u16, "ldrh", "w")
+PROBE_READ(probe_read32, u32, "ldr", "w")
+PROBE_READ(probe_read64, u64, "ldr", "")
+PROBE_WRITE(probe_write32, u32, "str", "w")
+PROBE_WRITE(probe_write64, u64, "str", "")
+
 void el0_ret(void);
 void el1_ret(void);
 
@@ -222,6 +283,18 @@ void exc_sync(u64 *regs)
     int el12 = 0;
     bool in_gl = in_gl12();
 
+    if (exc_fixup) {
+        // Pre-armed probe: redirect and skip the diagnostic machinery
+        u64 sts = mrs(SYS_IMP_APL_L2C_ERR_STS);
+        msr(SYS_IMP_APL_L2C_ERR_STS, sts);
+        if (in_gl)
+            msr(SYS_IMP_APL_ELR_GL1, exc_fixup);
+        else
+            msr(ELR_EL1, exc_fixup);
+        exc_count++;
+        return;
+    }
+
     u64 spsr = in_gl ? mrs(SYS_IMP_APL_SPSR_GL1) : mrs(SPSR_EL1);
     u64 esr = in_gl ? mrs(SYS_IMP_APL_ESR_GL1) : mrs(ESR_EL1);
     u64 elr = in_gl ? mrs(SYS_IMP_APL_ELR_GL1) : mrs(ELR_EL1);
@@ -307,16 +380,20 @@ void exc_sync(u64 *regs)
 void exc_irq(u64 *regs)
 {
     u64 spsr = in_gl12() ? mrs(SYS_IMP_APL_SPSR_GL1) : mrs(SPSR_EL1);
-    u32 reason = aic_ack();
+    u32 events[32];
+    int n = aic_ack_batch(events, ARRAY_SIZE(events));
+
+    if (!n)
+        printf("Exception: spurious IRQ (from %s) mpidr: %lx cnt: %lx\n",
+               get_exception_source(spsr), mrs(MPIDR_EL1), mrs(CNTPCT_EL0));
 
-    do {
+    for (int i = 0; i < n; i++) {
+        u32 reason = events[i];
         printf("Exception: IRQ (from %s) die: %lu type: %lu num: %lu mpidr: %lx cnt: %lx\n",
                get_exception_source(spsr), FIELD_GET(AIC_EVENT_DIE, reason),
                FIELD_GET(AIC_EVENT_TYPE, reason), FIELD_GET(AIC_EVENT_NUM, reason), mrs(MPIDR_EL1),
                mrs(CNTPCT_EL0));
-
-        reason = aic_ack();
-    } while (reason);
+    }
 
     UNUSED(regs);
     // print_regs(regs);
@@ -374,6 +451,16 @@ void exc_fiq(u64 *regs)
 
 void exc_serr(u64 *regs)
 {
+    if (exc_fixup) {
+        // A probe poked something that answered with an async abort
+        if (in_gl12())
+            msr(SYS_IMP_APL_ELR_GL1, exc_fixup);
+        else
+            msr(ELR_EL1, exc_fixup);
+        exc_count++;
+        return;
+    }
+
     if (!(exc_guard & GUARD_SILENT))
         printf("Exception: SError\n");
 
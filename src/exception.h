@@ -50,6 +50,19 @@ void print_regs(u64 *regs, int el12);
 uint64_t el0_call(void *func, uint64_t a, uint64_t b, uint64_t c, uint64_t d);
 uint64_t el1_call(void *func, uint64_t a, uint64_t b, uint64_t c, uint64_t d);
 
+/*
+ * Exception-safe probe primitives for fault-dense sweeps. Unlike the
+ * exc_guard path, these pre-arm a fixup address, so the handler bypasses the
+ * whole diagnostic machinery and a faulting access costs little more than
+ * the register save/restore. Return 0, or -1 if the access faulted.
+ */
+int probe_read8(u64 addr, u8 *val);
+int probe_read16(u64 addr, u16 *val);
+int probe_read32(u64 addr, u32 *val);
+int probe_read64(u64 addr, u64 *val);
+int probe_write32(u64 addr, u32 val);
+int probe_write64(u64 addr, u64 val);
+
 #endif
 
 #endif
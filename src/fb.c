@@ -2,6 +2,7 @@
 
 #include "fb.h"
 #include "assert.h"
+#include "hash.h"
 #include "iodev.h"
 #include "malloc.h"
 #include "memory.h"
@@ -40,10 +41,29 @@ static struct {
         u32 cols;
     } margin;
 
+    /*
+     * Scroll ring: logical console row r is stored at shadow font row
+     * (row_base + r) % max_row, so scrolling just advances the base and
+     * clears one row instead of moving every pixel row. fb_update()
+     * de-rotates the console columns when copying to the hardware.
+     */
+    u32 row_base;
+
+    /*
+     * Text shadow of the visible console (ring-indexed like the pixels) and
+     * the scrollback ring holding lines that scrolled off, space padded to
+     * max_col. sb_wptr counts every line ever pushed.
+     */
+    u8 *text;
+    u8 *scrollback;
+    u32 sb_wptr;
+
     bool initialized;
     bool active;
 } console;
 
+#define FB_SCROLLBACK_LINES 1024
+
 extern u8 _binary_build_bootlogo_128_bin_start[];
 extern u8 _binary_build_bootlogo_256_bin_start[];
 
@@ -65,33 +85,147 @@ const struct image logo_256 = {
 const struct image *logo;
 struct image orig_logo;
 
+/*
+ * Dirty row range of the shadow buffer ([y0, y1) in pixel rows), so
+ * fb_update() only has to touch the uncached framebuffer for lines that
+ * actually changed.
+ */
+static struct {
+    u32 y0;
+    u32 y1;
+} fb_dirty;
+
+static inline void fb_mark_dirty(u32 y0, u32 y1)
+{
+    fb_dirty.y0 = min(fb_dirty.y0, y0);
+    fb_dirty.y1 = max(fb_dirty.y1, y1);
+}
+
+static inline void fb_mark_dirty_all(void)
+{
+    fb_mark_dirty(0, fb.height);
+}
+
 void fb_update(void)
 {
-    memcpy128(fb.hwptr, fb.ptr, fb.size);
+    u32 y0 = min(fb_dirty.y0, fb.height);
+    u32 y1 = min(fb_dirty.y1, fb.height);
+
+    if (y0 >= y1)
+        return;
+
+    if (!console.initialized || !console.row_base) {
+        size_t start = ALIGN_DOWN((size_t)y0 * fb.stride * 4, 16);
+        size_t end = min((size_t)fb.size, ALIGN_UP((size_t)y1 * fb.stride * 4, 16));
+
+        memcpy128((u8 *)fb.hwptr + start, (u8 *)fb.ptr + start, end - start);
+    } else {
+        /*
+         * The console region is stored rotated (see row_base): de-rotate the
+         * console columns row by row, straight-copy everything else.
+         */
+        const u32 fh = console.font.height;
+        const u32 ctop = console.margin.rows * fh;
+        const u32 cbot = ctop + console.cursor.max_row * fh;
+        const u32 cwidth = (console.margin.cols + console.cursor.max_col) * console.font.width;
+
+        for (u32 y = y0; y < y1; y++) {
+            u32 *src = fb.ptr + (size_t)y * fb.stride;
+            u32 *dst = fb.hwptr + (size_t)y * fb.stride;
+
+            if (y >= ctop && y < cbot) {
+                u32 row = (console.row_base + (y - ctop) / fh) % console.cursor.max_row;
+                u32 ysrc = ctop + row * fh + (y - ctop) % fh;
+
+                memcpy32(dst, fb.ptr + (size_t)ysrc * fb.stride, cwidth * 4);
+                memcpy32(dst + cwidth, src + cwidth, (fb.stride - cwidth) * 4);
+            } else {
+                memcpy32(dst, src, fb.stride * 4);
+            }
+        }
+    }
+
+    fb_dirty.y0 = fb.height;
+    fb_dirty.y1 = 0;
+}
+
+static u32 *fb_capture_buf;
+static size_t fb_capture_buf_size;
+static u64 fb_capture_last_hash;
+
+/*
+ * Snapshot the scanout buffer for the host. There is no vsync event we can
+ * hook (the DCP endpoints we drive are command/response only), so captures
+ * are polled: hash the live framebuffer, and if it changed since the last
+ * snapshot, copy it into a stable RAM buffer the host can then pull over the
+ * bulk pipe at its leisure while scanout continues. Unchanged frames cost one
+ * hash pass and no copy.
+ */
+int fb_capture(struct fb_capture_info *info)
+{
+    if (!fb.hwptr || !fb.size)
+        return -1;
+
+    u64 hash = xxh64(fb.hwptr, fb.size, 0);
+    if (fb_capture_buf && fb_capture_buf_size == fb.size && hash == fb_capture_last_hash)
+        return 0;
+
+    if (fb_capture_buf_size != fb.size) {
+        free(fb_capture_buf);
+        fb_capture_buf = malloc(fb.size);
+        if (!fb_capture_buf) {
+            fb_capture_buf_size = 0;
+            return -1;
+        }
+        fb_capture_buf_size = fb.size;
+    }
+
+    memcpy128(fb_capture_buf, fb.hwptr, fb.size);
+    fb_capture_last_hash = hash;
+
+    info->addr = (u64)fb_capture_buf;
+    info->size = fb.size;
+    info->stride = fb.stride;
+    info->width = fb.width;
+    info->height = fb.height;
+    info->depth = fb.depth;
+
+    return 1;
+}
+
+/* Shadow ring row backing logical console row */
+static u32 fb_ring_row(u32 row)
+{
+    return (console.row_base + row) % console.cursor.max_row;
 }
 
 static void fb_clear_font_row(u32 row)
 {
     const u32 row_size = (console.margin.cols + console.cursor.max_col) * console.font.width * 4;
-    const u32 ystart = (console.margin.rows + row) * console.font.height * fb.stride;
+    const u32 y0 = (console.margin.rows + fb_ring_row(row)) * console.font.height;
+    const u32 yd = (console.margin.rows + row) * console.font.height;
+    const u32 ystart = y0 * fb.stride;
 
     for (u32 y = 0; y < console.font.height; ++y)
         memset32(fb.ptr + ystart + y * fb.stride, 0, row_size);
-}
 
-static void fb_move_font_row(u32 dst, u32 src)
-{
-    const u32 row_size = (console.margin.cols + console.cursor.max_col) * console.font.width * 4;
-    u32 ysrc = (console.margin.rows + src) * console.font.height;
-    u32 ydst = (console.margin.rows + dst) * console.font.height;
+    if (console.text)
+        memset(console.text + fb_ring_row(row) * console.cursor.max_col, ' ',
+               console.cursor.max_col);
 
-    ysrc *= fb.stride;
-    ydst *= fb.stride;
+    fb_mark_dirty(yd, yd + console.font.height);
+}
 
-    for (u32 y = 0; y < console.font.height; ++y)
-        memcpy32(fb.ptr + ydst + y * fb.stride, fb.ptr + ysrc + y * fb.stride, row_size);
+/* Copy a line about to scroll off into the scrollback ring */
+static void fb_scrollback_push(u32 row)
+{
+    if (!console.scrollback || !console.text)
+        return;
 
-    fb_clear_font_row(src);
+    memcpy(console.scrollback +
+               (console.sb_wptr % FB_SCROLLBACK_LINES) * console.cursor.max_col,
+           console.text + fb_ring_row(row) * console.cursor.max_col, console.cursor.max_col);
+    console.sb_wptr++;
 }
 
 static inline u32 rgb2pixel_30(rgb_t c)
@@ -107,6 +241,7 @@ static inline rgb_t pixel2rgb_30(u32 c)
 static inline void fb_set_pixel(u32 x, u32 y, rgb_t c)
 {
     fb.ptr[x + y * fb.stride] = rgb2pixel_30(c);
+    fb_mark_dirty(y, y + 1);
 }
 
 static inline rgb_t fb_get_pixel(u32 x, u32 y)
@@ -160,6 +295,7 @@ void fb_fill(u32 x, u32 y, u32 w, u32 h, rgb_t color)
     u32 c = rgb2pixel_30(color);
     for (u32 i = 0; i < h; i++)
         memset32(&fb.ptr[x + (y + i) * fb.stride], c, w * 4);
+    fb_mark_dirty(y, y + h);
     fb_update();
 }
 
@@ -167,6 +303,7 @@ void fb_clear(rgb_t color)
 {
     u32 c = rgb2pixel_30(color);
     memset32(fb.ptr, c, fb.stride * fb.height * 4);
+    fb_mark_dirty_all();
     fb_update();
 }
 
@@ -213,9 +350,12 @@ void fb_improve_logo(void)
     }
 }
 
+#define FONT_FIRST_CHAR 0x20
+#define FONT_NUM_GLYPHS 95
+
 static inline rgb_t font_get_pixel(u8 c, u32 x, u32 y)
 {
-    c -= 0x20;
+    c -= FONT_FIRST_CHAR;
     u8 v =
         console.font.ptr[c * console.font.width * console.font.height + y * console.font.width + x];
 
@@ -223,14 +363,56 @@ static inline rgb_t font_get_pixel(u8 c, u32 x, u32 y)
     return col;
 }
 
+/*
+ * Glyphs pre-expanded from the 8bpp grayscale font into native framebuffer
+ * pixels, so the console write path is a straight row copy per character.
+ */
+static u32 *glyph_cache;
+
+static void fb_prerender_font(void)
+{
+    const u32 w = console.font.width;
+    const u32 h = console.font.height;
+
+    glyph_cache = malloc(FONT_NUM_GLYPHS * w * h * 4);
+    if (!glyph_cache)
+        return; // fb_putbyte falls back to per-pixel expansion
+
+    u32 *p = glyph_cache;
+    for (u32 c = 0; c < FONT_NUM_GLYPHS; c++)
+        for (u32 y = 0; y < h; y++)
+            for (u32 x = 0; x < w; x++)
+                *p++ = rgb2pixel_30(font_get_pixel(c + FONT_FIRST_CHAR, x, y));
+}
+
 static void fb_putbyte(u8 c)
 {
     u32 x = (console.margin.cols + console.cursor.col) * console.font.width;
-    u32 y = (console.margin.rows + console.cursor.row) * console.font.height;
+    u32 y = (console.margin.rows + fb_ring_row(console.cursor.row)) * console.font.height;
+    u32 yd = (console.margin.rows + console.cursor.row) * console.font.height;
+
+    if (console.text)
+        console.text[fb_ring_row(console.cursor.row) * console.cursor.max_col +
+                     console.cursor.col] = c;
+
+    if (glyph_cache) {
+        const u32 w = console.font.width;
+        const u32 h = console.font.height;
+        u32 *glyph = &glyph_cache[(c - FONT_FIRST_CHAR) * w * h];
+        u32 *dst = &fb.ptr[x + y * fb.stride];
+
+        for (u32 i = 0; i < h; i++)
+            memcpy32(dst + i * fb.stride, glyph + i * w, w * 4);
+
+        fb_mark_dirty(yd, yd + h);
+        return;
+    }
 
     for (u32 i = 0; i < console.font.height; i++)
         for (u32 j = 0; j < console.font.width; j++)
-            fb_set_pixel(x + j, y + i, font_get_pixel(c, j, i));
+            fb.ptr[(x + j) + (y + i) * fb.stride] = rgb2pixel_30(font_get_pixel(c, j, i));
+
+    fb_mark_dirty(yd, yd + console.font.height);
 }
 
 static void fb_putchar(u8 c)
@@ -259,13 +441,35 @@ static void fb_putchar(u8 c)
 
 void fb_console_scroll(u32 n)
 {
-    u32 row = 0;
     n = min(n, console.cursor.row);
-    for (; row < console.cursor.max_row - n; ++row)
-        fb_move_font_row(row, row + n);
-    for (; row < console.cursor.max_row; ++row)
+    for (u32 row = 0; row < n; ++row)
+        fb_scrollback_push(row);
+    console.row_base = (console.row_base + n) % console.cursor.max_row;
+    for (u32 row = console.cursor.max_row - n; row < console.cursor.max_row; ++row)
         fb_clear_font_row(row);
     console.cursor.row -= n;
+
+    /* every visible console line moved */
+    fb_mark_dirty(console.margin.rows * console.font.height,
+                  (console.margin.rows + console.cursor.max_row) * console.font.height);
+}
+
+/*
+ * Expose the scrollback ring to the host. lines counts every line ever
+ * pushed; the ring holds the last min(lines, max_lines) of them, each
+ * line_len bytes and space padded, line n living at
+ * addr + (n % max_lines) * line_len.
+ */
+int fb_console_scrollback(struct fb_scrollback_info *info)
+{
+    if (!console.initialized || !console.scrollback)
+        return -1;
+
+    info->addr = (u64)console.scrollback;
+    info->lines = console.sb_wptr;
+    info->line_len = console.cursor.max_col;
+    info->max_lines = FB_SCROLLBACK_LINES;
+    return 0;
 }
 
 void fb_console_reserve_lines(u32 n)
@@ -317,6 +521,7 @@ struct iodev iodev_fb = {
 
 static void fb_clear_console(void)
 {
+    console.row_base = 0;
     for (u32 row = 0; row < console.cursor.max_row; ++row)
         fb_clear_font_row(row);
 
@@ -337,6 +542,25 @@ void fb_clear_direct(void)
 
 void fb_init(bool clear)
 {
+    /*
+     * Warm path: if the framebuffer geometry is unchanged since the last
+     * init, the mapping, shadow buffer and prerendered font are still valid,
+     * so skip the reprogramming (and the shadow realloc) and just reset the
+     * console. The proxy re-runs this on every restart cycle.
+     */
+    if (console.initialized && fb.hwptr == (void *)cur_boot_args.video.base &&
+        fb.stride == cur_boot_args.video.stride / 4 && fb.width == cur_boot_args.video.width &&
+        fb.height == cur_boot_args.video.height &&
+        fb.depth == (cur_boot_args.video.depth & FB_DEPTH_MASK)) {
+        if (clear) {
+            memset32(fb.ptr, 0, fb.size);
+            fb_mark_dirty_all();
+        }
+        console.active = false;
+        fb_clear_console();
+        return;
+    }
+
     fb.hwptr = (void *)cur_boot_args.video.base;
     fb.stride = cur_boot_args.video.stride / 4;
     fb.width = cur_boot_args.video.width;
@@ -350,6 +574,8 @@ void fb_init(bool clear)
 
     fb.ptr = malloc(fb.size);
     memcpy(fb.ptr, fb.hwptr, fb.size);
+    fb_dirty.y0 = fb.height;
+    fb_dirty.y1 = 0;
 
     if (cur_boot_args.video.depth & FB_DEPTH_FLAG_RETINA) {
         logo = &logo_256;
@@ -370,8 +596,10 @@ void fb_init(bool clear)
                         &orig_logo);
     }
 
-    if (clear)
+    if (clear) {
         memset32(fb.ptr, 0, fb.size);
+        fb_mark_dirty_all();
+    }
 
     console.margin.rows = 2;
     console.margin.cols = 4;
@@ -382,6 +610,13 @@ void fb_init(bool clear)
     console.cursor.max_col =
         ((fb.width - logo->width) / 2) / console.font.width - 2 * console.margin.cols;
 
+    // NULL-tolerant: without these the console works, just without scrollback
+    console.text = malloc(console.cursor.max_row * console.cursor.max_col);
+    console.scrollback = malloc(FB_SCROLLBACK_LINES * console.cursor.max_col);
+    console.sb_wptr = 0;
+
+    fb_prerender_font();
+
     console.initialized = true;
     console.active = false;
 
@@ -411,6 +646,13 @@ void fb_shutdown(bool restore_logo)
         free(orig_logo.ptr);
         orig_logo.ptr = NULL;
     }
+    free(glyph_cache);
+    glyph_cache = NULL;
+    free(console.text);
+    console.text = NULL;
+    free(console.scrollback);
+    console.scrollback = NULL;
+    console.sb_wptr = 0;
     free(fb.ptr);
 }
 
@@ -419,7 +661,30 @@ void fb_reinit(void)
     if (!console.initialized)
         return;
 
+    /*
+     * Carry the console history across the reinit: push the lines still on
+     * screen into the scrollback, then keep the ring itself if the new mode
+     * ends up with the same console width (lines are padded to max_col, so
+     * a width change would misalign the stored lines).
+     */
+    u32 rows = console.cursor.row + (console.cursor.col ? 1 : 0);
+    for (u32 row = 0; row < rows; row++)
+        fb_scrollback_push(row);
+
+    u8 *scrollback = console.scrollback;
+    u32 sb_wptr = console.sb_wptr;
+    u32 sb_line_len = console.cursor.max_col;
+    console.scrollback = NULL;
+
     fb_shutdown(false);
     fb_init(true);
     fb_display_logo();
+
+    if (scrollback && console.scrollback && console.cursor.max_col == sb_line_len) {
+        free(console.scrollback);
+        console.scrollback = scrollback;
+        console.sb_wptr = sb_wptr;
+    } else {
+        free(scrollback);
+    }
 }
@@ -41,6 +41,19 @@ void fb_reinit(void);
 void fb_update(void);
 void fb_set_active(bool active);
 
+/* Filled in by fb_capture() when a new frame is snapshotted */
+struct fb_capture_info {
+    u64 addr;
+    u64 size;
+    u32 stride;
+    u32 width;
+    u32 height;
+    u32 depth;
+};
+
+/* Returns 1 if a new frame was captured, 0 if unchanged, -1 on error */
+int fb_capture(struct fb_capture_info *info);
+
 void fb_blit(u32 x, u32 y, u32 w, u32 h, void *data, u32 stride, pix_fmt_t format);
 void fb_unblit(u32 x, u32 y, u32 w, u32 h, void *data, u32 stride);
 void fb_fill(u32 x, u32 y, u32 w, u32 h, rgb_t color);
@@ -55,4 +68,14 @@ void fb_console_scroll(u32 n);
 void fb_console_reserve_lines(u32 n);
 ssize_t fb_console_write(const char *bfr, size_t len);
 
+/* Filled in by fb_console_scrollback(); see the comment there */
+struct fb_scrollback_info {
+    u64 addr;
+    u32 lines;
+    u32 line_len;
+    u32 max_lines;
+};
+
+int fb_console_scrollback(struct fb_scrollback_info *info);
+
 #endif
@@ -12,6 +12,9 @@
 struct fw_version_info os_firmware;
 struct fw_version_info system_firmware;
 
+u32 os_fw_key;
+u32 fw_caps;
+
 #define bail(...)                                                                                  \
     do {                                                                                           \
         printf(__VA_ARGS__);                                                                       \
@@ -67,6 +70,31 @@ static void detect_firmware(struct fw_version_info *info, const char *ver)
     info->iboot = ver;
 }
 
+static u32 fw_version_key(const struct fw_version_info *info)
+{
+    u32 num[3] = {0};
+
+    for (size_t i = 0; i < min(info->num_length, ARRAY_SIZE(num)); i++)
+        num[i] = min(info->num[i], 0xffu);
+
+    return FW_VER_KEY(num[0], num[1], num[2]);
+}
+
+static void derive_caps(void)
+{
+    enum fw_version v = os_firmware.version;
+
+    fw_caps = 0;
+    if (v >= V13_3)
+        fw_caps |= FW_CAP_DCP_SWAP_V13_3;
+    if (v == V13_5)
+        fw_caps |= FW_CAP_DCP_DPTX;
+    if (v >= V13_5)
+        fw_caps |= FW_CAP_DCPEXT;
+    if (v != V_UNKNOWN && v <= V13_3)
+        fw_caps |= FW_CAP_CLUSTER_PSTATE_FIXUP;
+}
+
 int firmware_init(void)
 {
     int node = adt_path_offset(adt, "/chosen");
@@ -95,5 +123,8 @@ int firmware_init(void)
         return -1;
     }
 
+    os_fw_key = fw_version_key(&os_firmware);
+    derive_caps();
+
     return 0;
 }
@@ -38,6 +38,22 @@ extern struct fw_version_info os_firmware;
 extern struct fw_version_info system_firmware;
 extern const struct fw_version_info fw_versions[NUM_FW_VERSIONS];
 
+/*
+ * Packed comparable key for the detected OS firmware (major/minor/patch, one
+ * byte each), and capability flags derived from it once at firmware_init()
+ * time. Subsystems test a flag instead of each encoding its own
+ * version-range knowledge.
+ */
+#define FW_VER_KEY(maj, min, patch) (((maj) << 16) | ((min) << 8) | (patch))
+
+#define FW_CAP_DCP_SWAP_V13_3       BIT(0) // iBoot DCP swap call uses the 13.3 layout
+#define FW_CAP_DCP_DPTX             BIT(1) // dptx-phy display bring-up supported (13.5 only)
+#define FW_CAP_DCPEXT               BIT(2) // dcpext nodes are live and need carveouts
+#define FW_CAP_CLUSTER_PSTATE_FIXUP BIT(3) // old enough to need the stage-1 P-state fixup
+
+extern u32 os_fw_key;
+extern u32 fw_caps;
+
 int firmware_init(void);
 int firmware_set_fdt(void *fdt, int node, const char *prop, const struct fw_version_info *ver);
 
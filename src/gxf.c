@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: MIT */
 
+#include "assert.h"
 #include "cpu_regs.h"
 #include "exception.h"
 #include "gxf.h"
@@ -44,6 +45,49 @@ bool in_gl12(void)
     return (mrs(SYS_IMP_APL_GXF_STATUS_EL1) & GXF_STATUS_GUARDED);
 }
 
+/*
+ * Batched guarded calls: gl_call() pays four synchronized sysreg writes per
+ * invocation to toggle SPRR and GXF around the lane switch. A batch keeps
+ * both enabled across its scope (the hypervisor runs that way permanently,
+ * so plain EL2 code is fine under it), which reduces each gl_call() inside
+ * to just the genter round trip. Per-CPU and nestable.
+ */
+static int gl_batch_depth[MAX_CPUS];
+static u64 gl_batch_sprr[MAX_CPUS];
+static u64 gl_batch_gxf[MAX_CPUS];
+
+void gxf_batch_begin(void)
+{
+    int cpu = smp_id();
+
+    if (gl_batch_depth[cpu]++)
+        return;
+
+    u64 sprr_state = mrs(SYS_IMP_APL_SPRR_CONFIG_EL1);
+    gl_batch_sprr[cpu] = sprr_state;
+    if (!(sprr_state & SPRR_CONFIG_EN))
+        reg_set_sync(SYS_IMP_APL_SPRR_CONFIG_EL1, sprr_state | SPRR_CONFIG_EN);
+
+    u64 gxf_state = mrs(SYS_IMP_APL_GXF_CONFIG_EL1);
+    gl_batch_gxf[cpu] = gxf_state;
+    if (!(gxf_state & GXF_CONFIG_EN))
+        reg_set_sync(SYS_IMP_APL_GXF_CONFIG_EL1, gxf_state | GXF_CONFIG_EN);
+}
+
+void gxf_batch_end(void)
+{
+    int cpu = smp_id();
+
+    assert(gl_batch_depth[cpu]);
+    if (--gl_batch_depth[cpu])
+        return;
+
+    if (!(gl_batch_gxf[cpu] & GXF_CONFIG_EN))
+        msr_sync(SYS_IMP_APL_GXF_CONFIG_EL1, gl_batch_gxf[cpu]);
+    if (!(gl_batch_sprr[cpu] & SPRR_CONFIG_EN))
+        msr_sync(SYS_IMP_APL_SPRR_CONFIG_EL1, gl_batch_sprr[cpu]);
+}
+
 static uint64_t gl_call(void *func, uint64_t a, uint64_t b, uint64_t c, uint64_t d)
 {
     // disable the MMU first since enabling SPRR will change the meaning of all
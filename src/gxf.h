@@ -17,6 +17,10 @@ void gxf_init(void);
 uint64_t gl1_call(void *func, uint64_t a, uint64_t b, uint64_t c, uint64_t d);
 uint64_t gl2_call(void *func, uint64_t a, uint64_t b, uint64_t c, uint64_t d);
 
+/* Keep SPRR/GXF enabled across a run of guarded calls; per-CPU, nestable. */
+void gxf_batch_begin(void);
+void gxf_batch_end(void);
+
 #endif
 
 #endif
@@ -0,0 +1,280 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "hash.h"
+#include "string.h"
+#include "utils.h"
+
+/*
+ * CRC32 (IEEE). All Apple cores implement the ARMv8 CRC32 instructions
+ * (ID_AA64ISAR0_EL1.CRC32), which operate on general registers and so are
+ * fine under -mgeneral-regs-only, but keep a nibble-table fallback so the
+ * primitive works anywhere.
+ */
+#define ID_AA64ISAR0_CRC32 GENMASK(19, 16)
+
+static const u32 crc32_tab[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4,
+    0x4db26158, 0x5005713c, 0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
+
+static bool crc32_have_insn(void)
+{
+    static int have = -1;
+
+    if (have < 0)
+        have = FIELD_GET(ID_AA64ISAR0_CRC32, mrs(ID_AA64ISAR0_EL1)) != 0;
+
+    return have;
+}
+
+u32 crc32_update(u32 crc, const void *buf, size_t len)
+{
+    const u8 *d = buf;
+
+    if (crc32_have_insn()) {
+        while (len && ((u64)d & 7)) {
+            __asm__("crc32b %w0, %w0, %w1" : "+r"(crc) : "r"((u32)*d++));
+            len--;
+        }
+        while (len >= 8) {
+            u64 v;
+            memcpy(&v, d, sizeof(v));
+            __asm__("crc32x %w0, %w0, %x1" : "+r"(crc) : "r"(v));
+            d += 8;
+            len -= 8;
+        }
+        while (len--)
+            __asm__("crc32b %w0, %w0, %w1" : "+r"(crc) : "r"((u32)*d++));
+
+        return crc;
+    }
+
+    while (len--) {
+        crc ^= *d++;
+        crc = crc32_tab[crc & 0x0f] ^ (crc >> 4);
+        crc = crc32_tab[crc & 0x0f] ^ (crc >> 4);
+    }
+
+    return crc;
+}
+
+/*
+ * xxHash64 (Yann Collet's public domain algorithm), used to checksum memory
+ * ranges on-device so the host does not have to read them back for
+ * verification.
+ */
+#define XXH_PRIME1 0x9e3779b185ebca87ULL
+#define XXH_PRIME2 0xc2b2ae3d27d4eb4fULL
+#define XXH_PRIME3 0x165667b19e3779f9ULL
+#define XXH_PRIME4 0x85ebca77c2b2ae63ULL
+#define XXH_PRIME5 0x27d4eb2f165667c5ULL
+
+static u64 xxh64_rotl(u64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static u64 xxh64_get64(const u8 *p)
+{
+    u64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static u64 xxh64_round(u64 acc, u64 input)
+{
+    return xxh64_rotl(acc + input * XXH_PRIME2, 31) * XXH_PRIME1;
+}
+
+static u64 xxh64_merge_round(u64 h, u64 v)
+{
+    return (h ^ xxh64_round(0, v)) * XXH_PRIME1 + XXH_PRIME4;
+}
+
+u64 xxh64(const void *addr, size_t len, u64 seed)
+{
+    const u8 *p = addr;
+    const u8 *end = p + len;
+    u64 h;
+
+    if (len >= 32) {
+        u64 v1 = seed + XXH_PRIME1 + XXH_PRIME2;
+        u64 v2 = seed + XXH_PRIME2;
+        u64 v3 = seed;
+        u64 v4 = seed - XXH_PRIME1;
+
+        do {
+            v1 = xxh64_round(v1, xxh64_get64(p));
+            v2 = xxh64_round(v2, xxh64_get64(p + 8));
+            v3 = xxh64_round(v3, xxh64_get64(p + 16));
+            v4 = xxh64_round(v4, xxh64_get64(p + 24));
+            p += 32;
+        } while (p + 32 <= end);
+
+        h = xxh64_rotl(v1, 1) + xxh64_rotl(v2, 7) + xxh64_rotl(v3, 12) + xxh64_rotl(v4, 18);
+        h = xxh64_merge_round(h, v1);
+        h = xxh64_merge_round(h, v2);
+        h = xxh64_merge_round(h, v3);
+        h = xxh64_merge_round(h, v4);
+    } else {
+        h = seed + XXH_PRIME5;
+    }
+
+    h += len;
+
+    while (p + 8 <= end) {
+        h ^= xxh64_round(0, xxh64_get64(p));
+        h = xxh64_rotl(h, 27) * XXH_PRIME1 + XXH_PRIME4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        u32 v;
+        memcpy(&v, p, sizeof(v));
+        h ^= v * XXH_PRIME1;
+        h = xxh64_rotl(h, 23) * XXH_PRIME2 + XXH_PRIME3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= *p++ * XXH_PRIME5;
+        h = xxh64_rotl(h, 11) * XXH_PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME2;
+    h ^= h >> 29;
+    h *= XXH_PRIME3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+/* SHA-256 (FIPS 180-4), scalar */
+static const u32 sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static u32 sha256_rotr(u32 x, int r)
+{
+    return (x >> r) | (x << (32 - r));
+}
+
+static void sha256_block(struct sha256_ctx *ctx, const u8 *p)
+{
+    u32 w[64];
+    u32 s[8];
+
+    for (int i = 0; i < 16; i++)
+        w[i] = (p[4 * i] << 24) | (p[4 * i + 1] << 16) | (p[4 * i + 2] << 8) | p[4 * i + 3];
+    for (int i = 16; i < 64; i++) {
+        u32 s0 = sha256_rotr(w[i - 15], 7) ^ sha256_rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        u32 s1 = sha256_rotr(w[i - 2], 17) ^ sha256_rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    memcpy(s, ctx->state, sizeof(s));
+
+    for (int i = 0; i < 64; i++) {
+        u32 s1 = sha256_rotr(s[4], 6) ^ sha256_rotr(s[4], 11) ^ sha256_rotr(s[4], 25);
+        u32 ch = (s[4] & s[5]) ^ (~s[4] & s[6]);
+        u32 t1 = s[7] + s1 + ch + sha256_k[i] + w[i];
+        u32 s0 = sha256_rotr(s[0], 2) ^ sha256_rotr(s[0], 13) ^ sha256_rotr(s[0], 22);
+        u32 maj = (s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]);
+        u32 t2 = s0 + maj;
+
+        s[7] = s[6];
+        s[6] = s[5];
+        s[5] = s[4];
+        s[4] = s[3] + t1;
+        s[3] = s[2];
+        s[2] = s[1];
+        s[1] = s[0];
+        s[0] = t1 + t2;
+    }
+
+    for (int i = 0; i < 8; i++)
+        ctx->state[i] += s[i];
+}
+
+void sha256_init(struct sha256_ctx *ctx)
+{
+    static const u32 iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->count = 0;
+}
+
+void sha256_update(struct sha256_ctx *ctx, const void *buf, size_t len)
+{
+    const u8 *p = buf;
+    size_t fill = ctx->count % SHA256_BLOCK_SIZE;
+
+    ctx->count += len;
+
+    if (fill) {
+        size_t chunk = min(len, SHA256_BLOCK_SIZE - fill);
+
+        memcpy(ctx->buf + fill, p, chunk);
+        p += chunk;
+        len -= chunk;
+
+        if (fill + chunk < SHA256_BLOCK_SIZE)
+            return;
+
+        sha256_block(ctx, ctx->buf);
+    }
+
+    while (len >= SHA256_BLOCK_SIZE) {
+        sha256_block(ctx, p);
+        p += SHA256_BLOCK_SIZE;
+        len -= SHA256_BLOCK_SIZE;
+    }
+
+    if (len)
+        memcpy(ctx->buf, p, len);
+}
+
+void sha256_final(struct sha256_ctx *ctx, u8 digest[SHA256_DIGEST_SIZE])
+{
+    u64 bits = ctx->count << 3;
+    size_t fill = ctx->count % SHA256_BLOCK_SIZE;
+
+    ctx->buf[fill++] = 0x80;
+
+    if (fill > SHA256_BLOCK_SIZE - 8) {
+        memset(ctx->buf + fill, 0, SHA256_BLOCK_SIZE - fill);
+        sha256_block(ctx, ctx->buf);
+        fill = 0;
+    }
+
+    memset(ctx->buf + fill, 0, SHA256_BLOCK_SIZE - 8 - fill);
+    for (int i = 0; i < 8; i++)
+        ctx->buf[SHA256_BLOCK_SIZE - 1 - i] = bits >> (8 * i);
+    sha256_block(ctx, ctx->buf);
+
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = ctx->state[i] >> 24;
+        digest[4 * i + 1] = ctx->state[i] >> 16;
+        digest[4 * i + 2] = ctx->state[i] >> 8;
+        digest[4 * i + 3] = ctx->state[i];
+    }
+}
+
+void sha256(const void *buf, size_t len, u8 digest[SHA256_DIGEST_SIZE])
+{
+    struct sha256_ctx ctx;
+
+    sha256_init(&ctx);
+    sha256_update(&ctx, buf, len);
+    sha256_final(&ctx, digest);
+}
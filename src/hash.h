@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include "types.h"
+
+/*
+ * Common hash/checksum primitives.
+ *
+ * CRC32 (IEEE, the gzip/zlib polynomial) uses the ARMv8 CRC32 instructions
+ * when the core has them, falling back to a table otherwise; the check is
+ * done once at first use. Everything else is scalar: we build with
+ * -mgeneral-regs-only and run with FP/SIMD traps enabled, so the NEON and
+ * SHA-2 instruction variants are not an option.
+ */
+
+/* Streaming CRC32: start with CRC32_INIT, finish by inverting */
+#define CRC32_INIT (~0u)
+
+u32 crc32_update(u32 crc, const void *buf, size_t len);
+
+static inline u32 crc32(const void *buf, size_t len)
+{
+    return ~crc32_update(CRC32_INIT, buf, len);
+}
+
+u64 xxh64(const void *addr, size_t len, u64 seed);
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_BLOCK_SIZE  64
+
+struct sha256_ctx {
+    u32 state[8];
+    u64 count;
+    u8 buf[SHA256_BLOCK_SIZE];
+};
+
+void sha256_init(struct sha256_ctx *ctx);
+void sha256_update(struct sha256_ctx *ctx, const void *buf, size_t len);
+void sha256_final(struct sha256_ctx *ctx, u8 digest[SHA256_DIGEST_SIZE]);
+void sha256(const void *buf, size_t len, u8 digest[SHA256_DIGEST_SIZE]);
+
+#endif
@@ -42,3 +42,24 @@ void *heapblock_alloc_aligned(size_t size, size_t align)
 
     return (void *)block;
 }
+
+/*
+ * Region-scoped allocation: take a mark, make transient allocations, then
+ * release back to the mark so large temporary buffers do not stay reserved
+ * until boot. Strictly LIFO: everything allocated after the mark must be dead
+ * by release time, including malloc growth (malloc grabs its slabs from here),
+ * so only bracket regions that do not leave live malloc'd objects behind.
+ */
+u64 heapblock_mark(void)
+{
+    assert(heap_base);
+
+    return (u64)heap_base;
+}
+
+void heapblock_release(u64 mark)
+{
+    assert(mark && mark <= (u64)heap_base);
+
+    heap_base = (void *)mark;
+}
@@ -10,4 +10,7 @@ void heapblock_init(void);
 void *heapblock_alloc(size_t size);
 void *heapblock_alloc_aligned(size_t size, size_t align);
 
+u64 heapblock_mark(void);
+void heapblock_release(u64 mark);
+
 #endif
@@ -29,6 +29,9 @@ int hv_pinned_cpu;
 int hv_want_cpu;
 
 static bool hv_has_ecv;
+
+/* Desired CNTHCTL_EL2 for all guest CPUs; vCPUs refresh it on every exit */
+u64 hv_cnthctl;
 static bool hv_should_exit[MAX_CPUS];
 bool hv_started_cpus[MAX_CPUS];
 u64 hv_cpus_in_guest;
@@ -63,6 +66,7 @@ void hv_init(void)
     smp_set_wfe_mode(true);
     hv_wdt_init();
 
+    hv_exc_init();
     hv_pt_init();
 
     // Configure hypervisor defaults
@@ -95,6 +99,8 @@ void hv_init(void)
         hv_secondary_tick_interval = hv_tick_interval;
     }
 
+    hv_cnthctl = mrs(CNTHCTL_EL2);
+
     // Set deep WFI back to defaults
     reg_mask(SYS_IMP_APL_CYC_OVRD, CYC_OVRD_WFI_MODE_MASK, CYC_OVRD_WFI_MODE(0));
 
@@ -104,6 +110,32 @@ void hv_init(void)
     sysop("isb");
 }
 
+void hv_set_timer_passthrough(bool enabled)
+{
+    const u64 traps = CNTHCTL_EL1NVVCT | CNTHCTL_EL1NVPCT | CNTHCTL_EL1TVT;
+
+    if (!hv_has_ecv) {
+        /* Without ECV we never trap the guest timers in the first place */
+        printf("HV: no ECV, timer accesses are already passed through\n");
+        return;
+    }
+
+    /*
+     * When nothing on the host side is tracing or adjusting guest timers,
+     * these traps are pure exit overhead. Drop (or restore) them in the
+     * shared desired value: this CPU takes it immediately, CPUs already in
+     * the guest pick it up on their next exit, and late-started CPUs get it
+     * from hv_secondary_info.
+     */
+    if (enabled)
+        hv_cnthctl &= ~traps;
+    else
+        hv_cnthctl |= traps;
+
+    msr(CNTHCTL_EL2, hv_cnthctl);
+    sysop("isb");
+}
+
 static void hv_set_gxf_vbar(void)
 {
     msr(SYS_IMP_APL_VBAR_GL1, _hv_vectors_start);
@@ -376,6 +408,8 @@ void hv_maybe_exit(void)
 void hv_tick(struct exc_info *ctx)
 {
     hv_wdt_pet();
+    // Bound the latency of a pending write-combined MMIO run
+    hv_wc_flush(ctx);
     iodev_handle_events(uartproxy_iodev);
     if (iodev_can_read(uartproxy_iodev)) {
         printf("HV: User interrupt\n");
@@ -5,17 +5,20 @@
 
 #include "exception.h"
 #include "iodev.h"
+#include "smp.h"
 #include "types.h"
 #include "uartproxy.h"
 
 typedef bool(hv_hook_t)(struct exc_info *ctx, u64 addr, u64 *val, bool write, int width);
 
-#define MMIO_EVT_ATTR  GENMASK(31, 24)
-#define MMIO_EVT_CPU   GENMASK(23, 16)
-#define MMIO_EVT_SH    GENMASK(15, 14)
-#define MMIO_EVT_MULTI BIT(6)
-#define MMIO_EVT_WRITE BIT(5)
-#define MMIO_EVT_WIDTH GENMASK(4, 0)
+#define MMIO_EVT_ATTR    GENMASK(31, 24)
+#define MMIO_EVT_CPU     GENMASK(23, 16)
+#define MMIO_EVT_SH      GENMASK(15, 14)
+#define MMIO_EVT_WC_NLEN GENMASK(13, 8) // write-combined run length minus one
+#define MMIO_EVT_WC      BIT(7)
+#define MMIO_EVT_MULTI   BIT(6)
+#define MMIO_EVT_WRITE   BIT(5)
+#define MMIO_EVT_WIDTH   GENMASK(4, 0)
 
 struct hv_evt_mmiotrace {
     u32 flags;
@@ -31,6 +34,89 @@ struct hv_evt_irqtrace {
     u16 num;
 };
 
+/*
+ * Shared-memory MMIO trace ring. The guest side appends events and bumps wptr;
+ * the host drains in bulk and advances rptr, with no proxy round trip per
+ * event. Pointers are free-running; the ring holds num_events (power of two)
+ * entries.
+ */
+struct hv_trace_ring {
+    u64 wptr;
+    u64 rptr;
+    u32 num_events;
+    u32 _pad;
+    struct hv_evt_mmiotrace evt[];
+};
+
+/*
+ * MMIO trace filter entry. An access is emitted if any entry matches its
+ * address range, direction and (data & mask) == value; mask 0 matches any
+ * data. With no filter installed, everything is emitted.
+ */
+#define HV_TRACE_FILTER_R BIT(0)
+#define HV_TRACE_FILTER_W BIT(1)
+
+struct hv_trace_filter_ent {
+    u64 start, end; // [start, end)
+    u64 mask, value;
+    u32 flags;
+    u32 _pad;
+};
+
+/* Per-vCPU exit statistics */
+enum hv_exit_type {
+    HV_EXIT_SYNC = 0,
+    HV_EXIT_IRQ,
+    HV_EXIT_FIQ,
+    HV_EXIT_SERROR,
+    HV_EXIT_TYPES,
+};
+
+/* Exit classes for cycle accounting; sync and FIQ exits are split by cause */
+enum hv_exit_class {
+    HV_EC_SYSREG = 0,  // locked sysreg emulation
+    HV_EC_SYSREG_FAST, // unlocked sysreg fast path
+    HV_EC_DABORT,      // stage-2 data aborts (MMIO hooks/tracing)
+    HV_EC_SYNC_OTHER,
+    HV_EC_TIMER, // guest timer FIQs
+    HV_EC_IPI,   // IPI delivery FIQs
+    HV_EC_FIQ_OTHER,
+    HV_EC_IRQ,
+    HV_EC_SERROR,
+    HV_EC_CLASSES,
+};
+
+// log2(CNTPCT cycles) buckets; the last bucket is a catch-all
+#define HV_EXIT_HIST_BUCKETS 24
+
+struct hv_exit_class_stats {
+    u64 count;
+    u64 cycles;
+    u64 hist[HV_EXIT_HIST_BUCKETS];
+};
+
+struct hv_vcpu_stats {
+    u64 exits[HV_EXIT_TYPES];
+    u64 fast_exits;  // handled without taking the big hypervisor lock
+    u64 exit_cycles; // CNTPCT cycles spent in locked exits
+    struct hv_exit_class_stats classes[HV_EC_CLASSES];
+};
+
+/*
+ * Paravirtual time page, shared with the guest. The offset is the current
+ * CNTVOFF_EL2 value (accumulated stolen time); epoch is bumped whenever it
+ * changes. Readers use seq as a seqlock: it is odd while an update is in
+ * progress, so sample seq, read the fields, and retry if seq changed or was
+ * odd. Untrapped CNTVCT reads plus this page give guests a consistent view
+ * of time across host-side adjustments without a single exit.
+ */
+struct hv_pvtime {
+    u64 seq;
+    u64 freq;   // CNTFRQ_EL0
+    u64 offset; // current CNTVOFF_EL2 value
+    u64 epoch;
+};
+
 #define HV_MAX_RW_SIZE  64
 #define HV_MAX_RW_WORDS (HV_MAX_RW_SIZE >> 3)
 
@@ -58,13 +144,39 @@ int hv_unmap(u64 from, u64 size);
 int hv_map_hw(u64 from, u64 to, u64 size);
 int hv_map_sw(u64 from, u64 to, u64 size);
 int hv_map_hook(u64 from, hv_hook_t *hook, u64 size);
+int hv_map_hook_w(u64 from, hv_hook_t *hook, u64 size);
+int hv_map_hook_r(u64 from, hv_hook_t *hook, u64 size);
+void hv_wc_flush(struct exc_info *ctx);
 u64 hv_translate(u64 addr, bool s1only, bool w, u64 *par_out);
+
+struct hv_gather_ent {
+    u64 addr;
+    u64 len;
+};
+
+s64 hv_gather(struct hv_gather_ent *list, u32 count, void *buf, u64 size);
 u64 hv_pt_walk(u64 addr);
+int hv_vm_start_dirty_track(u64 from, u64 size);
+void hv_vm_stop_dirty_track(void);
+u64 hv_vm_collect_dirty(u64 *bitmap);
 bool hv_handle_dabort(struct exc_info *ctx);
 bool hv_pa_write(struct exc_info *ctx, u64 addr, u64 *val, int width);
 bool hv_pa_read(struct exc_info *ctx, u64 addr, u64 *val, int width);
 bool hv_pa_rw(struct exc_info *ctx, u64 addr, u64 *val, bool write, int width);
 
+int hv_tracering_init(void *buf, u32 num_events);
+int hv_trace_filter_init(void *buf, u32 count);
+
+#define HV_REPLAY_TIMED    BIT(0)
+#define HV_REPLAY_CONTINUE BIT(1)
+
+s64 hv_mmio_replay(struct hv_evt_mmiotrace *evts, u32 count, u32 replay_flags);
+
+/* Exc */
+int hv_get_vcpu_stats(int cpu, struct hv_vcpu_stats *stats, bool reset);
+int hv_pvtime_init(void *buf);
+int hv_step_batch(u64 count, u64 *buf, u64 stop);
+
 /* AIC events through tracing the MMIO event address */
 bool hv_trace_irq(u32 type, u32 num, u32 count, u32 flags);
 
@@ -76,6 +188,9 @@ void hv_map_virtio(u64 base, struct virtio_conf *conf);
 void virtio_put_buffer(u64 base, int qu, u32 id, u32 len);
 
 /* Exceptions */
+void hv_exc_init(void);
+/* Whitelist a RAZ/WI sysreg for the asm fast path; returns total fast exits */
+u64 hv_sysreg_set_raz_wi(u64 iss, bool enable);
 void hv_exc_proxy(struct exc_info *ctx, uartproxy_boot_reason_t reason, u32 type, void *extra);
 void hv_set_time_stealing(bool enabled, bool reset);
 void hv_add_time(s64 time);
@@ -107,8 +222,12 @@ u64 hv_get_elr(void);
 u64 hv_get_afsr1(void);
 void hv_set_elr(u64 val);
 
+extern u64 hv_cnthctl;
+extern bool hv_started_cpus[MAX_CPUS];
+
 /* HV main */
 void hv_init(void);
+void hv_set_timer_passthrough(bool enabled);
 void hv_start(void *entry, u64 regs[4]);
 void hv_start_secondary(int cpu, void *entry, u64 regs[4]);
 void hv_exit_cpu(int cpu);
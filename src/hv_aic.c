@@ -10,6 +10,7 @@
 #define IRQTRACE_IRQ BIT(0)
 
 static u32 trace_hw_num[AIC_MAX_DIES][AIC_MAX_HW_NUM / 32];
+static u32 trace_hw_count;
 
 static void emit_irqtrace(u16 die, u16 type, u16 num)
 {
@@ -65,12 +66,17 @@ bool hv_trace_irq(u32 type, u32 num, u32 count, u32 flags)
             return false;
         }
         for (u32 n = num; n < num + count; n++) {
+            bool traced = trace_hw_num[die][n / 32] & BIT(n & 31);
             switch (flags) {
                 case IRQTRACE_IRQ:
                     trace_hw_num[die][n / 32] |= BIT(n & 31);
+                    if (!traced)
+                        trace_hw_count++;
                     break;
                 default:
                     trace_hw_num[die][n / 32] &= ~(BIT(n & 31));
+                    if (traced)
+                        trace_hw_count--;
                     break;
             }
         }
@@ -84,11 +90,21 @@ bool hv_trace_irq(u32 type, u32 num, u32 count, u32 flags)
         return false;
     }
 
+    /*
+     * The guest polls AIC_EVENT constantly, so keep the trap footprint as
+     * small as possible: hook only the page holding the event register (the
+     * rest of the AIC block stays mapped through), and drop the hook entirely
+     * when the last traced IRQ goes away so untraced guests run at full speed.
+     */
     static bool hooked = false;
+    u64 event_page = ALIGN_DOWN(aic->base + aic->regs.event, SZ_16K);
 
-    if (aic && !hooked) {
-        hv_map_hook(aic->base, trace_aic_event, aic->regs.reg_size);
+    if (trace_hw_count && !hooked) {
+        hv_map_hook(event_page, trace_aic_event, SZ_16K);
         hooked = true;
+    } else if (!trace_hw_count && hooked) {
+        hv_map_hw(event_page, event_page, SZ_16K);
+        hooked = false;
     }
 
     return true;
@@ -4,6 +4,7 @@
 #include "assert.h"
 #include "cpu_regs.h"
 #include "exception.h"
+#include "malloc.h"
 #include "smp.h"
 #include "string.h"
 #include "uart.h"
@@ -27,15 +28,78 @@ struct hv_pcpu_data {
     u32 pmc_pending;
     u64 pmc_irq_mode;
     u64 exc_entry_pmcr0_cnt;
+    struct hv_vcpu_stats stats;
 } ALIGNED(64);
 
 struct hv_pcpu_data pcpu[MAX_CPUS];
 
+int hv_get_vcpu_stats(int cpu, struct hv_vcpu_stats *stats, bool reset)
+{
+    if (cpu < 0 || cpu >= MAX_CPUS)
+        return -1;
+
+    *stats = pcpu[cpu].stats;
+    if (reset)
+        memset(&pcpu[cpu].stats, 0, sizeof(pcpu[cpu].stats));
+    return 0;
+}
+
+/*
+ * Per-class exit cost accounting, from vector entry to guest reentry. The
+ * histograms use log2(cycle) buckets, which is plenty to tell a regressed
+ * trap class apart from noise without host-side timing.
+ */
+static void hv_exit_account(enum hv_exit_class class, u64 t0)
+{
+    struct hv_exit_class_stats *st = &PERCPU(stats.classes[class]);
+    u64 cycles = mrs(CNTPCT_EL0) - t0;
+    int bucket = cycles ? 63 - __builtin_clzll(cycles) : 0;
+
+    st->count++;
+    st->cycles += cycles;
+    st->hist[min(bucket, HV_EXIT_HIST_BUCKETS - 1)]++;
+}
+
 void hv_exit_guest(void) __attribute__((noreturn));
 
 static u64 stolen_time = 0;
 static u64 exc_entry_time;
 
+static struct hv_pvtime *pvtime = NULL;
+
+int hv_pvtime_init(void *buf)
+{
+    if (buf) {
+        struct hv_pvtime *pv = buf;
+        memset(pv, 0, sizeof(*pv));
+        pv->freq = mrs(CNTFRQ_EL0);
+        pv->offset = stolen_time;
+        sysop("dmb ish");
+        pvtime = pv;
+    } else {
+        pvtime = NULL;
+    }
+    return 0;
+}
+
+/*
+ * Publish the current time offset to the paravirtual time page. Called with
+ * the big HV lock held on the way back into the guest, which is the only
+ * point where the guest-visible offset can change, so writers never race.
+ */
+static void hv_pvtime_update(void)
+{
+    if (!pvtime || pvtime->offset == stolen_time)
+        return;
+
+    pvtime->seq++;
+    sysop("dmb ish");
+    pvtime->offset = stolen_time;
+    pvtime->epoch++;
+    sysop("dmb ish");
+    pvtime->seq++;
+}
+
 extern u64 hv_cpus_in_guest;
 extern int hv_pinned_cpu;
 extern int hv_want_cpu;
@@ -69,9 +133,12 @@ static void _hv_exc_proxy(struct exc_info *ctx, uartproxy_boot_reason_t reason,
         .info = ctx,
     };
 
+    // Host-driven ops may legitimately allocate (hv_map from hooks, etc.)
+    malloc_noalloc_pop();
     hv_wdt_suspend();
     int ret = uartproxy_run(&start);
     hv_wdt_resume();
+    malloc_noalloc_push();
 
     switch (ret) {
         case EXC_RET_HANDLED:
@@ -181,21 +248,324 @@ static void hv_update_fiq(void)
     }
 }
 
+/*
+ * Unlocked sysreg traps dominate guest interrupt latency (CNTV/CNTP and the IPI
+ * registers in particular), so they dispatch through a table sorted by ISS
+ * encoding instead of a switch. hv_exc_init() sorts it once; lookups are a
+ * binary search plus an indirect call. Each entry keeps a hit counter so the
+ * hot set can be inspected from the host (counters are not atomic, so they are
+ * approximate under SMP).
+ */
+
+typedef bool(hv_sysreg_handler_t)(struct exc_info *ctx, u64 *regs, u64 rt, bool is_read);
+
+struct hv_sysreg_ent {
+    u64 iss;
+    u64 hits;
+    hv_sysreg_handler_t *handler;
+};
+
+#define _SYSREG_FN(_1, _2, op0, op1, CRn, CRm, op2)                                                \
+    hv_sysreg_##op0##_##op1##_##CRn##_##CRm##_##op2
+#define SYSREG_FN(...) _SYSREG_FN(__VA_ARGS__)
+
 #define SYSREG_MAP(sr, to)                                                                         \
-    case SYSREG_ISS(sr):                                                                           \
+    static bool SYSREG_FN(sr)(struct exc_info * ctx, u64 *regs, u64 rt, bool is_read)              \
+    {                                                                                              \
+        UNUSED(ctx);                                                                               \
         if (is_read)                                                                               \
             regs[rt] = _mrs(sr_tkn(to));                                                           \
         else                                                                                       \
             _msr(sr_tkn(to), regs[rt]);                                                            \
-        return true;
+        return true;                                                                               \
+    }
 
 #define SYSREG_PASS(sr)                                                                            \
-    case SYSREG_ISS(sr):                                                                           \
+    static bool SYSREG_FN(sr)(struct exc_info * ctx, u64 *regs, u64 rt, bool is_read)              \
+    {                                                                                              \
+        UNUSED(ctx);                                                                               \
         if (is_read)                                                                               \
             regs[rt] = _mrs(sr_tkn(sr));                                                           \
         else                                                                                       \
             _msr(sr_tkn(sr), regs[rt]);                                                            \
-        return true;
+        return true;                                                                               \
+    }
+
+#define SYSREG_ENT(sr) {SYSREG_ISS(sr), 0, SYSREG_FN(sr)}
+
+/* Some kind of timer */
+SYSREG_PASS(sys_reg(3, 7, 15, 1, 1))
+SYSREG_PASS(sys_reg(3, 7, 15, 3, 1))
+/* Architectural timer, for ECV */
+SYSREG_MAP(SYS_CNTV_CTL_EL0, SYS_CNTV_CTL_EL02)
+SYSREG_MAP(SYS_CNTV_CVAL_EL0, SYS_CNTV_CVAL_EL02)
+SYSREG_MAP(SYS_CNTV_TVAL_EL0, SYS_CNTV_TVAL_EL02)
+SYSREG_MAP(SYS_CNTP_CTL_EL0, SYS_CNTP_CTL_EL02)
+SYSREG_MAP(SYS_CNTP_CVAL_EL0, SYS_CNTP_CVAL_EL02)
+SYSREG_MAP(SYS_CNTP_TVAL_EL0, SYS_CNTP_TVAL_EL02)
+/* Spammy stuff seen on t600x p-cores */
+SYSREG_PASS(sys_reg(3, 2, 15, 12, 0))
+SYSREG_PASS(sys_reg(3, 2, 15, 13, 0))
+SYSREG_PASS(sys_reg(3, 2, 15, 14, 0))
+SYSREG_PASS(sys_reg(3, 2, 15, 15, 0))
+SYSREG_PASS(sys_reg(3, 1, 15, 7, 0))
+SYSREG_PASS(sys_reg(3, 1, 15, 8, 0))
+SYSREG_PASS(sys_reg(3, 1, 15, 9, 0))
+SYSREG_PASS(sys_reg(3, 1, 15, 10, 0))
+/* Noisy traps */
+SYSREG_MAP(SYS_ACTLR_EL1, SYS_IMP_APL_ACTLR_EL12)
+SYSREG_PASS(SYS_IMP_APL_HID4)
+SYSREG_PASS(SYS_IMP_APL_EHID4)
+/* We don't normally trap hese, but if we do, they're noisy */
+SYSREG_PASS(SYS_IMP_APL_GXF_STATUS_EL1)
+SYSREG_PASS(SYS_IMP_APL_CNTVCT_ALIAS_EL0)
+SYSREG_PASS(SYS_IMP_APL_TPIDR_GL1)
+SYSREG_MAP(SYS_IMP_APL_SPSR_GL1, SYS_IMP_APL_SPSR_GL12)
+SYSREG_MAP(SYS_IMP_APL_ASPSR_GL1, SYS_IMP_APL_ASPSR_GL12)
+SYSREG_MAP(SYS_IMP_APL_ELR_GL1, SYS_IMP_APL_ELR_GL12)
+SYSREG_MAP(SYS_IMP_APL_ESR_GL1, SYS_IMP_APL_ESR_GL12)
+SYSREG_MAP(SYS_IMP_APL_SPRR_PERM_EL1, SYS_IMP_APL_SPRR_PERM_EL12)
+SYSREG_MAP(SYS_IMP_APL_APCTL_EL1, SYS_IMP_APL_APCTL_EL12)
+SYSREG_MAP(SYS_IMP_APL_AMX_CTL_EL1, SYS_IMP_APL_AMX_CTL_EL12)
+/* FIXME:Might be wrong */
+SYSREG_PASS(sys_reg(3, 4, 15, 1, 3))
+/* pass through PMU handling */
+SYSREG_PASS(SYS_IMP_APL_PMCR1)
+SYSREG_PASS(SYS_IMP_APL_PMCR2)
+SYSREG_PASS(SYS_IMP_APL_PMCR3)
+SYSREG_PASS(SYS_IMP_APL_PMCR4)
+SYSREG_PASS(SYS_IMP_APL_PMESR0)
+SYSREG_PASS(SYS_IMP_APL_PMESR1)
+SYSREG_PASS(SYS_IMP_APL_PMSR)
+#ifndef DEBUG_PMU_IRQ
+SYSREG_PASS(SYS_IMP_APL_PMC0)
+#endif
+SYSREG_PASS(SYS_IMP_APL_PMC1)
+SYSREG_PASS(SYS_IMP_APL_PMC2)
+SYSREG_PASS(SYS_IMP_APL_PMC3)
+SYSREG_PASS(SYS_IMP_APL_PMC4)
+SYSREG_PASS(SYS_IMP_APL_PMC5)
+SYSREG_PASS(SYS_IMP_APL_PMC6)
+SYSREG_PASS(SYS_IMP_APL_PMC7)
+SYSREG_PASS(SYS_IMP_APL_PMC8)
+SYSREG_PASS(SYS_IMP_APL_PMC9)
+/* Outer Sharable TLB maintenance instructions */
+SYSREG_PASS(sys_reg(1, 0, 8, 1, 0)) // TLBI VMALLE1OS
+SYSREG_PASS(sys_reg(1, 0, 8, 1, 1)) // TLBI VAE1OS
+SYSREG_PASS(sys_reg(1, 0, 8, 1, 2)) // TLBI ASIDE1OS
+SYSREG_PASS(sys_reg(1, 0, 8, 5, 1)) // TLBI RVAE1OS
+/* IPI handling */
+SYSREG_PASS(SYS_IMP_APL_IPI_CR_EL1)
+
+static bool hv_sysreg_ipi_sr(struct exc_info *ctx, u64 *regs, u64 rt, bool is_read)
+{
+    UNUSED(ctx);
+    if (is_read)
+        regs[rt] = PERCPU(ipi_pending) ? IPI_SR_PENDING : 0;
+    else if (regs[rt] & IPI_SR_PENDING)
+        PERCPU(ipi_pending) = false;
+    return true;
+}
+
+/*
+ * Guest IPI sends stay on the unlocked path: they only flag the target's
+ * ipi_queued slot and forward the write to the hardware IPI_RR registers, so
+ * same-cluster cross-calls are delivered without taking the big hypervisor
+ * lock. An unknown target falls through to the proxy.
+ */
+static bool hv_sysreg_ipi_rr_local(struct exc_info *ctx, u64 *regs, u64 rt, bool is_read)
+{
+    UNUSED(ctx);
+    assert(!is_read);
+    u64 mpidr = (regs[rt] & 0xff) | (mrs(MPIDR_EL1) & 0xffff00);
+    for (int i = 0; i < MAX_CPUS; i++)
+        if (mpidr == smp_get_mpidr(i)) {
+            pcpu[i].ipi_queued = true;
+            msr(SYS_IMP_APL_IPI_RR_LOCAL_EL1, regs[rt]);
+            return true;
+        }
+    return false;
+}
+
+static bool hv_sysreg_ipi_rr_global(struct exc_info *ctx, u64 *regs, u64 rt, bool is_read)
+{
+    UNUSED(ctx);
+    assert(!is_read);
+    u64 mpidr = (regs[rt] & 0xff) | ((regs[rt] & 0xff0000) >> 8);
+    for (int i = 0; i < MAX_CPUS; i++)
+        if (mpidr == (smp_get_mpidr(i) & 0xffff)) {
+            pcpu[i].ipi_queued = true;
+            msr(SYS_IMP_APL_IPI_RR_GLOBAL_EL1, regs[rt]);
+            return true;
+        }
+    return false;
+}
+
+/* shadow the interrupt mode and state flag */
+static bool hv_sysreg_pmcr0(struct exc_info *ctx, u64 *regs, u64 rt, bool is_read)
+{
+    UNUSED(ctx);
+    if (is_read) {
+        u64 val = (mrs(SYS_IMP_APL_PMCR0) & ~PMCR0_IMODE_MASK) | PERCPU(pmc_irq_mode);
+        regs[rt] = val | (PERCPU(pmc_pending) ? PMCR0_IACT : 0);
+    } else {
+        PERCPU(pmc_pending) = !!(regs[rt] & PMCR0_IACT);
+        PERCPU(pmc_irq_mode) = regs[rt] & PMCR0_IMODE_MASK;
+        msr(SYS_IMP_APL_PMCR0, regs[rt]);
+    }
+    return true;
+}
+
+/*
+ * Handle this one here because m1n1/Linux (will) use it for explicit cpuidle.
+ * We can pass it through; going into deep sleep doesn't break the HV since we
+ * don't do any wfis that assume otherwise in m1n1. However, don't het macOS
+ * disable WFI ret (when going into systemwide sleep), since that breaks things.
+ */
+static bool hv_sysreg_cyc_ovrd(struct exc_info *ctx, u64 *regs, u64 rt, bool is_read)
+{
+    UNUSED(ctx);
+    if (is_read) {
+        regs[rt] = mrs(SYS_IMP_APL_CYC_OVRD);
+    } else {
+        if (regs[rt] & (CYC_OVRD_DISABLE_WFI_RET | CYC_OVRD_FIQ_MODE_MASK))
+            return false;
+        msr(SYS_IMP_APL_CYC_OVRD, regs[rt]);
+    }
+    return true;
+}
+
+/* M1RACLES reg, handle here due to silly 12.0 "mitigation" */
+static bool hv_sysreg_m1racles(struct exc_info *ctx, u64 *regs, u64 rt, bool is_read)
+{
+    UNUSED(ctx);
+    if (is_read)
+        regs[rt] = 0;
+    return true;
+}
+
+static struct hv_sysreg_ent hv_sysreg_table[] = {
+    SYSREG_ENT(sys_reg(3, 7, 15, 1, 1)),
+    SYSREG_ENT(sys_reg(3, 7, 15, 3, 1)),
+    SYSREG_ENT(SYS_CNTV_CTL_EL0),
+    SYSREG_ENT(SYS_CNTV_CVAL_EL0),
+    SYSREG_ENT(SYS_CNTV_TVAL_EL0),
+    SYSREG_ENT(SYS_CNTP_CTL_EL0),
+    SYSREG_ENT(SYS_CNTP_CVAL_EL0),
+    SYSREG_ENT(SYS_CNTP_TVAL_EL0),
+    SYSREG_ENT(sys_reg(3, 2, 15, 12, 0)),
+    SYSREG_ENT(sys_reg(3, 2, 15, 13, 0)),
+    SYSREG_ENT(sys_reg(3, 2, 15, 14, 0)),
+    SYSREG_ENT(sys_reg(3, 2, 15, 15, 0)),
+    SYSREG_ENT(sys_reg(3, 1, 15, 7, 0)),
+    SYSREG_ENT(sys_reg(3, 1, 15, 8, 0)),
+    SYSREG_ENT(sys_reg(3, 1, 15, 9, 0)),
+    SYSREG_ENT(sys_reg(3, 1, 15, 10, 0)),
+    SYSREG_ENT(SYS_ACTLR_EL1),
+    SYSREG_ENT(SYS_IMP_APL_HID4),
+    SYSREG_ENT(SYS_IMP_APL_EHID4),
+    SYSREG_ENT(SYS_IMP_APL_GXF_STATUS_EL1),
+    SYSREG_ENT(SYS_IMP_APL_CNTVCT_ALIAS_EL0),
+    SYSREG_ENT(SYS_IMP_APL_TPIDR_GL1),
+    SYSREG_ENT(SYS_IMP_APL_SPSR_GL1),
+    SYSREG_ENT(SYS_IMP_APL_ASPSR_GL1),
+    SYSREG_ENT(SYS_IMP_APL_ELR_GL1),
+    SYSREG_ENT(SYS_IMP_APL_ESR_GL1),
+    SYSREG_ENT(SYS_IMP_APL_SPRR_PERM_EL1),
+    SYSREG_ENT(SYS_IMP_APL_APCTL_EL1),
+    SYSREG_ENT(SYS_IMP_APL_AMX_CTL_EL1),
+    SYSREG_ENT(sys_reg(3, 4, 15, 1, 3)),
+    SYSREG_ENT(SYS_IMP_APL_PMCR1),
+    SYSREG_ENT(SYS_IMP_APL_PMCR2),
+    SYSREG_ENT(SYS_IMP_APL_PMCR3),
+    SYSREG_ENT(SYS_IMP_APL_PMCR4),
+    SYSREG_ENT(SYS_IMP_APL_PMESR0),
+    SYSREG_ENT(SYS_IMP_APL_PMESR1),
+    SYSREG_ENT(SYS_IMP_APL_PMSR),
+#ifndef DEBUG_PMU_IRQ
+    SYSREG_ENT(SYS_IMP_APL_PMC0),
+#endif
+    SYSREG_ENT(SYS_IMP_APL_PMC1),
+    SYSREG_ENT(SYS_IMP_APL_PMC2),
+    SYSREG_ENT(SYS_IMP_APL_PMC3),
+    SYSREG_ENT(SYS_IMP_APL_PMC4),
+    SYSREG_ENT(SYS_IMP_APL_PMC5),
+    SYSREG_ENT(SYS_IMP_APL_PMC6),
+    SYSREG_ENT(SYS_IMP_APL_PMC7),
+    SYSREG_ENT(SYS_IMP_APL_PMC8),
+    SYSREG_ENT(SYS_IMP_APL_PMC9),
+    SYSREG_ENT(sys_reg(1, 0, 8, 1, 0)),
+    SYSREG_ENT(sys_reg(1, 0, 8, 1, 1)),
+    SYSREG_ENT(sys_reg(1, 0, 8, 1, 2)),
+    SYSREG_ENT(sys_reg(1, 0, 8, 5, 1)),
+    SYSREG_ENT(SYS_IMP_APL_IPI_CR_EL1),
+    {SYSREG_ISS(SYS_IMP_APL_IPI_SR_EL1), 0, hv_sysreg_ipi_sr},
+    {SYSREG_ISS(SYS_IMP_APL_IPI_RR_LOCAL_EL1), 0, hv_sysreg_ipi_rr_local},
+    {SYSREG_ISS(SYS_IMP_APL_IPI_RR_GLOBAL_EL1), 0, hv_sysreg_ipi_rr_global},
+    {SYSREG_ISS(SYS_IMP_APL_PMCR0), 0, hv_sysreg_pmcr0},
+    {SYSREG_ISS(SYS_IMP_APL_CYC_OVRD), 0, hv_sysreg_cyc_ovrd},
+    {SYSREG_ISS(sys_reg(3, 5, 15, 10, 1)), 0, hv_sysreg_m1racles},
+};
+
+/*
+ * Encodings pre-validated as read-as-zero/write-ignore never need C at all:
+ * the EL2 sync vector in hv_asm.S consults this bitmap before the context
+ * save and retires whitelisted accesses in a few dozen cycles. The index is
+ * the 16-bit Op0:Op2:Op1:CRn:CRm encoding in ESR ISS order, with Rt and the
+ * direction bit stripped.
+ */
+u8 hv_sysreg_raz_wi_bitmap[0x10000 / 8] ALIGNED(64);
+u64 hv_sysreg_raz_wi_hits[MAX_CPUS];
+
+u64 hv_sysreg_set_raz_wi(u64 iss, bool enable)
+{
+    u32 idx = ((iss >> ESR_ISS_MSR_CRn_SHIFT << 4) & 0xfff0) | FIELD_GET(ESR_ISS_MSR_CRm, iss);
+
+    if (enable)
+        hv_sysreg_raz_wi_bitmap[idx >> 3] |= BIT(idx & 7);
+    else
+        hv_sysreg_raz_wi_bitmap[idx >> 3] &= ~BIT(idx & 7);
+
+    u64 hits = 0;
+    for (int i = 0; i < MAX_CPUS; i++)
+        hits += hv_sysreg_raz_wi_hits[i];
+    return hits;
+}
+
+void hv_exc_init(void)
+{
+    /* M1RACLES reg: RAZ/WI, so retire it in the vector stub */
+    hv_sysreg_set_raz_wi(SYSREG_ISS(sys_reg(3, 5, 15, 10, 1)), true);
+
+    /* Insertion sort; this runs once and the table is small */
+    for (size_t i = 1; i < ARRAY_SIZE(hv_sysreg_table); i++) {
+        struct hv_sysreg_ent ent = hv_sysreg_table[i];
+        size_t j = i;
+        while (j > 0 && hv_sysreg_table[j - 1].iss > ent.iss) {
+            hv_sysreg_table[j] = hv_sysreg_table[j - 1];
+            j--;
+        }
+        hv_sysreg_table[j] = ent;
+    }
+}
+
+static struct hv_sysreg_ent *hv_sysreg_lookup(u64 iss)
+{
+    size_t lo = 0, hi = ARRAY_SIZE(hv_sysreg_table);
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (hv_sysreg_table[mid].iss < iss)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo < ARRAY_SIZE(hv_sysreg_table) && hv_sysreg_table[lo].iss == iss)
+        return &hv_sysreg_table[lo];
+
+    return NULL;
+}
 
 static bool hv_handle_msr_unlocked(struct exc_info *ctx, u64 iss)
 {
@@ -208,113 +578,12 @@ static bool hv_handle_msr_unlocked(struct exc_info *ctx, u64 iss)
 
     regs[31] = 0;
 
-    switch (reg) {
-        /* Some kind of timer */
-        SYSREG_PASS(sys_reg(3, 7, 15, 1, 1));
-        SYSREG_PASS(sys_reg(3, 7, 15, 3, 1));
-        /* Architectural timer, for ECV */
-        SYSREG_MAP(SYS_CNTV_CTL_EL0, SYS_CNTV_CTL_EL02)
-        SYSREG_MAP(SYS_CNTV_CVAL_EL0, SYS_CNTV_CVAL_EL02)
-        SYSREG_MAP(SYS_CNTV_TVAL_EL0, SYS_CNTV_TVAL_EL02)
-        SYSREG_MAP(SYS_CNTP_CTL_EL0, SYS_CNTP_CTL_EL02)
-        SYSREG_MAP(SYS_CNTP_CVAL_EL0, SYS_CNTP_CVAL_EL02)
-        SYSREG_MAP(SYS_CNTP_TVAL_EL0, SYS_CNTP_TVAL_EL02)
-        /* Spammy stuff seen on t600x p-cores */
-        SYSREG_PASS(sys_reg(3, 2, 15, 12, 0));
-        SYSREG_PASS(sys_reg(3, 2, 15, 13, 0));
-        SYSREG_PASS(sys_reg(3, 2, 15, 14, 0));
-        SYSREG_PASS(sys_reg(3, 2, 15, 15, 0));
-        SYSREG_PASS(sys_reg(3, 1, 15, 7, 0));
-        SYSREG_PASS(sys_reg(3, 1, 15, 8, 0));
-        SYSREG_PASS(sys_reg(3, 1, 15, 9, 0));
-        SYSREG_PASS(sys_reg(3, 1, 15, 10, 0));
-        /* Noisy traps */
-        SYSREG_MAP(SYS_ACTLR_EL1, SYS_IMP_APL_ACTLR_EL12)
-        SYSREG_PASS(SYS_IMP_APL_HID4)
-        SYSREG_PASS(SYS_IMP_APL_EHID4)
-        /* We don't normally trap hese, but if we do, they're noisy */
-        SYSREG_PASS(SYS_IMP_APL_GXF_STATUS_EL1)
-        SYSREG_PASS(SYS_IMP_APL_CNTVCT_ALIAS_EL0)
-        SYSREG_PASS(SYS_IMP_APL_TPIDR_GL1)
-        SYSREG_MAP(SYS_IMP_APL_SPSR_GL1, SYS_IMP_APL_SPSR_GL12)
-        SYSREG_MAP(SYS_IMP_APL_ASPSR_GL1, SYS_IMP_APL_ASPSR_GL12)
-        SYSREG_MAP(SYS_IMP_APL_ELR_GL1, SYS_IMP_APL_ELR_GL12)
-        SYSREG_MAP(SYS_IMP_APL_ESR_GL1, SYS_IMP_APL_ESR_GL12)
-        SYSREG_MAP(SYS_IMP_APL_SPRR_PERM_EL1, SYS_IMP_APL_SPRR_PERM_EL12)
-        SYSREG_MAP(SYS_IMP_APL_APCTL_EL1, SYS_IMP_APL_APCTL_EL12)
-        SYSREG_MAP(SYS_IMP_APL_AMX_CTL_EL1, SYS_IMP_APL_AMX_CTL_EL12)
-        /* FIXME:Might be wrong */
-        SYSREG_PASS(sys_reg(3, 4, 15, 1, 3))
-        /* pass through PMU handling */
-        SYSREG_PASS(SYS_IMP_APL_PMCR1)
-        SYSREG_PASS(SYS_IMP_APL_PMCR2)
-        SYSREG_PASS(SYS_IMP_APL_PMCR3)
-        SYSREG_PASS(SYS_IMP_APL_PMCR4)
-        SYSREG_PASS(SYS_IMP_APL_PMESR0)
-        SYSREG_PASS(SYS_IMP_APL_PMESR1)
-        SYSREG_PASS(SYS_IMP_APL_PMSR)
-#ifndef DEBUG_PMU_IRQ
-        SYSREG_PASS(SYS_IMP_APL_PMC0)
-#endif
-        SYSREG_PASS(SYS_IMP_APL_PMC1)
-        SYSREG_PASS(SYS_IMP_APL_PMC2)
-        SYSREG_PASS(SYS_IMP_APL_PMC3)
-        SYSREG_PASS(SYS_IMP_APL_PMC4)
-        SYSREG_PASS(SYS_IMP_APL_PMC5)
-        SYSREG_PASS(SYS_IMP_APL_PMC6)
-        SYSREG_PASS(SYS_IMP_APL_PMC7)
-        SYSREG_PASS(SYS_IMP_APL_PMC8)
-        SYSREG_PASS(SYS_IMP_APL_PMC9)
-
-        /* Outer Sharable TLB maintenance instructions */
-        SYSREG_PASS(sys_reg(1, 0, 8, 1, 0)) // TLBI VMALLE1OS
-        SYSREG_PASS(sys_reg(1, 0, 8, 1, 1)) // TLBI VAE1OS
-        SYSREG_PASS(sys_reg(1, 0, 8, 1, 2)) // TLBI ASIDE1OS
-        SYSREG_PASS(sys_reg(1, 0, 8, 5, 1)) // TLBI RVAE1OS
-
-        case SYSREG_ISS(SYS_IMP_APL_IPI_SR_EL1):
-            if (is_read)
-                regs[rt] = PERCPU(ipi_pending) ? IPI_SR_PENDING : 0;
-            else if (regs[rt] & IPI_SR_PENDING)
-                PERCPU(ipi_pending) = false;
-            return true;
-
-        /* shadow the interrupt mode and state flag */
-        case SYSREG_ISS(SYS_IMP_APL_PMCR0):
-            if (is_read) {
-                u64 val = (mrs(SYS_IMP_APL_PMCR0) & ~PMCR0_IMODE_MASK) | PERCPU(pmc_irq_mode);
-                regs[rt] = val | (PERCPU(pmc_pending) ? PMCR0_IACT : 0);
-            } else {
-                PERCPU(pmc_pending) = !!(regs[rt] & PMCR0_IACT);
-                PERCPU(pmc_irq_mode) = regs[rt] & PMCR0_IMODE_MASK;
-                msr(SYS_IMP_APL_PMCR0, regs[rt]);
-            }
-            return true;
-
-        /*
-         * Handle this one here because m1n1/Linux (will) use it for explicit cpuidle.
-         * We can pass it through; going into deep sleep doesn't break the HV since we
-         * don't do any wfis that assume otherwise in m1n1. However, don't het macOS
-         * disable WFI ret (when going into systemwide sleep), since that breaks things.
-         */
-        case SYSREG_ISS(SYS_IMP_APL_CYC_OVRD):
-            if (is_read) {
-                regs[rt] = mrs(SYS_IMP_APL_CYC_OVRD);
-            } else {
-                if (regs[rt] & (CYC_OVRD_DISABLE_WFI_RET | CYC_OVRD_FIQ_MODE_MASK))
-                    return false;
-                msr(SYS_IMP_APL_CYC_OVRD, regs[rt]);
-            }
-            return true;
-            /* clang-format off */
-        /* IPI handling */
-        SYSREG_PASS(SYS_IMP_APL_IPI_CR_EL1)
-        /* M1RACLES reg, handle here due to silly 12.0 "mitigation" */
-        case SYSREG_ISS(sys_reg(3, 5, 15, 10, 1)):
-            if (is_read)
-                regs[rt] = 0;
-            return true;
+    struct hv_sysreg_ent *ent = hv_sysreg_lookup(reg);
+    if (ent) {
+        ent->hits++;
+        return ent->handler(ctx, regs, rt, is_read);
     }
+
     return false;
 }
 
@@ -329,30 +598,12 @@ static bool hv_handle_msr(struct exc_info *ctx, u64 iss)
 
     regs[31] = 0;
 
+#ifndef DEBUG_PMU_IRQ
+    UNUSED(rt);
+    UNUSED(is_read);
+#endif
+
     switch (reg) {
-        /* clang-format on */
-        case SYSREG_ISS(SYS_IMP_APL_IPI_RR_LOCAL_EL1): {
-            assert(!is_read);
-            u64 mpidr = (regs[rt] & 0xff) | (mrs(MPIDR_EL1) & 0xffff00);
-            for (int i = 0; i < MAX_CPUS; i++)
-                if (mpidr == smp_get_mpidr(i)) {
-                    pcpu[i].ipi_queued = true;
-                    msr(SYS_IMP_APL_IPI_RR_LOCAL_EL1, regs[rt]);
-                    return true;
-                }
-            return false;
-        }
-        case SYSREG_ISS(SYS_IMP_APL_IPI_RR_GLOBAL_EL1):
-            assert(!is_read);
-            u64 mpidr = (regs[rt] & 0xff) | ((regs[rt] & 0xff0000) >> 8);
-            for (int i = 0; i < MAX_CPUS; i++) {
-                if (mpidr == (smp_get_mpidr(i) & 0xffff)) {
-                    pcpu[i].ipi_queued = true;
-                    msr(SYS_IMP_APL_IPI_RR_GLOBAL_EL1, regs[rt]);
-                    return true;
-                }
-            }
-            return false;
 #ifdef DEBUG_PMU_IRQ
         case SYSREG_ISS(SYS_IMP_APL_PMC0):
             if (is_read) {
@@ -369,6 +620,68 @@ static bool hv_handle_msr(struct exc_info *ctx, u64 iss)
     return false;
 }
 
+/*
+ * EL2-resident single-step engine. The host arms a step budget and a PC trace
+ * buffer, then single-steps as usual; step exceptions are consumed entirely at
+ * EL2 (record the PC, re-arm SPSR.SS, eret) until the budget runs out or the
+ * guest reaches the stop address, and only the final step is proxied to the
+ * host. Scripted instruction tracing thus pays one host round trip per batch
+ * instead of one per instruction.
+ */
+static struct {
+    u64 left;
+    u64 *buf;
+    u64 pos;
+    u64 stop;
+} hv_step;
+
+int hv_step_batch(u64 count, u64 *buf, u64 stop)
+{
+    if (!count || !buf)
+        return -1;
+
+    hv_step.left = count;
+    hv_step.buf = buf;
+    hv_step.pos = 0;
+    hv_step.stop = stop;
+    buf[0] = 0;
+    return 0;
+}
+
+static bool hv_exc_step(struct exc_info *ctx)
+{
+    if (!hv_step.left)
+        return false;
+
+    /* buf[0] holds the running count, the PCs follow */
+    hv_step.buf[++hv_step.pos] = ctx->elr;
+    hv_step.buf[0] = hv_step.pos;
+    hv_step.left--;
+
+    if (!hv_step.left || ctx->elr == hv_step.stop) {
+        /* batch done: deliver this last step to the host as usual */
+        hv_step.left = 0;
+        return false;
+    }
+
+    hv_set_spsr(hv_get_spsr() | SPSR_SS);
+    return true;
+}
+
+/*
+ * Minimal context for the unlocked fast path: just what classification and
+ * the sysreg handlers touch. The full capture below is deferred until an
+ * exit actually takes the slow path.
+ */
+static void hv_get_context_unlocked(struct exc_info *ctx)
+{
+    ctx->elr = hv_get_elr();
+    ctx->esr = hv_get_esr();
+    ctx->afsr1 = hv_get_afsr1();
+
+    sysop("isb");
+}
+
 static void hv_get_context(struct exc_info *ctx)
 {
     ctx->spsr = hv_get_spsr();
@@ -393,6 +706,8 @@ static void hv_exc_entry(void)
 
     __atomic_and_fetch(&hv_cpus_in_guest, ~BIT(smp_id()), __ATOMIC_ACQUIRE);
     spin_lock(&bhl);
+    // The guest exit path must stay off the heap: catch regressions
+    malloc_noalloc_push();
     hv_wdt_breadcrumb('X');
     exc_entry_time = mrs(CNTPCT_EL0);
     /* disable PMU counters in the hypervisor */
@@ -404,9 +719,13 @@ static void hv_exc_entry(void)
 static void hv_exc_exit(struct exc_info *ctx)
 {
     hv_wdt_breadcrumb('x');
+    PERCPU(stats.exit_cycles) += mrs(CNTPCT_EL0) - exc_entry_time;
+    malloc_noalloc_pop();
     hv_update_fiq();
     /* reenable PMU counters */
     reg_set(SYS_IMP_APL_PMCR0, PERCPU(exc_entry_pmcr0_cnt));
+    msr(CNTHCTL_EL2, hv_cnthctl);
+    hv_pvtime_update();
     msr(CNTVOFF_EL2, stolen_time);
     spin_unlock(&bhl);
     hv_maybe_exit();
@@ -420,8 +739,11 @@ static void hv_exc_exit(struct exc_info *ctx)
 
 void hv_exc_sync(struct exc_info *ctx)
 {
+    u64 t0 = mrs(CNTPCT_EL0);
+
     hv_wdt_breadcrumb('S');
-    hv_get_context(ctx);
+    hv_get_context_unlocked(ctx);
+    PERCPU(stats.exits[HV_EXIT_SYNC])++;
     bool handled = false;
     u32 ec = FIELD_GET(ESR_EC, ctx->esr);
 
@@ -438,17 +760,41 @@ void hv_exc_sync(struct exc_info *ctx)
                     break;
             }
             break;
+        case ESR_EC_SSTEP_LOWER:
+            hv_wdt_breadcrumb('t');
+            handled = hv_exc_step(ctx);
+            break;
     }
 
     if (handled) {
         hv_wdt_breadcrumb('#');
-        ctx->elr += 4;
+        PERCPU(stats.fast_exits)++;
+        /* a consumed step restarts at the recorded ELR; everything else
+         * skips the trapped instruction */
+        if (ec != ESR_EC_SSTEP_LOWER)
+            ctx->elr += 4;
         hv_set_elr(ctx->elr);
         hv_update_fiq();
+        hv_exit_account(HV_EC_SYSREG_FAST, t0);
         hv_wdt_breadcrumb('s');
         return;
     }
 
+    enum hv_exit_class class;
+    switch (ec) {
+        case ESR_EC_DABORT_LOWER:
+            class = HV_EC_DABORT;
+            break;
+        case ESR_EC_MSR:
+        case ESR_EC_IMPDEF:
+            class = HV_EC_SYSREG;
+            break;
+        default:
+            class = HV_EC_SYNC_OTHER;
+            break;
+    }
+
+    hv_get_context(ctx);
     hv_exc_entry();
 
     switch (ec) {
@@ -483,28 +829,37 @@ void hv_exc_sync(struct exc_info *ctx)
     }
 
     hv_exc_exit(ctx);
+    hv_exit_account(class, t0);
     hv_wdt_breadcrumb('s');
 }
 
 void hv_exc_irq(struct exc_info *ctx)
 {
+    u64 t0 = mrs(CNTPCT_EL0);
+
     hv_wdt_breadcrumb('I');
     hv_get_context(ctx);
+    PERCPU(stats.exits[HV_EXIT_IRQ])++;
     hv_exc_entry();
     hv_exc_proxy(ctx, START_EXCEPTION_LOWER, EXC_IRQ, NULL);
     hv_exc_exit(ctx);
+    hv_exit_account(HV_EC_IRQ, t0);
     hv_wdt_breadcrumb('i');
 }
 
 void hv_exc_fiq(struct exc_info *ctx)
 {
+    u64 t0 = mrs(CNTPCT_EL0);
+    enum hv_exit_class class = HV_EC_FIQ_OTHER;
     bool tick = false;
 
     hv_maybe_exit();
+    PERCPU(stats.exits[HV_EXIT_FIQ])++;
 
     if (mrs(CNTP_CTL_EL0) == (CNTx_CTL_ISTATUS | CNTx_CTL_ENABLE)) {
         msr(CNTP_CTL_EL0, CNTx_CTL_ISTATUS | CNTx_CTL_IMASK | CNTx_CTL_ENABLE);
         tick = true;
+        class = HV_EC_TIMER;
     }
 
     int interruptible_cpu = hv_pinned_cpu;
@@ -513,8 +868,10 @@ void hv_exc_fiq(struct exc_info *ctx)
 
     if (smp_id() != interruptible_cpu && !(mrs(ISR_EL1) & 0x40) && hv_want_cpu == -1) {
         // Non-interruptible CPU and it was just a timer tick (or spurious), so just update FIQs
+        PERCPU(stats.fast_exits)++;
         hv_update_fiq();
         hv_arm_tick(true);
+        hv_exit_account(class, t0);
         return;
     }
 
@@ -535,6 +892,7 @@ void hv_exc_fiq(struct exc_info *ctx)
 
     if (mrs(CNTV_CTL_EL0) == (CNTx_CTL_ISTATUS | CNTx_CTL_ENABLE)) {
         msr(CNTV_CTL_EL0, CNTx_CTL_ISTATUS | CNTx_CTL_IMASK | CNTx_CTL_ENABLE);
+        class = HV_EC_TIMER;
         hv_exc_proxy(ctx, START_HV, HV_VTIMER, NULL);
     }
 
@@ -559,6 +917,8 @@ void hv_exc_fiq(struct exc_info *ctx)
             PERCPU(ipi_pending) = true;
             PERCPU(ipi_queued) = false;
         }
+        if (class == HV_EC_FIQ_OTHER)
+            class = HV_EC_IPI;
         msr(SYS_IMP_APL_IPI_SR_EL1, IPI_SR_PENDING);
         sysop("isb");
     }
@@ -567,15 +927,20 @@ void hv_exc_fiq(struct exc_info *ctx)
 
     // Handles guest timers
     hv_exc_exit(ctx);
+    hv_exit_account(class, t0);
     hv_wdt_breadcrumb('f');
 }
 
 void hv_exc_serr(struct exc_info *ctx)
 {
+    u64 t0 = mrs(CNTPCT_EL0);
+
     hv_wdt_breadcrumb('E');
     hv_get_context(ctx);
+    PERCPU(stats.exits[HV_EXIT_SERROR])++;
     hv_exc_entry();
     hv_exc_proxy(ctx, START_EXCEPTION_LOWER, EXC_SERROR, NULL);
     hv_exc_exit(ctx);
+    hv_exit_account(HV_EC_SERROR, t0);
     hv_wdt_breadcrumb('e');
 }
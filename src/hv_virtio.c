@@ -33,6 +33,9 @@
 #define DESC_NEXT  BIT(0)
 #define DESC_WRITE BIT(1)
 
+#define VIRTIO_F_EVENT_IDX BIT(29)
+#define VIRTIO_F_VERSION_1 BIT(32)
+
 struct availring {
     u16 flags;
     u16 idx;
@@ -92,6 +95,8 @@ struct virtio_dev {
     bool verbose;
 
     u32 feat_host_sel;
+    u32 feat_guest_sel;
+    u64 feat_guest;
     u32 status;
     u32 irqstatus;
 
@@ -101,22 +106,44 @@ struct virtio_dev {
 
 static struct virtio_dev *devlist;
 
-static void notify_avail(struct exc_info *ctx, struct virtio_q *q, int idx)
+static bool event_idx_on(struct virtio_dev *dev)
+{
+    return dev->feat_guest & VIRTIO_F_EVENT_IDX;
+}
+
+/* With EVENT_IDX, the used_event/avail_event words live just past each ring */
+static u16 *avail_event(struct virtio_q *q)
+{
+    return (u16 *)&q->used->ring[q->size];
+}
+
+static u16 used_event(struct virtio_q *q)
+{
+    return q->avail->ring[q->size];
+}
+
+static bool vring_need_event(u16 event, u16 new_idx, u16 old_idx)
+{
+    return (u16)(new_idx - event - 1) < (u16)(new_idx - old_idx);
+}
+
+static void notify_avail(struct exc_info *ctx, struct virtio_q *q, u16 first, u16 count)
 {
-    struct desc *d = &q->desc[idx];
     struct {
         u64 devbase;
         u16 qu;
         u16 idx;
-        u32 pad;
+        u16 count;
+        u16 size;
         u64 descbase;
+        u64 availbase;
     } PACKED info = {
-        q->host->base, q->idx, idx, 0, (u64)q->desc,
+        q->host->base, q->idx, first, count, q->size, (u64)q->desc, (u64)q->avail,
     };
 
     if (q->host->verbose)
-        printf("virtio @ %lx: available %s buffer at %lx, size %x, flags %x\n", q->host->base,
-               (d->flags & DESC_WRITE) ? "device" : "driver", d->addr, d->len, d->flags);
+        printf("virtio @ %lx: %d available buffer(s) from ring index %d\n", q->host->base, count,
+               first);
 
     hv_exc_proxy(ctx, START_HV, HV_VIRTIO, &info);
 }
@@ -129,8 +156,21 @@ static void notify_buffers(struct exc_info *ctx, struct virtio_dev *dev, u32 qid
     if (qidx >= (u32)dev->num_qus)
         return;
 
-    for (; avail->idx != q->avail_seen; q->avail_seen++)
-        notify_avail(ctx, q, avail->ring[q->avail_seen % q->size]);
+    /*
+     * Drain the entire avail ring with a single proxy round trip per batch,
+     * and tell the driver not to kick us again for buffers we already grabbed.
+     * More buffers may show up while the host is processing, so loop.
+     */
+    while (avail->idx != q->avail_seen) {
+        u16 first = q->avail_seen;
+        u16 count = avail->idx - first;
+
+        if (event_idx_on(dev))
+            *avail_event(q) = avail->idx;
+
+        q->avail_seen = avail->idx;
+        notify_avail(ctx, q, first, count);
+    }
 }
 
 static struct virtio_dev *dev_by_base(u64 base)
@@ -158,9 +198,14 @@ void virtio_put_buffer(u64 base, int qu, u32 id, u32 len)
     q = &dev->qs[qu];
     used = q->used;
 
-    used->ring[used->idx % q->size].id = id;
-    used->ring[used->idx % q->size].len = len;
-    used->idx++;
+    u16 old_idx = used->idx;
+    used->ring[old_idx % q->size].id = id;
+    used->ring[old_idx % q->size].len = len;
+    used->idx = old_idx + 1;
+
+    /* Suppress the interrupt unless the driver asked for one at this index */
+    if (event_idx_on(dev) && !vring_need_event(used_event(q), old_idx + 1, old_idx))
+        return;
 
     dev->irqstatus |= USED_BUFFER;
     aic_set_sw(dev->irq, true);
@@ -199,6 +244,13 @@ static bool handle_virtio(struct exc_info *ctx, u64 addr, u64 *val, bool write,
             case FEAT_HOST_SEL:
                 dev->feat_host_sel = *val;
                 break;
+            case FEAT_GUEST:
+                dev->feat_guest &= ~(0xffffffffUL << (dev->feat_guest_sel * 32));
+                dev->feat_guest |= *val << (dev->feat_guest_sel * 32);
+                break;
+            case FEAT_GUEST_SEL:
+                dev->feat_guest_sel = *val;
+                break;
             case IRQ_ACK:
                 dev->irqstatus &= ~(*val);
                 if (!dev->irqstatus)
@@ -288,7 +340,7 @@ void hv_map_virtio(u64 base, struct virtio_conf *conf)
     dev->irq = conf->irq;
     dev->devid = conf->devid;
     dev->currq = NULL;
-    dev->feats = conf->feats | BIT(32); /* always set: VIRTIO_F_VERSION_1 */
+    dev->feats = conf->feats | VIRTIO_F_VERSION_1 | VIRTIO_F_EVENT_IDX;
     dev->config = conf->config;
     dev->config_len = conf->config_len;
     dev->verbose = conf->verbose;
@@ -8,6 +8,7 @@
 #include "exception.h"
 #include "iodev.h"
 #include "malloc.h"
+#include "memory.h"
 #include "smp.h"
 #include "string.h"
 #include "types.h"
@@ -20,7 +21,9 @@ extern uint64_t ram_base;
 #define CACHE_LINE_SIZE 64
 #define CACHE_LINE_LOG2 6
 
-#define PTE_ACCESS            BIT(10)
+#define PTE_ACCESS BIT(10)
+/* Stage-2 layout; shadows the stage-1 definition from memory.h */
+#undef PTE_SH_NS
 #define PTE_SH_NS             (0b11L << 8)
 #define PTE_S2AP_RW           (0b11L << 6)
 #define PTE_MEMATTR_UNCHANGED (0b1111L << 2)
@@ -58,12 +61,15 @@ extern uint64_t ram_base;
 #define SPTE_TRACE_READ    BIT(63)
 #define SPTE_TRACE_WRITE   BIT(62)
 #define SPTE_TRACE_UNBUF   BIT(61)
+#define SPTE_WC            BIT(60)
 #define SPTE_TYPE          GENMASK(52, 50)
 #define SPTE_MAP           0
 #define SPTE_HOOK          1
 #define SPTE_PROXY_HOOK_R  2
 #define SPTE_PROXY_HOOK_W  3
 #define SPTE_PROXY_HOOK_RW 4
+#define SPTE_HOOK_R        5
+#define SPTE_HOOK_W        6
 
 #define IS_HW(pte) ((pte) && pte & PTE_VALID)
 #define IS_SW(pte) ((pte) && !(pte & PTE_VALID))
@@ -114,6 +120,33 @@ uint64_t vaddr_bits;
 
 static u64 *hv_Ltop;
 
+/*
+ * Software walk cache for hv_pt_walk().
+ *
+ * Every hooked guest access pays for a full software walk of the shadow
+ * tables, and hot MMIO pages (the DCP mailbox, for one) are hit millions of
+ * times. This is a small per-CPU direct-mapped cache of walk results, keyed
+ * by IPA page. Only SW leaves (hooks and moved mappings) are cached: those
+ * are exactly the hot cases, and unlike HW leaves they are never mutated in
+ * place by dirty tracking, so the only invalidation point is hv_map(), which
+ * bumps the epoch to drop all entries at once. Pages refined into L4
+ * sub-page tables are not cached, since their entries vary within the page.
+ *
+ * hv_pt_walk() and hv_map() both run under the HV lock, so no atomics are
+ * needed here.
+ */
+#define HV_PT_CACHE_ENTRIES 64
+
+struct hv_pt_cache_ent {
+    u64 tag;      // IPA page number, ~0UL if invalid
+    u64 pte;      // walk result for the page base
+    u64 off_mask; // sub-page address bits to reapply on a hit
+};
+
+static struct hv_pt_cache_ent hv_pt_cache[MAX_CPUS][HV_PT_CACHE_ENTRIES];
+static u64 hv_pt_cache_gen[MAX_CPUS];
+static u64 hv_pt_cache_epoch = 1; // per-CPU gen 0 == empty
+
 void hv_pt_init(void)
 {
     const uint64_t pa_bits[] = {32, 36, 40, 42, 44, 48, 52};
@@ -235,9 +268,14 @@ static void hv_pt_map_l3(u64 from, u64 to, u64 size, u64 incr)
     else
         to |= FIELD_PREP(PTE_TYPE, PTE_BLOCK);
 
+    u64 *l3 = NULL;
+
     for (; size; size -= BIT(VADDR_L3_OFFSET_BITS)) {
         u64 idx = (from >> VADDR_L3_OFFSET_BITS) & MASK(VADDR_L3_INDEX_BITS);
-        u64 *l3 = hv_pt_get_l3(from);
+
+        // Only re-walk the upper levels when crossing into a new L3 table
+        if (!l3 || idx == 0)
+            l3 = hv_pt_get_l3(from);
 
         if (L3_IS_TABLE(l3[idx]))
             free((void *)(l3[idx] & PTE_TARGET_MASK));
@@ -293,9 +331,14 @@ static void hv_pt_map_l4(u64 from, u64 to, u64 size, u64 incr)
     if (IS_SW(to))
         to |= FIELD_PREP(PTE_TYPE, PTE_PAGE);
 
+    u64 *l4 = NULL;
+
     for (; size; size -= BIT(VADDR_L4_OFFSET_BITS)) {
         u64 idx = (from >> VADDR_L4_OFFSET_BITS) & MASK(VADDR_L4_INDEX_BITS);
-        u64 *l4 = hv_pt_get_l4(from);
+
+        // Only re-walk the upper levels when crossing into a new L4 table
+        if (!l4 || idx == 0)
+            l4 = hv_pt_get_l4(from);
 
         l4[idx] = to;
         from += BIT(VADDR_L4_OFFSET_BITS);
@@ -303,10 +346,79 @@ static void hv_pt_map_l4(u64 from, u64 to, u64 size, u64 incr)
     }
 }
 
+/*
+ * Scoped stage-2 TLB invalidation by IPA range, so remapping (e.g. MMIO hook
+ * churn while tracing) does not blow away the guest's entire TLB state.
+ * Cores with FEAT_TLBIRANGE (ID_AA64ISAR0_EL1.TLB == 2) get RIPAS2E1IS range
+ * ops; others fall back to a per-page IPAS2E1IS loop.
+ */
+#define ID_AA64ISAR0_TLB       GENMASK(59, 56)
+#define ID_AA64ISAR0_TLB_RANGE 2
+
+static bool hv_has_tlbi_range(void)
+{
+    static int has_range = -1;
+
+    if (has_range < 0)
+        has_range = FIELD_GET(ID_AA64ISAR0_TLB, mrs(ID_AA64ISAR0_EL1)) == ID_AA64ISAR0_TLB_RANGE;
+
+    return has_range;
+}
+
+static void hv_tlbi_ipa_range(u64 ipa, u64 size)
+{
+    u64 pages = size >> VADDR_L3_OFFSET_BITS;
+
+    sysop("dsb ishst");
+
+    if (!hv_has_tlbi_range()) {
+        for (u64 off = 0; off < size; off += BIT(VADDR_L3_OFFSET_BITS)) {
+            u64 arg = (ipa + off) >> 12;
+            asm volatile("tlbi ipas2e1is, %0" : : "r"(arg) : "memory");
+        }
+    } else {
+        while (pages) {
+            if (pages < 2) {
+                u64 arg = ipa >> 12;
+                asm volatile("tlbi ipas2e1is, %0" : : "r"(arg) : "memory");
+                break;
+            }
+
+            /* Each op covers (NUM + 1) << (5 * SCALE + 1) granules */
+            int scale = 3;
+            while (scale > 0 && pages < (2UL << (5 * scale)))
+                scale--;
+            u64 num = min(pages >> (5 * scale + 1), 32UL);
+            u64 span = num << (5 * scale + 1);
+
+            /* TG = 16K, BaseADDR = IPA[50:14] */
+            u64 arg = (2UL << 46) | ((u64)scale << 44) | ((num - 1) << 39) |
+                      ((ipa >> VADDR_L3_OFFSET_BITS) & GENMASK(36, 0));
+            asm volatile("tlbi ripas2e1is, %0" : : "r"(arg) : "memory");
+
+            ipa += span << VADDR_L3_OFFSET_BITS;
+            pages -= span;
+        }
+    }
+
+    sysop("dsb ish");
+    sysop("isb");
+}
+
+static bool hv_vm_live(void)
+{
+    for (int i = 0; i < MAX_CPUS; i++)
+        if (hv_started_cpus[i])
+            return true;
+
+    return false;
+}
+
 int hv_map(u64 from, u64 to, u64 size, u64 incr)
 {
     u64 chunk;
     bool hw = IS_HW(to);
+    u64 start = from, total = size;
 
     if (from & MASK(VADDR_L4_OFFSET_BITS) || size & MASK(VADDR_L4_OFFSET_BITS))
         return -1;
@@ -316,6 +428,9 @@ int hv_map(u64 from, u64 to, u64 size, u64 incr)
         return -1;
     }
 
+    // Any mapping change may invalidate cached software walks
+    hv_pt_cache_epoch++;
+
     // L4 mappings to boundary
     chunk = min(size, ALIGN_UP(from, BIT(VADDR_L3_OFFSET_BITS)) - from);
     if (chunk) {
@@ -364,6 +479,10 @@ int hv_map(u64 from, u64 to, u64 size, u64 incr)
         hv_pt_map_l4(from, to, size, incr);
     }
 
+    // Before the guest runs, hv_start() flushes everything in one go
+    if (hv_vm_live())
+        hv_tlbi_ipa_range(start, ALIGN_UP(total, BIT(VADDR_L3_OFFSET_BITS)));
+
     return 0;
 }
 
@@ -387,6 +506,148 @@ int hv_map_hook(u64 from, hv_hook_t *hook, u64 size)
     return hv_map(from, ((u64)hook) | FIELD_PREP(SPTE_TYPE, SPTE_HOOK), size, 0);
 }
 
+/*
+ * Asymmetric hooks: only one access direction goes through the hook, the
+ * other passes straight through to hardware at the same address. Write-only
+ * tracers no longer pay the emulation cost for reads.
+ */
+int hv_map_hook_w(u64 from, hv_hook_t *hook, u64 size)
+{
+    return hv_map(from, ((u64)hook) | FIELD_PREP(SPTE_TYPE, SPTE_HOOK_W), size, 0);
+}
+
+int hv_map_hook_r(u64 from, hv_hook_t *hook, u64 size)
+{
+    return hv_map(from, ((u64)hook) | FIELD_PREP(SPTE_TYPE, SPTE_HOOK_R), size, 0);
+}
+
+/*
+ * Dirty-page tracking via stage 2 write protection.
+ *
+ * Tracked HW pages get their S2AP write bit cleared; the resulting permission
+ * faults land in hv_handle_dabort(), which records the page in a bitmap and
+ * restores write access, so each page faults once per tracking round. PTE and
+ * bitmap updates are atomic since guest vCPUs fault concurrently.
+ */
+#define PTE_S2AP_W BIT(7)
+
+static u64 hv_dirty_base;
+static u64 hv_dirty_size;
+static u64 *hv_dirty_bitmap;
+
+static u64 *hv_pt_get_leaf(u64 ipa)
+{
+    u64 *l3 = hv_pt_get_l3(ipa);
+
+    return &l3[(ipa >> VADDR_L3_OFFSET_BITS) & MASK(VADDR_L3_INDEX_BITS)];
+}
+
+static void hv_dirty_tlb_flush(void)
+{
+    sysop("dsb ishst");
+    sysop("tlbi vmalls12e1is");
+    sysop("dsb ish");
+    sysop("isb");
+}
+
+int hv_vm_start_dirty_track(u64 from, u64 size)
+{
+    if (from & MASK(VADDR_L3_OFFSET_BITS) || size & MASK(VADDR_L3_OFFSET_BITS))
+        return -1;
+
+    hv_vm_stop_dirty_track();
+
+    u64 pages = size >> VADDR_L3_OFFSET_BITS;
+    u64 words = ALIGN_UP(pages, 64) / 64;
+
+    hv_dirty_bitmap = calloc(words, sizeof(u64));
+    if (!hv_dirty_bitmap)
+        return -1;
+
+    hv_dirty_base = from;
+    hv_dirty_size = size;
+
+    for (u64 off = 0; off < size; off += BIT(VADDR_L3_OFFSET_BITS)) {
+        u64 *leaf = hv_pt_get_leaf(from + off);
+
+        if (L3_IS_HW_BLOCK(*leaf))
+            *leaf &= ~PTE_S2AP_W;
+    }
+
+    hv_dirty_tlb_flush();
+    return 0;
+}
+
+void hv_vm_stop_dirty_track(void)
+{
+    if (!hv_dirty_bitmap)
+        return;
+
+    for (u64 off = 0; off < hv_dirty_size; off += BIT(VADDR_L3_OFFSET_BITS)) {
+        u64 *leaf = hv_pt_get_leaf(hv_dirty_base + off);
+
+        if (L3_IS_HW_BLOCK(*leaf))
+            *leaf |= PTE_S2AP_W;
+    }
+
+    free(hv_dirty_bitmap);
+    hv_dirty_bitmap = NULL;
+    hv_dirty_base = hv_dirty_size = 0;
+
+    hv_dirty_tlb_flush();
+}
+
+u64 hv_vm_collect_dirty(u64 *bitmap)
+{
+    if (!hv_dirty_bitmap)
+        return (u64)-1;
+
+    u64 pages = hv_dirty_size >> VADDR_L3_OFFSET_BITS;
+    u64 words = ALIGN_UP(pages, 64) / 64;
+    u64 count = 0;
+
+    for (u64 w = 0; w < words; w++) {
+        u64 val = __atomic_exchange_n(&hv_dirty_bitmap[w], 0, __ATOMIC_ACQ_REL);
+
+        if (bitmap)
+            bitmap[w] = val;
+
+        while (val) {
+            u64 page = (w << 6) + __builtin_ctzl(val);
+            u64 *leaf = hv_pt_get_leaf(hv_dirty_base + (page << VADDR_L3_OFFSET_BITS));
+
+            val &= val - 1;
+            if (L3_IS_HW_BLOCK(*leaf))
+                __atomic_fetch_and(leaf, ~PTE_S2AP_W, __ATOMIC_ACQ_REL);
+            count++;
+        }
+    }
+
+    if (count)
+        hv_dirty_tlb_flush();
+
+    return count;
+}
+
+static bool hv_dirty_mark(u64 ipa)
+{
+    if (!hv_dirty_bitmap || ipa - hv_dirty_base >= hv_dirty_size)
+        return false;
+
+    u64 *leaf = hv_pt_get_leaf(ipa);
+
+    if (!L3_IS_HW_BLOCK(*leaf) || (*leaf & PTE_S2AP_W))
+        return false;
+
+    __atomic_fetch_or(leaf, PTE_S2AP_W, __ATOMIC_ACQ_REL);
+
+    u64 page = (ipa - hv_dirty_base) >> VADDR_L3_OFFSET_BITS;
+    __atomic_fetch_or(&hv_dirty_bitmap[page >> 6], BIT(page & 63), __ATOMIC_ACQ_REL);
+
+    hv_dirty_tlb_flush();
+    return true;
+}
+
 u64 hv_translate(u64 addr, bool s1, bool w, u64 *par_out)
 {
     if (!(mrs(SCTLR_EL12) & SCTLR_M))
@@ -434,10 +695,61 @@ u64 hv_translate(u64 addr, bool s1, bool w, u64 *par_out)
     }
 }
 
+/*
+ * Gather a list of guest-virtual extents into one host-readable buffer.
+ * Guest VAs are translated in 4K steps (the smallest stage-1 granule, so the
+ * backing memory need not be contiguous), letting host-side structure chasers
+ * pull hundreds of reads in a single proxy round trip. Returns the number of
+ * bytes gathered; the first untranslatable page or a full output buffer stops
+ * the copy short.
+ */
+s64 hv_gather(struct hv_gather_ent *list, u32 count, void *buf, u64 size)
+{
+    u64 done = 0;
+
+    for (u32 i = 0; i < count; i++) {
+        u64 vaddr = list[i].addr;
+        u64 left = list[i].len;
+
+        while (left) {
+            u64 chunk = min(left, SZ_4K - (vaddr & (SZ_4K - 1)));
+            if (chunk > size - done)
+                chunk = size - done;
+            if (!chunk)
+                return done;
+
+            u64 paddr = hv_translate(vaddr, false, false, NULL);
+            if (!paddr)
+                return done;
+
+            memcpy((u8 *)buf + done, (void *)paddr, chunk);
+            done += chunk;
+            vaddr += chunk;
+            left -= chunk;
+        }
+    }
+
+    return done;
+}
+
 u64 hv_pt_walk(u64 addr)
 {
     dprintf("hv_pt_walk(0x%lx)\n", addr);
 
+    int cpu = smp_id();
+    u64 tag = addr >> VADDR_L3_OFFSET_BITS;
+    struct hv_pt_cache_ent *ent = &hv_pt_cache[cpu][tag & (HV_PT_CACHE_ENTRIES - 1)];
+
+    if (hv_pt_cache_gen[cpu] != hv_pt_cache_epoch) {
+        memset(hv_pt_cache[cpu], 0xff, sizeof(hv_pt_cache[cpu]));
+        hv_pt_cache_gen[cpu] = hv_pt_cache_epoch;
+    } else if (ent->tag == tag) {
+        // SW block targets need not be page aligned, so reapply the sub-page
+        // offset as an add (a no-op for hooks, which have off_mask == 0)
+        dprintf("  cached: 0x%lx\n", ent->pte + (addr & ent->off_mask));
+        return ent->pte + (addr & ent->off_mask);
+    }
+
     u64 idx = addr >> VADDR_L1_OFFSET_BITS;
     u64 *l2;
     if (vaddr_bits > 36) {
@@ -462,15 +774,25 @@ u64 hv_pt_walk(u64 addr)
     dprintf("  l2d = 0x%lx\n", l2d);
 
     if (!L2_IS_TABLE(l2d)) {
-        if (L2_IS_SW_BLOCK(l2d))
-            l2d += addr & (VADDR_L2_ALIGN_MASK | VADDR_L3_ALIGN_MASK);
+        u64 off_mask = 0;
+        if (L2_IS_SW_BLOCK(l2d)) {
+            l2d += addr & VADDR_L2_ALIGN_MASK;
+            off_mask = VADDR_L3_ALIGN_MASK;
+        }
         if (L2_IS_HW_BLOCK(l2d)) {
             l2d &= ~PTE_LOWER_ATTRIBUTES;
-            l2d |= addr & (VADDR_L2_ALIGN_MASK | VADDR_L3_ALIGN_MASK);
+            l2d |= addr & VADDR_L2_ALIGN_MASK;
+            off_mask = VADDR_L3_ALIGN_MASK;
+        }
+
+        if (IS_SW(l2d)) {
+            ent->tag = tag;
+            ent->pte = l2d;
+            ent->off_mask = off_mask;
         }
 
-        dprintf("  result: 0x%lx\n", l2d);
-        return l2d;
+        dprintf("  result: 0x%lx\n", l2d + (addr & off_mask));
+        return l2d + (addr & off_mask);
     }
 
     idx = (addr >> VADDR_L3_OFFSET_BITS) & MASK(VADDR_L3_INDEX_BITS);
@@ -478,16 +800,25 @@ u64 hv_pt_walk(u64 addr)
     dprintf("  l3d = 0x%lx\n", l3d);
 
     if (!L3_IS_TABLE(l3d)) {
+        u64 off_mask = 0;
         if (L3_IS_SW_BLOCK(l3d))
-            l3d += addr & VADDR_L3_ALIGN_MASK;
+            off_mask = VADDR_L3_ALIGN_MASK;
         if (L3_IS_HW_BLOCK(l3d)) {
             l3d &= ~PTE_LOWER_ATTRIBUTES;
-            l3d |= addr & VADDR_L3_ALIGN_MASK;
+            off_mask = VADDR_L3_ALIGN_MASK;
         }
-        dprintf("  result: 0x%lx\n", l3d);
-        return l3d;
+
+        if (IS_SW(l3d)) {
+            ent->tag = tag;
+            ent->pte = l3d;
+            ent->off_mask = off_mask;
+        }
+
+        dprintf("  result: 0x%lx\n", l3d + (addr & off_mask));
+        return l3d + (addr & off_mask);
     }
 
+    // L4 entries vary at word granularity within the page, so they bypass the cache
     idx = (addr >> VADDR_L4_OFFSET_BITS) & MASK(VADDR_L4_INDEX_BITS);
     dprintf("  l4 idx = 0x%lx\n", idx);
     u64 l4d = ((u64 *)(l3d & PTE_TARGET_MASK))[idx];
@@ -821,6 +1152,89 @@ static bool emulate_store(struct exc_info *ctx, u32 insn, u64 *val, u64 *width,
     return true;
 }
 
+static struct hv_trace_ring *trace_ring = NULL;
+static DECLARE_SPINLOCK(trace_ring_lock);
+
+int hv_tracering_init(void *buf, u32 num_events)
+{
+    if (buf && (num_events < 2 || (num_events & (num_events - 1))))
+        return -1;
+
+    spin_lock(&trace_ring_lock);
+    if (buf) {
+        struct hv_trace_ring *ring = buf;
+
+        ring->wptr = 0;
+        ring->rptr = 0;
+        ring->num_events = num_events;
+        sysop("dmb ish");
+        trace_ring = ring;
+    } else {
+        trace_ring = NULL;
+    }
+    spin_unlock(&trace_ring_lock);
+
+    return 0;
+}
+
+static bool trace_ring_push(struct hv_evt_mmiotrace *evt)
+{
+    bool ok = false;
+
+    spin_lock(&trace_ring_lock);
+    if (trace_ring && trace_ring->wptr - trace_ring->rptr < trace_ring->num_events) {
+        trace_ring->evt[trace_ring->wptr & (trace_ring->num_events - 1)] = *evt;
+        // Make sure the event is visible before publishing the new wptr
+        sysop("dmb ish");
+        trace_ring->wptr++;
+        ok = true;
+    }
+    spin_unlock(&trace_ring_lock);
+
+    return ok;
+}
+
+static struct hv_trace_filter_ent *trace_filter = NULL;
+static u32 trace_filter_count = 0;
+
+int hv_trace_filter_init(void *buf, u32 count)
+{
+    if (buf && !count)
+        return -1;
+
+    spin_lock(&trace_ring_lock);
+    trace_filter_count = buf ? count : 0;
+    sysop("dmb ish");
+    trace_filter = buf;
+    spin_unlock(&trace_ring_lock);
+
+    return 0;
+}
+
+static bool trace_filter_match(u64 addr, u64 *data, u64 width, bool is_write)
+{
+    struct hv_trace_filter_ent *filter = trace_filter;
+
+    if (!filter)
+        return true;
+
+    for (u32 i = 0; i < trace_filter_count; i++) {
+        struct hv_trace_filter_ent *ent = &filter[i];
+
+        if (!(ent->flags & (is_write ? HV_TRACE_FILTER_W : HV_TRACE_FILTER_R)))
+            continue;
+        if (addr < ent->start || addr >= ent->end)
+            continue;
+        if (!ent->mask)
+            return true;
+        for (u64 off = 0; off < (1UL << width); off += 8)
+            if ((data[off >> 3] & ent->mask) == ent->value)
+                return true;
+    }
+
+    return false;
+}
+
 static void emit_mmiotrace(u64 pc, u64 addr, u64 *data, u64 width, u64 flags, bool sync)
 {
     struct hv_evt_mmiotrace evt = {
@@ -836,6 +1250,12 @@ static void emit_mmiotrace(u64 pc, u64 addr, u64 *data, u64 width, u64 flags, bo
 
     for (int i = 0; i < (1 << width); i += 8) {
         evt.data = *data++;
+        // Buffered events go through the shared ring when the host has one
+        // mapped; fall back to a proxy event when it is full or absent.
+        if (!sync && trace_ring_push(&evt)) {
+            evt.addr += 8;
+            continue;
+        }
         hv_wdt_suspend();
         uartproxy_send_event(EVT_MMIOTRACE, &evt, sizeof(evt));
         if (sync) {
@@ -942,6 +1362,60 @@ bool hv_pa_rw(struct exc_info *ctx, u64 addr, u64 *val, bool write, int width)
         return hv_pa_read(ctx, addr, val, width);
 }
 
+/*
+ * Write combining for proxy write hooks (SPTE_WC): a run of adjacent guest
+ * writes to the same hook accumulates here and reaches the host as a single
+ * HV_HOOK_VM event. Each write still exits, but only the flush pays the host
+ * round trip. Runs flush when broken (different hook, non-adjacent address,
+ * buffer full), before any other proxy hook event so ordering is preserved,
+ * and from the vtimer path so the tail of a run is never stuck. All callers
+ * hold the big HV lock.
+ */
+static struct {
+    bool valid;
+    u32 id;
+    u32 len;
+    u32 flags;
+    u64 base;
+    u8 data[HV_MAX_RW_WORDS * 8];
+} wc_state;
+
+void hv_wc_flush(struct exc_info *ctx)
+{
+    if (!wc_state.valid)
+        return;
+
+    struct hv_vm_proxy_hook_data hook = {
+        .flags = wc_state.flags | MMIO_EVT_WC | MMIO_EVT_WRITE |
+                 FIELD_PREP(MMIO_EVT_WC_NLEN, wc_state.len - 1),
+        .id = wc_state.id,
+        .addr = wc_state.base,
+    };
+    memcpy(hook.data, wc_state.data, wc_state.len);
+
+    // Clear before proxying in case the host touches another hooked page
+    wc_state.valid = false;
+    hv_exc_proxy(ctx, START_HV, HV_HOOK_VM, &hook);
+}
+
+static void hv_wc_append(struct exc_info *ctx, u32 id, u64 ipa, u64 *val, u64 width, u64 flags)
+{
+    if (wc_state.valid && (wc_state.id != id || ipa != wc_state.base + wc_state.len ||
+                           wc_state.len + (1 << width) > sizeof(wc_state.data)))
+        hv_wc_flush(ctx);
+
+    if (!wc_state.valid) {
+        wc_state.valid = true;
+        wc_state.id = id;
+        wc_state.len = 0;
+        wc_state.flags = flags;
+        wc_state.base = ipa;
+    }
+
+    memcpy(wc_state.data + wc_state.len, val, 1 << width);
+    wc_state.len += 1 << width;
+}
+
 static bool hv_emulate_rw_aligned(struct exc_info *ctx, u64 pte, u64 vaddr, u64 ipa, u64 *val,
                                   bool is_write, u64 width, u64 elr, u64 par)
 {
@@ -961,13 +1435,14 @@ static bool hv_emulate_rw_aligned(struct exc_info *ctx, u64 pte, u64 vaddr, u64
         // Write
         hv_wdt_breadcrumb('3');
 
-        if (pte & SPTE_TRACE_WRITE)
+        if ((pte & SPTE_TRACE_WRITE) && trace_filter_match(ipa, val, width, true))
             emit_mmiotrace(elr, ipa, val, width, flags | MMIO_EVT_WRITE, pte & SPTE_TRACE_UNBUF);
 
         hv_wdt_breadcrumb('4');
 
         switch (FIELD_GET(SPTE_TYPE, pte)) {
             case SPTE_PROXY_HOOK_R:
+            case SPTE_HOOK_R:
                 paddr = ipa;
                 // fallthrough
             case SPTE_MAP:
@@ -977,7 +1452,8 @@ static bool hv_emulate_rw_aligned(struct exc_info *ctx, u64 pte, u64 vaddr, u64
                 if (!hv_pa_write(ctx, paddr, val, width))
                     return false;
                 break;
-            case SPTE_HOOK: {
+            case SPTE_HOOK:
+            case SPTE_HOOK_W: {
                 hv_wdt_breadcrumb('6');
                 hv_hook_t *hook = (hv_hook_t *)target;
                 if (!hook(ctx, ipa, val, true, width))
@@ -989,9 +1465,17 @@ static bool hv_emulate_rw_aligned(struct exc_info *ctx, u64 pte, u64 vaddr, u64
             case SPTE_PROXY_HOOK_RW:
             case SPTE_PROXY_HOOK_W: {
                 hv_wdt_breadcrumb('7');
+                u32 id = FIELD_GET(PTE_TARGET_MASK_L4, pte);
+
+                if ((pte & SPTE_WC) && FIELD_GET(SPTE_TYPE, pte) == SPTE_PROXY_HOOK_W) {
+                    hv_wc_append(ctx, id, ipa, val, width, flags);
+                    break;
+                }
+
+                hv_wc_flush(ctx);
                 struct hv_vm_proxy_hook_data hook = {
                     .flags = FIELD_PREP(MMIO_EVT_WIDTH, width) | MMIO_EVT_WRITE | flags,
-                    .id = FIELD_GET(PTE_TARGET_MASK_L4, pte),
+                    .id = id,
                     .addr = ipa,
                     .data = {0},
                 };
@@ -1007,6 +1491,7 @@ static bool hv_emulate_rw_aligned(struct exc_info *ctx, u64 pte, u64 vaddr, u64
         hv_wdt_breadcrumb('3');
         switch (FIELD_GET(SPTE_TYPE, pte)) {
             case SPTE_PROXY_HOOK_W:
+            case SPTE_HOOK_W:
                 paddr = ipa;
                 // fallthrough
             case SPTE_MAP:
@@ -1016,7 +1501,8 @@ static bool hv_emulate_rw_aligned(struct exc_info *ctx, u64 pte, u64 vaddr, u64
                 dprintf("HV: SPTE_MAP[R] @0x%lx 0x%lx -> 0x%lx (w=%d): 0x%lx\n", elr, ipa, paddr,
                         1 << width, val[0]);
                 break;
-            case SPTE_HOOK: {
+            case SPTE_HOOK:
+            case SPTE_HOOK_R: {
                 hv_wdt_breadcrumb('5');
                 hv_hook_t *hook = (hv_hook_t *)target;
                 if (!hook(ctx, ipa, val, false, width))
@@ -1028,6 +1514,7 @@ static bool hv_emulate_rw_aligned(struct exc_info *ctx, u64 pte, u64 vaddr, u64
             case SPTE_PROXY_HOOK_RW:
             case SPTE_PROXY_HOOK_R: {
                 hv_wdt_breadcrumb('6');
+                hv_wc_flush(ctx);
                 struct hv_vm_proxy_hook_data hook = {
                     .flags = FIELD_PREP(MMIO_EVT_WIDTH, width) | flags,
                     .id = FIELD_GET(PTE_TARGET_MASK_L4, pte),
@@ -1043,7 +1530,7 @@ static bool hv_emulate_rw_aligned(struct exc_info *ctx, u64 pte, u64 vaddr, u64
         }
 
         hv_wdt_breadcrumb('7');
-        if (pte & SPTE_TRACE_READ)
+        if ((pte & SPTE_TRACE_READ) && trace_filter_match(ipa, val, width, false))
             emit_mmiotrace(elr, ipa, val, width, flags, pte & SPTE_TRACE_UNBUF);
     }
 
@@ -1121,6 +1608,184 @@ static bool hv_emulate_rw(struct exc_info *ctx, u64 pte, u64 vaddr, u64 ipa, u8
     return true;
 }
 
+/*
+ * Emulate-ahead for guest copy loops. A guest memcpy into a hooked region
+ * takes one exit per store, which turns a single block copy into an exit
+ * storm. Detect a streak of sequential faulting stores from one PC and, once
+ * established, decode the surrounding loop. If it is the canonical copy
+ * idiom
+ *
+ *     ldr  Rt, [Rs], #size
+ *     str  Rt, [Rd], #size    <- the faulting store
+ *     subs Rc, Rc, #1
+ *     b.ne back to the ldr
+ *
+ * service up to HV_COPY_MAX_ITERS further iterations in this exit: load from
+ * the guest source, emulate the store through the normal SPTE path (so
+ * hooks, tracing and write combining all still apply), and update Rs/Rd/Rc
+ * and NZCV. Every stop point is a clean architectural boundary, so when the
+ * burst ends early (budget, source fault, region edge) the guest simply
+ * resumes the loop natively.
+ */
+#define HV_COPY_THRESHOLD 8
+#define HV_COPY_MAX_ITERS 2048
+
+static struct {
+    u64 pc;
+    u64 next_ipa;
+    u32 streak;
+} copy_state;
+
+static bool hv_copy_fetch(u64 vaddr, u32 *insn)
+{
+    u64 pa = hv_translate(vaddr, false, false, NULL);
+
+    if (!pa)
+        return false;
+
+    *insn = read32(pa);
+    return true;
+}
+
+static void hv_copy_run_ahead(struct exc_info *ctx, u32 insn, u64 width, u64 elr, u64 par)
+{
+    u64 *regs = ctx->regs;
+    u64 bytes = 1 << width;
+    u32 ldr, subs, bne;
+
+    /* str Rt, [Rd], #imm (post-index), stride == access size, GPR only */
+    if ((insn & 0x3fe00c00) != 0x38000400 || width > 3)
+        return;
+
+    u64 Rt = insn & 0x1f;
+    u64 Rd = (insn >> 5) & 0x1f;
+
+    if (Rd == 31 || Rt == Rd || EXT((insn >> 12) & 0x1ff, 9) != (s64)bytes)
+        return;
+
+    if (!hv_copy_fetch(elr - 4, &ldr) || !hv_copy_fetch(elr + 4, &subs) ||
+        !hv_copy_fetch(elr + 8, &bne))
+        return;
+
+    /* ldr Rt, [Rs], #imm with the same width and stride */
+    if ((ldr & 0x3fe00c00) != 0x38400400 || (ldr >> 30) != width || (ldr & 0x1f) != Rt)
+        return;
+
+    u64 Rs = (ldr >> 5) & 0x1f;
+
+    if (Rs == 31 || Rs == Rd || Rs == Rt || EXT((ldr >> 12) & 0x1ff, 9) != (s64)bytes)
+        return;
+
+    /* subs Rc, Rc, #1 (64-bit) */
+    if ((subs & 0xffc00000) != 0xf1000000)
+        return;
+
+    u64 Rc = subs & 0x1f;
+
+    if (Rc != ((subs >> 5) & 0x1f) || Rc == 31 || ((subs >> 10) & 0xfff) != 1)
+        return;
+    if (Rc == Rt || Rc == Rs || Rc == Rd)
+        return;
+
+    /* b.ne back to the ldr */
+    if (bne != (0x54000001 | ((-3ull & 0x7ffff) << 5)))
+        return;
+
+    /* keep to the aligned case; split accesses take the slow path */
+    if ((regs[Rs] | regs[Rd]) & (bytes - 1))
+        return;
+
+    int iters = 0;
+    bool set_flags = false;
+    u64 nzcv = 0;
+
+    /*
+     * The faulting store was already emulated; its writeback is done and the
+     * guest is logically at the subs. Run extra (subs, b.ne, ldr, str)
+     * iterations from there; without an explicit ELR fixup, the exit return
+     * path resumes at the subs, which is the clean stop point.
+     */
+    while (iters < HV_COPY_MAX_ITERS) {
+        u64 c = regs[Rc];
+        u64 v = 0;
+        u64 src_pa = 0;
+
+        if (c != 1) {
+            /* Peek the source before committing the subs */
+            u64 src_ipa = hv_translate(regs[Rs], true, false, NULL);
+            if (!src_ipa)
+                break;
+
+            u64 spte = hv_pt_walk(src_ipa);
+            if (!IS_HW(spte))
+                break;
+
+            src_pa = (spte & PTE_TARGET_MASK_L4) | (src_ipa & MASK(VADDR_L4_OFFSET_BITS));
+        }
+
+        u64 r = c - 1;
+        regs[Rc] = r;
+        nzcv = ((r >> 63) << 3) | ((u64)(r == 0) << 2) | ((u64)(c != 0) << 1) |
+               (c == (1ULL << 63));
+        set_flags = true;
+
+        if (r == 0) {
+            /* b.ne falls through; resume past the loop */
+            ctx->elr = elr + 8;
+            break;
+        }
+
+        /* ldr Rt, [Rs], #imm */
+        if (!hv_pa_read(ctx, src_pa, &v, width)) {
+            ctx->elr = elr - 8;
+            break;
+        }
+
+        regs[Rt] = v;
+        regs[Rs] += bytes;
+
+        /* str Rt, [Rd], #imm */
+        u64 dst_ipa = hv_translate(regs[Rd], true, true, NULL);
+        if (!dst_ipa) {
+            ctx->elr = elr - 4;
+            break;
+        }
+
+        u64 dpte = hv_pt_walk(dst_ipa);
+        if (!IS_SW(dpte) || !hv_emulate_rw(ctx, dpte, regs[Rd], dst_ipa, (u8 *)&v, true, bytes,
+                                           elr, par)) {
+            ctx->elr = elr - 4;
+            break;
+        }
+
+        regs[Rd] += bytes;
+        iters++;
+    }
+
+    if (set_flags)
+        ctx->spsr = (ctx->spsr & ~(0xfULL << 28)) | (nzcv << 28);
+
+    dprintf("HV: copy emulate-ahead: %d iterations @ 0x%lx\n", iters, elr);
+}
+
+static void hv_copy_detect(struct exc_info *ctx, u32 insn, u64 width, u64 ipa, u64 elr, u64 par)
+{
+    if (elr == copy_state.pc && ipa == copy_state.next_ipa) {
+        if (++copy_state.streak >= HV_COPY_THRESHOLD) {
+            hv_copy_run_ahead(ctx, insn, width, elr, par);
+            /* the burst moved the stream; re-detect from scratch */
+            copy_state.pc = 0;
+            copy_state.streak = 0;
+            return;
+        }
+    } else {
+        copy_state.streak = 0;
+    }
+
+    copy_state.pc = elr;
+    copy_state.next_ipa = ipa + (1 << width);
+}
+
 bool hv_handle_dabort(struct exc_info *ctx)
 {
     hv_wdt_breadcrumb('0');
@@ -1146,11 +1811,18 @@ bool hv_handle_dabort(struct exc_info *ctx)
     u64 pte = hv_pt_walk(ipa);
 
     if (!pte) {
-        printf("HV: Unmapped IPA 0x%lx\n", ipa);
+        const struct mem_region *rgn = mem_map_lookup(ipa);
+        printf("HV: Unmapped IPA 0x%lx (%s)\n", ipa, rgn ? mem_region_type_name(rgn->type) : "hole");
         return false;
     }
 
     if (IS_HW(pte)) {
+        // Write to a page we write-protected for dirty tracking
+        if (is_write && hv_dirty_mark(ipa)) {
+            ctx->elr -= 4;
+            return true;
+        }
+
         printf("HV: Data abort on mapped page (0x%lx -> 0x%lx)\n", far, pte);
         // Try again, this is usually a race
         ctx->elr -= 4;
@@ -1212,6 +1884,9 @@ bool hv_handle_dabort(struct exc_info *ctx)
 
         if (!hv_emulate_rw(ctx, pte, vaddr, ipa, val, is_write, bytes, elr, par))
             return false;
+
+        if (is_write)
+            hv_copy_detect(ctx, insn, width, ipa, elr, par);
     } else {
         // Oops, we're straddling a page boundary
         // Treat it as two separate loads or stores
@@ -1290,3 +1965,87 @@ bool hv_handle_dabort(struct exc_info *ctx)
 
     return true;
 }
+
+/*
+ * Trace-driven MMIO replay. Feeds recorded hv_evt_mmiotrace records (the same
+ * layout the trace ring emits) back at the hardware, optionally preserving the
+ * recorded inter-access timing, and compares what the device returns for reads
+ * against the recorded values. Every replayed read overwrites the record's
+ * data field with the observed value so the host can diff the whole run
+ * afterwards; the return value is the index of the first divergence, or count
+ * if the device behaved as recorded.
+ *
+ * When HV_REPLAY_TIMED is set, the reserved field of each record holds the
+ * tick delta to the previous access.
+ */
+s64 hv_mmio_replay(struct hv_evt_mmiotrace *evts, u32 count, u32 replay_flags)
+{
+    s64 first_div = count;
+    u64 deadline = get_ticks();
+
+    for (u32 i = 0; i < count; i++) {
+        struct hv_evt_mmiotrace *evt = &evts[i];
+        u32 width = FIELD_GET(MMIO_EVT_WIDTH, evt->flags);
+        bool diverged = false;
+
+        /* MULTI runs are recorded as consecutive 8-byte events */
+        if (width > 3)
+            return i;
+
+        if (replay_flags & HV_REPLAY_TIMED) {
+            deadline += evt->reserved;
+            while (get_ticks() < deadline)
+                sysop("isb");
+        }
+
+        int exc_before = exc_count;
+        exc_guard = GUARD_MARK | GUARD_SILENT;
+        if (evt->flags & MMIO_EVT_WRITE) {
+            switch (width) {
+                case 0:
+                    write8(evt->addr, evt->data);
+                    break;
+                case 1:
+                    write16(evt->addr, evt->data);
+                    break;
+                case 2:
+                    write32(evt->addr, evt->data);
+                    break;
+                case 3:
+                    write64(evt->addr, evt->data);
+                    break;
+            }
+        } else {
+            u64 val = 0;
+            switch (width) {
+                case 0:
+                    val = read8(evt->addr);
+                    break;
+                case 1:
+                    val = read16(evt->addr);
+                    break;
+                case 2:
+                    val = read32(evt->addr);
+                    break;
+                case 3:
+                    val = read64(evt->addr);
+                    break;
+            }
+            if (exc_count == exc_before && val != evt->data)
+                diverged = true;
+            evt->data = val;
+        }
+        exc_guard = GUARD_OFF;
+        if (exc_count != exc_before)
+            diverged = true;
+
+        if (diverged) {
+            if (!(replay_flags & HV_REPLAY_CONTINUE))
+                return i;
+            if (first_div == (s64)count)
+                first_div = i;
+        }
+    }
+
+    return first_div;
+}
@@ -3,6 +3,7 @@
 #include "hv.h"
 #include "aic.h"
 #include "iodev.h"
+#include "timer.h"
 #include "uart.h"
 #include "uart_regs.h"
 #include "usb.h"
@@ -15,12 +16,63 @@ u32 ufstat = 0;
 
 int vuart_irq = 0;
 
+/*
+ * A verbose guest console writes UTXH one byte per trap; shipping each byte
+ * straight to the iodev floods the host with tiny transfers. Accumulate TX
+ * bytes and flush in bulk, either when the buffer fills or shortly after the
+ * first pending byte (a one-shot timer fires the flush when the guest goes
+ * quiet).
+ */
+#define TX_BUFSIZE    4096
+#define TX_FLUSH_USEC 1000
+
+static u8 tx_buf[TX_BUFSIZE];
+static size_t tx_len = 0;
+static int tx_timer = -1;
+
+static void tx_flush(void)
+{
+    if (tx_timer >= 0) {
+        timer_cancel(tx_timer);
+        tx_timer = -1;
+    }
+
+    if (!tx_len)
+        return;
+
+    if (iodev_can_write(IODEV_USB_VUART))
+        iodev_write(IODEV_USB_VUART, tx_buf, tx_len);
+
+    tx_len = 0;
+}
+
+static void tx_flush_timer(void *cookie)
+{
+    UNUSED(cookie);
+
+    tx_timer = -1;
+    tx_flush();
+}
+
+static void tx_push(u8 b)
+{
+    if (tx_len == TX_BUFSIZE)
+        tx_flush();
+
+    if (!tx_len)
+        tx_timer = timer_register(TX_FLUSH_USEC, tx_flush_timer, NULL);
+
+    tx_buf[tx_len++] = b;
+}
+
 static void update_irq(void)
 {
     ssize_t rx_queued;
 
     iodev_handle_events(IODEV_USB_VUART);
 
+    timer_poll();
+
     utrstat |= UTRSTAT_TXBE | UTRSTAT_TXE;
     utrstat &= ~UTRSTAT_RXD;
 
@@ -68,12 +120,9 @@ static bool handle_vuart(struct exc_info *ctx, u64 addr, u64 *val, bool write, i
             case UCON:
                 ucon = *val;
                 break;
-            case UTXH: {
-                uint8_t b = *val;
-                if (iodev_can_write(IODEV_USB_VUART))
-                    iodev_write(IODEV_USB_VUART, &b, 1);
+            case UTXH:
+                tx_push(*val);
                 break;
-            }
             case UTRSTAT:
                 utrstat &= ~(*val & (UTRSTAT_TXTHRESH | UTRSTAT_RXTHRESH | UTRSTAT_RXTO));
                 break;
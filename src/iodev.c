@@ -4,6 +4,7 @@
 
 #include "iodev.h"
 #include "memory.h"
+#include "plog.h"
 #include "string.h"
 
 #ifdef DEBUG_IODEV
@@ -14,20 +15,29 @@
     } while (0)
 #endif
 
-#define CONSOLE_BUFFER_SIZE 8192
-
 extern struct iodev iodev_uart;
 extern struct iodev iodev_fb;
 extern struct iodev iodev_usb_vuart;
+extern struct iodev iodev_usb_event;
 
 struct iodev *iodevs[IODEV_MAX] = {
     [IODEV_UART] = &iodev_uart,
     [IODEV_FB] = &iodev_fb,
     [IODEV_USB_VUART] = &iodev_usb_vuart,
+    [IODEV_USB_EVENT] = &iodev_usb_event,
+};
+
+/*
+ * The console staging ring doubles as a shared-memory stdout channel: the host
+ * fetches its address once via P_CONSOLE_RING_GET, then tails wptr and
+ * bulk-reads new bytes straight out of the buffer, with no per-line proxy
+ * traffic. wptr is free-running; the ring keeps the newest size bytes.
+ */
+struct console_ring con_ring = {
+    .magic = CONSOLE_RING_MAGIC,
+    .size = CONSOLE_BUFFER_SIZE,
 };
 
-char con_buf[CONSOLE_BUFFER_SIZE];
-size_t con_wp;
 size_t con_rp[IODEV_MAX];
 
 void iodev_register_device(iodev_id_t id, struct iodev *dev)
@@ -112,6 +122,60 @@ ssize_t iodev_queue(iodev_id_t id, const void *buf, size_t length)
     return ret;
 }
 
+ssize_t iodev_queue_sg(iodev_id_t id, const struct iodev_iovec *iov, int niov)
+{
+    if (!iodevs[id] || (!iodevs[id]->ops->queue_sg && !iodevs[id]->ops->queue &&
+                        !iodevs[id]->ops->write))
+        return -1;
+
+    if (mmu_active())
+        spin_lock(&iodevs[id]->lock);
+
+    ssize_t ret = 0;
+
+    if (iodevs[id]->ops->queue_sg) {
+        ret = iodevs[id]->ops->queue_sg(iodevs[id]->opaque, iov, niov);
+    } else {
+        // Fall back to per-segment queueing under a single lock acquisition
+        for (int i = 0; i < niov; i++) {
+            ssize_t seg;
+
+            if (!iov[i].len)
+                continue;
+
+            if (iodevs[id]->ops->queue)
+                seg = iodevs[id]->ops->queue(iodevs[id]->opaque, iov[i].base, iov[i].len);
+            else
+                seg = iodevs[id]->ops->write(iodevs[id]->opaque, iov[i].base, iov[i].len);
+
+            if (seg < 0) {
+                ret = seg;
+                break;
+            }
+            ret += seg;
+            if ((size_t)seg < iov[i].len)
+                break;
+        }
+    }
+
+    if (mmu_active())
+        spin_unlock(&iodevs[id]->lock);
+    return ret;
+}
+
+ssize_t iodev_write_room(iodev_id_t id)
+{
+    if (!iodevs[id] || !iodevs[id]->ops->write_room)
+        return -1;
+
+    if (mmu_active())
+        spin_lock(&iodevs[id]->lock);
+    ssize_t ret = iodevs[id]->ops->write_room(iodevs[id]->opaque);
+    if (mmu_active())
+        spin_unlock(&iodevs[id]->lock);
+    return ret;
+}
+
 void iodev_flush(iodev_id_t id)
 {
     if (!iodevs[id] || !iodevs[id]->ops->flush)
@@ -144,8 +208,16 @@ void iodev_unlock(iodev_id_t id)
 
 int in_iodev = 0;
 
+static bool console_bounded = false;
+u64 con_overrun[IODEV_MAX];
+
 static DECLARE_SPINLOCK(console_lock);
 
+void iodev_console_bounded(bool enable)
+{
+    console_bounded = enable;
+}
+
 void iodev_console_write(const void *buf, size_t length)
 {
     bool do_lock = mmu_active();
@@ -161,6 +233,9 @@ void iodev_console_write(const void *buf, size_t length)
     if (do_lock)
         spin_lock(&console_lock);
 
+    /* Mirror into the persistent ring, including reentrant prints */
+    plog_write(buf, length);
+
     if (in_iodev) {
         if (length && iodevs[IODEV_UART]->usage & USAGE_CONSOLE) {
             iodevs[IODEV_UART]->ops->write(iodevs[IODEV_UART]->opaque, "+", 1);
@@ -172,36 +247,58 @@ void iodev_console_write(const void *buf, size_t length)
     }
     in_iodev++;
 
-    dprintf("  iodev_console_write() wp=%d\n", con_wp);
+    dprintf("  iodev_console_write() wp=%d\n", con_ring.wptr);
     for (iodev_id_t id = 0; id < IODEV_MAX; id++) {
         if (!iodevs[id])
             continue;
 
         if (!(iodevs[id]->usage & USAGE_CONSOLE)) {
             /* Drop buffer */
-            con_rp[id] = con_wp + length;
+            con_rp[id] = con_ring.wptr + length;
             continue;
         }
 
         if (!iodev_can_write(id))
             continue;
 
-        if (con_wp > CONSOLE_BUFFER_SIZE)
-            con_rp[id] = max(con_wp - CONSOLE_BUFFER_SIZE, con_rp[id]);
+        if (con_ring.wptr > CONSOLE_BUFFER_SIZE) {
+            u64 floor = con_ring.wptr - CONSOLE_BUFFER_SIZE;
+            if (floor > con_rp[id]) {
+                con_overrun[id] += floor - con_rp[id];
+                con_rp[id] = floor;
+            }
+        }
+
+        /*
+         * In bounded mode, only hand the device what it can take without
+         * blocking; whatever is left stays in the ring for a later write
+         * (or gets counted as overrun when overwritten).
+         */
+        ssize_t room = -1;
+        if (console_bounded) {
+            room = iodev_write_room(id);
+            if (!room)
+                continue;
+        }
 
         dprintf("  rp=%d\n", con_rp[id]);
         // Flush existing buffer to device if possible
-        while (con_rp[id] < con_wp) {
+        while (con_rp[id] < con_ring.wptr) {
             size_t buf_rp = con_rp[id] % CONSOLE_BUFFER_SIZE;
-            size_t block = min(con_wp - con_rp[id], CONSOLE_BUFFER_SIZE - buf_rp);
+            size_t block = min(con_ring.wptr - con_rp[id], CONSOLE_BUFFER_SIZE - buf_rp);
+
+            if (room >= 0)
+                block = min(block, (size_t)room);
 
             dprintf("  write buf %d\n", block);
-            ssize_t ret = iodev_write(id, &con_buf[buf_rp], block);
+            ssize_t ret = iodev_write(id, &con_ring.buf[buf_rp], block);
 
             if (ret <= 0)
                 goto next_dev;
 
             con_rp[id] += ret;
+            if (room >= 0 && !(room -= ret))
+                goto next_dev;
         }
 
         const u8 *p = buf;
@@ -209,7 +306,12 @@ void iodev_console_write(const void *buf, size_t length)
 
         // Write the current buffer
         while (wrote < length) {
-            ssize_t ret = iodev_write(id, p, length - wrote);
+            size_t block = length - wrote;
+
+            if (room >= 0)
+                block = min(block, (size_t)room);
+
+            ssize_t ret = iodev_write(id, p, block);
 
             if (ret <= 0)
                 goto next_dev;
@@ -217,6 +319,8 @@ void iodev_console_write(const void *buf, size_t length)
             con_rp[id] += ret;
             wrote += ret;
             p += ret;
+            if (room >= 0 && !(room -= ret))
+                goto next_dev;
         }
 
     next_dev:;
@@ -226,16 +330,16 @@ void iodev_console_write(const void *buf, size_t length)
 
     if (length > CONSOLE_BUFFER_SIZE) {
         buf += (length - CONSOLE_BUFFER_SIZE);
-        con_wp += (length - CONSOLE_BUFFER_SIZE);
+        con_ring.wptr += (length - CONSOLE_BUFFER_SIZE);
         length = CONSOLE_BUFFER_SIZE;
     }
 
     while (length) {
-        size_t buf_wp = con_wp % CONSOLE_BUFFER_SIZE;
+        size_t buf_wp = con_ring.wptr % CONSOLE_BUFFER_SIZE;
         size_t block = min(length, CONSOLE_BUFFER_SIZE - buf_wp);
-        memcpy(&con_buf[buf_wp], buf, block);
+        memcpy(&con_ring.buf[buf_wp], buf, block);
         buf += block;
-        con_wp += block;
+        con_ring.wptr += block;
         length -= block;
     }
 
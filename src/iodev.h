@@ -8,10 +8,23 @@
 
 #define USB_IODEV_COUNT 8
 
+#define CONSOLE_BUFFER_SIZE 0x20000
+#define CONSOLE_RING_MAGIC  0x534e4f43 // 'CONS'
+
+struct console_ring {
+    u32 magic;
+    u32 size;
+    u64 wptr;
+    char buf[CONSOLE_BUFFER_SIZE];
+};
+
+extern struct console_ring con_ring;
+
 typedef enum _iodev_id_t {
     IODEV_UART,
     IODEV_FB,
     IODEV_USB_VUART,
+    IODEV_USB_EVENT,
     IODEV_USB0,
     IODEV_MAX = IODEV_USB0 + USB_IODEV_COUNT,
 } iodev_id_t;
@@ -21,12 +34,21 @@ typedef enum _iodev_usage_t {
     USAGE_UARTPROXY = BIT(1),
 } iodev_usage_t;
 
+struct iodev_iovec {
+    const void *base;
+    size_t len;
+};
+
 struct iodev_ops {
     ssize_t (*can_read)(void *opaque);
     bool (*can_write)(void *opaque);
     ssize_t (*read)(void *opaque, void *buf, size_t length);
     ssize_t (*write)(void *opaque, const void *buf, size_t length);
     ssize_t (*queue)(void *opaque, const void *buf, size_t length);
+    // Optional: queue multiple segments without copying into a staging buffer
+    ssize_t (*queue_sg)(void *opaque, const struct iodev_iovec *iov, int niov);
+    // Optional: bytes write/queue will accept without blocking
+    ssize_t (*write_room)(void *opaque);
     void (*flush)(void *opaque);
     void (*handle_events)(void *opaque);
 };
@@ -47,6 +69,8 @@ bool iodev_can_write(iodev_id_t id);
 ssize_t iodev_read(iodev_id_t id, void *buf, size_t length);
 ssize_t iodev_write(iodev_id_t id, const void *buf, size_t length);
 ssize_t iodev_queue(iodev_id_t id, const void *buf, size_t length);
+ssize_t iodev_queue_sg(iodev_id_t id, const struct iodev_iovec *iov, int niov);
+ssize_t iodev_write_room(iodev_id_t id); // -1: unknown, assume unlimited
 void iodev_flush(iodev_id_t id);
 void iodev_handle_events(iodev_id_t id);
 void iodev_lock(iodev_id_t id);
@@ -56,6 +80,15 @@ void iodev_console_write(const void *buf, size_t length);
 void iodev_console_kick(void);
 void iodev_console_flush(void);
 
+/*
+ * Bounded console mode: never block on a saturated device, only write what
+ * it can take right now. The backlog stays in the console ring and is
+ * flushed by later writes; bytes the ring overwrites before a device caught
+ * up are counted in con_overrun[].
+ */
+void iodev_console_bounded(bool enable);
+extern u64 con_overrun[IODEV_MAX];
+
 iodev_usage_t iodev_get_usage(iodev_id_t id);
 void iodev_set_usage(iodev_id_t id, iodev_usage_t usage);
 void *iodev_get_opaque(iodev_id_t id);
@@ -9,9 +9,11 @@
 #include "dapf.h"
 #include "devicetree.h"
 #include "display.h"
+#include "evtlog.h"
 #include "exception.h"
 #include "firmware.h"
 #include "isp.h"
+#include "log.h"
 #include "malloc.h"
 #include "mcc.h"
 #include "memory.h"
@@ -28,6 +30,8 @@
 
 #include "libfdt/libfdt.h"
 
+#define LOG_SUBSYS LOG_KBOOT
+
 #define MAX_CHOSEN_PARAMS 16
 
 #define MAX_ATC_DEVS 8
@@ -89,8 +93,8 @@ void get_notchless_fb(u64 *fb_base, u64 *fb_height)
 
     u64 offset = cur_boot_args.video.height - new_height;
 
-    printf("display: Hiding notch, %lux%lu -> %lux%lu (+%lu, 16:%lu)\n", cur_boot_args.video.width,
-           cur_boot_args.video.height, cur_boot_args.video.width, new_height, offset, hfrac);
+    log_info("display: Hiding notch, %lux%lu -> %lux%lu (+%lu, 16:%lu)\n",
+             cur_boot_args.video.width, cur_boot_args.video.height, cur_boot_args.video.width, new_height, offset, hfrac);
 
     *fb_base += cur_boot_args.video.stride * offset;
     *fb_height = new_height;
@@ -111,8 +115,8 @@ static int dt_set_rng_seed_sep(int node)
     if (fdt_setprop(dt, node, "rng-seed", rng_seed, sizeof(rng_seed)))
         bail("FDT: couldn't set rng-seed\n");
 
-    printf("FDT: Passing %ld bytes of KASLR seed and %ld bytes of random seed\n",
-           sizeof(kaslr_seed), sizeof(rng_seed));
+    log_debug("FDT: Passing %ld bytes of KASLR seed and %ld bytes of random seed\n",
+              sizeof(kaslr_seed), sizeof(rng_seed));
 
     return 0;
 }
@@ -129,7 +133,7 @@ static int dt_set_rng_seed_adt(int node)
 
     random_seed = adt_getprop(adt, anode, "random-seed", &seed_length);
     if (random_seed) {
-        printf("ADT: %d bytes of random seed available\n", seed_length);
+        log_debug("ADT: %d bytes of random seed available\n", seed_length);
 
         if (seed_length >= sizeof(u64)) {
             u64 kaslr_seed;
@@ -150,7 +154,7 @@ static int dt_set_rng_seed_adt(int node)
             if (fdt_setprop_u64(dt, node, "kaslr-seed", kaslr_seed))
                 bail("FDT: couldn't set kaslr-seed\n");
 
-            printf("FDT: KASLR seed initialized\n");
+            log_debug("FDT: KASLR seed initialized\n");
         } else {
             printf("ADT: not enough random data for kaslr-seed\n");
         }
@@ -159,7 +163,7 @@ static int dt_set_rng_seed_adt(int node)
             if (fdt_setprop(dt, node, "rng-seed", random_seed, seed_length))
                 bail("FDT: couldn't set rng-seed\n");
 
-            printf("FDT: Passing %d bytes of random seed\n", seed_length);
+            log_debug("FDT: Passing %d bytes of random seed\n", seed_length);
         }
     } else {
         printf("ADT: no random-seed available!\n");
@@ -183,7 +187,7 @@ static int dt_set_chosen(void)
         const char *value = chosen_params[i][1];
         if (fdt_setprop(dt, node, name, value, strlen(value) + 1) < 0)
             bail("FDT: couldn't set chosen.%s property\n", name);
-        printf("FDT: %s = '%s'\n", name, value);
+        log_debug("FDT: %s = '%s'\n", name, value);
     }
 
     if (initrd_start && initrd_size) {
@@ -197,7 +201,7 @@ static int dt_set_chosen(void)
         if (fdt_add_mem_rsv(dt, (u64)initrd_start, initrd_size))
             bail("FDT: couldn't add reservation for the initrd\n");
 
-        printf("FDT: initrd at %p size 0x%lx\n", initrd_start, initrd_size);
+        log_info("FDT: initrd at %p size 0x%lx\n", initrd_start, initrd_size);
     }
 
     if (cur_boot_args.video.base) {
@@ -241,7 +245,7 @@ static int dt_set_chosen(void)
                 format = "r5g6b5";
                 break;
             default:
-                printf("FDT: unsupported fb depth %lu, not enabling\n", cur_boot_args.video.depth);
+                log_warn("FDT: unsupported fb depth %lu, not enabling\n", cur_boot_args.video.depth);
                 return 0; // Do not error out, but don't set the FB
         }
 
@@ -250,7 +254,7 @@ static int dt_set_chosen(void)
 
         fdt_delprop(dt, fb, "status"); // may fail if it does not exist
 
-        printf("FDT: %s base 0x%lx size 0x%lx\n", fbname, fb_base, fb_size);
+        log_info("FDT: %s base 0x%lx size 0x%lx\n", fbname, fb_base, fb_size);
 
         // We do not need to reserve the framebuffer, as it will be excluded from the usable RAM
         // range already.
@@ -268,24 +272,16 @@ static int dt_set_chosen(void)
     if (node < 0)
         bail("FDT: /chosen node not found in devtree\n");
 
-    if (fdt_setprop(dt, node, "asahi,iboot1-version", system_firmware.iboot,
-                    strlen(system_firmware.iboot) + 1))
-        bail("FDT: couldn't set asahi,iboot1-version\n");
-
-    if (fdt_setprop(dt, node, "asahi,system-fw-version", system_firmware.string,
-                    strlen(system_firmware.string) + 1))
-        bail("FDT: couldn't set asahi,system-fw-version\n");
-
-    if (fdt_setprop(dt, node, "asahi,iboot2-version", os_firmware.iboot,
-                    strlen(os_firmware.iboot) + 1))
-        bail("FDT: couldn't set asahi,iboot2-version\n");
-
-    if (fdt_setprop(dt, node, "asahi,os-fw-version", os_firmware.string,
-                    strlen(os_firmware.string) + 1))
-        bail("FDT: couldn't set asahi,os-fw-version\n");
+    struct dt_builder builder;
 
-    if (fdt_setprop(dt, node, "asahi,m1n1-stage2-version", m1n1_version, strlen(m1n1_version) + 1))
-        bail("FDT: couldn't set asahi,m1n1-stage2-version\n");
+    dt_build_start(dt, node, &builder);
+    dt_build_prop_string(&builder, "asahi,iboot1-version", system_firmware.iboot);
+    dt_build_prop_string(&builder, "asahi,system-fw-version", system_firmware.string);
+    dt_build_prop_string(&builder, "asahi,iboot2-version", os_firmware.iboot);
+    dt_build_prop_string(&builder, "asahi,os-fw-version", os_firmware.string);
+    dt_build_prop_string(&builder, "asahi,m1n1-stage2-version", m1n1_version);
+    if (dt_build_commit(&builder))
+        bail("FDT: couldn't set asahi version properties\n");
 
     if (dt_set_rng_seed_sep(node))
         return dt_set_rng_seed_adt(node);
@@ -314,8 +310,9 @@ static int dt_set_memory(void)
     u64 dram_min = cur_boot_args.phys_base;
     u64 dram_max = cur_boot_args.phys_base + cur_boot_args.mem_size;
 
-    printf("FDT: DRAM at 0x%lx size 0x%lx\n", dram_base, dram_size);
-    printf("FDT: Usable memory is 0x%lx..0x%lx (0x%lx)\n", dram_min, dram_max, dram_max - dram_min);
+    log_info("FDT: DRAM at 0x%lx size 0x%lx\n", dram_base, dram_size);
+    log_info("FDT: Usable memory is 0x%lx..0x%lx (0x%lx)\n", dram_min, dram_max,
+             dram_max - dram_min);
 
     u64 memreg[2] = {cpu_to_fdt64(dram_min), cpu_to_fdt64(dram_max - dram_min)};
 
@@ -344,7 +341,7 @@ static int dt_set_serial_number(void)
     const char *serial_number = adt_getprop(adt, adt_root, "serial-number", &sn_len);
     if (fdt_setprop_string(dt, fdt_root, "serial-number", serial_number))
         bail("FDT: unable to set device serial number!\n");
-    printf("FDT: reporting device serial number: %s\n", serial_number);
+    log_info("FDT: reporting device serial number: %s\n", serial_number);
 
     return 0;
 }
@@ -382,7 +379,7 @@ static int dt_set_cpus(void)
             goto next_cpu;
 
         if (!smp_is_alive(cpu)) {
-            printf("FDT: CPU %d is not alive, disabling...\n", cpu);
+            log_info("FDT: CPU %d is not alive, disabling...\n", cpu);
             pruned_phandles[pruned++] = fdt_get_phandle(dt, node);
 
             int next = fdt_next_subnode(dt, node);
@@ -401,7 +398,7 @@ static int dt_set_cpus(void)
         if (fdt_setprop_inplace_u64(dt, node, "cpu-release-addr", release_addr))
             bail_cleanup("FDT: couldn't set cpu-release-addr property\n");
 
-        printf("FDT: CPU %d MPIDR=0x%lx release-addr=0x%lx\n", cpu, mpidr, release_addr);
+        log_debug("FDT: CPU %d MPIDR=0x%lx release-addr=0x%lx\n", cpu, mpidr, release_addr);
 
     next_cpu:
         cpu++;
@@ -457,8 +454,8 @@ static int dt_set_cpus(void)
                 bail_cleanup("FDT: Failed to set cpus property under AIC affinity\n");
 
             const char *name = fdt_get_name(dt, node, NULL);
-            printf("FDT: Pruned %ld/%ld CPU references in [AIC]/affinities/%s\n", count - index,
-                   count, name);
+            log_debug("FDT: Pruned %ld/%ld CPU references in [AIC]/affinities/%s\n", count - index,
+                      count, name);
         }
 
         if ((node < 0) && (node != -FDT_ERR_NOTFOUND))
@@ -506,7 +503,7 @@ static int dt_set_cpus(void)
             }
 
             if (prune) {
-                printf("FDT: Pruning /cpus/cpu-map/%s/%s\n", name, cpu_name);
+                log_debug("FDT: Pruning /cpus/cpu-map/%s/%s\n", name, cpu_name);
 
                 int next = fdt_next_subnode(dt, cpu_node);
                 fdt_nop_node(dt, cpu_node);
@@ -526,7 +523,7 @@ static int dt_set_cpus(void)
             bail_cleanup("FDT: Error iterating through CPU nodes\n");
 
         if (cpu_idx == 0) {
-            printf("FDT: Pruning /cpus/cpu-map/%s\n", name);
+            log_debug("FDT: Pruning /cpus/cpu-map/%s\n", name);
 
             int next = fdt_next_subnode(dt, cluster_node);
             fdt_nop_node(dt, cluster_node);
@@ -609,42 +606,109 @@ static int dt_set_mac_addresses(void)
     return 0;
 }
 
-static int dt_set_bluetooth_cal(int anode, int node, const char *adt_name, const char *fdt_name)
-{
-    u32 len;
-    const u8 *cal_blob = adt_getprop(adt, anode, adt_name, &len);
+/*
+ * Declarative rules for the mechanical ADT-to-FDT property translations
+ * (calibration blobs and the like). The table is sorted by source node so one
+ * pass resolves each ADT node and each FDT alias exactly once, instead of
+ * every translation re-walking both trees from the root. Transforms that need
+ * real logic (memory map, CPUs, display) stay as dedicated dt_set_* functions.
+ */
+enum a2f_op {
+    A2F_COPY,   // copy the property verbatim
+    A2F_STRING, // copy a slice of the property as a string
+};
 
-    if (!cal_blob || !len)
-        bail("ADT: Failed to get %s\n", adt_name);
+struct a2f_rule {
+    const char *adt_path;
+    const char *adt_prop;
+    const char *fdt_alias;
+    const char *fdt_prop;
+    enum a2f_op op;
+    u16 offset, len; // for A2F_STRING: slice of the source blob
+};
 
-    fdt_setprop(dt, node, fdt_name, cal_blob, len);
-    return 0;
-}
+static const struct a2f_rule a2f_rules[] = {
+    {
+        .adt_path = "/arm-io/bluetooth",
+        .adt_prop = "bluetooth-taurus-calibration-bf",
+        .fdt_alias = "bluetooth0",
+        .fdt_prop = "brcm,taurus-bf-cal-blob",
+        .op = A2F_COPY,
+    },
+    {
+        .adt_path = "/arm-io/bluetooth",
+        .adt_prop = "bluetooth-taurus-calibration",
+        .fdt_alias = "bluetooth0",
+        .fdt_prop = "brcm,taurus-cal-blob",
+        .op = A2F_COPY,
+    },
+    {
+        .adt_path = "/arm-io/wlan",
+        .adt_prop = "wifi-antenna-sku-info",
+        .fdt_alias = "wifi0",
+        .fdt_prop = "apple,antenna-sku",
+        .op = A2F_STRING,
+        .offset = 8,
+        .len = 8,
+    },
+    {
+        .adt_path = "/arm-io/wlan",
+        .adt_prop = "wifi-calibration-msf",
+        .fdt_alias = "wifi0",
+        .fdt_prop = "brcm,cal-blob",
+        .op = A2F_COPY,
+    },
+};
 
-static int dt_set_bluetooth(void)
+static int dt_apply_adt_rules(void)
 {
-    int ret;
-    int anode = adt_path_offset(adt, "/arm-io/bluetooth");
-
-    if (anode < 0)
-        bail("ADT: /arm-io/bluetooth not found\n");
+    const char *cur_adt_path = NULL;
+    const char *cur_fdt_alias = NULL;
+    int anode = -1;
+    int node = -1;
+
+    for (size_t i = 0; i < ARRAY_SIZE(a2f_rules); i++) {
+        const struct a2f_rule *rule = &a2f_rules[i];
+
+        if (cur_adt_path != rule->adt_path) {
+            cur_adt_path = rule->adt_path;
+            anode = adt_path_offset(adt, rule->adt_path);
+            if (anode < 0)
+                bail("ADT: %s not found\n", rule->adt_path);
+        }
 
-    const char *path = fdt_get_alias(dt, "bluetooth0");
-    if (path == NULL)
-        return 0;
+        if (cur_fdt_alias != rule->fdt_alias) {
+            cur_fdt_alias = rule->fdt_alias;
+            node = -1;
+            const char *path = fdt_get_alias(dt, rule->fdt_alias);
+            if (path != NULL)
+                node = fdt_path_offset(dt, path);
+        }
 
-    int node = fdt_path_offset(dt, path);
-    if (node < 0)
-        return 0;
+        // No alias in this FDT means the device is absent; skip its rules
+        if (node < 0)
+            continue;
 
-    ret = dt_set_bluetooth_cal(anode, node, "bluetooth-taurus-calibration-bf",
-                               "brcm,taurus-bf-cal-blob");
-    if (ret)
-        return ret;
+        u32 len;
+        const u8 *blob = adt_getprop(adt, anode, rule->adt_prop, &len);
+        if (!blob || !len)
+            bail("ADT: Failed to get %s\n", rule->adt_prop);
 
-    ret = dt_set_bluetooth_cal(anode, node, "bluetooth-taurus-calibration", "brcm,taurus-cal-blob");
-    if (ret)
-        return ret;
+        switch (rule->op) {
+            case A2F_COPY:
+                fdt_setprop(dt, node, rule->fdt_prop, blob, len);
+                break;
+            case A2F_STRING: {
+                char buf[64];
+                if (len < (u32)rule->offset + rule->len || rule->len >= sizeof(buf))
+                    bail("ADT: %s too short for %s\n", rule->adt_prop, rule->fdt_prop);
+                memcpy(buf, blob + rule->offset, rule->len);
+                buf[rule->len] = 0;
+                fdt_setprop_string(dt, node, rule->fdt_prop, buf);
+                break;
+            }
+        }
+    }
 
     return 0;
 }
@@ -782,40 +846,6 @@ static int dt_set_nvram(void)
     return 0;
 }
 
-static int dt_set_wifi(void)
-{
-    int anode = adt_path_offset(adt, "/arm-io/wlan");
-
-    if (anode < 0)
-        bail("ADT: /arm-io/wlan not found\n");
-
-    uint8_t info[16];
-    if (ADT_GETPROP_ARRAY(adt, anode, "wifi-antenna-sku-info", info) < 0)
-        bail("ADT: Failed to get wifi-antenna-sku-info\n");
-
-    const char *path = fdt_get_alias(dt, "wifi0");
-    if (path == NULL)
-        return 0;
-
-    int node = fdt_path_offset(dt, path);
-    if (node < 0)
-        return 0;
-
-    char antenna[8];
-    memcpy(antenna, &info[8], sizeof(antenna));
-    fdt_setprop_string(dt, node, "apple,antenna-sku", antenna);
-
-    u32 len;
-    const u8 *cal_blob = adt_getprop(adt, anode, "wifi-calibration-msf", &len);
-
-    if (!cal_blob || !len)
-        bail("ADT: Failed to get wifi-calibration-msf\n");
-
-    fdt_setprop(dt, node, "brcm,cal-blob", cal_blob, len);
-
-    return 0;
-}
-
 static void dt_set_uboot_dm_preloc(int node)
 {
     // Tell U-Boot to bind this node early
@@ -1800,7 +1830,7 @@ static int dt_set_display(void)
         if (ret)
             return ret;
 
-        if (os_firmware.version >= V13_5) {
+        if (fw_caps & FW_CAP_DCPEXT) {
             for (int n = 0; n < MAX_DCPEXT && ret == 0; n++) {
                 char dcpext_alias[16];
 
@@ -1862,7 +1892,7 @@ static int dt_set_sio_fwdata(const char *adt_path, const char *fdt_alias)
             bail("FDT: couldn't set '%s.phandle' property: %d\n", fdt_alias, ret);
     }
 
-    struct sio_data *siodata = sio_setup_fwdata(adt_path);
+    struct sio_data *siodata = sio_get_fwdata(adt_path);
     if (!siodata)
         bail("FDT: failed to set up SIO(%s) firmware data\n", adt_path);
 
@@ -1903,7 +1933,7 @@ static int dt_set_sio_fwdata(const char *adt_path, const char *fdt_alias)
     }
 
 err:
-    free(siodata);
+    // siodata is a cached handle owned by sio.c, do not free it
     return 0;
 }
 
@@ -2262,8 +2292,74 @@ int kboot_set_chosen(const char *name, const char *value)
     return i;
 }
 
+/*
+ * Lightweight self-profiling of DT preparation: each phase records its
+ * elapsed time, how many ADT lookups it performed and how much structure and
+ * string data it added to the FDT, so a regression in any one phase shows up
+ * in the boot log without external tooling.
+ */
+struct dt_phase_stat {
+    const char *name;
+    u64 ticks;
+    u64 lookups;
+    s64 growth;
+};
+
+#define DT_MAX_PHASES 24
+
+static struct dt_phase_stat dt_phase_stats[DT_MAX_PHASES];
+static int dt_n_phases;
+
+static void dt_phase_record(const char *name, u64 ticks, u64 lookups, s64 growth)
+{
+    if (dt_n_phases >= DT_MAX_PHASES)
+        return;
+
+    dt_phase_stats[dt_n_phases++] = (struct dt_phase_stat){name, ticks, lookups, growth};
+}
+
+static void dt_print_profile(void)
+{
+    const struct dt_phase_stat *worst = NULL;
+    u64 ticks = 0, lookups = 0;
+    s64 growth = 0;
+
+    for (int i = 0; i < dt_n_phases; i++) {
+        const struct dt_phase_stat *st = &dt_phase_stats[i];
+
+        ticks += st->ticks;
+        lookups += st->lookups;
+        growth += st->growth;
+        if (!worst || st->ticks > worst->ticks)
+            worst = st;
+    }
+
+    if (!worst)
+        return;
+
+    printf("FDT: prep took %ld us over %d phases (%ld ADT lookups, %ld bytes added), "
+           "slowest %s (%ld us, %ld lookups, %ld bytes)\n",
+           ticks_to_usecs(ticks), dt_n_phases, lookups, growth, worst->name,
+           ticks_to_usecs(worst->ticks), worst->lookups, worst->growth);
+}
+
+#define DT_PHASE(expr, bad)                                                                        \
+    do {                                                                                           \
+        u64 _t0 = mrs(CNTPCT_EL0);                                                                 \
+        u64 _l0 = adt_lookup_count;                                                                \
+        s64 _s0 = fdt_size_dt_struct(dt) + fdt_size_dt_strings(dt);                                \
+        if (expr)                                                                                  \
+            return bad;                                                                            \
+        dt_phase_record(#expr, mrs(CNTPCT_EL0) - _t0, adt_lookup_count - _l0,                      \
+                        (s64)(fdt_size_dt_struct(dt) + fdt_size_dt_strings(dt)) - _s0);            \
+    } while (0)
+
 int kboot_prepare_dt(void *fdt)
 {
+    EVT(KBOOT_DT_START, 0);
+
+    dt_n_phases = 0;
+
     if (dt) {
         free(dt);
         dt = NULL;
@@ -2275,7 +2371,15 @@ int kboot_prepare_dt(void *fdt)
     dt_bufsize = fdt_totalsize(fdt);
     assert(dt_bufsize);
 
-    dt_bufsize += 64 * 1024; // Add 64K of buffer for modifications
+    /*
+     * Everything we insert below ultimately comes out of the ADT (tunables,
+     * firmware data, per-CPU properties), so its size bounds our additions.
+     * Size the buffer accordingly instead of using a fixed slack, which
+     * overflows on machines with large tunable sets. The slack is free:
+     * libfdt only memmoves up to the used data size on insertions, and the
+     * reservation is tightened to the packed size below.
+     */
+    dt_bufsize += max(64 * 1024, (int)cur_boot_args.devtree_size / 2);
     dt = memalign(DT_ALIGN, dt_bufsize);
 
     if (fdt_open_into(fdt, dt, dt_bufsize) < 0)
@@ -2287,47 +2391,27 @@ int kboot_prepare_dt(void *fdt)
     if (fdt_add_mem_rsv(dt, (u64)_base, ((u64)_end) - ((u64)_base)))
         bail("FDT: couldn't add reservation for m1n1\n");
 
-    if (dt_set_chosen())
-        return -1;
-    if (dt_set_serial_number())
-        return -1;
-    if (dt_set_cpus())
-        return -1;
-    if (dt_set_mac_addresses())
-        return -1;
-    if (dt_set_wifi())
-        return -1;
-    if (dt_set_bluetooth())
-        return -1;
-    if (dt_set_uboot())
-        return -1;
-    if (dt_set_atc_tunables())
-        return -1;
-    if (dt_set_acio_tunables())
-        return -1;
-    if (dt_set_display())
-        return -1;
-    if (dt_set_gpu(dt))
-        return -1;
-    if (dt_set_multitouch())
-        return -1;
-    if (dt_set_nvram())
-        return -1;
-    if (dt_set_ipd())
-        return -1;
-    if (dt_disable_missing_devs("usb-drd", "usb@", 8))
-        return -1;
-    if (dt_disable_missing_devs("i2c", "i2c@", 8))
-        return -1;
-    if (dt_setup_sio())
-        return -1;
-    if (dt_reserve_asc_firmware("/arm-io/isp", "/arm-io/isp0", "isp", false, isp_iova_base()))
-        return -1;
-    if (dt_set_isp_fwdata())
-        return -1;
+    DT_PHASE(dt_set_chosen(), -1);
+    DT_PHASE(dt_set_serial_number(), -1);
+    DT_PHASE(dt_set_cpus(), -1);
+    DT_PHASE(dt_set_mac_addresses(), -1);
+    DT_PHASE(dt_apply_adt_rules(), -1);
+    DT_PHASE(dt_set_uboot(), -1);
+    DT_PHASE(dt_set_atc_tunables(), -1);
+    DT_PHASE(dt_set_acio_tunables(), -1);
+    DT_PHASE(dt_set_display(), -1);
+    DT_PHASE(dt_set_gpu(dt), -1);
+    DT_PHASE(dt_set_multitouch(), -1);
+    DT_PHASE(dt_set_nvram(), -1);
+    DT_PHASE(dt_set_ipd(), -1);
+    DT_PHASE(dt_disable_missing_devs("usb-drd", "usb@", 8), -1);
+    DT_PHASE(dt_disable_missing_devs("i2c", "i2c@", 8), -1);
+    DT_PHASE(dt_setup_sio(), -1);
+    DT_PHASE(dt_reserve_asc_firmware("/arm-io/isp", "/arm-io/isp0", "isp", false, isp_iova_base()),
+             -1);
+    DT_PHASE(dt_set_isp_fwdata(), -1);
 #ifndef RELEASE
-    if (dt_transfer_virtios())
-        return 1;
+    DT_PHASE(dt_transfer_virtios(), 1);
 #endif
 
     /*
@@ -2335,19 +2419,40 @@ int kboot_prepare_dt(void *fdt)
      * in one of the above devicetree prep functions, and we want an up-to-date value
      * for the usable memory span to make it into the devicetree.
      */
-    if (dt_set_memory())
-        return -1;
+    DT_PHASE(dt_set_memory(), -1);
 
     if (fdt_pack(dt))
         bail("FDT: fdt_pack() failed\n");
 
+    /*
+     * The devtree reservation was made for the whole working buffer; shrink
+     * it to the packed size so the slack is not permanently lost to the OS.
+     */
+    int nrsv = fdt_num_mem_rsv(dt);
+    for (int i = 0; i < nrsv; i++) {
+        u64 addr, size;
+
+        if (fdt_get_mem_rsv(dt, i, &addr, &size))
+            continue;
+        if (addr != (u64)dt || size != (u64)dt_bufsize)
+            continue;
+        if (!fdt_del_mem_rsv(dt, i) && fdt_add_mem_rsv(dt, (u64)dt, fdt_totalsize(dt)))
+            bail("FDT: couldn't re-add reservation for the devtree\n");
+        break;
+    }
+
+    dt_print_profile();
+
     printf("FDT prepared at %p\n", dt);
+    EVT(KBOOT_DT_DONE, 0);
 
     return 0;
 }
 
 int kboot_boot(void *kernel)
 {
+    EVT(KBOOT_BOOT, 0);
+
     mcc_enable_cache();
     tunables_apply_static();
     clk_init();
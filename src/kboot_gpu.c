@@ -373,6 +373,22 @@ static int calc_power_t600x(u32 count, u32 table_count, const struct perf_state
     return 0;
 }
 
+/*
+ * The power tables depend on per-device fuses and core binning, so they cannot
+ * be precomputed per chip id, but none of the inputs change while m1n1 is
+ * running. Memoize the results so repeated chainloads in one proxy session
+ * skip the floating point curve evaluation (and the sgx power-up it needs).
+ */
+static struct {
+    bool valid;
+    u32 count, table_count;
+    u32 max_pwr[MAX_PSTATES];
+    float core_leak[MAX_CLUSTERS];
+    float sram_leak[MAX_CLUSTERS];
+    float cs_leak[MAX_DIES];
+    float afr_leak[MAX_DIES];
+} power_cache;
+
 static int dt_set_region(void *dt, int sgx, const char *name, const char *path)
 {
     u64 base, size;
@@ -554,15 +570,24 @@ int dt_set_gpu(void *dt)
     if (has_cs_afr && !perf_states_afr)
         bail("ADT: GPU: afr-perf-states not found\n");
 
-    u32 max_pwr[MAX_PSTATES];
-    float core_leak[MAX_CLUSTERS];
-    float sram_leak[MAX_CLUSTERS];
-    float cs_leak[MAX_DIES];
-    float afr_leak[MAX_DIES];
+    u32 *max_pwr = power_cache.max_pwr;
+    float *core_leak = power_cache.core_leak;
+    float *sram_leak = power_cache.sram_leak;
+    float *cs_leak = power_cache.cs_leak;
+    float *afr_leak = power_cache.afr_leak;
+
+    if (power_cache.valid && power_cache.count == perf_state_count &&
+        power_cache.table_count == perf_state_table_count) {
+        printf("FDT: GPU: Using cached power tables\n");
+    } else {
+        if (calc_power(perf_state_count, perf_state_table_count, perf_states, perf_states_sram,
+                       perf_states_cs, max_pwr, core_leak, sram_leak, cs_leak, afr_leak))
+            return -1;
 
-    if (calc_power(perf_state_count, perf_state_table_count, perf_states, perf_states_sram,
-                   perf_states_cs, max_pwr, core_leak, sram_leak, cs_leak, afr_leak))
-        return -1;
+        power_cache.count = perf_state_count;
+        power_cache.table_count = perf_state_table_count;
+        power_cache.valid = true;
+    }
 
     printf("FDT: GPU: Max power table: ");
     for (u32 i = 0; i < perf_state_count; i++) {
@@ -0,0 +1,212 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "kcache.h"
+#include "nvme.h"
+#include "string.h"
+#include "utils.h"
+
+#define KCACHE_MAGIC      0x3163616b316e316dULL // "m1n1kac1"
+#define KCACHE_SLOTS      8
+#define KCACHE_BLOCK_SIZE 4096
+
+struct kcache_slot {
+    u64 hash;
+    u64 size; // bytes, 0 = free
+    u64 stamp;
+};
+
+/*
+ * One block at base_lba holds the superblock; the rest of the extent is split
+ * into KCACHE_SLOTS equal data regions, so slot locations are implicit and
+ * eviction never has to move data.
+ */
+struct kcache_sb {
+    u64 magic;
+    u64 base;
+    u64 blocks;
+    u64 stamp;
+    struct kcache_slot slots[KCACHE_SLOTS];
+};
+
+static union {
+    struct kcache_sb sb;
+    u8 block[KCACHE_BLOCK_SIZE];
+} kcache ALIGNED(SZ_4K);
+
+static bool kcache_active = false;
+static u32 kcache_nsid;
+static u64 kcache_slot_blocks;
+
+static u64 kcache_slot_lba(int slot)
+{
+    return kcache.sb.base + 1 + slot * kcache_slot_blocks;
+}
+
+static bool kcache_write_sb(void)
+{
+    return nvme_write_blocks(kcache_nsid, kcache.sb.base, 1, &kcache);
+}
+
+int kcache_init(u32 nsid, u64 base_lba, u64 num_blocks)
+{
+    kcache_active = false;
+
+    if (num_blocks < 1 + KCACHE_SLOTS) {
+        printf("kcache: extent too small (%ld blocks)\n", num_blocks);
+        return -1;
+    }
+
+    if (!nvme_read_blocks(nsid, base_lba, 1, &kcache)) {
+        printf("kcache: superblock read failed\n");
+        return -1;
+    }
+
+    kcache_nsid = nsid;
+    kcache_slot_blocks = (num_blocks - 1) / KCACHE_SLOTS;
+
+    if (kcache.sb.magic != KCACHE_MAGIC || kcache.sb.base != base_lba ||
+        kcache.sb.blocks != num_blocks) {
+        printf("kcache: formatting cache @ lba 0x%lx (%ld blocks, %ld/slot)\n", base_lba,
+               num_blocks, kcache_slot_blocks);
+        memset(&kcache, 0, sizeof(kcache));
+        kcache.sb.magic = KCACHE_MAGIC;
+        kcache.sb.base = base_lba;
+        kcache.sb.blocks = num_blocks;
+        if (!kcache_write_sb()) {
+            printf("kcache: superblock write failed\n");
+            return -1;
+        }
+    }
+
+    kcache_active = true;
+    return 0;
+}
+
+static int kcache_find(u64 hash)
+{
+    for (int i = 0; i < KCACHE_SLOTS; i++)
+        if (kcache.sb.slots[i].size && kcache.sb.slots[i].hash == hash)
+            return i;
+
+    return -1;
+}
+
+s64 kcache_load(u64 hash, void *buffer)
+{
+    if (!kcache_active)
+        return -1;
+
+    int slot = kcache_find(hash);
+    if (slot < 0)
+        return -1;
+
+    u64 size = kcache.sb.slots[slot].size;
+    u32 blocks = ALIGN_UP(size, KCACHE_BLOCK_SIZE) / KCACHE_BLOCK_SIZE;
+
+    if (!nvme_read_blocks(kcache_nsid, kcache_slot_lba(slot), blocks, buffer)) {
+        printf("kcache: read of slot %d failed\n", slot);
+        return -1;
+    }
+
+    /* LRU bookkeeping only; not worth failing the load over */
+    kcache.sb.slots[slot].stamp = ++kcache.sb.stamp;
+    kcache_write_sb();
+
+    return size;
+}
+
+/*
+ * Asynchronous load: kcache_load_begin() queues the whole read and returns
+ * immediately, so the host can run other boot preparation proxy calls (e.g.
+ * kboot_prepare_dt()) while the NVMe DMA streams, then reap the transfer with
+ * kcache_load_poll(). Boot handoff then costs max(IO, CPU) instead of the sum.
+ */
+static int kcache_load_slot = -1;
+
+s64 kcache_load_begin(u64 hash, void *buffer)
+{
+    if (!kcache_active || kcache_load_slot >= 0)
+        return -1;
+
+    int slot = kcache_find(hash);
+    if (slot < 0)
+        return -1;
+
+    u64 size = kcache.sb.slots[slot].size;
+    u32 blocks = ALIGN_UP(size, KCACHE_BLOCK_SIZE) / KCACHE_BLOCK_SIZE;
+
+    if (nvme_read_blocks_start(kcache_nsid, kcache_slot_lba(slot), blocks, buffer) < 0) {
+        printf("kcache: async read of slot %d failed to start\n", slot);
+        return -1;
+    }
+
+    kcache_load_slot = slot;
+    return size;
+}
+
+int kcache_load_poll(void)
+{
+    if (kcache_load_slot < 0)
+        return -1;
+
+    int ret = nvme_read_blocks_poll();
+    if (!ret)
+        return 0;
+
+    int slot = kcache_load_slot;
+    kcache_load_slot = -1;
+
+    if (ret < 0) {
+        printf("kcache: async read of slot %d failed\n", slot);
+        return -1;
+    }
+
+    /* LRU bookkeeping only; not worth failing the load over */
+    kcache.sb.slots[slot].stamp = ++kcache.sb.stamp;
+    kcache_write_sb();
+
+    return 1;
+}
+
+int kcache_store(u64 hash, void *buffer, u64 size)
+{
+    if (!kcache_active)
+        return -1;
+
+    if (!size || size > kcache_slot_blocks * KCACHE_BLOCK_SIZE) {
+        printf("kcache: image size 0x%lx does not fit a slot\n", size);
+        return -1;
+    }
+
+    /* Overwrite a matching entry, else a free slot, else the oldest */
+    int slot = kcache_find(hash);
+    if (slot < 0) {
+        slot = 0;
+        for (int i = 0; i < KCACHE_SLOTS; i++) {
+            if (!kcache.sb.slots[i].size) {
+                slot = i;
+                break;
+            }
+            if (kcache.sb.slots[i].stamp < kcache.sb.slots[slot].stamp)
+                slot = i;
+        }
+    }
+
+    u32 blocks = ALIGN_UP(size, KCACHE_BLOCK_SIZE) / KCACHE_BLOCK_SIZE;
+
+    if (!nvme_write_blocks(kcache_nsid, kcache_slot_lba(slot), blocks, buffer)) {
+        printf("kcache: write of slot %d failed\n", slot);
+        return -1;
+    }
+
+    kcache.sb.slots[slot].hash = hash;
+    kcache.sb.slots[slot].size = size;
+    kcache.sb.slots[slot].stamp = ++kcache.sb.stamp;
+
+    if (!kcache_write_sb()) {
+        printf("kcache: superblock write failed\n");
+        return -1;
+    }
+
+    return nvme_flush(kcache_nsid) ? 0 : -1;
+}
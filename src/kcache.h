@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef KCACHE_H
+#define KCACHE_H
+
+#include "types.h"
+
+/*
+ * On-flash payload cache for the development boot loop. The host locates a
+ * scratch partition (GPT parsing stays on the host side), hands us its extent
+ * once via kcache_init(), and can then stash uploaded kernel images keyed by
+ * a host-computed 64-bit content hash and re-load them at NVMe speed instead
+ * of pushing the same image over the proxy link every iteration.
+ *
+ * Transfers are rounded up to whole 4096-byte NVMe blocks, so buffers must be
+ * 4K-aligned and sized with up to one block of slack.
+ */
+
+int kcache_init(u32 nsid, u64 base_lba, u64 num_blocks);
+s64 kcache_load(u64 hash, void *buffer);
+int kcache_store(u64 hash, void *buffer, u64 size);
+
+/*
+ * Asynchronous variant of kcache_load(): begin returns the image size with
+ * the NVMe reads left streaming, poll returns 1 when the buffer is complete
+ * (0 = pending, -1 = error), so other proxy work can overlap the transfer.
+ */
+s64 kcache_load_begin(u64 hash, void *buffer);
+int kcache_load_poll(void);
+
+#endif
@@ -0,0 +1,96 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "log.h"
+#include "string.h"
+
+u8 log_levels[LOG_NUM_SUBSYS] = {
+    [0 ... LOG_NUM_SUBSYS - 1] = LOG_INFO,
+};
+
+int log_set_level(int subsys, int level)
+{
+    if (subsys < 0 || subsys >= LOG_NUM_SUBSYS)
+        return -1;
+    if (level < LOG_ERR || level > LOG_DEBUG)
+        return -1;
+
+    log_levels[subsys] = level;
+    return 0;
+}
+
+static struct log_bin_ring *log_bin_ring;
+static DECLARE_SPINLOCK(log_bin_lock);
+
+int log_bin_init(void *buf, u32 num)
+{
+    if (buf && (num < 2 || (num & (num - 1))))
+        return -1;
+
+    spin_lock(&log_bin_lock);
+    if (buf) {
+        struct log_bin_ring *ring = buf;
+
+        ring->wptr = 0;
+        ring->rptr = 0;
+        ring->num = num;
+        ring->drops = 0;
+        sysop("dmb ish");
+        log_bin_ring = ring;
+    } else {
+        log_bin_ring = NULL;
+    }
+    spin_unlock(&log_bin_lock);
+
+    return 0;
+}
+
+bool log_bin_vprintf(const char *fmt, va_list args)
+{
+    struct log_bin_entry ent = {.fmt = (u64)fmt};
+    int nargs = 0;
+
+    if (!log_bin_ring)
+        return false;
+
+    for (const char *p = fmt; *p; p++) {
+        if (*p != '%')
+            continue;
+        if (*++p == '%')
+            continue;
+
+        /* one vararg per conversion, plus one per '*' width/precision */
+        int extra = 0;
+        while (*p && !strchr("diouxXcsp", *p)) {
+            if (*p == '*')
+                extra++;
+            p++;
+        }
+        if (!*p)
+            break;
+
+        for (int i = 0; i <= extra; i++) {
+            if (nargs == LOG_BIN_ARGS)
+                return false;
+            ent.args[nargs++] = va_arg(args, u64);
+        }
+    }
+
+    bool pushed = false;
+
+    spin_lock(&log_bin_lock);
+    struct log_bin_ring *ring = log_bin_ring;
+    if (ring) {
+        if (ring->wptr - ring->rptr < ring->num) {
+            ring->ent[ring->wptr & (ring->num - 1)] = ent;
+            // Make sure the entry is visible before publishing the new wptr
+            sysop("dmb ish");
+            ring->wptr++;
+        } else {
+            ring->drops++;
+        }
+        pushed = true;
+    }
+    spin_unlock(&log_bin_lock);
+
+    return pushed;
+}
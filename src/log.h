@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdarg.h>
+
+#include "types.h"
+#include "utils.h"
+
+/*
+ * Leveled logging with per-subsystem runtime levels and a compile-time floor.
+ *
+ * Messages at or below the subsystem's runtime level are printed; the check
+ * happens before any argument is evaluated, so a disabled message costs a
+ * load and a compare rather than a vsprintf. Messages above LOG_LEVEL_FLOOR
+ * are compiled out entirely, arguments included.
+ */
+
+enum log_level {
+    LOG_ERR = 0,
+    LOG_WARN,
+    LOG_INFO,
+    LOG_DEBUG,
+};
+
+enum log_subsys {
+    LOG_DART = 0,
+    LOG_RTKIT,
+    LOG_KBOOT,
+    LOG_NUM_SUBSYS,
+};
+
+/* Messages above this level do not exist in the binary */
+#ifndef LOG_LEVEL_FLOOR
+#ifdef DEBUG
+#define LOG_LEVEL_FLOOR LOG_DEBUG
+#else
+#define LOG_LEVEL_FLOOR LOG_INFO
+#endif
+#endif
+
+extern u8 log_levels[LOG_NUM_SUBSYS];
+
+int log_set_level(int subsys, int level);
+
+/*
+ * Optional binary console mode. While a ring is armed, debug_printf() stops
+ * formatting on-device: each message is pushed as its format string pointer
+ * plus raw arguments, and the host renders it, fetching (and caching) the
+ * format strings by address. This cuts both the vsprintf cost and the console
+ * bandwidth severalfold for trace-heavy hypervisor sessions.
+ *
+ * At most LOG_BIN_ARGS conversions fit in one record; longer messages fall
+ * back to text. %s arguments are logged as pointers, which renders correctly
+ * for the static names m1n1 prints but may go stale for transient buffers.
+ */
+
+#define LOG_BIN_ARGS 7
+
+struct log_bin_entry {
+    u64 fmt;
+    u64 args[LOG_BIN_ARGS];
+};
+
+struct log_bin_ring {
+    u32 wptr;
+    u32 rptr;
+    u32 num;
+    u32 drops;
+    struct log_bin_entry ent[];
+};
+
+int log_bin_init(void *buf, u32 num);
+bool log_bin_vprintf(const char *fmt, va_list args);
+
+#define log_printf(subsys, level, ...)                                                             \
+    do {                                                                                           \
+        if ((level) <= LOG_LEVEL_FLOOR && (level) <= log_levels[subsys])                           \
+            debug_printf(__VA_ARGS__);                                                             \
+    } while (0)
+
+/* Convenience wrappers; the including file defines LOG_SUBSYS */
+#define log_err(...)   log_printf(LOG_SUBSYS, LOG_ERR, __VA_ARGS__)
+#define log_warn(...)  log_printf(LOG_SUBSYS, LOG_WARN, __VA_ARGS__)
+#define log_info(...)  log_printf(LOG_SUBSYS, LOG_INFO, __VA_ARGS__)
+#define log_debug(...) log_printf(LOG_SUBSYS, LOG_DEBUG, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "lz4.h"
+#include "string.h"
+
+static u32 lz4_read32(const u8 *p)
+{
+    return p[0] | (p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+static u32 lz4_hash(u32 v)
+{
+    return (v * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+static u8 *lz4_emit_length(u8 *op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+size_t lz4_compress(const u8 *src, size_t src_len, u8 *dst, size_t dst_max, u32 *ht)
+{
+    const u8 *ip = src;
+    const u8 *end = src + src_len;
+    const u8 *anchor = src;
+    /* Per the block format spec: matches must not start within the last 12
+     * bytes, and must end at least 5 bytes before the end of the block. */
+    const u8 *mflimit = src_len > 12 ? end - 12 : src;
+    const u8 *matchlimit = end - 5;
+    u8 *op = dst;
+    u8 *oend = dst + dst_max;
+
+    memset(ht, 0, LZ4_HASH_SIZE * sizeof(u32));
+
+    while (ip < mflimit) {
+        u32 seq = lz4_read32(ip);
+        u32 h = lz4_hash(seq);
+        u32 cand = ht[h];
+        u32 pos = ip - src + 1;
+
+        ht[h] = pos;
+
+        if (!cand || pos - cand > 0xffff || lz4_read32(src + cand - 1) != seq) {
+            ip++;
+            continue;
+        }
+
+        const u8 *match = src + cand - 1;
+        const u8 *mip = ip + 4;
+        const u8 *mref = match + 4;
+
+        while (mip < matchlimit && *mip == *mref) {
+            mip++;
+            mref++;
+        }
+
+        size_t mlen = mip - ip - 4; /* encoded match length (actual - 4) */
+        size_t lit = ip - anchor;
+
+        if (op + 1 + lit + lit / 255 + 1 + 2 + mlen / 255 + 1 > oend)
+            return 0;
+
+        u8 *token = op++;
+
+        if (lit >= 15) {
+            *token = 15 << 4;
+            op = lz4_emit_length(op, lit - 15);
+        } else {
+            *token = lit << 4;
+        }
+
+        for (size_t i = 0; i < lit; i++)
+            *op++ = anchor[i];
+
+        size_t off = ip - match;
+        *op++ = off & 0xff;
+        *op++ = off >> 8;
+
+        if (mlen >= 15) {
+            *token |= 15;
+            op = lz4_emit_length(op, mlen - 15);
+        } else {
+            *token |= mlen;
+        }
+
+        ip = mip;
+        anchor = ip;
+    }
+
+    /* Trailing literals */
+    size_t lit = end - anchor;
+
+    if (op + 1 + lit + lit / 255 + 1 > oend)
+        return 0;
+
+    u8 *token = op++;
+
+    if (lit >= 15) {
+        *token = 15 << 4;
+        op = lz4_emit_length(op, lit - 15);
+    } else {
+        *token = lit << 4;
+    }
+
+    for (size_t i = 0; i < lit; i++)
+        *op++ = anchor[i];
+
+    return op - dst;
+}
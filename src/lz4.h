@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef LZ4_H
+#define LZ4_H
+
+#include "types.h"
+
+/*
+ * Minimal LZ4 block compressor (greedy match search, 64KB window). Decoding is
+ * left to the host; any stock LZ4 block decoder can consume the output.
+ */
+
+#define LZ4_HASH_BITS 12
+#define LZ4_HASH_SIZE (1 << LZ4_HASH_BITS)
+
+/* Worst-case compressed size for an incompressible input */
+#define LZ4_WORST_SIZE(n) ((n) + (n) / 255 + 16)
+
+/*
+ * Compress src into dst. ht is a caller-provided LZ4_HASH_SIZE u32 scratch
+ * table, so concurrent callers can use disjoint tables. Uses only byte
+ * accesses, so it is safe on uncached memory with strict alignment.
+ * Returns the compressed size, or 0 if dst_max would be exceeded.
+ */
+size_t lz4_compress(const u8 *src, size_t src_len, u8 *dst, size_t dst_max, u32 *ht);
+
+#endif
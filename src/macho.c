@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "macho.h"
+#include "memory.h"
+#include "string.h"
+#include "utils.h"
+
+#define MH_MAGIC_64   0xfeedfacf
+#define LC_UNIXTHREAD 0x05
+#define LC_SEGMENT_64 0x19
+
+struct mach_header_64 {
+    u32 magic;
+    u32 cputype;
+    u32 cpusubtype;
+    u32 filetype;
+    u32 ncmds;
+    u32 sizeofcmds;
+    u32 flags;
+    u32 reserved;
+};
+
+struct load_command {
+    u32 cmd;
+    u32 cmdsize;
+};
+
+struct segment_command_64 {
+    u32 cmd;
+    u32 cmdsize;
+    char segname[16];
+    u64 vmaddr;
+    u64 vmsize;
+    u64 fileoff;
+    u64 filesize;
+    u32 maxprot;
+    u32 initprot;
+    u32 nsects;
+    u32 flags;
+};
+
+struct thread_command_64 {
+    u32 cmd;
+    u32 cmdsize;
+    u32 flavor;
+    u32 count;
+    u64 x[29];
+    u64 fp, lr, sp, pc;
+};
+
+static struct load_command *next_command(struct mach_header_64 *hdr, struct load_command *lc)
+{
+    void *cmds = hdr + 1;
+    void *p = lc;
+
+    if (!lc)
+        return cmds;
+
+    if (lc->cmdsize < sizeof(*lc))
+        return NULL;
+
+    p += lc->cmdsize;
+    if (p + sizeof(*lc) > cmds + hdr->sizeofcmds)
+        return NULL;
+
+    return p;
+}
+
+/*
+ * Flatten a Mach-O image into its in-memory layout at dest: segments placed
+ * at (vmaddr - vmin), gaps and trailing vmsize zero-filled. Returns the
+ * flattened size, and the LC_UNIXTHREAD entry point (as a virtual address)
+ * via *entry if present.
+ */
+s64 macho_flatten(void *image, size_t size, void *dest, size_t dest_size, u64 *entry)
+{
+    struct mach_header_64 *hdr = image;
+    struct load_command *lc;
+    u32 ncmds = 0;
+
+    if (size < sizeof(*hdr) || hdr->magic != MH_MAGIC_64) {
+        printf("macho: bad Mach-O magic\n");
+        return -1;
+    }
+
+    if (sizeof(*hdr) + hdr->sizeofcmds > size) {
+        printf("macho: load commands exceed image size\n");
+        return -1;
+    }
+
+    u64 vmin = ~0ULL, vmax = 0;
+
+    for (lc = next_command(hdr, NULL); lc && ncmds < hdr->ncmds;
+         lc = next_command(hdr, lc), ncmds++) {
+        if (lc->cmd != LC_SEGMENT_64)
+            continue;
+
+        struct segment_command_64 *seg = (void *)lc;
+
+        if (seg->cmdsize < sizeof(*seg)) {
+            printf("macho: truncated segment command\n");
+            return -1;
+        }
+
+        vmin = min(vmin, seg->vmaddr);
+        vmax = max(vmax, seg->vmaddr + seg->vmsize);
+    }
+
+    if (vmax <= vmin) {
+        printf("macho: no segments found\n");
+        return -1;
+    }
+
+    u64 flat_size = vmax - vmin;
+    if (flat_size > dest_size) {
+        printf("macho: image size 0x%lx exceeds buffer size 0x%lx\n", flat_size, dest_size);
+        return -1;
+    }
+
+    memset(dest, 0, flat_size);
+
+    ncmds = 0;
+    for (lc = next_command(hdr, NULL); lc && ncmds < hdr->ncmds;
+         lc = next_command(hdr, lc), ncmds++) {
+        switch (lc->cmd) {
+            case LC_SEGMENT_64: {
+                struct segment_command_64 *seg = (void *)lc;
+
+                if (seg->fileoff > size) {
+                    printf("macho: segment %s exceeds file size\n", seg->segname);
+                    return -1;
+                }
+
+                u64 copy_size = min(seg->filesize, size - seg->fileoff);
+                copy_size = min(copy_size, seg->vmsize);
+
+                memcpy(dest + (seg->vmaddr - vmin), image + seg->fileoff, copy_size);
+                break;
+            }
+            case LC_UNIXTHREAD: {
+                struct thread_command_64 *tc = (void *)lc;
+
+                if (tc->cmdsize >= sizeof(*tc) && entry)
+                    *entry = tc->pc;
+                break;
+            }
+        }
+    }
+
+    dc_cvau_range(dest, flat_size);
+    ic_ivau_range(dest, flat_size);
+
+    return flat_size;
+}
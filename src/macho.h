@@ -0,0 +1,10 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef MACHO_H
+#define MACHO_H
+
+#include "types.h"
+
+s64 macho_flatten(void *image, size_t size, void *dest, size_t dest_size, u64 *entry);
+
+#endif
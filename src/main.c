@@ -7,22 +7,27 @@
 
 #include "adt.h"
 #include "aic.h"
+#include "bootprofile.h"
 #include "cpufreq.h"
 #include "display.h"
+#include "evtlog.h"
 #include "exception.h"
 #include "fb.h"
 #include "firmware.h"
 #include "gxf.h"
 #include "heapblock.h"
 #include "mcc.h"
+#include "measure.h"
 #include "memory.h"
 #include "nvme.h"
 #include "payload.h"
 #include "pcie.h"
+#include "plog.h"
 #include "pmgr.h"
 #include "sep.h"
 #include "smp.h"
 #include "string.h"
+#include "telemetry.h"
 #include "uart.h"
 #include "uartproxy.h"
 #include "usb.h"
@@ -137,22 +142,33 @@ void m1n1_main(void)
 
     printf("Running in EL%lu\n\n", mrs(CurrentEL) >> 2);
 
+    EVT(MAIN_START, 0);
+
     get_device_info();
     firmware_init();
 
     heapblock_init();
+    EVT(HEAP_READY, 0);
 
 #ifndef BRINGUP
     gxf_init();
     mcc_init();
+    bootprofile_begin("mmu");
     mmu_init();
+    bootprofile_end("mmu");
+    EVT(MMU_READY, 0);
+    plog_init();
     aic_init();
 #endif
     wdt_disable();
 #ifndef BRINGUP
+    bootprofile_begin("pmgr");
     pmgr_init();
+    bootprofile_end("pmgr");
+    EVT(PMGR_READY, 0);
 
 #ifdef USE_FB
+    bootprofile_begin("display");
     display_init();
     // Kick DCP to sleep, so dodgy monitors which cause reconnect cycles don't cause us to lose the
     // framebuffer.
@@ -164,13 +180,23 @@ void m1n1_main(void)
 #else
     fb_set_active(true);
 #endif
+    bootprofile_end("display");
+    EVT(DISPLAY_READY, 0);
 #endif
 
     cpufreq_fixup();
     sep_init();
 #endif
 
+    telemetry_init();
+
+#ifndef BRINGUP
+    // Boot chain digests land asynchronously on idle secondaries
+    measure_boot();
+#endif
+
     printf("Initialization complete.\n");
+    EVT(INIT_DONE, 0);
 
     run_actions();
 
@@ -180,7 +206,7 @@ void m1n1_main(void)
 
     printf("Preparing to run next stage at %p...\n", next_stage.entry);
 
-    nvme_shutdown();
+    nvme_shutdown_now();
     exception_shutdown();
 #ifndef BRINGUP
     usb_iodev_shutdown();
@@ -192,6 +218,7 @@ void m1n1_main(void)
 #endif
 
     printf("Vectoring to next stage...\n");
+    EVT(NEXT_STAGE, 0);
 
     next_stage.entry(next_stage.args[0], next_stage.args[1], next_stage.args[2], next_stage.args[3],
                      next_stage.args[4]);
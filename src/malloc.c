@@ -0,0 +1,156 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "malloc.h"
+#include "smp.h"
+#include "string.h"
+#include "utils.h"
+
+/* dlmalloc entry points (USE_DL_PREFIX) */
+void *dlmalloc(size_t size);
+void dlfree(void *p);
+void *dlcalloc(size_t count, size_t size);
+void *dlrealloc(void *p, size_t size);
+void *dlrealloc_in_place(void *p, size_t size);
+void *dlmemalign(size_t align, size_t size);
+int dlposix_memalign(void **out, size_t align, size_t size);
+size_t dlmalloc_footprint(void);
+size_t dlmalloc_max_footprint(void);
+void dlmalloc_inspect_all(void (*handler)(void *start, void *end, size_t used, void *arg),
+                          void *arg);
+
+/*
+ * Allocation accounting. Long sessions see malloc latency creep up as the
+ * heap fragments; these counters plus the heap walk in malloc_get_stats()
+ * let the host quantify that and attribute churn to callers.
+ */
+static u64 alloc_count;
+static u64 free_count;
+static u64 size_hist[MALLOC_SIZE_BUCKETS];
+static struct malloc_callsite callsites[MALLOC_MAX_CALLSITES];
+
+static void account(size_t size, void *caller)
+{
+    u64 pc = (u64)caller;
+    int bucket = size ? 63 - __builtin_clzll(size) : 0;
+
+    alloc_count++;
+    size_hist[min(bucket, MALLOC_SIZE_BUCKETS - 1)]++;
+
+    size_t idx = (pc >> 2) % MALLOC_MAX_CALLSITES;
+    for (int i = 0; i < MALLOC_MAX_CALLSITES; i++) {
+        struct malloc_callsite *cs = &callsites[idx];
+
+        if (!cs->pc)
+            cs->pc = pc;
+        if (cs->pc == pc) {
+            cs->count++;
+            cs->bytes += size;
+            return;
+        }
+        idx = (idx + 1) % MALLOC_MAX_CALLSITES;
+    }
+    // Table full; the per-site data is best-effort, the totals stay exact
+}
+
+static void inspect_chunk(void *start, void *end, size_t used, void *arg)
+{
+    struct malloc_stats *st = arg;
+    size_t size = (u8 *)end - (u8 *)start;
+
+    if (used) {
+        st->used_chunks++;
+        st->used_bytes += used;
+    } else {
+        st->free_chunks++;
+        st->free_bytes += size;
+        st->largest_free = max(st->largest_free, size);
+    }
+}
+
+void malloc_get_stats(struct malloc_stats *st)
+{
+    memset(st, 0, sizeof(*st));
+
+    st->alloc_count = alloc_count;
+    st->free_count = free_count;
+    st->footprint = dlmalloc_footprint();
+    st->max_footprint = dlmalloc_max_footprint();
+    memcpy(st->size_hist, size_hist, sizeof(size_hist));
+    memcpy(st->callsites, callsites, sizeof(callsites));
+
+    dlmalloc_inspect_all(inspect_chunk, st);
+}
+
+/*
+ * No-allocation guard. Latency-critical sections (the hypervisor guest exit
+ * path) push this to assert that they stay off the heap; any allocation while
+ * it is held is a bug and gets reported, but still serviced.
+ */
+static int noalloc_depth[MAX_CPUS];
+
+void malloc_noalloc_push(void)
+{
+    noalloc_depth[smp_id()]++;
+}
+
+void malloc_noalloc_pop(void)
+{
+    noalloc_depth[smp_id()]--;
+}
+
+static void noalloc_check(const char *what)
+{
+    if (noalloc_depth[smp_id()])
+        printf("malloc: %s() called in a no-allocation context (caller: %p)\n", what,
+               __builtin_return_address(0));
+}
+
+void *malloc(size_t size)
+{
+    noalloc_check("malloc");
+    account(size, __builtin_return_address(0));
+    return dlmalloc(size);
+}
+
+void free(void *p)
+{
+    noalloc_check("free");
+    if (p)
+        free_count++;
+    dlfree(p);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    noalloc_check("calloc");
+    account(count * size, __builtin_return_address(0));
+    return dlcalloc(count, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+    noalloc_check("realloc");
+    account(size, __builtin_return_address(0));
+    return dlrealloc(p, size);
+}
+
+void *realloc_in_place(void *p, size_t size)
+{
+    noalloc_check("realloc_in_place");
+    account(size, __builtin_return_address(0));
+    return dlrealloc_in_place(p, size);
+}
+
+void *memalign(size_t align, size_t size)
+{
+    noalloc_check("memalign");
+    account(size, __builtin_return_address(0));
+    return dlmemalign(align, size);
+}
+
+int posix_memalign(void **out, size_t align, size_t size)
+{
+    noalloc_check("posix_memalign");
+    account(size, __builtin_return_address(0));
+    return dlposix_memalign(out, align, size);
+}
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef MEASURE_H
+#define MEASURE_H
+
+#include "hash.h"
+#include "types.h"
+
+/*
+ * Measured-boot style SHA-256 digests of the boot chain, computed on idle
+ * secondary cores so boot does not stall on the hashing. Each done flag is
+ * written only by the worker that owns it, and the workers run with their
+ * caches off; readers must go through measure_read(), which drops the boot
+ * CPU's stale cached view first.
+ */
+
+#define MEASURE_MAGIC 0x5341454d // 'MEAS'
+
+struct boot_measurements {
+    u32 magic;
+    u32 pad;
+
+    /* m1n1 text + rodata (_base.._rodata_end; data/bss mutate at runtime) */
+    u8 m1n1[SHA256_DIGEST_SIZE];
+    u32 m1n1_done;
+
+    /* the ADT as handed over by iBoot */
+    u8 adt[SHA256_DIGEST_SIZE];
+    u32 adt_done;
+
+    /* chainloaded image, if any */
+    u8 payload[SHA256_DIGEST_SIZE];
+    u32 payload_done;
+    u64 payload_size;
+} ALIGNED(64);
+
+void measure_boot(void);
+void measure_payload(const void *buf, size_t len);
+void measure_read(struct boot_measurements *out);
+
+#endif
@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+ * On-device memory diff.
+ *
+ * Comparing two guest snapshots host-side means transferring both copies over
+ * the proxy; comparing them here returns only the differing extents. The
+ * range is split into equal slices, one per idle CPU (plus the boot CPU, which
+ * takes the first slice so the per-slot extent regions end up in address
+ * order). Compares are plain 64-bit loads: the build is -mgeneral-regs-only,
+ * so there are no vector registers to go wider with, and the loop is
+ * DRAM-bound anyway.
+ *
+ * The secondaries run with their caches off, so both ranges are cleaned to
+ * PoC before dispatch and each worker records extents into its own
+ * cache-line-aligned region of memdiff_log.extents, returning its differing
+ * byte count through the smp mailbox. The boot CPU compacts the regions into
+ * one sorted array afterwards, merging extents that touch across slice
+ * boundaries.
+ */
+
+#include "memdiff.h"
+#include "memory.h"
+#include "smp.h"
+#include "string.h"
+#include "utils.h"
+
+struct memdiff_log memdiff_log = {
+    .magic = MEMDIFF_MAGIC,
+    .ent_size = sizeof(struct memdiff_extent),
+    .max_extents = MEMDIFF_MAX_EXTENTS,
+};
+
+static u64 memdiff_slice(u64 a, u64 size, u64 delta, u64 slot)
+{
+    struct memdiff_extent *ebuf = &memdiff_log.extents[slot * MEMDIFF_EXTENTS_PER_CPU];
+    const u64 *pa = (const u64 *)a;
+    const u64 *pb = (const u64 *)(a + delta);
+    u64 bytes = 0;
+    u64 recorded = 0;
+
+    for (u64 off = 0; off < size; off += 8) {
+        if (*pa++ == *pb++)
+            continue;
+
+        bytes += 8;
+        /* Extents are recorded with absolute addresses; the boot CPU
+         * rebases them to offsets when compacting. */
+        if (recorded && ebuf[recorded - 1].offset + ebuf[recorded - 1].size == a + off)
+            ebuf[recorded - 1].size += 8;
+        else if (recorded < MEMDIFF_EXTENTS_PER_CPU)
+            ebuf[recorded++] = (struct memdiff_extent){a + off, 8};
+    }
+
+    return bytes;
+}
+
+s64 memdiff_run(u64 a, u64 b, u64 size)
+{
+    if (!size || ((a | b | size) & 7))
+        return -1;
+
+    int cpus[MEMDIFF_MAX_CPUS];
+    int ncpus = smp_idle_cpus(CPU_TYPE_UNKNOWN, -1, cpus, MEMDIFF_MAX_CPUS);
+
+    u64 start = mrs(CNTPCT_EL0);
+
+    memdiff_log.count = 0;
+    memdiff_log.bytes = 0;
+    memdiff_log.truncated = 0;
+    memset(memdiff_log.extents, 0, sizeof(memdiff_log.extents));
+    // Push the reset state to DRAM so MMU-off secondaries see it
+    dc_civac_range(&memdiff_log, sizeof(memdiff_log));
+
+    if (ncpus) {
+        // Workers read both ranges uncached
+        dc_civac_range_par((void *)a, size);
+        dc_civac_range_par((void *)b, size);
+    }
+
+    u64 chunk = ALIGN_UP(size / (ncpus + 1), 8);
+    u64 end = a + size;
+    u64 delta = b - a;
+
+    struct smp_group group;
+    smp_group_init(&group);
+
+    int nslices = 0;
+    for (int i = 0; i < ncpus; i++) {
+        u64 p = a + (u64)(i + 1) * chunk;
+        if (p >= end)
+            break;
+        smp_group_call4(&group, cpus[i], memdiff_slice, p, min(chunk, end - p), delta,
+                        ++nslices);
+    }
+
+    u64 bytes = memdiff_slice(a, min(chunk, size), delta, 0);
+
+    // Flush our own extents, then drop stale cached views of the workers'
+    dc_cvac_range(&memdiff_log.extents[0], MEMDIFF_EXTENTS_PER_CPU * sizeof(struct memdiff_extent));
+
+    smp_group_wait(&group);
+    for (int i = 0; i < nslices; i++)
+        bytes += group.retval[i];
+
+    dc_ivac_range(&memdiff_log.extents[MEMDIFF_EXTENTS_PER_CPU],
+                  (u64)nslices * MEMDIFF_EXTENTS_PER_CPU * sizeof(struct memdiff_extent));
+
+    // Compact the per-slot regions (already in address order) into one array
+    u32 count = 0;
+    for (int i = 0; i <= nslices; i++) {
+        struct memdiff_extent *reg = &memdiff_log.extents[i * MEMDIFF_EXTENTS_PER_CPU];
+
+        for (u64 j = 0; j < MEMDIFF_EXTENTS_PER_CPU && reg[j].size; j++) {
+            u64 off = reg[j].offset - a;
+            u64 len = reg[j].size;
+
+            if (count && memdiff_log.extents[count - 1].offset +
+                             memdiff_log.extents[count - 1].size ==
+                             off)
+                memdiff_log.extents[count - 1].size += len;
+            else
+                memdiff_log.extents[count++] = (struct memdiff_extent){off, len};
+        }
+    }
+
+    u64 recorded_bytes = 0;
+    for (u32 i = 0; i < count; i++)
+        recorded_bytes += memdiff_log.extents[i].size;
+
+    memdiff_log.count = count;
+    memdiff_log.bytes = bytes;
+    memdiff_log.truncated = recorded_bytes != bytes;
+    memdiff_log.elapsed = mrs(CNTPCT_EL0) - start;
+
+    return bytes;
+}
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef MEMDIFF_H
+#define MEMDIFF_H
+
+#include "types.h"
+#include "utils.h"
+
+/*
+ * Parallel memory diff, invoked via P_MEMDIFF_RUN. Two equal-sized ranges
+ * (typically a live region and an earlier snapshot of it) are compared
+ * on-device, one slice per idle CPU, and only the differing extents are
+ * recorded in memdiff_log, read via P_MEMDIFF_GET.
+ */
+
+#define MEMDIFF_MAGIC 0x46444d4d // 'MMDF'
+
+#define MEMDIFF_MAX_CPUS        8
+#define MEMDIFF_EXTENTS_PER_CPU 64
+#define MEMDIFF_MAX_EXTENTS     ((MEMDIFF_MAX_CPUS + 1) * MEMDIFF_EXTENTS_PER_CPU)
+
+struct memdiff_extent {
+    u64 offset;
+    u64 size;
+};
+
+struct memdiff_log {
+    u32 magic;
+    u32 ent_size;
+    u32 max_extents;
+    u32 count;
+    /* Total differing bytes; exceeds the recorded extents if truncated is set */
+    u64 bytes;
+    u32 truncated;
+    u32 pad;
+    u64 elapsed;
+    /* One cache-line-aligned region per worker, compacted after each run */
+    struct memdiff_extent extents[MEMDIFF_MAX_EXTENTS] ALIGNED(64);
+};
+
+extern struct memdiff_log memdiff_log;
+
+s64 memdiff_run(u64 a, u64 b, u64 size);
+
+#endif
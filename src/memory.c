@@ -27,12 +27,127 @@
         }                                                                                          \
     }
 
+/*
+ * Pure maintenance ops (not zero-fill, not icache) are no-ops on ranges that
+ * are mapped uncached, and can be elided; see mmu_range_is_uncached().
+ */
+#define CACHE_MAINT_RANGE_OP(func, op)                                                             \
+    void func(void *addr, size_t length)                                                           \
+    {                                                                                              \
+        if (mmu_range_is_uncached((u64)addr, length))                                              \
+            return;                                                                                \
+        u64 p = (u64)addr;                                                                         \
+        u64 end = p + length;                                                                      \
+        while (p < end) {                                                                          \
+            cacheop(op, p);                                                                        \
+            p += CACHE_LINE_SIZE;                                                                  \
+        }                                                                                          \
+    }
+
 CACHE_RANGE_OP(ic_ivau_range, "ic ivau")
-CACHE_RANGE_OP(dc_ivac_range, "dc ivac")
+CACHE_MAINT_RANGE_OP(dc_ivac_range, "dc ivac")
 CACHE_RANGE_OP(dc_zva_range, "dc zva")
-CACHE_RANGE_OP(dc_cvac_range, "dc cvac")
-CACHE_RANGE_OP(dc_cvau_range, "dc cvau")
-CACHE_RANGE_OP(dc_civac_range, "dc civac")
+CACHE_MAINT_RANGE_OP(dc_cvac_range, "dc cvac")
+CACHE_MAINT_RANGE_OP(dc_cvau_range, "dc cvau")
+CACHE_MAINT_RANGE_OP(dc_civac_range, "dc civac")
+
+/*
+ * Flushing a large image (kernel + initramfs can be the better part of a GB) a
+ * line at a time on one core takes hundreds of milliseconds. Split big ranges
+ * into equal slices across any idle secondaries; VA maintenance ops are
+ * broadcast, and work from the secondaries' spin loop even with their MMU off.
+ * Set/way loops are deliberately not used: they are not safe while other cores
+ * are live, and are no faster than VA ops on these machines.
+ */
+#define PAR_CACHE_OP_THRESHOLD SZ_32M
+#define PAR_CACHE_OP_MAX_CPUS  8
+
+static void cache_range_op_par(void *func, void *addr, size_t length)
+{
+    void (*op)(void *, size_t) = func;
+    u64 start = (u64)addr;
+    u64 end = start + length;
+    int cpus[PAR_CACHE_OP_MAX_CPUS];
+    int ncpus = 0;
+
+    if (length >= PAR_CACHE_OP_THRESHOLD)
+        ncpus = smp_idle_cpus(CPU_TYPE_UNKNOWN, -1, cpus, PAR_CACHE_OP_MAX_CPUS);
+
+    if (!ncpus) {
+        op(addr, length);
+        return;
+    }
+
+    u64 chunk = ALIGN_UP(length / (ncpus + 1), CACHE_LINE_SIZE);
+
+    struct smp_group group;
+    smp_group_init(&group);
+
+    for (int i = 0; i < ncpus; i++) {
+        u64 p = start + i * chunk;
+        smp_group_call2(&group, cpus[i], func, p, min(chunk, end - p));
+    }
+
+    u64 p = start + (u64)ncpus * chunk;
+    if (p < end)
+        op((void *)p, end - p);
+
+    smp_group_wait(&group);
+
+    sysop("dsb ish");
+}
+
+void ic_ivau_range_par(void *addr, size_t length)
+{
+    cache_range_op_par(ic_ivau_range, addr, length);
+}
+
+void dc_ivac_range_par(void *addr, size_t length)
+{
+    // Don't wake secondaries for a range with nothing to maintain
+    if (mmu_range_is_uncached((u64)addr, length))
+        return;
+
+    cache_range_op_par(dc_ivac_range, addr, length);
+}
+
+void dc_civac_range_par(void *addr, size_t length)
+{
+    if (mmu_range_is_uncached((u64)addr, length))
+        return;
+
+    cache_range_op_par(dc_civac_range, addr, length);
+}
+
+/*
+ * Bulk fill: DC ZVA for zero fills, non-temporal store pairs for patterns.
+ * Plain stores handle the unaligned edges, and the whole thing falls back to
+ * memset64 when the MMU (and thus the caches) are off, where ZVA and STNP
+ * would operate on Device memory.
+ */
+void memset_fast(void *dst, u64 value, size_t size)
+{
+    u64 p = (u64)dst;
+    u64 end = p + size;
+
+    if (!mmu_active() || size < 2 * CACHE_LINE_SIZE) {
+        memset64(dst, value, size);
+        return;
+    }
+
+    u64 aligned = ALIGN_UP(p, CACHE_LINE_SIZE);
+    u64 aligned_end = ALIGN_DOWN(end, CACHE_LINE_SIZE);
+
+    memset64((void *)p, value, aligned - p);
+    if (value == 0)
+        memset_zva((void *)aligned, aligned_end - aligned);
+    else
+        memset_stnp((void *)aligned, value, aligned_end - aligned);
+    memset64((void *)aligned_end, value, end - aligned_end);
+
+    /* Order the non-temporal stores against whatever comes next */
+    sysop("dmb ish");
+}
 
 extern u8 _stack_top[];
 
@@ -67,6 +182,12 @@ static inline void write_sctlr(u64 val)
 #define ENTRIES_PER_L2_TABLE BIT(VADDR_L2_INDEX_BITS)
 #define ENTRIES_PER_L3_TABLE BIT(VADDR_L3_INDEX_BITS)
 
+// Contiguous-hint spans at 16K granule: 128 L3 entries (2MB), 32 L2 entries (1GB)
+#define VADDR_L3_CONTIG_BITS (VADDR_L3_OFFSET_BITS + 7)
+#define VADDR_L2_CONTIG_BITS (VADDR_L2_OFFSET_BITS + 5)
+#define L3_CONTIG_ENTRIES    BIT(VADDR_L3_CONTIG_BITS - VADDR_L3_OFFSET_BITS)
+#define L2_CONTIG_ENTRIES    BIT(VADDR_L2_CONTIG_BITS - VADDR_L2_OFFSET_BITS)
+
 #define IS_PTE(pte) ((pte) && pte & PTE_VALID)
 
 #define L1_IS_TABLE(pte) (IS_PTE(pte) && FIELD_GET(PTE_TYPE, pte) == PTE_TABLE)
@@ -188,8 +309,22 @@ static u64 *mmu_pt_get_l2(u64 from)
     return l2;
 }
 
+/*
+ * The contiguous hint may only be set if all entries of a span are valid and
+ * uniform; when a mapping partially overwrites a hinted span, the hint must be
+ * cleared on the remaining entries first.
+ */
+static void mmu_pt_break_contig(u64 *tbl, u64 idx, u64 entries)
+{
+    idx &= ~(entries - 1);
+    for (u64 i = 0; i < entries; i++)
+        tbl[idx + i] &= ~PTE_CONTIG;
+}
+
 static void mmu_pt_map_l2(u64 from, u64 to, u64 size)
 {
+    u64 contig_left = 0;
+
     assert((from & MASK(VADDR_L2_OFFSET_BITS)) == 0);
     assert((to & PTE_TARGET_MASK & MASK(VADDR_L2_OFFSET_BITS)) == 0);
     assert((size & MASK(VADDR_L2_OFFSET_BITS)) == 0);
@@ -203,7 +338,19 @@ static void mmu_pt_map_l2(u64 from, u64 to, u64 size)
         if (L2_IS_TABLE(l2[idx]))
             free((void *)(l2[idx] & PTE_TARGET_MASK));
 
-        l2[idx] = to;
+        if (!contig_left && (from & MASK(VADDR_L2_CONTIG_BITS)) == 0 &&
+            ((to & PTE_TARGET_MASK) & MASK(VADDR_L2_CONTIG_BITS)) == 0 &&
+            size >= BIT(VADDR_L2_CONTIG_BITS))
+            contig_left = L2_CONTIG_ENTRIES;
+
+        if (contig_left) {
+            l2[idx] = to | PTE_CONTIG;
+            contig_left--;
+        } else {
+            if (l2[idx] & PTE_CONTIG)
+                mmu_pt_break_contig(l2, idx, L2_CONTIG_ENTRIES);
+            l2[idx] = to;
+        }
         from += BIT(VADDR_L2_OFFSET_BITS);
         to += BIT(VADDR_L2_OFFSET_BITS);
     }
@@ -221,9 +368,15 @@ static u64 *mmu_pt_get_l3(u64 from)
 
     u64 *l3 = (u64 *)memalign(PAGE_SIZE, ENTRIES_PER_L3_TABLE * sizeof(u64));
     if (IS_PTE(l2d)) {
+        /* Splitting a block breaks the uniformity of its contiguous span */
+        if (l2d & PTE_CONTIG) {
+            mmu_pt_break_contig(l2, l2idx, L2_CONTIG_ENTRIES);
+            l2d &= ~PTE_CONTIG;
+        }
+
         u64 l3d = l2d;
         l3d &= ~PTE_TYPE;
-        l3d |= FIELD_PREP(PTE_TYPE, PTE_PAGE);
+        l3d |= FIELD_PREP(PTE_TYPE, PTE_PAGE) | PTE_CONTIG;
         for (u64 idx = 0; idx < ENTRIES_PER_L3_TABLE; idx++, l3d += BIT(VADDR_L3_OFFSET_BITS))
             l3[idx] = l3d;
     } else {
@@ -237,6 +390,8 @@ static u64 *mmu_pt_get_l3(u64 from)
 
 static void mmu_pt_map_l3(u64 from, u64 to, u64 size)
 {
+    u64 contig_left = 0;
+
     assert((from & MASK(VADDR_L3_OFFSET_BITS)) == 0);
     assert((to & PTE_TARGET_MASK & MASK(VADDR_L3_OFFSET_BITS)) == 0);
     assert((size & MASK(VADDR_L3_OFFSET_BITS)) == 0);
@@ -247,7 +402,19 @@ static void mmu_pt_map_l3(u64 from, u64 to, u64 size)
         u64 idx = (from >> VADDR_L3_OFFSET_BITS) & MASK(VADDR_L3_INDEX_BITS);
         u64 *l3 = mmu_pt_get_l3(from);
 
-        l3[idx] = to;
+        if (!contig_left && (from & MASK(VADDR_L3_CONTIG_BITS)) == 0 &&
+            ((to & PTE_TARGET_MASK) & MASK(VADDR_L3_CONTIG_BITS)) == 0 &&
+            size >= BIT(VADDR_L3_CONTIG_BITS))
+            contig_left = L3_CONTIG_ENTRIES;
+
+        if (contig_left) {
+            l3[idx] = to | PTE_CONTIG;
+            contig_left--;
+        } else {
+            if (l3[idx] & PTE_CONTIG)
+                mmu_pt_break_contig(l3, idx, L3_CONTIG_ENTRIES);
+            l3[idx] = to;
+        }
         from += BIT(VADDR_L3_OFFSET_BITS);
         to += BIT(VADDR_L3_OFFSET_BITS);
     }
@@ -291,6 +458,174 @@ int mmu_map(u64 from, u64 to, u64 size)
     return 0;
 }
 
+/* Returns the leaf PTE covering addr, or 0 if unmapped */
+static u64 mmu_pt_walk_leaf(u64 addr)
+{
+    u64 l1idx = addr >> VADDR_L1_OFFSET_BITS;
+    if (l1idx >= ENTRIES_PER_L1_TABLE)
+        return 0;
+
+    u64 l1d = mmu_pt_L1[l1idx];
+    if (L1_IS_BLOCK(l1d))
+        return l1d;
+    if (!L1_IS_TABLE(l1d))
+        return 0;
+
+    u64 *l2 = (u64 *)(l1d & PTE_TARGET_MASK);
+    u64 l2d = l2[(addr >> VADDR_L2_OFFSET_BITS) & MASK(VADDR_L2_INDEX_BITS)];
+    if (L2_IS_BLOCK(l2d))
+        return l2d;
+    if (!L2_IS_TABLE(l2d))
+        return 0;
+
+    u64 *l3 = (u64 *)(l2d & PTE_TARGET_MASK);
+    u64 l3d = l3[(addr >> VADDR_L3_OFFSET_BITS) & MASK(VADDR_L3_INDEX_BITS)];
+    if (L3_IS_BLOCK(l3d))
+        return l3d;
+
+    return 0;
+}
+
+/*
+ * True if every page of the range is currently mapped with an uncached
+ * attribute (Device or Normal-NC). Every cached->uncached remap in m1n1
+ * cleans and invalidates the range first (see mmu_map_framebuffer()), so an
+ * uncached range cannot hold stale lines and data cache maintenance on it is
+ * a no-op. The common cached case exits on the first page, so the walk adds
+ * negligible cost to real flushes.
+ */
+bool mmu_range_is_uncached(u64 addr, size_t length)
+{
+    if (!mmu_active() || !length)
+        return false;
+
+    u64 end = addr + length;
+    addr = ALIGN_DOWN(addr, PAGE_SIZE);
+
+    for (; addr < end; addr += PAGE_SIZE) {
+        u64 pte = mmu_pt_walk_leaf(addr);
+
+        if (!IS_PTE(pte) || FIELD_GET(PTE_MAIR_IDX_MASK, pte) == MAIR_IDX_NORMAL)
+            return false;
+    }
+
+    return true;
+}
+
+/*
+ * The memory map is filled in by the mmu_add_default_mappings() pass below.
+ * Additions carve overlapping parts out of earlier regions (so the MCC
+ * carveouts punch holes into the RAM block) and contiguous same-type
+ * neighbours are merged, keeping the array sorted and minimal.
+ */
+#define MEM_MAP_MAX 128
+
+static struct mem_region mem_map[MEM_MAP_MAX];
+static size_t mem_map_count;
+
+static void mem_map_insert(size_t idx, u64 base, u64 size, enum mem_region_type type)
+{
+    if (mem_map_count >= MEM_MAP_MAX) {
+        printf("MMU: memory map full, dropping 0x%lx (0x%lx)\n", base, size);
+        return;
+    }
+    memmove(&mem_map[idx + 1], &mem_map[idx], (mem_map_count - idx) * sizeof(mem_map[0]));
+    mem_map[idx] = (struct mem_region){base, size, type};
+    mem_map_count++;
+}
+
+static void mem_map_remove(size_t idx)
+{
+    memmove(&mem_map[idx], &mem_map[idx + 1], (mem_map_count - idx - 1) * sizeof(mem_map[0]));
+    mem_map_count--;
+}
+
+void mem_map_add(u64 base, u64 size, enum mem_region_type type)
+{
+    u64 end = base + size;
+    size_t i = 0;
+
+    if (!size)
+        return;
+
+    /* Later additions win: carve the overlap out of existing regions */
+    while (i < mem_map_count) {
+        struct mem_region *r = &mem_map[i];
+        u64 r_end = r->base + r->size;
+
+        if (r_end <= base || r->base >= end) {
+            i++;
+        } else if (r->base < base && r_end > end) {
+            mem_map_insert(i + 1, end, r_end - end, r->type);
+            mem_map[i].size = base - mem_map[i].base;
+            i += 2;
+        } else if (r->base < base) {
+            r->size = base - r->base;
+            i++;
+        } else if (r_end > end) {
+            r->size = r_end - end;
+            r->base = end;
+            i++;
+        } else {
+            mem_map_remove(i);
+        }
+    }
+
+    for (i = 0; i < mem_map_count; i++)
+        if (mem_map[i].base > base)
+            break;
+
+    /* Merge with contiguous same-type neighbours */
+    if (i > 0 && mem_map[i - 1].type == type && mem_map[i - 1].base + mem_map[i - 1].size == base) {
+        i--;
+        base = mem_map[i].base;
+        mem_map_remove(i);
+    }
+    if (i < mem_map_count && mem_map[i].type == type && mem_map[i].base == end) {
+        end += mem_map[i].size;
+        mem_map_remove(i);
+    }
+
+    mem_map_insert(i, base, end - base, type);
+}
+
+const struct mem_region *mem_map_get(size_t *count)
+{
+    *count = mem_map_count;
+    return mem_map;
+}
+
+const struct mem_region *mem_map_lookup(u64 addr)
+{
+    size_t lo = 0, hi = mem_map_count;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (mem_map[mid].base > addr)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    if (lo && addr - mem_map[lo - 1].base < mem_map[lo - 1].size)
+        return &mem_map[lo - 1];
+    return NULL;
+}
+
+const char *mem_region_type_name(enum mem_region_type type)
+{
+    switch (type) {
+        case MEM_RAM:
+            return "RAM";
+        case MEM_MMIO:
+            return "MMIO";
+        case MEM_CARVEOUT:
+            return "carveout";
+        default:
+            return "unknown";
+    }
+}
+
 static u64 mmu_make_table_pte(u64 *addr)
 {
     u64 pte = FIELD_PREP(PTE_TYPE, PTE_TABLE) | PTE_VALID;
@@ -311,19 +646,36 @@ static void mmu_init_pagetables(void)
     mmu_pt_L0[1] = mmu_make_table_pte(&mmu_pt_L1[ENTRIES_PER_L1_TABLE >> 1]);
 }
 
-void mmu_add_mapping(u64 from, u64 to, size_t size, u8 attribute_index, u64 perms)
+static void mmu_map_one(u64 from, u64 to, size_t size, u8 attribute_index, u64 perms)
 {
     if (mmu_map(from,
                 to | PTE_MAIR_IDX(attribute_index) | PTE_ACCESS | PTE_VALID | PTE_SH_OS | perms,
                 size) < 0)
         panic("Failed to add MMU mapping 0x%lx -> 0x%lx (0x%lx)\n", from, to, size);
+}
 
+static void mmu_tlb_flush(void)
+{
     sysop("dsb ishst");
     sysop("tlbi vmalle1is");
     sysop("dsb ish");
     sysop("isb");
 }
 
+void mmu_add_mapping(u64 from, u64 to, size_t size, u8 attribute_index, u64 perms)
+{
+    mmu_map_one(from, to, size, attribute_index, perms);
+    mmu_tlb_flush();
+}
+
+void mmu_map_ranges(const struct mmu_map_range *ranges, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        mmu_map_one(ranges[i].from, ranges[i].to, ranges[i].size, ranges[i].attribute_index,
+                    ranges[i].perms);
+    mmu_tlb_flush();
+}
+
 void mmu_rm_mapping(u64 from, size_t size)
 {
     if (mmu_map(from, 0, size) < 0)
@@ -345,13 +697,22 @@ static void mmu_map_mmio(void)
     }
     // Assume all cell counts are 2 (64bit)
     int range_cnt = ranges_len / 24;
-    while (range_cnt--) {
-        u64 bus = ranges[2] | ((u64)ranges[3] << 32);
-        u64 size = ranges[4] | ((u64)ranges[5] << 32);
+    while (range_cnt) {
+        struct mmu_map_range map[64];
+        int batch = min(range_cnt, (int)ARRAY_SIZE(map));
 
-        mmu_add_mapping(bus, bus, size, MAIR_IDX_DEVICE_nGnRnE, PERM_RW_EL0);
+        for (int i = 0; i < batch; i++) {
+            u64 bus = ranges[2] | ((u64)ranges[3] << 32);
+            u64 size = ranges[4] | ((u64)ranges[5] << 32);
 
-        ranges += 6;
+            map[i] = (struct mmu_map_range){bus, bus, size, MAIR_IDX_DEVICE_nGnRnE, PERM_RW_EL0};
+            mem_map_add(bus, size, MEM_MMIO);
+
+            ranges += 6;
+        }
+
+        mmu_map_ranges(map, batch);
+        range_cnt -= batch;
     }
 }
 
@@ -379,9 +740,11 @@ static void mmu_remap_ranges(void)
         if ((flags >> 28) == 8) {
             printf("MMU: Adding Device-nGnRE mapping at 0x%lx (0x%lx)\n", addr, size);
             mmu_add_mapping(addr, addr, size, MAIR_IDX_DEVICE_nGnRE, PERM_RW_EL0);
+            mem_map_add(addr, size, MEM_MMIO);
         } else if (flags == 0x60004016) {
             printf("MMU: Adding Normal-NC mapping at 0x%lx (0x%lx)\n", addr, size);
             mmu_add_mapping(addr, addr, size, MAIR_IDX_NORMAL_NC, PERM_RW_EL0);
+            mem_map_add(addr, size, MEM_MMIO);
         }
 
         ranges += 6;
@@ -412,9 +775,12 @@ static void mmu_add_default_mappings(void)
      * This range includes all real RAM, including carveouts
      */
     mmu_add_mapping(ram_base, ram_base, cur_boot_args.mem_size_actual, MAIR_IDX_NORMAL, PERM_RWX);
+    mem_map_add(ram_base, cur_boot_args.mem_size_actual, MEM_RAM);
 
     /* Unmap carveout regions */
     mcc_unmap_carveouts();
+    for (size_t i = 0; i < mcc_carveout_count; i++)
+        mem_map_add(mcc_carveouts[i].base, mcc_carveouts[i].size, MEM_CARVEOUT);
 
     /*
      * Remap m1n1 executable code as RX.
@@ -427,32 +793,35 @@ static void mmu_add_default_mappings(void)
      */
     mmu_rm_mapping((u64)_stack_top, PAGE_SIZE);
 
-    /*
-     * Create mapping for RAM from 0x88_0000_0000,
-     * read/writable/exec by EL0 (but not executable by EL1)
-     * With SPRR enabled, this becomes RX_EL0.
-     */
-    mmu_add_mapping(ram_base | REGION_RWX_EL0, ram_base, ram_size, MAIR_IDX_NORMAL, PERM_RWX_EL0);
-    /*
-     * Create mapping for RAM from 0x98_0000_0000,
-     * read/writable by EL0 (but not executable by EL1)
-     * With SPRR enabled, this becomes RW_EL0.
-     */
-    mmu_add_mapping(ram_base | REGION_RW_EL0, ram_base, ram_size, MAIR_IDX_NORMAL, PERM_RW_EL0);
-    /*
-     * Create mapping for RAM from 0xa8_0000_0000,
-     * read/executable by EL1
-     * This allows executing from dynamic regions in EL1
-     */
-    mmu_add_mapping(ram_base | REGION_RX_EL1, ram_base, ram_size, MAIR_IDX_NORMAL, PERM_RX_EL0);
-
-    /*
-     * Create four separate full mappings of MMIO space, with different access types
-     */
-    mmu_add_mapping(0xc000000000, 0x0000000000, 0x0800000000, MAIR_IDX_DEVICE_GRE, PERM_RW_EL0);
-    mmu_add_mapping(0xd000000000, 0x0000000000, 0x0800000000, MAIR_IDX_DEVICE_nGRE, PERM_RW_EL0);
-    mmu_add_mapping(0xe000000000, 0x0000000000, 0x0800000000, MAIR_IDX_DEVICE_nGnRnE, PERM_RW_EL0);
-    mmu_add_mapping(0xf000000000, 0x0000000000, 0x0800000000, MAIR_IDX_DEVICE_nGnRE, PERM_RW_EL0);
+    const struct mmu_map_range alias_map[] = {
+        /*
+         * Create mapping for RAM from 0x88_0000_0000,
+         * read/writable/exec by EL0 (but not executable by EL1)
+         * With SPRR enabled, this becomes RX_EL0.
+         */
+        {ram_base | REGION_RWX_EL0, ram_base, ram_size, MAIR_IDX_NORMAL, PERM_RWX_EL0},
+        /*
+         * Create mapping for RAM from 0x98_0000_0000,
+         * read/writable by EL0 (but not executable by EL1)
+         * With SPRR enabled, this becomes RW_EL0.
+         */
+        {ram_base | REGION_RW_EL0, ram_base, ram_size, MAIR_IDX_NORMAL, PERM_RW_EL0},
+        /*
+         * Create mapping for RAM from 0xa8_0000_0000,
+         * read/executable by EL1
+         * This allows executing from dynamic regions in EL1
+         */
+        {ram_base | REGION_RX_EL1, ram_base, ram_size, MAIR_IDX_NORMAL, PERM_RX_EL0},
+
+        /*
+         * Create four separate full mappings of MMIO space, with different access types
+         */
+        {REGION_MMIO_GRE, 0x0000000000, REGION_MMIO_SIZE, MAIR_IDX_DEVICE_GRE, PERM_RW_EL0},
+        {REGION_MMIO_nGRE, 0x0000000000, REGION_MMIO_SIZE, MAIR_IDX_DEVICE_nGRE, PERM_RW_EL0},
+        {REGION_MMIO_nGnRnE, 0x0000000000, REGION_MMIO_SIZE, MAIR_IDX_DEVICE_nGnRnE, PERM_RW_EL0},
+        {REGION_MMIO_nGnRE, 0x0000000000, REGION_MMIO_SIZE, MAIR_IDX_DEVICE_nGnRE, PERM_RW_EL0},
+    };
+    mmu_map_ranges(alias_map, ARRAY_SIZE(alias_map));
 
     /*
      * Handle pmap-ranges
@@ -10,6 +10,13 @@
 #define REGION_RW_EL0  0xa0000000000
 #define REGION_RX_EL1  0xc0000000000
 
+/* Aliases of the first 32GB of MMIO space with alternative Device access types */
+#define REGION_MMIO_GRE    0xc000000000
+#define REGION_MMIO_nGRE   0xd000000000
+#define REGION_MMIO_nGnRnE 0xe000000000
+#define REGION_MMIO_nGnRE  0xf000000000
+#define REGION_MMIO_SIZE   0x0800000000
+
 /*
  * https://armv8-ref.codingbelief.com/en/chapter_d4/d43_2_armv8_translation_table_level_3_descriptor_formats.html
  * PTE_TYPE:PTE_BLOCK indicates that the page table entry (PTE) points to a physical memory block
@@ -24,7 +31,9 @@
 #define PTE_TABLE       1
 #define PTE_PAGE        1
 #define PTE_ACCESS      BIT(10)
-#define PTE_MAIR_IDX(i) ((i & 7) << 2)
+#define PTE_MAIR_IDX(i)   ((i & 7) << 2)
+#define PTE_MAIR_IDX_MASK (7 << 2)
+#define PTE_CONTIG      BIT(52)
 #define PTE_PXN         BIT(53)
 #define PTE_UXN         BIT(54)
 #define PTE_AP_RO       BIT(7)
@@ -59,10 +68,22 @@ extern uint64_t ram_base;
 void ic_ivau_range(void *addr, size_t length);
 void dc_ivac_range(void *addr, size_t length);
 void dc_zva_range(void *addr, size_t length);
+void memset_fast(void *dst, u64 value, size_t size);
 void dc_cvac_range(void *addr, size_t length);
 void dc_cvau_range(void *addr, size_t length);
 void dc_civac_range(void *addr, size_t length);
 
+/* As above, but large ranges are split across idle secondaries */
+void ic_ivau_range_par(void *addr, size_t length);
+void dc_ivac_range_par(void *addr, size_t length);
+void dc_civac_range_par(void *addr, size_t length);
+
+/*
+ * True if the whole range is mapped uncached (Device or Normal-NC); such
+ * ranges hold no cache lines and the dc_* maintenance helpers skip them.
+ */
+bool mmu_range_is_uncached(u64 addr, size_t length);
+
 #define DCSW_OP_DCISW  0x0
 #define DCSW_OP_DCCISW 0x1
 #define DCSW_OP_DCCSW  0x2
@@ -73,8 +94,43 @@ void mmu_init_secondary(int cpu);
 void mmu_shutdown(void);
 void mmu_add_mapping(u64 from, u64 to, size_t size, u8 attribute_index, u64 perms);
 void mmu_rm_mapping(u64 from, size_t size);
+
+struct mmu_map_range {
+    u64 from;
+    u64 to;
+    size_t size;
+    u8 attribute_index;
+    u64 perms;
+};
+
+/* Like mmu_add_mapping() for several ranges, with a single TLB flush at the end */
+void mmu_map_ranges(const struct mmu_map_range *ranges, size_t count);
 void mmu_map_framebuffer(u64 addr, size_t size);
 
+/*
+ * Physical memory map, recorded as a side effect of building the initial page
+ * tables: RAM, the /arm-io MMIO ranges and the MCC carveouts end up in one
+ * array sorted by base address, with contiguous same-type ranges merged.
+ * Later consumers can classify a physical address without re-walking the ADT.
+ */
+enum mem_region_type {
+    MEM_NONE = 0,
+    MEM_RAM,
+    MEM_MMIO,
+    MEM_CARVEOUT,
+};
+
+struct mem_region {
+    u64 base;
+    u64 size;
+    enum mem_region_type type;
+};
+
+void mem_map_add(u64 base, u64 size, enum mem_region_type type);
+const struct mem_region *mem_map_get(size_t *count);
+const struct mem_region *mem_map_lookup(u64 addr);
+const char *mem_region_type_name(enum mem_region_type type);
+
 u64 mmu_disable(void);
 void mmu_restore(u64 state);
 
@@ -83,6 +139,72 @@ static inline bool mmu_active(void)
     return mrs(SCTLR_EL1) & SCTLR_M;
 }
 
+/*
+ * The regular MMIO mappings are Device-nGnRnE, so every write stalls the CPU
+ * until the endpoint acknowledges it. The _relaxed accessors go through the
+ * Device-nGnRE alias at REGION_MMIO_nGnRE instead, where writes may be
+ * acknowledged early and posted towards the device. They remain ordered
+ * against other accesses to the same peripheral but complete asynchronously:
+ * finish a run of relaxed writes with mmio_sync() (or a readback) before
+ * doing anything that depends on the device having seen them.
+ *
+ * The alias only exists once the MMU is up and only covers the first 32GB of
+ * the address space (which excludes die 1 on multi-die chips); outside that
+ * window these fall back to the strongly-ordered accessors.
+ */
+static inline u64 mmio_relaxed(u64 addr)
+{
+    if (addr < REGION_MMIO_SIZE && mmu_active())
+        return addr | REGION_MMIO_nGnRE;
+    return addr;
+}
+
+static inline void write32_relaxed(u64 addr, u32 data)
+{
+    write32(mmio_relaxed(addr), data);
+}
+
+static inline void write64_relaxed(u64 addr, u64 data)
+{
+    write64(mmio_relaxed(addr), data);
+}
+
+static inline u32 set32_relaxed(u64 addr, u32 set)
+{
+    return set32(mmio_relaxed(addr), set);
+}
+
+static inline u32 clear32_relaxed(u64 addr, u32 clear)
+{
+    return clear32(mmio_relaxed(addr), clear);
+}
+
+static inline u8 mask8_relaxed(u64 addr, u8 clear, u8 set)
+{
+    return mask8(mmio_relaxed(addr), clear, set);
+}
+
+static inline u16 mask16_relaxed(u64 addr, u16 clear, u16 set)
+{
+    return mask16(mmio_relaxed(addr), clear, set);
+}
+
+static inline u32 mask32_relaxed(u64 addr, u32 clear, u32 set)
+{
+    return mask32(mmio_relaxed(addr), clear, set);
+}
+
+static inline u64 mask64_relaxed(u64 addr, u64 clear, u64 set)
+{
+    return mask64(mmio_relaxed(addr), clear, set);
+}
+
+/* Completes all outstanding relaxed MMIO writes */
+static inline void mmio_sync(void)
+{
+    sysop("dsb sy");
+}
+
 #endif
 
 #endif
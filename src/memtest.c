@@ -0,0 +1,166 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+ * Boot-time DRAM confidence test.
+ *
+ * The range under test is split into equal slices, one per idle CPU (plus the
+ * boot CPU), and each slice is scrubbed independently: inversion patterns
+ * written with non-temporal store pairs, and an address-in-address pass that
+ * catches address line faults. Slices are far larger than any cache level and
+ * the secondaries run with their caches off, so the readback is served by
+ * DRAM rather than a cached copy of the write.
+ *
+ * Secondaries cannot use atomics or see the boot CPU's cached stores, so each
+ * worker records failures into its own cache-line-aligned region of
+ * memtest_log.errors and returns its error count through the smp mailbox; the
+ * boot CPU compacts the regions after joining.
+ */
+
+#include "memtest.h"
+#include "memory.h"
+#include "smp.h"
+#include "string.h"
+#include "utils.h"
+
+struct memtest_log memtest_log = {
+    .magic = MEMTEST_MAGIC,
+    .ent_size = sizeof(struct memtest_error),
+    .max_errors = MEMTEST_MAX_ERRORS,
+};
+
+static const u64 memtest_patterns[] = {
+    0xaaaaaaaaaaaaaaaaUL,
+    0x5555555555555555UL,
+};
+
+#define MEMTEST_PASS_ADDR_ID ARRAY_SIZE(memtest_patterns)
+#define MEMTEST_ADDR_XOR     0x9e3779b97f4a7c15UL
+
+struct memtest_slice_state {
+    struct memtest_error *ebuf;
+    u64 recorded;
+    u64 errors;
+};
+
+static void memtest_record(struct memtest_slice_state *st, u64 addr, u64 expected, u64 actual,
+                           u64 pass)
+{
+    if (st->recorded < MEMTEST_ERRORS_PER_CPU) {
+        st->ebuf[st->recorded] = (struct memtest_error){
+            .addr = addr,
+            .expected = expected,
+            .actual = actual,
+            .pass = pass,
+        };
+        st->recorded++;
+    }
+    st->errors++;
+}
+
+static void memtest_verify(struct memtest_slice_state *st, u64 base, u64 size, u64 pattern,
+                           u64 pass)
+{
+    volatile u64 *p = (volatile u64 *)base;
+
+    for (u64 off = 0; off < size; off += 8) {
+        u64 val = *p++;
+        if (val != pattern)
+            memtest_record(st, base + off, pattern, val, pass);
+    }
+}
+
+static u64 memtest_slice(u64 base, u64 size, u64 passes, u64 slot)
+{
+    struct memtest_slice_state st = {
+        .ebuf = &memtest_log.errors[slot * MEMTEST_ERRORS_PER_CPU],
+    };
+
+    if (passes & MEMTEST_PASS_PATTERNS) {
+        for (u64 i = 0; i < ARRAY_SIZE(memtest_patterns); i++) {
+            memset_stnp((void *)base, memtest_patterns[i], size);
+            sysop("dsb sy");
+            memtest_verify(&st, base, size, memtest_patterns[i], i);
+        }
+    }
+
+    if (passes & MEMTEST_PASS_ADDR) {
+        volatile u64 *p = (volatile u64 *)base;
+        for (u64 off = 0; off < size; off += 8)
+            *p++ = (base + off) ^ MEMTEST_ADDR_XOR;
+        sysop("dsb sy");
+
+        p = (volatile u64 *)base;
+        for (u64 off = 0; off < size; off += 8) {
+            u64 expected = (base + off) ^ MEMTEST_ADDR_XOR;
+            u64 val = *p++;
+            if (val != expected)
+                memtest_record(&st, base + off, expected, val, MEMTEST_PASS_ADDR_ID);
+        }
+    }
+
+    return st.errors;
+}
+
+s64 memtest_run(u64 base, u64 size, u64 passes)
+{
+    // memset_stnp works in 64-byte blocks
+    if (!size || ((base | size) & 63) || !(passes & MEMTEST_PASS_ALL))
+        return -1;
+
+    int cpus[MEMTEST_MAX_CPUS];
+    int ncpus = smp_idle_cpus(CPU_TYPE_UNKNOWN, -1, cpus, MEMTEST_MAX_CPUS);
+
+    u64 start = mrs(CNTPCT_EL0);
+
+    memtest_log.count = 0;
+    memtest_log.bytes = size;
+    memset(memtest_log.errors, 0, sizeof(memtest_log.errors));
+    // Push the reset state to DRAM so MMU-off secondaries see it
+    dc_civac_range(&memtest_log, sizeof(memtest_log));
+
+    u64 chunk = ALIGN_UP(size / (ncpus + 1), 64);
+    u64 end = base + size;
+
+    struct smp_group group;
+    smp_group_init(&group);
+
+    for (int i = 0; i < ncpus; i++) {
+        u64 p = base + i * chunk;
+        // With the per-slice round-up, small ranges can run out before the workers do
+        u64 len = p < end ? min(chunk, end - p) : 0;
+        smp_group_call4(&group, cpus[i], memtest_slice, p, len, passes, i + 1);
+    }
+
+    u64 errors = 0;
+    u64 recorded[MEMTEST_MAX_CPUS + 1] = {0};
+    u64 p = base + (u64)ncpus * chunk;
+    if (p < end) {
+        u64 e = memtest_slice(p, end - p, passes, 0);
+        recorded[0] = min(e, (u64)MEMTEST_ERRORS_PER_CPU);
+        errors += e;
+    }
+
+    // Flush our own entries, then drop stale cached views of the workers'
+    dc_cvac_range(&memtest_log.errors[0], MEMTEST_ERRORS_PER_CPU * sizeof(struct memtest_error));
+
+    smp_group_wait(&group);
+    for (int i = 0; i < ncpus; i++) {
+        u64 e = group.retval[i];
+        recorded[i + 1] = min(e, (u64)MEMTEST_ERRORS_PER_CPU);
+        errors += e;
+    }
+
+    dc_ivac_range(&memtest_log.errors[MEMTEST_ERRORS_PER_CPU],
+                  (u64)ncpus * MEMTEST_ERRORS_PER_CPU * sizeof(struct memtest_error));
+
+    // Compact the per-worker regions into one dense array
+    u32 count = 0;
+    for (int i = 0; i <= ncpus; i++)
+        for (u64 j = 0; j < recorded[i]; j++)
+            memtest_log.errors[count++] = memtest_log.errors[i * MEMTEST_ERRORS_PER_CPU + j];
+
+    memtest_log.count = count;
+    memtest_log.elapsed = mrs(CNTPCT_EL0) - start;
+
+    return errors;
+}
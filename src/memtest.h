@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef MEMTEST_H
+#define MEMTEST_H
+
+#include "types.h"
+#include "utils.h"
+
+/*
+ * Parallel DRAM confidence test, invoked via P_MEMTEST_RUN. The range is split
+ * into one slice per idle CPU, each scrubbed with inversion patterns and an
+ * address-in-address pass. Failures land in memtest_log, read via
+ * P_MEMTEST_GET.
+ */
+
+#define MEMTEST_MAGIC 0x5453544d // 'MTST'
+
+#define MEMTEST_MAX_CPUS       8
+#define MEMTEST_ERRORS_PER_CPU 8
+#define MEMTEST_MAX_ERRORS     ((MEMTEST_MAX_CPUS + 1) * MEMTEST_ERRORS_PER_CPU)
+
+#define MEMTEST_PASS_PATTERNS BIT(0)
+#define MEMTEST_PASS_ADDR     BIT(1)
+#define MEMTEST_PASS_ALL      (MEMTEST_PASS_PATTERNS | MEMTEST_PASS_ADDR)
+
+struct memtest_error {
+    u64 addr;
+    u64 expected;
+    u64 actual;
+    u64 pass;
+};
+
+struct memtest_log {
+    u32 magic;
+    u32 ent_size;
+    u32 max_errors;
+    u32 count;
+    u64 bytes;
+    u64 elapsed;
+    /* One cache-line-aligned region per worker, compacted after each run */
+    struct memtest_error errors[MEMTEST_MAX_ERRORS] ALIGNED(64);
+};
+
+extern struct memtest_log memtest_log;
+
+s64 memtest_run(u64 base, u64 size, u64 passes);
+
+#endif
@@ -147,6 +147,38 @@ DtRepeatSymbol (
     //
     // Now rewrite the stream of past symbols forward into the dictionary.
     //
+    // When the match distance is at least a word, source and destination
+    // cannot overlap within a word, so copy a word at a time (the loads and
+    // stores are unaligned, which AArch64 handles natively). Matches this
+    // long dominate xz kernel decompression, so this path is the hot one.
+    //
+    if (Distance >= sizeof(uint64_t))
+    {
+        uint8_t* dest = &Dictionary.Buffer[Dictionary.Offset];
+        const uint8_t* source = dest - Distance;
+        uint64_t chunk;
+
+        Dictionary.Offset += Length;
+        __builtin_prefetch(source);
+        while (Length >= sizeof(chunk))
+        {
+            __builtin_memcpy(&chunk, source, sizeof(chunk));
+            __builtin_memcpy(dest, &chunk, sizeof(chunk));
+            source += sizeof(chunk);
+            dest += sizeof(chunk);
+            Length -= sizeof(chunk);
+        }
+        while (Length-- > 0)
+        {
+            *dest++ = *source++;
+        }
+        return true;
+    }
+
+    //
+    // Short distances self-overlap (they replicate a pattern), so they must
+    // be copied a symbol at a time.
+    //
     do
     {
         DtPutSymbol(DtGetSymbol(Distance));
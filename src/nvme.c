@@ -2,6 +2,7 @@
 
 #include "adt.h"
 #include "assert.h"
+#include "dma_pool.h"
 #include "malloc.h"
 #include "nvme.h"
 #include "pmgr.h"
@@ -65,6 +66,10 @@
 #define NVME_CMD_WRITE 0x01
 #define NVME_CMD_READ  0x02
 
+#define NVME_BLOCK_SIZE 4096
+/* one PRP list page covers the first PRP plus 512 list entries */
+#define NVME_MAX_BLOCKS (SZ_4K / sizeof(u64))
+
 struct nvme_command {
     u8 opcode;
     u8 flags;
@@ -114,8 +119,16 @@ struct nvme_queue {
     u8 cq_phase;
 
     bool adminq;
+
+    /* async command tracking (one bit per tag/slot) */
+    u64 inflight;
+    u64 done;
+    u16 status[NVME_QUEUE_SIZE];
+    u64 result[NVME_QUEUE_SIZE];
 };
 
+static_assert(NVME_QUEUE_SIZE <= 64, "tag bitmaps assume at most 64 slots");
+
 static_assert(sizeof(struct nvme_command) == 64, "invalid nvme_command size");
 static_assert(sizeof(struct nvme_completion) == 16, "invalid nvme_completion size");
 static_assert(sizeof(struct apple_nvmmu_tcb) == 128, "invalid apple_nvmmu_tcb size");
@@ -130,48 +143,56 @@ static sart_dev_t *nvme_sart = NULL;
 static u64 nvme_base;
 
 static struct nvme_queue adminq, ioq;
+static u64 *nvme_prp_list;
+
+/* batched streaming read state (one PRP page per tag) */
+static u64 *nvme_batch_prps;
+static u64 nvme_batch_tags;
+static bool nvme_batch_err;
+static struct {
+    u32 nsid;
+    u64 lba;
+    u32 count;
+    u64 buffer_addr;
+} nvme_batch;
 
 static bool alloc_queue(struct nvme_queue *q)
 {
     memset(q, 0, sizeof(*q));
 
-    q->tcbs = memalign(SZ_16K, NVME_QUEUE_SIZE * sizeof(*q->tcbs));
+    q->tcbs = dma_pool_alloc(NVME_QUEUE_SIZE * sizeof(*q->tcbs));
     if (!q->tcbs)
         return false;
 
-    q->cmds = memalign(SZ_16K, NVME_QUEUE_SIZE * sizeof(*q->cmds));
+    q->cmds = dma_pool_alloc(NVME_QUEUE_SIZE * sizeof(*q->cmds));
     if (!q->cmds)
         goto free_tcbs;
 
-    q->cqes = memalign(SZ_16K, NVME_QUEUE_SIZE * sizeof(*q->cqes));
+    q->cqes = dma_pool_alloc(NVME_QUEUE_SIZE * sizeof(*q->cqes));
     if (!q->cqes)
         goto free_cmds;
 
-    memset(q->tcbs, 0, NVME_QUEUE_SIZE * sizeof(*q->tcbs));
-    memset(q->cmds, 0, NVME_QUEUE_SIZE * sizeof(*q->cmds));
-    memset(q->cqes, 0, NVME_QUEUE_SIZE * sizeof(*q->cqes));
     q->cq_head = 0;
     q->cq_phase = 1;
     return true;
 
 free_cmds:
-    free(q->cmds);
+    dma_pool_free(q->cmds);
 free_tcbs:
-    free(q->tcbs);
+    dma_pool_free(q->tcbs);
     return false;
 }
 
 static void free_queue(struct nvme_queue *q)
 {
-    free(q->cmds);
-    free(q->tcbs);
-    free(q->cqes);
+    dma_pool_free(q->cmds);
+    dma_pool_free(q->tcbs);
+    dma_pool_free(q->cqes);
 }
 
 static void nvme_poll_syslog(void)
 {
-    struct rtkit_message msg;
-    rtkit_recv(nvme_rtkit, &msg);
+    rtkit_poll(nvme_rtkit);
 }
 
 static bool nvme_ctrl_disable(void)
@@ -208,11 +229,15 @@ static bool nvme_ctrl_shutdown(void)
     return FIELD_GET(NVME_CSTS_SHST, read32(nvme_base + NVME_CSTS)) == NVME_CSTS_SHST_DONE;
 }
 
-static bool nvme_exec_command(struct nvme_queue *q, struct nvme_command *cmd, u64 *result)
+static int nvme_submit_command(struct nvme_queue *q, struct nvme_command *cmd)
 {
-    bool found = false;
-    u64 timeout;
-    u8 tag = 0;
+    int tag = __builtin_ffsll(~q->inflight) - 1;
+
+    if (tag < 0 || tag >= NVME_QUEUE_SIZE) {
+        printf("nvme: no free command slots\n");
+        return -1;
+    }
+
     struct nvme_command *queue_cmd = &q->cmds[tag];
     struct apple_nvmmu_tcb *tcb = &q->tcbs[tag];
 
@@ -227,6 +252,9 @@ static bool nvme_exec_command(struct nvme_queue *q, struct nvme_command *cmd, u6
     tcb->prp1 = queue_cmd->prp1;
     tcb->prp2 = queue_cmd->prp2;
 
+    q->inflight |= BIT(tag);
+    q->done &= ~BIT(tag);
+
     /* make sure ANS2 can see the command and tcb before triggering it */
     dma_wmb();
 
@@ -237,23 +265,30 @@ static bool nvme_exec_command(struct nvme_queue *q, struct nvme_command *cmd, u6
         write32(nvme_base + NVME_DB_LINEAR_IOSQ, tag);
     nvme_poll_syslog();
 
-    timeout = timeout_calculate(NVME_TIMEOUT);
+    return tag;
+}
+
+static int nvme_process_completions(struct nvme_queue *q)
+{
     struct nvme_completion cqe;
-    while (!timeout_expired(timeout)) {
-        nvme_poll_syslog();
+    int reaped = 0;
+
+    nvme_poll_syslog();
 
+    while (true) {
         /* we need a DMA read barrier here since the CQ will be updated using DMA */
         dma_rmb();
         memcpy(&cqe, &q->cqes[q->cq_head], sizeof(cqe));
         if ((cqe.status & 1) != q->cq_phase)
-            continue;
+            break;
 
-        if (cqe.tag == tag) {
-            found = true;
-            if (result)
-                *result = cqe.result;
+        if (cqe.tag < NVME_QUEUE_SIZE && (q->inflight & BIT(cqe.tag))) {
+            q->inflight &= ~BIT(cqe.tag);
+            q->done |= BIT(cqe.tag);
+            q->status[cqe.tag] = cqe.status >> 1;
+            q->result[cqe.tag] = cqe.result;
         } else {
-            printf("nvme: invalid tag in CQ: expected %d but got %d\n", tag, cqe.tag);
+            printf("nvme: unexpected tag in CQ: %d\n", cqe.tag);
         }
 
         write32(nvme_base + NVMMU_TCB_INVAL, cqe.tag);
@@ -266,32 +301,68 @@ static bool nvme_exec_command(struct nvme_queue *q, struct nvme_command *cmd, u6
             q->cq_head = 0;
             q->cq_phase ^= 1;
         }
+        reaped++;
+    }
 
+    /* batch the CQ doorbell update over everything reaped in this pass */
+    if (reaped) {
         if (q->adminq)
             write32(nvme_base + NVME_DB_ACQ, q->cq_head);
         else
             write32(nvme_base + NVME_DB_IOCQ, q->cq_head);
-        break;
     }
 
-    if (!found) {
+    return reaped;
+}
+
+static bool nvme_wait_tag(struct nvme_queue *q, int tag, u64 *result)
+{
+    u64 timeout = timeout_calculate(NVME_TIMEOUT);
+
+    while (!(q->done & BIT(tag)) && !timeout_expired(timeout))
+        nvme_process_completions(q);
+
+    if (!(q->done & BIT(tag))) {
         printf("nvme: could not find command completion in CQ\n");
         return false;
     }
 
-    cqe.status >>= 1;
-    if (cqe.status) {
-        printf("nvme: command failed with status %d\n", cqe.status);
+    q->done &= ~BIT(tag);
+
+    if (result)
+        *result = q->result[tag];
+
+    if (q->status[tag]) {
+        printf("nvme: command failed with status %d\n", q->status[tag]);
         return false;
     }
 
     return true;
 }
 
+static bool nvme_exec_command(struct nvme_queue *q, struct nvme_command *cmd, u64 *result)
+{
+    int tag = nvme_submit_command(q, cmd);
+
+    if (tag < 0)
+        return false;
+
+    return nvme_wait_tag(q, tag, result);
+}
+
+/*
+ * Clients are reference counted and release is lazy: when the last client
+ * calls nvme_shutdown(), the ANS is left up ("warm"), so the next
+ * nvme_init() in the same session costs nothing instead of re-paying the ~1s
+ * RTKit boot. The boot handoff paths use nvme_shutdown_now(), which always
+ * performs the real teardown — the next stage expects ANS asleep and reset.
+ */
+static int nvme_clients;
+
 bool nvme_init(void)
 {
     if (nvme_initialized) {
-        printf("nvme: already initialized\n");
+        nvme_clients++;
         return true;
     }
 
@@ -327,6 +398,12 @@ bool nvme_init(void)
     ioq.adminq = false;
     adminq.adminq = true;
 
+    nvme_prp_list = dma_pool_alloc(SZ_4K);
+    if (!nvme_prp_list) {
+        printf("nvme: Error allocating PRP list\n");
+        goto out_ioq;
+    }
+
     nvme_asc = asc_init("/arm-io/ans");
     if (!nvme_asc)
         goto out_ioq;
@@ -396,6 +473,7 @@ bool nvme_init(void)
     }
 
     nvme_initialized = true;
+    nvme_clients = 1;
     printf("nvme: initialized at 0x%lx\n", nvme_base);
     return true;
 
@@ -421,6 +499,8 @@ out_sart:
 out_asc:
     asc_free(nvme_asc);
 out_ioq:
+    dma_pool_free(nvme_prp_list);
+    nvme_prp_list = NULL;
     free_queue(&ioq);
 out_adminq:
     free_queue(&adminq);
@@ -473,6 +553,18 @@ fail:
 }
 
 void nvme_shutdown(void)
+{
+    if (!nvme_initialized)
+        return;
+
+    if (nvme_clients && --nvme_clients)
+        return;
+
+    /* keep the controller warm; nvme_shutdown_now() does the real teardown */
+    printf("nvme: no clients left, keeping ANS up\n");
+}
+
+void nvme_shutdown_now(void)
 {
     if (!nvme_initialized) {
         // nvme_ensure_shutdown();
@@ -505,9 +597,18 @@ void nvme_shutdown(void)
     rtkit_free(nvme_rtkit);
     sart_free(nvme_sart);
     asc_free(nvme_asc);
+    dma_pool_free(nvme_prp_list);
+    nvme_prp_list = NULL;
+    if (nvme_batch_prps) {
+        dma_pool_free(nvme_batch_prps);
+        nvme_batch_prps = NULL;
+    }
+    nvme_batch_tags = 0;
+    nvme_batch.count = 0;
     free_queue(&ioq);
     free_queue(&adminq);
     nvme_initialized = false;
+    nvme_clients = 0;
 
     printf("nvme: shutdown done\n");
 }
@@ -548,3 +649,214 @@ bool nvme_read(u32 nsid, u64 lba, void *buffer)
 
     return nvme_exec_command(&ioq, &cmd, NULL);
 }
+
+static bool nvme_rw_blocks(u32 nsid, u64 lba, u32 count, void *buffer, bool write)
+{
+    struct nvme_command cmd;
+    u64 buffer_addr = (u64)buffer;
+
+    if (!nvme_initialized)
+        return false;
+
+    /* no need for 16K alignment here since the NVME page size is 4k */
+    if (buffer_addr & (SZ_4K - 1))
+        return false;
+
+    while (count) {
+        u32 blocks = min(count, (u32)NVME_MAX_BLOCKS);
+
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.opcode = write ? NVME_CMD_WRITE : NVME_CMD_READ;
+        cmd.nsid = nsid;
+        cmd.prp1 = buffer_addr;
+        if (blocks == 2) {
+            cmd.prp2 = buffer_addr + NVME_BLOCK_SIZE;
+        } else if (blocks > 2) {
+            /* chain the remaining pages through the PRP list */
+            for (u32 i = 0; i < blocks - 1; i++)
+                nvme_prp_list[i] = buffer_addr + (i + 1) * (u64)NVME_BLOCK_SIZE;
+            cmd.prp2 = (u64)nvme_prp_list;
+        }
+        cmd.cdw10 = lba;
+        cmd.cdw11 = lba >> 32;
+        cmd.cdw12 = blocks;
+
+        if (!nvme_exec_command(&ioq, &cmd, NULL))
+            return false;
+
+        lba += blocks;
+        count -= blocks;
+        buffer_addr += blocks * (u64)NVME_BLOCK_SIZE;
+    }
+
+    return true;
+}
+
+bool nvme_read_blocks(u32 nsid, u64 lba, u32 count, void *buffer)
+{
+    return nvme_rw_blocks(nsid, lba, count, buffer, false);
+}
+
+bool nvme_write_blocks(u32 nsid, u64 lba, u32 count, void *buffer)
+{
+    return nvme_rw_blocks(nsid, lba, count, buffer, true);
+}
+
+int nvme_read_async(u32 nsid, u64 lba, void *buffer)
+{
+    struct nvme_command cmd;
+    u64 buffer_addr = (u64)buffer;
+
+    if (!nvme_initialized)
+        return -1;
+
+    /* no need for 16K alignment here since the NVME page size is 4k */
+    if (buffer_addr & (SZ_4K - 1))
+        return -1;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = NVME_CMD_READ;
+    cmd.nsid = nsid;
+    cmd.prp1 = (u64)buffer_addr;
+    cmd.cdw10 = lba;
+    cmd.cdw11 = lba >> 32;
+    cmd.cdw12 = 1; // 4096 bytes
+
+    return nvme_submit_command(&ioq, &cmd);
+}
+
+int nvme_poll_async(int tag)
+{
+    if (!nvme_initialized || tag < 0 || tag >= NVME_QUEUE_SIZE)
+        return -1;
+
+    nvme_process_completions(&ioq);
+
+    if (!(ioq.done & BIT(tag)))
+        return 0;
+
+    ioq.done &= ~BIT(tag);
+    return ioq.status[tag] ? -1 : 1;
+}
+
+bool nvme_wait_async(int tag)
+{
+    if (!nvme_initialized || tag < 0 || tag >= NVME_QUEUE_SIZE)
+        return false;
+
+    return nvme_wait_tag(&ioq, tag, NULL);
+}
+
+/*
+ * Batched streaming reads. The synchronous multi-block path funnels every
+ * command through the single shared PRP list, so only one large command can
+ * exist at a time. Here each tag gets its own PRP page, letting us keep the
+ * whole IO queue full of 2MB commands: 64 slots cover 128MB queued up front,
+ * so even a large image streams autonomously while the CPU is busy elsewhere
+ * (e.g. device tree preparation during boot). nvme_read_blocks_poll() reaps
+ * completions and tops the queue back up.
+ */
+static void nvme_batch_submit(void)
+{
+    struct nvme_command cmd;
+
+    while (nvme_batch.count) {
+        /*
+         * Peek the tag nvme_submit_command() will pick so we can build the
+         * PRP list in that tag's page before the command is triggered.
+         */
+        int tag = __builtin_ffsll(~ioq.inflight) - 1;
+        if (tag < 0 || tag >= NVME_QUEUE_SIZE)
+            return; // queue full, the next poll will continue
+
+        u32 blocks = min(nvme_batch.count, (u32)NVME_MAX_BLOCKS);
+
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.opcode = NVME_CMD_READ;
+        cmd.nsid = nvme_batch.nsid;
+        cmd.prp1 = nvme_batch.buffer_addr;
+        if (blocks == 2) {
+            cmd.prp2 = nvme_batch.buffer_addr + NVME_BLOCK_SIZE;
+        } else if (blocks > 2) {
+            u64 *prps = nvme_batch_prps + tag * (SZ_4K / sizeof(u64));
+            for (u32 i = 0; i < blocks - 1; i++)
+                prps[i] = nvme_batch.buffer_addr + (i + 1) * (u64)NVME_BLOCK_SIZE;
+            cmd.prp2 = (u64)prps;
+        }
+        cmd.cdw10 = nvme_batch.lba;
+        cmd.cdw11 = nvme_batch.lba >> 32;
+        cmd.cdw12 = blocks;
+
+        if (nvme_submit_command(&ioq, &cmd) != tag)
+            return;
+
+        nvme_batch_tags |= BIT(tag);
+        nvme_batch.lba += blocks;
+        nvme_batch.count -= blocks;
+        nvme_batch.buffer_addr += blocks * (u64)NVME_BLOCK_SIZE;
+    }
+}
+
+int nvme_read_blocks_start(u32 nsid, u64 lba, u32 count, void *buffer)
+{
+    u64 buffer_addr = (u64)buffer;
+
+    if (!nvme_initialized || !count)
+        return -1;
+
+    /* one batch at a time */
+    if (nvme_batch_tags || nvme_batch.count)
+        return -1;
+
+    /* no need for 16K alignment here since the NVME page size is 4k */
+    if (buffer_addr & (SZ_4K - 1))
+        return -1;
+
+    if (!nvme_batch_prps) {
+        nvme_batch_prps = dma_pool_alloc(NVME_QUEUE_SIZE * SZ_4K);
+        if (!nvme_batch_prps)
+            return -1;
+    }
+
+    nvme_batch.nsid = nsid;
+    nvme_batch.lba = lba;
+    nvme_batch.count = count;
+    nvme_batch.buffer_addr = buffer_addr;
+    nvme_batch_err = false;
+    nvme_batch_submit();
+
+    return 0;
+}
+
+int nvme_read_blocks_poll(void)
+{
+    if (!nvme_initialized)
+        return -1;
+
+    nvme_process_completions(&ioq);
+
+    u64 done = nvme_batch_tags & ioq.done;
+    while (done) {
+        int tag = __builtin_ffsll(done) - 1;
+
+        done &= ~BIT(tag);
+        ioq.done &= ~BIT(tag);
+        nvme_batch_tags &= ~BIT(tag);
+        if (ioq.status[tag]) {
+            printf("nvme: batched read failed with status %d\n", ioq.status[tag]);
+            nvme_batch_err = true;
+        }
+    }
+
+    if (nvme_batch_err) {
+        /* let the in-flight remainder drain, but submit nothing new */
+        if (nvme_batch_tags)
+            return 0;
+        nvme_batch.count = 0;
+        return -1;
+    }
+
+    nvme_batch_submit();
+
+    return (nvme_batch_tags || nvme_batch.count) ? 0 : 1;
+}
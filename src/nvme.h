@@ -5,10 +5,40 @@
 
 #include "types.h"
 
+/*
+ * Clients are reference counted: nvme_init()/nvme_shutdown() pair up, and
+ * releasing the last client keeps the ANS warm so repeated disk access phases
+ * don't re-pay the RTKit boot. nvme_shutdown_now() forces the real teardown
+ * (used before handing off to the next boot stage).
+ */
 bool nvme_init(void);
 void nvme_shutdown(void);
+void nvme_shutdown_now(void);
 
 bool nvme_flush(u32 nsid);
 bool nvme_read(u32 nsid, u64 lba, void *buffer);
 
+/* Multi-block transfers (4096-byte blocks, PRP-list backed, up to 2MB/command) */
+bool nvme_read_blocks(u32 nsid, u64 lba, u32 count, void *buffer);
+bool nvme_write_blocks(u32 nsid, u64 lba, u32 count, void *buffer);
+
+/*
+ * Asynchronous reads: nvme_read_async() returns a command tag (or -1) with the
+ * command left in flight, so callers can keep the IO queue full. Completion is
+ * checked with nvme_poll_async() (1 = done, 0 = pending, -1 = error) or waited
+ * for with nvme_wait_async().
+ */
+int nvme_read_async(u32 nsid, u64 lba, void *buffer);
+int nvme_poll_async(int tag);
+bool nvme_wait_async(int tag);
+
+/*
+ * Batched streaming read: nvme_read_blocks_start() queues the whole transfer
+ * as pipelined large commands (one batch at a time), then
+ * nvme_read_blocks_poll() reaps and refills (1 = done, 0 = pending,
+ * -1 = error).
+ */
+int nvme_read_blocks_start(u32 nsid, u64 lba, u32 count, void *buffer);
+int nvme_read_blocks_poll(void);
+
 #endif
@@ -9,9 +9,13 @@
 #include "chainload.h"
 #include "cpufreq.h"
 #include "display.h"
+#include "evtlog.h"
+#include "hash.h"
 #include "heapblock.h"
 #include "kboot.h"
+#include "memory.h"
 #include "smp.h"
+#include "usb.h"
 #include "utils.h"
 
 #include "libfdt/libfdt.h"
@@ -28,6 +32,7 @@ static const u8 kernel_magic[] = {'A', 'R', 'M', 0x64};          // at 0x38
 static const u8 cpio_magic[] = {'0', '7', '0', '7', '0'};        // '1' or '2' next
 static const u8 img4_magic[] = {0x16, 0x04, 'I', 'M', 'G', '4'}; // IA5String 'IMG4'
 static const u8 sig_magic[] = {'m', '1', 'n', '1', '_', 's', 'i', 'g'};
+static const u8 par_magic[] = {'m', '1', 'n', '1', '_', 'p', 'a', 'r'};
 static const u8 initramfs_magic[] = {
     'm', '1', 'n', '1', '_', 'i', 'n',
     'i', 't', 'r', 'a', 'm', 'f', 's'}; // followed by size as little endian uint32_t
@@ -57,8 +62,29 @@ static void finalize_uncompression(void *dest, size_t dest_len)
     }
 }
 
+/*
+ * When iBoot hands over with the clusters idling at a low P-State, the
+ * compute-heavy boot phases (payload decompression, cache flushes before
+ * boot) crawl. Bring the clusters up to their full boot P-States before the
+ * first decompression rather than waiting for the kernel boot path; this is
+ * the same state cpufreq_init() always programs, so there is nothing to
+ * drop back down afterwards.
+ */
+static bool clocks_boosted;
+
+static void boost_clocks(void)
+{
+    if (clocks_boosted)
+        return;
+
+    cpufreq_init();
+    clocks_boosted = true;
+}
+
 static void *decompress_gz(void *p, size_t size)
 {
+    boost_clocks();
+
     unsigned int source_len = size, dest_len = 1 << 30; // 1 GiB should be enough hopefully
 
     // Start at the end of the heap area, no allocation yet. The following code must not use
@@ -66,6 +92,7 @@ static void *decompress_gz(void *p, size_t size)
     void *dest = heapblock_alloc_aligned(0, KERNEL_ALIGN);
 
     printf("Uncompressing... ");
+    EVT(DECOMPRESS_START, size >> 10);
     int ret = tinf_gzip_uncompress(dest, &dest_len, p, &source_len);
 
     if (ret != TINF_OK) {
@@ -74,6 +101,7 @@ static void *decompress_gz(void *p, size_t size)
     }
 
     printf("%d bytes uncompressed to %d bytes\n", source_len, dest_len);
+    EVT(DECOMPRESS_DONE, dest_len >> 10);
 
     finalize_uncompression(dest, dest_len);
 
@@ -82,6 +110,8 @@ static void *decompress_gz(void *p, size_t size)
 
 static void *decompress_xz(void *p, size_t size)
 {
+    boost_clocks();
+
     uint32_t source_len = size, dest_len = 1 << 30; // 1 GiB should be enough hopefully
 
     // Start at the end of the heap area, no allocation yet. The following code must not use
@@ -89,6 +119,7 @@ static void *decompress_xz(void *p, size_t size)
     void *dest = heapblock_alloc_aligned(0, KERNEL_ALIGN);
 
     printf("Uncompressing... ");
+    EVT(DECOMPRESS_START, size >> 10);
     int ret = XzDecode(p, &source_len, dest, &dest_len);
 
     if (!ret) {
@@ -97,12 +128,153 @@ static void *decompress_xz(void *p, size_t size)
     }
 
     printf("%d bytes uncompressed to %d bytes\n", source_len, dest_len);
+    EVT(DECOMPRESS_DONE, dest_len >> 10);
 
     finalize_uncompression(dest, dest_len);
 
     return ((u8 *)p) + source_len;
 }
 
+/*
+ * Parallel compressed container: a "m1n1_par" header framing independently
+ * compressed gzip/xz members, which lets us fan decompression out across the
+ * secondary cores instead of unpacking the whole image on the boot CPU.
+ */
+struct par_member {
+    u64 comp_off;
+    u64 comp_size;
+    u64 dest_off;
+    u64 dest_size;
+};
+
+struct par_header {
+    u8 magic[8];
+    u32 members;
+    u32 _pad;
+    struct par_member member[];
+};
+
+#define PAR_MAX_MEMBERS 64
+
+u64 payload_decompress_member(u64 src, u64 src_size, u64 dst, u64 dst_size)
+{
+    if (src_size >= sizeof(gz_magic) && !memcmp((void *)src, gz_magic, sizeof(gz_magic))) {
+        unsigned int s = src_size, d = dst_size;
+        if (tinf_gzip_uncompress((void *)dst, &d, (void *)src, &s) != TINF_OK)
+            return 0;
+        return d;
+    } else if (src_size >= sizeof(xz_magic) && !memcmp((void *)src, xz_magic, sizeof(xz_magic))) {
+        u32 s = src_size, d = dst_size;
+        if (!XzDecode((void *)src, &s, (void *)dst, &d))
+            return 0;
+        return d;
+    }
+
+    return 0;
+}
+
+static void *decompress_par(void *p, size_t size)
+{
+    struct par_header *hdr = p;
+
+    boost_clocks();
+    UNUSED(size);
+
+    if (!hdr->members || hdr->members > PAR_MAX_MEMBERS) {
+        printf("Bad parallel container member count %d\n", hdr->members);
+        return NULL;
+    }
+
+    size_t dest_len = 0;
+    u64 comp_end = 0;
+    for (u32 i = 0; i < hdr->members; i++) {
+        dest_len = max(dest_len, hdr->member[i].dest_off + hdr->member[i].dest_size);
+        comp_end = max(comp_end, hdr->member[i].comp_off + hdr->member[i].comp_size);
+    }
+
+    // Start at the end of the heap area, no allocation yet. The following code must not use
+    // malloc or heapblock, until finalize_uncompression is called.
+    void *dest = heapblock_alloc_aligned(0, KERNEL_ALIGN);
+
+    smp_start_secondaries();
+
+    // The secondaries run with their MMU (and thus caches) off, so push the
+    // compressed data to PoC and make sure no dirty destination lines can
+    // evict over their output.
+    dc_cvac_range(p, comp_end);
+    dc_civac_range_par(dest, dest_len);
+
+    printf("Uncompressing (%d members in parallel)... ", hdr->members);
+    EVT(DECOMPRESS_START, comp_end >> 10);
+
+    u32 m = 0;
+    bool ok = true;
+    while (m < hdr->members && ok) {
+        struct smp_group group;
+
+        smp_group_init(&group);
+
+        for (int cpu = 0; cpu < MAX_CPUS && m + 1 < hdr->members; cpu++) {
+            if (cpu == boot_cpu_idx || !smp_is_alive(cpu))
+                continue;
+
+            const struct par_member *mb = &hdr->member[m++];
+            smp_group_call4(&group, cpu, payload_decompress_member, (u64)p + mb->comp_off,
+                            mb->comp_size, (u64)dest + mb->dest_off, mb->dest_size);
+        }
+
+        // The boot CPU takes the next member itself instead of idling
+        const struct par_member *mb = &hdr->member[m++];
+        if (!payload_decompress_member((u64)p + mb->comp_off, mb->comp_size, (u64)dest + mb->dest_off,
+                                   mb->dest_size))
+            ok = false;
+        dc_cvac_range((u8 *)dest + mb->dest_off, mb->dest_size);
+
+        smp_group_wait(&group);
+        for (int i = 0; i < group.ncpus; i++)
+            if (!group.retval[i])
+                ok = false;
+    }
+
+    // Drop any stale cached view of what the secondaries wrote
+    dc_ivac_range_par(dest, dest_len);
+
+    /*
+     * The decompressors verify their output, but through the secondaries'
+     * uncached view. Recheck gzip members (whose trailer carries a CRC32 of
+     * the uncompressed data) from our cached view, so a slip in the cache
+     * dance above cannot boot a corrupted kernel. XZ members only embed
+     * block-level checks, so they are covered by the decode alone.
+     */
+    for (u32 i = 0; i < hdr->members && ok; i++) {
+        const struct par_member *mb = &hdr->member[i];
+        const u8 *comp = (u8 *)p + mb->comp_off;
+        u32 want, isize;
+
+        if (mb->comp_size < 18 || memcmp(comp, gz_magic, sizeof gz_magic))
+            continue;
+
+        memcpy(&want, comp + mb->comp_size - 8, 4);
+        memcpy(&isize, comp + mb->comp_size - 4, 4);
+        if (isize > mb->dest_size || crc32((u8 *)dest + mb->dest_off, isize) != want) {
+            printf("Member %d failed verification\n", i);
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        printf("Error\n");
+        return NULL;
+    }
+
+    printf("%ld bytes uncompressed to %ld bytes\n", comp_end, dest_len);
+
+    EVT(DECOMPRESS_DONE, dest_len >> 10);
+    finalize_uncompression(dest, dest_len);
+
+    return ((u8 *)p) + comp_end;
+}
+
 static void *load_fdt(void *p, size_t size)
 {
     if (fdt_node_check_compatible(p, 0, expect_compatible) == 0) {
@@ -170,6 +342,28 @@ static char *chosen[MAX_CHOSEN_VARS];
 #endif
 
 static bool enable_tso = false;
+static u64 kernel_dest = 0;
+
+static u64 parse_addr(const char *s)
+{
+    u64 val = 0;
+
+    if (s[0] != '0' || (s[1] != 'x' && s[1] != 'X'))
+        return atol(s);
+
+    for (s += 2; *s; s++) {
+        if (*s >= '0' && *s <= '9')
+            val = (val << 4) | (*s - '0');
+        else if (*s >= 'a' && *s <= 'f')
+            val = (val << 4) | (*s - 'a' + 10);
+        else if (*s >= 'A' && *s <= 'F')
+            val = (val << 4) | (*s - 'A' + 10);
+        else
+            break;
+    }
+
+    return val;
+}
 
 static bool check_var(u8 **p)
 {
@@ -197,6 +391,11 @@ static bool check_var(u8 **p)
         display_configure(val);
     } else if (IS_VAR("tso=")) {
         enable_tso = val[0] == '1';
+    } else if (IS_VAR("kernel_base=")) {
+        kernel_dest = parse_addr(val);
+    } else if (IS_VAR("usb_handoff=")) {
+        if (val[0] == '1')
+            usb_set_handoff();
     } else {
         printf("Unknown variable %s\n", *p);
     }
@@ -212,7 +411,10 @@ static void *load_one_payload(void *start, size_t size)
     if (!start)
         return NULL;
 
-    if (!memcmp(p, gz_magic, sizeof gz_magic)) {
+    if (!memcmp(p, par_magic, sizeof par_magic)) {
+        printf("Found a parallel compressed payload at %p\n", p);
+        return decompress_par(p, size);
+    } else if (!memcmp(p, gz_magic, sizeof gz_magic)) {
         printf("Found a gzip compressed payload at %p\n", p);
         return decompress_gz(p, size);
     } else if (!memcmp(p, xz_magic, sizeof xz_magic)) {
@@ -275,17 +477,36 @@ int payload_run(void)
 
     chosen_cnt = 0;
 
+    EVT(PAYLOAD_SCAN, 0);
     void *p = _payload_start;
 
     while (p)
         p = load_one_payload(p, 0);
 
+    /*
+     * Optional placement pin (kernel_base= variable). DRAM on these parts is
+     * channel-interleaved across all MCCs, so there is no "better die" to
+     * select automatically, but experiments measuring placement-dependent
+     * throughput (e.g. against MCC cache carveouts) can pin the kernel
+     * wherever they want. The caller is responsible for picking a free,
+     * KERNEL_ALIGN-aligned range.
+     */
+    if (kernel && kernel_dest && (u64)kernel != kernel_dest) {
+        if (kernel_dest & (KERNEL_ALIGN - 1)) {
+            printf("Ignoring misaligned kernel_base 0x%lx\n", kernel_dest);
+        } else {
+            printf("Moving kernel to pinned base 0x%lx\n", kernel_dest);
+            memcpy((void *)kernel_dest, kernel, kernel->image_size);
+            kernel = (void *)kernel_dest;
+        }
+    }
+
     if (chainload_spec) {
         return chainload_load(chainload_spec, chosen, chosen_cnt);
     }
 
     if (kernel && fdt) {
-        cpufreq_init();
+        boost_clocks();
         smp_start_secondaries();
         if (enable_tso) {
 
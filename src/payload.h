@@ -3,6 +3,11 @@
 #ifndef __PAYLOAD_H__
 #define __PAYLOAD_H__
 
+#include "types.h"
+
 int payload_run(void);
 
+/* Decompress a single gzip/xz member; returns output size or 0 on failure */
+u64 payload_decompress_member(u64 src, u64 src_size, u64 dst, u64 dst_size);
+
 #endif
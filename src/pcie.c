@@ -1,6 +1,8 @@
 /* SPDX-License-Identifier: MIT */
 
 #include "adt.h"
+#include "bootprofile.h"
+#include "memory.h"
 #include "pcie.h"
 #include "pmgr.h"
 #include "string.h"
@@ -462,9 +464,17 @@ static int pcie_init_controller(int controller, const char *path)
         pmgr_adt_power_disable_index(path, 1);
     }
 
+    /*
+     * Port bring-up is split into phases so link training overlaps: phase 1
+     * configures each port and releases PERST, then one combined wait lets
+     * all links train concurrently, and phase 2 finishes per-port setup.
+     * Total time is set by the slowest port instead of the sum of all ports.
+     */
+    bool port_active[8] = {false};
+    u64 port_config_base[8];
+
     for (u32 port = 0; port < state->port_count; port++) {
         char bridge[64];
-        int bridge_offset;
 
         /*
          * Initialize RC port.
@@ -482,7 +492,7 @@ static int pcie_init_controller(int controller, const char *path)
                 break;
         }
 
-        if ((bridge_offset = adt_path_offset(adt, bridge)) < 0)
+        if (adt_path_offset(adt, bridge) < 0)
             continue;
 
         printf("pcie: Initializing port %d\n", port);
@@ -528,33 +538,34 @@ static int pcie_init_controller(int controller, const char *path)
 
             // ??????
             if (controller == APCIE)
-                write32(state->port_base[port] + 0x10, 0x2);
-            write32(state->port_base[port] + 0x88, 0x110);
-            write32(state->port_base[port] + 0x100, 0xffffffff);
-            write32(state->port_base[port] + 0x148, 0xffffffff);
-            write32(state->port_base[port] + 0x210, 0xffffffff);
-            write32(state->port_base[port] + 0x80, 0x0);
-            write32(state->port_base[port] + 0x84, 0x0);
-            write32(state->port_base[port] + 0x104, 0x7fffffff);
-            write32(state->port_base[port] + 0x124, 0x100);
-            write32(state->port_base[port] + 0x16c, 0x0);
-            write32(state->port_base[port] + 0x13c, 0x10);
-            write32(state->port_base[port] + 0x800, 0x100100);
-            write32(state->port_base[port] + 0x808, 0x1000ff);
-            write32(state->port_base[port] + 0x82c, 0x0);
+                write32_relaxed(state->port_base[port] + 0x10, 0x2);
+            write32_relaxed(state->port_base[port] + 0x88, 0x110);
+            write32_relaxed(state->port_base[port] + 0x100, 0xffffffff);
+            write32_relaxed(state->port_base[port] + 0x148, 0xffffffff);
+            write32_relaxed(state->port_base[port] + 0x210, 0xffffffff);
+            write32_relaxed(state->port_base[port] + 0x80, 0x0);
+            write32_relaxed(state->port_base[port] + 0x84, 0x0);
+            write32_relaxed(state->port_base[port] + 0x104, 0x7fffffff);
+            write32_relaxed(state->port_base[port] + 0x124, 0x100);
+            write32_relaxed(state->port_base[port] + 0x16c, 0x0);
+            write32_relaxed(state->port_base[port] + 0x13c, 0x10);
+            write32_relaxed(state->port_base[port] + 0x800, 0x100100);
+            write32_relaxed(state->port_base[port] + 0x808, 0x1000ff);
+            write32_relaxed(state->port_base[port] + 0x82c, 0x0);
             for (int i = 0; i < 512; i++)
-                write32(state->port_base[port] + APCIE_T602X_PORT_MSIMAP + 4 * i, 0);
-            write32(state->port_base[port] + 0x397c, 0x0);
+                write32_relaxed(state->port_base[port] + APCIE_T602X_PORT_MSIMAP + 4 * i, 0);
+            write32_relaxed(state->port_base[port] + 0x397c, 0x0);
             if (controller == APCIE)
-                write32(state->port_base[port] + 0x130, 0x3000000);
+                write32_relaxed(state->port_base[port] + 0x130, 0x3000000);
             else
-                write32(state->port_base[port] + 0x130, 0x3000008);
-            write32(state->port_base[port] + 0x140, 0x10);
-            write32(state->port_base[port] + 0x144, 0x253770);
-            write32(state->port_base[port] + 0x21c, 0x0);
-            write32(state->port_base[port] + 0x834, 0x0);
+                write32_relaxed(state->port_base[port] + 0x130, 0x3000008);
+            write32_relaxed(state->port_base[port] + 0x140, 0x10);
+            write32_relaxed(state->port_base[port] + 0x144, 0x253770);
+            write32_relaxed(state->port_base[port] + 0x21c, 0x0);
+            write32_relaxed(state->port_base[port] + 0x834, 0x0);
             if (controller != APCIE)
-                write32(state->port_base[port] + 0x83c, 0x0);
+                write32_relaxed(state->port_base[port] + 0x83c, 0x0);
+            mmio_sync();
         }
 
         if (tunables_apply_local_addr(bridge, "apcie-config-tunables", state->port_base[port])) {
@@ -592,12 +603,52 @@ static int pcie_init_controller(int controller, const char *path)
             set32(state->port_base[port] + APCIE_PORT_RESET, APCIE_PORT_RESET_DIS);
         }
 
-        if (poll32(state->port_base[port] + APCIE_PORT_STATUS, APCIE_PORT_STATUS_RUN,
-                   APCIE_PORT_STATUS_RUN, 250000)) {
-            printf("pcie: Port failed to come up on %s\n", bridge);
-            return -1;
+        port_active[port] = true;
+        port_config_base[port] = config_base;
+        config_base += (1 << 15);
+    }
+
+    /* All released ports are now training their links; wait for all of them */
+    u64 run_timeout = timeout_calculate(250000);
+    bool pending = true;
+    while (pending && !timeout_expired(run_timeout)) {
+        pending = false;
+        for (u32 port = 0; port < state->port_count; port++)
+            if (port_active[port] &&
+                !(read32(state->port_base[port] + APCIE_PORT_STATUS) & APCIE_PORT_STATUS_RUN))
+                pending = true;
+    }
+
+    if (pending) {
+        for (u32 port = 0; port < state->port_count; port++)
+            if (port_active[port] &&
+                !(read32(state->port_base[port] + APCIE_PORT_STATUS) & APCIE_PORT_STATUS_RUN))
+                printf("pcie: Port %d failed to come up\n", port);
+        return -1;
+    }
+
+    for (u32 port = 0; port < state->port_count; port++) {
+        char bridge[64];
+        int bridge_offset;
+
+        if (!port_active[port])
+            continue;
+
+        switch (controller) {
+            case APCIE:
+                snprintf(bridge, sizeof(bridge), "/arm-io/apcie/pci-bridge%d", port);
+                break;
+            case APCIE_GE0:
+                strcpy(bridge, "/arm-io/apcie-ge0/pci-ge0-bridge");
+                break;
+            case APCIE_GE1:
+                strcpy(bridge, "/arm-io/apcie-ge1/pci-ge1-bridge");
+                break;
         }
 
+        bridge_offset = adt_path_offset(adt, bridge);
+        config_base = port_config_base[port];
+
         if (state->pcie_regs->type == APCIE_T602X && controller != APCIE) {
             write32(state->port_ltssm_base[port] + 0x10, 0x2);
             write32(state->port_ltssm_base[port] + 0x1c, 0x4);
@@ -707,13 +758,12 @@ static int pcie_init_controller(int controller, const char *path)
 
             clear32(state->rc_base + 0x3c, 0x1);
             for (int i = 0; i < 32; i++)
-                write32(state->port_base[port] + APCIE_T602X_PORT_MSIMAP + 4 * i, 0x80000000 | i);
+                write32_relaxed(state->port_base[port] + APCIE_T602X_PORT_MSIMAP + 4 * i,
+                                0x80000000 | i);
+            mmio_sync();
         }
 
         read32(state->port_base[port] + APCIE_PORT_LINKSTS);
-
-        /* Move to the next PCIe device on this bus. */
-        config_base += (1 << 15);
     }
 
     printf("pcie: Initialized controller %d\n", controller);
@@ -729,6 +779,8 @@ int pcie_init(void)
     if (pcie_initialized)
         return 0;
 
+    bootprofile_begin("pcie");
+
     success |= pcie_init_controller(APCIE, "/arm-io/apcie") == 0;
     success |= pcie_init_controller(APCIE_GE0, "/arm-io/apcie-ge0") == 0;
     success |= pcie_init_controller(APCIE_GE1, "/arm-io/apcie-ge1") == 0;
@@ -736,6 +788,8 @@ int pcie_init(void)
     if (success)
         pcie_initialized = true;
 
+    bootprofile_end("pcie");
+
     return success ? 0 : -1;
 }
 
@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "plog.h"
+#include "hash.h"
+#include "mcc.h"
+#include "memory.h"
+#include "string.h"
+#include "utils.h"
+#include "xnuboot.h"
+
+static struct plog_hdr *plog;
+
+static u32 plog_hdr_crc(struct plog_hdr *h)
+{
+    return crc32(h, offsetof(struct plog_hdr, crc));
+}
+
+void plog_init(void)
+{
+    u64 top = ram_base + cur_boot_args.mem_size_actual;
+
+    /* The MCC carveouts sit at the top of DRAM; stay below them */
+    for (size_t i = 0; i < mcc_carveout_count; i++)
+        if (mcc_carveouts[i].base < top)
+            top = mcc_carveouts[i].base;
+
+    struct plog_hdr *h = (void *)ALIGN_DOWN(top - PLOG_SIZE, SZ_16K);
+
+    if (h->magic == PLOG_MAGIC && h->version == PLOG_VERSION &&
+        h->size == PLOG_SIZE - sizeof(*h) && h->crc == plog_hdr_crc(h)) {
+        /* Keep the previous session's ring; new output appends behind it */
+        h->boot_wptr = h->wptr;
+        h->crc = plog_hdr_crc(h);
+        printf("plog: recovered 0x%lx bytes of console log at %p\n",
+               min(h->wptr, (u64)h->size), h);
+    } else {
+        memset(h, 0, sizeof(*h));
+        h->magic = PLOG_MAGIC;
+        h->version = PLOG_VERSION;
+        h->size = PLOG_SIZE - sizeof(*h);
+        h->crc = plog_hdr_crc(h);
+    }
+
+    mem_map_add((u64)h, PLOG_SIZE, MEM_CARVEOUT);
+    dc_cvac_range(h, sizeof(*h));
+    plog = h;
+}
+
+/*
+ * Mirror console bytes into the ring. They arrive formatted, so this is a
+ * copy plus a clean to the PoC (a warm reboot loses cache contents, not
+ * DRAM). Runs under the console lock like the staging ring appends.
+ */
+void plog_write(const void *buf, size_t length)
+{
+    if (!plog || !length)
+        return;
+
+    const u8 *p = buf;
+
+    if (length > plog->size) {
+        p += length - plog->size;
+        length = plog->size;
+    }
+
+    while (length) {
+        size_t wp = plog->wptr % plog->size;
+        size_t block = min(length, plog->size - wp);
+
+        memcpy(plog->data + wp, p, block);
+        dc_cvac_range(plog->data + wp, block);
+        plog->wptr += block;
+        p += block;
+        length -= block;
+    }
+
+    plog->crc = plog_hdr_crc(plog);
+    dc_cvac_range(plog, sizeof(*plog));
+}
+
+u64 plog_get(void)
+{
+    return (u64)plog;
+}
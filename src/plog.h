@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef PLOG_H
+#define PLOG_H
+
+#include "types.h"
+
+/*
+ * Persistent console log: a ring in a carveout at the top of DRAM that
+ * survives warm reboots. iodev_console_write() mirrors every byte into it
+ * (already formatted, so the append is just a memcpy plus a cache clean to
+ * make sure the bytes are in DRAM when the next boot looks). If a payload
+ * crashes, the next m1n1 finds the previous ring by magic and header CRC and
+ * keeps it: the host can then dump the tail of the dead session's console
+ * via P_PLOG_GET before it scrolls out.
+ */
+
+#define PLOG_MAGIC   0x474f4c50 // 'PLOG'
+#define PLOG_VERSION 1
+#define PLOG_SIZE    (SZ_1M / 2)
+
+struct plog_hdr {
+    u32 magic;
+    u32 version;
+    u32 size; // data bytes following the header
+    u32 pad;
+    u64 wptr;      // free-running; the ring keeps the newest size bytes
+    u64 boot_wptr; // wptr when the current m1n1 instance took over
+    u32 crc;       // of the fields above
+    u32 pad2;
+    u8 data[];
+};
+
+void plog_init(void);
+void plog_write(const void *buf, size_t length);
+/* Header address for the host (0 if unavailable) */
+u64 plog_get(void);
+
+#endif
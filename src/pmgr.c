@@ -2,6 +2,7 @@
 
 #include "pmgr.h"
 #include "adt.h"
+#include "assert.h"
 #include "string.h"
 #include "types.h"
 #include "utils.h"
@@ -44,8 +45,25 @@ static u32 pmgr_ps_regs_len = 0;
 static const struct pmgr_device *pmgr_devices = NULL;
 static u32 pmgr_devices_len = 0;
 
+/*
+ * Every PS register address re-walks the pmgr "reg" property and every device
+ * lookup scans the ADT table linearly, so parent chains re-derive both on
+ * each transition. Snapshot them on first use instead: ps-regs bases are
+ * memoized per index and device ids go through a table sorted at init. The
+ * ADT is immutable, so there is no invalidation to worry about.
+ */
+#define PMGR_MAX_PS_REGS 16
+#define PMGR_MAX_DEVICES 1024
+
+static uintptr_t pmgr_psreg_base[PMGR_MAX_PS_REGS];
+static u16 pmgr_sorted[PMGR_MAX_DEVICES];
+static u32 pmgr_n_sorted;
+
 static uintptr_t pmgr_get_psreg(u8 idx)
 {
+    if (idx < PMGR_MAX_PS_REGS && pmgr_psreg_base[idx])
+        return pmgr_psreg_base[idx];
+
     if (idx * 12 >= pmgr_ps_regs_len) {
         printf("pmgr: Index %d is out of bounds for ps-regs\n", idx);
         return 0;
@@ -60,12 +78,31 @@ static uintptr_t pmgr_get_psreg(u8 idx)
         return 0;
     }
 
+    if (idx < PMGR_MAX_PS_REGS)
+        pmgr_psreg_base[idx] = pmgr_reg + reg_offset;
+
     return pmgr_reg + reg_offset;
 }
 
-int pmgr_set_mode(uintptr_t addr, u8 target_mode)
+/*
+ * Batched transitions: within a batch, pmgr_set_mode() kicks the TARGET write
+ * and defers the ACTUAL poll until pmgr_power_batch_end(), which polls the
+ * pending registers in submission order (so a parent is always confirmed
+ * before its children are checked). Duplicate writes to shared parents are
+ * elided, and the hardware settling times of independent chains overlap
+ * instead of summing.
+ */
+#define PMGR_MAX_PENDING 64
+
+static struct {
+    uintptr_t addr;
+    u8 mode;
+} pmgr_pending[PMGR_MAX_PENDING];
+static u32 pmgr_n_pending;
+static int pmgr_batch_depth;
+
+static int pmgr_poll_mode(uintptr_t addr, u8 target_mode)
 {
-    mask32(addr, PMGR_PS_TARGET, FIELD_PREP(PMGR_PS_TARGET, target_mode));
     if (poll32(addr, PMGR_PS_ACTUAL, FIELD_PREP(PMGR_PS_ACTUAL, target_mode), PMGR_POLL_TIMEOUT) <
         0) {
         printf("pmgr: timeout while trying to set mode %x for device at 0x%lx: %x\n", target_mode,
@@ -76,9 +113,91 @@ int pmgr_set_mode(uintptr_t addr, u8 target_mode)
     return 0;
 }
 
+static int pmgr_flush_pending(void)
+{
+    int ret = 0;
+
+    for (u32 i = 0; i < pmgr_n_pending; i++)
+        if (pmgr_poll_mode(pmgr_pending[i].addr, pmgr_pending[i].mode))
+            ret = -1;
+
+    pmgr_n_pending = 0;
+    return ret;
+}
+
+void pmgr_power_batch_begin(void)
+{
+    pmgr_batch_depth++;
+}
+
+int pmgr_power_batch_end(void)
+{
+    int ret = 0;
+
+    assert(pmgr_batch_depth);
+    if (!--pmgr_batch_depth)
+        ret = pmgr_flush_pending();
+
+    return ret;
+}
+
+int pmgr_set_mode(uintptr_t addr, u8 target_mode)
+{
+    u32 reg = read32(addr);
+
+    /* Warm path: the device is already settled in the requested state */
+    if (FIELD_GET(PMGR_PS_TARGET, reg) == target_mode &&
+        FIELD_GET(PMGR_PS_ACTUAL, reg) == target_mode)
+        return 0;
+
+    if (pmgr_batch_depth) {
+        for (u32 i = 0; i < pmgr_n_pending; i++) {
+            if (pmgr_pending[i].addr != addr)
+                continue;
+            if (pmgr_pending[i].mode == target_mode)
+                return 0;
+            /* mode changed mid-batch: settle the old transition first */
+            if (pmgr_poll_mode(addr, pmgr_pending[i].mode))
+                return -1;
+            mask32(addr, PMGR_PS_TARGET, FIELD_PREP(PMGR_PS_TARGET, target_mode));
+            pmgr_pending[i].mode = target_mode;
+            return 0;
+        }
+
+        if (pmgr_n_pending == PMGR_MAX_PENDING && pmgr_flush_pending())
+            return -1;
+
+        mask32(addr, PMGR_PS_TARGET, FIELD_PREP(PMGR_PS_TARGET, target_mode));
+        pmgr_pending[pmgr_n_pending].addr = addr;
+        pmgr_pending[pmgr_n_pending].mode = target_mode;
+        pmgr_n_pending++;
+        return 0;
+    }
+
+    mask32(addr, PMGR_PS_TARGET, FIELD_PREP(PMGR_PS_TARGET, target_mode));
+    return pmgr_poll_mode(addr, target_mode);
+}
+
 static int pmgr_find_device(u16 id, const struct pmgr_device **device)
 {
-    for (size_t i = 0; i < pmgr_devices_len; ++i) {
+    u32 lo = 0, hi = pmgr_n_sorted;
+
+    while (lo < hi) {
+        u32 mid = (lo + hi) / 2;
+        const struct pmgr_device *i_device = &pmgr_devices[pmgr_sorted[mid]];
+
+        if (i_device->id == id) {
+            *device = i_device;
+            return 0;
+        }
+        if (i_device->id < id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    /* Fall back to a scan if the table did not fit the sorted index */
+    for (size_t i = pmgr_n_sorted; i < pmgr_devices_len; ++i) {
         const struct pmgr_device *i_device = &pmgr_devices[i];
         if (i_device->id != id)
             continue;
@@ -90,6 +209,21 @@ static int pmgr_find_device(u16 id, const struct pmgr_device **device)
     return -1;
 }
 
+static void pmgr_build_index(void)
+{
+    pmgr_n_sorted = min(pmgr_devices_len, (u32)PMGR_MAX_DEVICES);
+
+    for (u32 i = 0; i < pmgr_n_sorted; i++) {
+        u32 j = i;
+
+        while (j > 0 && pmgr_devices[pmgr_sorted[j - 1]].id > pmgr_devices[i].id) {
+            pmgr_sorted[j] = pmgr_sorted[j - 1];
+            j--;
+        }
+        pmgr_sorted[j] = i;
+    }
+}
+
 static uintptr_t pmgr_device_get_addr(u8 die, const struct pmgr_device *device)
 {
     uintptr_t addr = pmgr_get_psreg(device->psreg_idx);
@@ -188,6 +322,9 @@ static int pmgr_adt_devices_set_mode(const char *path, u8 target_mode, int recur
     if (pmgr_adt_find_devices(path, &devices, &n_devices) < 0)
         return -1;
 
+    // Batch the node's devices so independent chains settle in parallel
+    pmgr_power_batch_begin();
+
     for (u32 i = 0; i < n_devices; ++i) {
         u16 device = FIELD_GET(PMGR_DEVICE_ID, devices[i]);
         u8 die = FIELD_GET(PMGR_DIE_ID, devices[i]);
@@ -195,6 +332,9 @@ static int pmgr_adt_devices_set_mode(const char *path, u8 target_mode, int recur
             ret = -1;
     }
 
+    if (pmgr_power_batch_end())
+        ret = -1;
+
     return ret;
 }
 
@@ -338,6 +478,10 @@ int pmgr_init(void)
     }
 
     pmgr_devices_len /= sizeof(*pmgr_devices);
+
+    memset(pmgr_psreg_base, 0, sizeof(pmgr_psreg_base));
+    pmgr_build_index();
+
     pmgr_initialized = 1;
 
     printf("pmgr: Cleaning up device states...\n");
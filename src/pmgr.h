@@ -29,6 +29,10 @@ int pmgr_reset(int die, const char *name);
 
 int pmgr_set_mode(uintptr_t addr, u8 target_mode);
 
+/* Defer ACTUAL polls across a run of power transitions; nestable. */
+void pmgr_power_batch_begin(void);
+int pmgr_power_batch_end(void);
+
 u32 pmgr_get_feature(const char *name);
 
 #endif
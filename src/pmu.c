@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "pmu.h"
+#include "cpu_regs.h"
+#include "utils.h"
+
+/*
+ * Driver for the Apple core performance counters.
+ *
+ * Counting is enabled for EL0/EL1/EL2 A64 so code run under the proxy and
+ * guest kernels under the hypervisor are both covered. Interrupt delivery is
+ * left off; this is a sampling service, the host fetches deltas via proxy
+ * calls. Counters are 48 bits wide.
+ */
+
+#define PMU_COUNTER_BITS 48
+
+static u64 pmu_cnt_bit(int i)
+{
+    return i < 8 ? BIT(i) : BIT(32 + i - 8);
+}
+
+static void pmu_write_counter(int idx, u64 val)
+{
+    switch (idx) {
+        case 0:
+            msr(SYS_IMP_APL_PMC0, val);
+            break;
+        case 1:
+            msr(SYS_IMP_APL_PMC1, val);
+            break;
+        case 2:
+            msr(SYS_IMP_APL_PMC2, val);
+            break;
+        case 3:
+            msr(SYS_IMP_APL_PMC3, val);
+            break;
+        case 4:
+            msr(SYS_IMP_APL_PMC4, val);
+            break;
+        case 5:
+            msr(SYS_IMP_APL_PMC5, val);
+            break;
+        case 6:
+            msr(SYS_IMP_APL_PMC6, val);
+            break;
+        case 7:
+            msr(SYS_IMP_APL_PMC7, val);
+            break;
+        case 8:
+            msr(SYS_IMP_APL_PMC8, val);
+            break;
+        case 9:
+            msr(SYS_IMP_APL_PMC9, val);
+            break;
+    }
+}
+
+void pmu_start(u64 events)
+{
+    u64 enable = pmu_cnt_bit(0) | pmu_cnt_bit(1);
+
+    msr(SYS_IMP_APL_PMCR0, 0);
+    sysop("isb");
+
+    msr(SYS_IMP_APL_PMESR0, events & MASK(32));
+    msr(SYS_IMP_APL_PMESR1, events >> 32);
+
+    for (int i = 0; i < PMU_NUM_PROGRAMMABLE; i++)
+        if ((events >> (8 * i)) & 0xff)
+            enable |= pmu_cnt_bit(2 + i);
+
+    for (int i = 0; i < PMU_NUM_COUNTERS; i++)
+        if (enable & pmu_cnt_bit(i))
+            pmu_write_counter(i, 0);
+
+    u64 lo = enable & MASK(8);
+    u64 hi = (enable >> 32) & MASK(2);
+    msr(SYS_IMP_APL_PMCR1,
+        FIELD_PREP(PMCR1_COUNT_A64_EL0_0_7, lo) | FIELD_PREP(PMCR1_COUNT_A64_EL1_0_7, lo) |
+            FIELD_PREP(PMCR1_COUNT_A64_EL2_0_7, lo) | FIELD_PREP(PMCR1_COUNT_A64_EL0_8_9, hi) |
+            FIELD_PREP(PMCR1_COUNT_A64_EL1_8_9, hi) | FIELD_PREP(PMCR1_COUNT_A64_EL2_8_9, hi));
+
+    msr(SYS_IMP_APL_PMCR0, enable | PMCR0_IMODE_OFF);
+    sysop("isb");
+}
+
+void pmu_stop(void)
+{
+    msr(SYS_IMP_APL_PMCR0, mrs(SYS_IMP_APL_PMCR0) & ~PMCR0_CNT_MASK);
+    sysop("isb");
+}
+
+u64 pmu_read(int idx)
+{
+    u64 val;
+
+    switch (idx) {
+        case 0:
+            val = mrs(SYS_IMP_APL_PMC0);
+            break;
+        case 1:
+            val = mrs(SYS_IMP_APL_PMC1);
+            break;
+        case 2:
+            val = mrs(SYS_IMP_APL_PMC2);
+            break;
+        case 3:
+            val = mrs(SYS_IMP_APL_PMC3);
+            break;
+        case 4:
+            val = mrs(SYS_IMP_APL_PMC4);
+            break;
+        case 5:
+            val = mrs(SYS_IMP_APL_PMC5);
+            break;
+        case 6:
+            val = mrs(SYS_IMP_APL_PMC6);
+            break;
+        case 7:
+            val = mrs(SYS_IMP_APL_PMC7);
+            break;
+        case 8:
+            val = mrs(SYS_IMP_APL_PMC8);
+            break;
+        case 9:
+            val = mrs(SYS_IMP_APL_PMC9);
+            break;
+        default:
+            return 0;
+    }
+
+    return val & MASK(PMU_COUNTER_BITS);
+}
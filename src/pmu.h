@@ -0,0 +1,21 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef PMU_H
+#define PMU_H
+
+#include "types.h"
+
+#define PMU_NUM_COUNTERS     10
+#define PMU_NUM_PROGRAMMABLE 8
+
+/*
+ * Core PMC sampling. PMC0 counts cycles and PMC1 instructions, both always
+ * enabled; `events` packs one IMP DEF event number per byte for the
+ * programmable counters PMC2-9, with zero leaving a counter disabled.
+ * Counters apply to the calling CPU only.
+ */
+void pmu_start(u64 events);
+void pmu_stop(void);
+u64 pmu_read(int idx);
+
+#endif
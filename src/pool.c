@@ -0,0 +1,142 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "pool.h"
+#include "assert.h"
+#include "heapblock.h"
+#include "malloc.h"
+#include "utils.h"
+
+void pool_init(struct pool *pool, const char *name, size_t obj_size, size_t align, u32 grow)
+{
+    assert(align >= sizeof(void *) && (align & (align - 1)) == 0);
+    assert(grow > 0);
+
+    pool->name = name;
+    pool->obj_size = ALIGN_UP(obj_size, align);
+    pool->align = align;
+    pool->grow = grow;
+    pool->total = 0;
+    pool->free_list = NULL;
+}
+
+static bool pool_grow(struct pool *pool)
+{
+    u8 *slab = heapblock_alloc_aligned(pool->obj_size * pool->grow, pool->align);
+
+    if (!slab)
+        return false;
+
+    for (u32 i = 0; i < pool->grow; i++) {
+        void *obj = slab + i * pool->obj_size;
+        *(void **)obj = pool->free_list;
+        pool->free_list = obj;
+    }
+
+    pool->total += pool->grow;
+    return true;
+}
+
+void *pool_get(struct pool *pool)
+{
+    if (!pool->free_list && !pool_grow(pool)) {
+        printf("pool[%s]: out of memory\n", pool->name);
+        return NULL;
+    }
+
+    void *obj = pool->free_list;
+    pool->free_list = *(void **)obj;
+    return obj;
+}
+
+void pool_put(struct pool *pool, void *obj)
+{
+    if (!obj)
+        return;
+
+    *(void **)obj = pool->free_list;
+    pool->free_list = obj;
+}
+
+void pool_reserve(struct pool *pool, u32 min_total)
+{
+    while (pool->total < min_total)
+        if (!pool_grow(pool))
+            return;
+}
+
+/*
+ * Power-of-two size classes from 64 bytes to 16K. A header in front of the
+ * returned pointer records the owning pool (or NULL for the malloc fallback)
+ * so pool_free() does not need the size.
+ */
+
+#define POOL_MIN_SHIFT 6
+#define POOL_MAX_SHIFT 14
+
+struct pool_hdr {
+    struct pool *owner;
+    u64 _pad;
+};
+
+static struct pool size_pools[POOL_MAX_SHIFT - POOL_MIN_SHIFT + 1];
+
+static struct pool *pool_size_class(size_t need)
+{
+    int shift = POOL_MIN_SHIFT;
+    while ((1UL << shift) < need)
+        shift++;
+
+    struct pool *pool = &size_pools[shift - POOL_MIN_SHIFT];
+
+    if (!pool->obj_size) {
+        /* Grow in slabs of at least 4 objects / 64K */
+        u32 grow = max(4, (4 * SZ_16K) >> shift);
+        pool_init(pool, "size", 1UL << shift, 64, grow);
+    }
+
+    return pool;
+}
+
+void *pool_alloc(size_t size)
+{
+    size_t need = size + sizeof(struct pool_hdr);
+    struct pool_hdr *hdr;
+
+    if (need > (1UL << POOL_MAX_SHIFT)) {
+        hdr = malloc(need);
+        if (!hdr)
+            return NULL;
+        hdr->owner = NULL;
+        return hdr + 1;
+    }
+
+    struct pool *pool = pool_size_class(need);
+
+    hdr = pool_get(pool);
+    if (!hdr)
+        return NULL;
+
+    hdr->owner = pool;
+    return hdr + 1;
+}
+
+void pool_alloc_reserve(size_t size, u32 count)
+{
+    size_t need = size + sizeof(struct pool_hdr);
+
+    if (need <= (1UL << POOL_MAX_SHIFT))
+        pool_reserve(pool_size_class(need), count);
+}
+
+void pool_free(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    struct pool_hdr *hdr = (struct pool_hdr *)ptr - 1;
+
+    if (hdr->owner)
+        pool_put(hdr->owner, hdr);
+    else
+        free(hdr);
+}
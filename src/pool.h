@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "types.h"
+
+/*
+ * Fixed-size object pools over heapblock, as a cheap front end to dlmalloc for
+ * hot-path allocations. Objects are carved out of heapblock slabs and recycled
+ * through a per-pool free list, so steady-state operation does not pay
+ * dlmalloc's bin walking or fragment its arena. Pool memory is never returned
+ * to the system.
+ */
+
+struct pool {
+    const char *name;
+    size_t obj_size;
+    size_t align;
+    u32 grow;
+    u32 total;
+    void *free_list;
+};
+
+void pool_init(struct pool *pool, const char *name, size_t obj_size, size_t align, u32 grow);
+void *pool_get(struct pool *pool);
+void pool_put(struct pool *pool, void *obj);
+/* Preallocate backing until the pool holds at least min_total objects */
+void pool_reserve(struct pool *pool, u32 min_total);
+
+/*
+ * Size-classed front end for short-lived variable-size allocations (message
+ * buffers and the like). Allocations larger than the biggest class fall back
+ * to malloc; pool_free() works for either.
+ */
+void *pool_alloc(size_t size);
+void pool_free(void *ptr);
+/* Preallocate count objects in the size class covering size */
+void pool_alloc_reserve(size_t size, u32 count);
+
+#endif
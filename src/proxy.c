@@ -1,25 +1,42 @@
 /* SPDX-License-Identifier: MIT */
 
 #include "proxy.h"
+#include "afk.h"
+#include "bench.h"
+#include "bootprofile.h"
+#include "chickens.h"
+#include "cmdlist.h"
 #include "cpufreq.h"
 #include "dapf.h"
 #include "dart.h"
 #include "display.h"
+#include "evtlog.h"
 #include "exception.h"
 #include "fb.h"
 #include "gxf.h"
+#include "hash.h"
 #include "heapblock.h"
 #include "hv.h"
 #include "iodev.h"
 #include "kboot.h"
+#include "kcache.h"
+#include "log.h"
+#include "macho.h"
 #include "malloc.h"
 #include "mcc.h"
 #include "memory.h"
+#include "memdiff.h"
+#include "memtest.h"
 #include "nvme.h"
 #include "pcie.h"
+#include "plog.h"
 #include "pmgr.h"
+#include "pmu.h"
+#include "ramdump.h"
 #include "smp.h"
 #include "string.h"
+#include "telemetry.h"
+#include "tripwire.h"
 #include "tunables.h"
 #include "types.h"
 #include "uart.h"
@@ -31,6 +48,63 @@
 #include "minilzlib/minlzma.h"
 #include "tinf/tinf.h"
 
+#define SWEEP_FAULT 0xacce5515abad1deaUL
+
+/*
+ * Guarded register sweep: read `count` locations of `width` bytes starting
+ * at `base`, `stride` apart, into the u64 array at `buf`. A faulting read
+ * stores SWEEP_FAULT (the same sentinel the exception guard uses), so an
+ * entire MMIO block can be probed with one proxy round trip instead of one
+ * guarded read per register. The probe primitives take the pre-armed fixup
+ * path through the exception handler, so fault-dense sweeps over unmapped
+ * holes don't pay the full diagnostic cost per access. Returns the number
+ * of reads that didn't fault.
+ */
+static u64 proxy_memsweep(u64 *buf, u64 base, u64 count, u64 stride, u64 width)
+{
+    u64 ok = 0;
+
+    for (u64 i = 0; i < count; i++) {
+        u64 addr = base + i * stride;
+        u64 val = 0;
+        int ret;
+
+        switch (width) {
+            case 1: {
+                u8 v;
+                ret = probe_read8(addr, &v);
+                val = v;
+                break;
+            }
+            case 2: {
+                u16 v;
+                ret = probe_read16(addr, &v);
+                val = v;
+                break;
+            }
+            case 4: {
+                u32 v;
+                ret = probe_read32(addr, &v);
+                val = v;
+                break;
+            }
+            default: {
+                ret = probe_read64(addr, &val);
+                break;
+            }
+        }
+
+        if (ret < 0)
+            val = SWEEP_FAULT;
+        else
+            ok++;
+
+        buf[i] = val;
+    }
+
+    return ok;
+}
+
 int proxy_process(ProxyRequest *request, ProxyReply *reply)
 {
     enum exc_guard_t guard_save = exc_guard;
@@ -38,7 +112,13 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
     reply->opcode = request->opcode;
     reply->status = S_OK;
     reply->retval = 0;
-    switch (request->opcode) {
+
+    telemetry_begin();
+    telemetry.proxy_requests++;
+    telemetry_end();
+    /* The high half of the opcode is a client-chosen tag, echoed via the
+     * reply->opcode copy above so pipelined clients can match replies */
+    switch (request->opcode & 0xffffffff) {
         case P_NOP:
             break;
         case P_EXIT:
@@ -116,6 +196,18 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
         case P_SLEEP:
             cpu_sleep(request->args[0]);
             break;
+        case P_GXF_BATCH_BEGIN:
+            gxf_batch_begin();
+            break;
+        case P_GXF_BATCH_END:
+            gxf_batch_end();
+            break;
+        case P_LOG_SET_LEVEL:
+            reply->retval = log_set_level(request->args[0], request->args[1]);
+            break;
+        case P_LOG_BINARY:
+            reply->retval = log_bin_init((void *)request->args[0], request->args[1]);
+            break;
 
         case P_WRITE64:
             exc_guard = GUARD_SKIP;
@@ -218,6 +310,10 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
             exc_guard = GUARD_MARK;
             reply->retval = writeread8(request->args[0], request->args[1]);
             break;
+        case P_MEMSWEEP:
+            reply->retval = proxy_memsweep((u64 *)request->args[0], request->args[1],
+                                           request->args[2], request->args[3], request->args[4]);
+            break;
 
         case P_MEMCPY64:
             exc_guard = GUARD_RETURN;
@@ -252,6 +348,10 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
             exc_guard = GUARD_RETURN;
             memset8((void *)request->args[0], request->args[1], request->args[2]);
             break;
+        case P_MEMSET_FAST:
+            exc_guard = GUARD_RETURN;
+            memset_fast((void *)request->args[0], request->args[1], request->args[2]);
+            break;
 
         case P_IC_IALLUIS:
             ic_ialluis();
@@ -260,10 +360,10 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
             ic_iallu();
             break;
         case P_IC_IVAU:
-            ic_ivau_range((void *)request->args[0], request->args[1]);
+            ic_ivau_range_par((void *)request->args[0], request->args[1]);
             break;
         case P_DC_IVAC:
-            dc_ivac_range((void *)request->args[0], request->args[1]);
+            dc_ivac_range_par((void *)request->args[0], request->args[1]);
             break;
         case P_DC_ISW:
             dc_isw((void *)request->args[0]);
@@ -284,7 +384,7 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
             dc_cvau_range((void *)request->args[0], request->args[1]);
             break;
         case P_DC_CIVAC:
-            dc_civac_range((void *)request->args[0], request->args[1]);
+            dc_civac_range_par((void *)request->args[0], request->args[1]);
             break;
         case P_MMU_SHUTDOWN:
             mmu_shutdown();
@@ -324,6 +424,33 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
                 reply->retval = destlen;
             break;
         }
+        case P_HASH_RANGE:
+            reply->retval = xxh64((void *)request->args[0], request->args[1], request->args[2]);
+            break;
+        case P_MACHO_FLATTEN: {
+            u64 entry = 0;
+            s64 ret = macho_flatten((void *)request->args[0], request->args[1],
+                                    (void *)request->args[2], request->args[3], &entry);
+            if (ret >= 0 && request->args[4])
+                *(u64 *)request->args[4] = entry;
+            reply->retval = ret;
+            break;
+        }
+        case P_HASH_CHUNKS: {
+            u64 addr = request->args[0];
+            u64 size = request->args[1];
+            u64 chunk_size = request->args[2];
+            u64 *out = (u64 *)request->args[3];
+            u64 count = 0;
+            while (size) {
+                u64 len = min(chunk_size, size);
+                out[count++] = xxh64((void *)addr, len, 0);
+                addr += len;
+                size -= len;
+            }
+            reply->retval = count;
+            break;
+        }
 
         case P_SMP_START_SECONDARIES:
             smp_start_secondaries();
@@ -380,6 +507,15 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
         case P_FREE:
             free((void *)request->args[0]);
             break;
+        case P_HEAPBLOCK_MARK:
+            reply->retval = heapblock_mark();
+            break;
+        case P_HEAPBLOCK_RELEASE:
+            heapblock_release(request->args[0]);
+            break;
+        case P_MALLOC_STATS:
+            malloc_get_stats((struct malloc_stats *)request->args[0]);
+            break;
 
         case P_KBOOT_BOOT:
             if (kboot_boot((void *)request->args[0]) == 0)
@@ -463,6 +599,12 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
         case P_DART_UNMAP:
             dart_unmap((dart_dev_t *)request->args[0], request->args[1], request->args[2]);
             break;
+        case P_DART_TLB_BATCH_BEGIN:
+            dart_tlb_batch_begin((dart_dev_t *)request->args[0]);
+            break;
+        case P_DART_TLB_BATCH_END:
+            dart_tlb_batch_end((dart_dev_t *)request->args[0]);
+            break;
 
         case P_HV_INIT:
             hv_init();
@@ -518,6 +660,53 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
         case P_HV_ADD_TIME:
             hv_add_time(request->args[0]);
             break;
+        case P_HV_TRACE_RING:
+            reply->retval = hv_tracering_init((void *)request->args[0], request->args[1]);
+            break;
+        case P_HV_DIRTY_TRACK:
+            if (request->args[1])
+                reply->retval = hv_vm_start_dirty_track(request->args[0], request->args[1]);
+            else
+                hv_vm_stop_dirty_track();
+            break;
+        case P_HV_DIRTY_COLLECT:
+            reply->retval = hv_vm_collect_dirty((u64 *)request->args[0]);
+            break;
+        case P_HV_SET_TIMER_PASSTHROUGH:
+            hv_set_timer_passthrough(request->args[0]);
+            break;
+        case P_HV_TRACE_FILTER:
+            reply->retval = hv_trace_filter_init((void *)request->args[0], request->args[1]);
+            break;
+        case P_HV_CPU_STATS:
+            reply->retval = hv_get_vcpu_stats(request->args[0],
+                                              (struct hv_vcpu_stats *)request->args[1],
+                                              request->args[2]);
+            break;
+        case P_HV_PVTIME:
+            reply->retval = hv_pvtime_init((void *)request->args[0]);
+            break;
+        case P_HV_STEP_BATCH:
+            reply->retval =
+                hv_step_batch(request->args[0], (u64 *)request->args[1], request->args[2]);
+            break;
+        case P_HV_MMIO_REPLAY:
+            reply->retval = hv_mmio_replay((struct hv_evt_mmiotrace *)request->args[0],
+                                           request->args[1], request->args[2]);
+            break;
+        case P_HV_GATHER:
+            exc_guard = GUARD_RETURN;
+            reply->retval = hv_gather((struct hv_gather_ent *)request->args[0], request->args[1],
+                                      (void *)request->args[2], request->args[3]);
+            break;
+        case P_HV_OUTPUT_BOUNDED:
+            uartproxy_set_event_bounded(request->args[0]);
+            iodev_console_bounded(request->args[0]);
+            reply->retval = (u64)uartproxy_event_drops;
+            break;
+        case P_HV_SYSREG_RAZ_WI:
+            reply->retval = hv_sysreg_set_raz_wi(request->args[0], request->args[1]);
+            break;
 
         case P_FB_INIT:
             fb_init(request->args[0]);
@@ -550,6 +739,12 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
         case P_FB_IMPROVE_LOGO:
             fb_improve_logo();
             break;
+        case P_FB_CAPTURE:
+            reply->retval = fb_capture((struct fb_capture_info *)request->args[0]);
+            break;
+        case P_FB_SCROLLBACK:
+            reply->retval = fb_console_scrollback((struct fb_scrollback_info *)request->args[0]);
+            break;
 
         case P_PCIE_INIT:
             pcie_init();
@@ -562,7 +757,10 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
             reply->retval = nvme_init();
             break;
         case P_NVME_SHUTDOWN:
-            nvme_shutdown();
+            if (request->args[0])
+                nvme_shutdown_now();
+            else
+                nvme_shutdown();
             break;
         case P_NVME_READ:
             reply->retval = nvme_read(request->args[0], request->args[1], (void *)request->args[2]);
@@ -574,6 +772,10 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
         case P_MCC_GET_CARVEOUTS:
             reply->retval = (u64)mcc_carveouts;
             break;
+        case P_MCC_BENCHMARK:
+            reply->retval = mcc_benchmark((void *)request->args[0], request->args[1],
+                                          (u64 *)request->args[2]);
+            break;
 
         case P_DISPLAY_INIT:
             reply->retval = display_init();
@@ -601,6 +803,95 @@ int proxy_process(ProxyRequest *request, ProxyReply *reply)
         case P_CPUFREQ_INIT:
             reply->retval = cpufreq_init();
             break;
+        case P_CPUFREQ_SET_PSTATE:
+            reply->retval = cpufreq_set_pstate(request->args[0], request->args[1]);
+            break;
+
+        case P_EVTLOG_GET:
+            reply->retval = (u64)&evtlog;
+            break;
+        case P_BOOT_PROFILE_GET:
+            reply->retval = (u64)&boot_profile;
+            break;
+        case P_TRIPWIRE_GET:
+            reply->retval = (u64)&tripwire_log;
+            break;
+        case P_CONSOLE_RING_GET:
+            reply->retval = (u64)&con_ring;
+            break;
+        case P_CHICKENS_GET:
+            reply->retval = (u64)&chicken_report;
+            break;
+        case P_TELEMETRY_GET:
+            reply->retval = (u64)&telemetry;
+            break;
+        case P_PLOG_GET:
+            reply->retval = plog_get();
+            break;
+        case P_AFK_STATS_GET:
+            reply->retval = (u64)&afk_stats;
+            break;
+
+        case P_PMU_START:
+            pmu_start(request->args[0]);
+            break;
+        case P_PMU_STOP:
+            pmu_stop();
+            break;
+        case P_PMU_READ:
+            reply->retval = pmu_read(request->args[0]);
+            break;
+
+        case P_KCACHE_INIT:
+            reply->retval = kcache_init(request->args[0], request->args[1], request->args[2]);
+            break;
+        case P_KCACHE_STORE:
+            reply->retval =
+                kcache_store(request->args[0], (void *)request->args[1], request->args[2]);
+            break;
+        case P_KCACHE_LOAD:
+            reply->retval = kcache_load(request->args[0], (void *)request->args[1]);
+            break;
+        case P_KCACHE_LOAD_ASYNC:
+            reply->retval = kcache_load_begin(request->args[0], (void *)request->args[1]);
+            break;
+        case P_KCACHE_LOAD_POLL:
+            reply->retval = kcache_load_poll();
+            break;
+
+        case P_BENCH_RUN:
+            reply->retval = bench_run(request->args[0], request->args[1], request->args[2],
+                                      request->args[3], request->args[4]);
+            break;
+        case P_BENCH_QUIESCE:
+            if (request->args[0])
+                reply->retval = bench_quiesce(request->args[1]);
+            else
+                reply->retval = bench_unquiesce();
+            break;
+
+        case P_MEMTEST_RUN:
+            reply->retval = memtest_run(request->args[0], request->args[1], request->args[2]);
+            break;
+        case P_MEMTEST_GET:
+            reply->retval = (u64)&memtest_log;
+            break;
+
+        case P_MEMDIFF_RUN:
+            reply->retval = memdiff_run(request->args[0], request->args[1], request->args[2]);
+            break;
+        case P_MEMDIFF_GET:
+            reply->retval = (u64)&memdiff_log;
+            break;
+
+        case P_DUMP_COMPRESSED:
+            reply->retval = ramdump_compress(request->args[0], request->args[1],
+                                             (void *)request->args[2], request->args[3]);
+            break;
+
+        case P_CMDLIST_RUN:
+            reply->retval = cmdlist_run((struct cmdlist_cmd *)request->args[0], request->args[1]);
+            break;
 
         default:
             reply->status = S_BADCMD;
@@ -24,6 +24,10 @@ typedef enum {
     P_PUT_SIMD_STATE,
     P_REBOOT,
     P_SLEEP,
+    P_GXF_BATCH_BEGIN,
+    P_GXF_BATCH_END,
+    P_LOG_SET_LEVEL,
+    P_LOG_BINARY,
 
     P_WRITE64 = 0x100, // Generic register functions
     P_WRITE32,
@@ -49,6 +53,7 @@ typedef enum {
     P_WRITEREAD32,
     P_WRITEREAD16,
     P_WRITEREAD8,
+    P_MEMSWEEP,
 
     P_MEMCPY64 = 0x200, // Memory block transfer functions
     P_MEMCPY32,
@@ -58,6 +63,7 @@ typedef enum {
     P_MEMSET32,
     P_MEMSET16,
     P_MEMSET8,
+    P_MEMSET_FAST,
 
     P_IC_IALLUIS = 0x300, // Cache and memory ops
     P_IC_IALLU,
@@ -78,6 +84,9 @@ typedef enum {
 
     P_XZDEC = 0x400, // Decompression and data processing ops
     P_GZDEC,
+    P_HASH_RANGE,
+    P_HASH_CHUNKS,
+    P_MACHO_FLATTEN,
 
     P_SMP_START_SECONDARIES = 0x500, // SMP and system management ops
     P_SMP_CALL,
@@ -95,6 +104,9 @@ typedef enum {
     P_MALLOC,
     P_MEMALIGN,
     P_FREE,
+    P_HEAPBLOCK_MARK,
+    P_HEAPBLOCK_RELEASE,
+    P_MALLOC_STATS,
 
     P_KBOOT_BOOT = 0x700, // Kernel boot ops
     P_KBOOT_SET_CHOSEN,
@@ -123,6 +135,8 @@ typedef enum {
     P_DART_SHUTDOWN,
     P_DART_MAP,
     P_DART_UNMAP,
+    P_DART_TLB_BATCH_BEGIN,
+    P_DART_TLB_BATCH_END,
 
     P_HV_INIT = 0xc00,
     P_HV_MAP,
@@ -141,6 +155,18 @@ typedef enum {
     P_VIRTIO_PUT_BUFFER,
     P_HV_EXIT_CPU,
     P_HV_ADD_TIME,
+    P_HV_TRACE_RING,
+    P_HV_DIRTY_TRACK,
+    P_HV_DIRTY_COLLECT,
+    P_HV_SET_TIMER_PASSTHROUGH,
+    P_HV_TRACE_FILTER,
+    P_HV_CPU_STATS,
+    P_HV_PVTIME,
+    P_HV_STEP_BATCH,
+    P_HV_MMIO_REPLAY,
+    P_HV_GATHER,
+    P_HV_OUTPUT_BOUNDED,
+    P_HV_SYSREG_RAZ_WI,
 
     P_FB_INIT = 0xd00,
     P_FB_SHUTDOWN,
@@ -151,6 +177,8 @@ typedef enum {
     P_FB_DISPLAY_LOGO,
     P_FB_RESTORE_LOGO,
     P_FB_IMPROVE_LOGO,
+    P_FB_CAPTURE,
+    P_FB_SCROLLBACK,
 
     P_PCIE_INIT = 0xe00,
     P_PCIE_SHUTDOWN,
@@ -161,6 +189,7 @@ typedef enum {
     P_NVME_FLUSH,
 
     P_MCC_GET_CARVEOUTS = 0x1000,
+    P_MCC_BENCHMARK,
 
     P_DISPLAY_INIT = 0x1100,
     P_DISPLAY_CONFIGURE,
@@ -172,13 +201,46 @@ typedef enum {
     P_DAPF_INIT,
 
     P_CPUFREQ_INIT = 0x1300,
+    P_CPUFREQ_SET_PSTATE,
+
+    P_EVTLOG_GET = 0x1400,
+    P_BOOT_PROFILE_GET,
+    P_TRIPWIRE_GET,
+    P_CONSOLE_RING_GET,
+    P_CHICKENS_GET,
+    P_TELEMETRY_GET,
+    P_AFK_STATS_GET,
+    P_PLOG_GET,
+
+    P_PMU_START = 0x1500, // Performance counter ops
+    P_PMU_STOP,
+    P_PMU_READ,
+
+    P_KCACHE_INIT = 0x1600, // NVMe payload cache
+    P_KCACHE_STORE,
+    P_KCACHE_LOAD,
+    P_KCACHE_LOAD_ASYNC,
+    P_KCACHE_LOAD_POLL,
+
+    P_BENCH_RUN = 0x1700, // Microbenchmarks
+    P_BENCH_QUIESCE,
+
+    P_MEMTEST_RUN = 0x1800, // Parallel DRAM test
+    P_MEMTEST_GET,
+
+    P_DUMP_COMPRESSED = 0x1900, // Parallel LZ4 RAM dump
+
+    P_CMDLIST_RUN = 0x1a00, // Device-side command lists
+
+    P_MEMDIFF_RUN = 0x1b00, // Parallel memory diff
+    P_MEMDIFF_GET,
 } ProxyOp;
 
 #define S_OK     0
 #define S_BADCMD -1
 
 typedef struct {
-    u64 opcode;
+    u64 opcode; // low 32 bits: opcode; high 32 bits: client tag, echoed in the reply
     u64 args[6];
 } ProxyRequest;
 
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+ * Parallel compressed RAM dumps.
+ *
+ * The range is cut into RAMDUMP_SLICE_SIZE slices handed out round-robin to
+ * idle secondaries (the boot CPU takes a slice per round too, like the
+ * parallel payload decompressor). Each worker LZ4-compresses its slice into a
+ * disjoint worst-case-sized region of the output buffer using its own hash
+ * table, so no locking is needed. The cache dance mirrors payload.c: the
+ * source is pushed to PoC before dispatch since secondaries run uncached, the
+ * boot CPU's own output is cleaned, and stale cached views of the worker
+ * output are dropped before the header is written.
+ */
+
+#include "ramdump.h"
+#include "lz4.h"
+#include "memory.h"
+#include "smp.h"
+#include "string.h"
+#include "utils.h"
+
+#define RAMDUMP_MAX_CPUS 8
+
+static u32 ramdump_ht[RAMDUMP_MAX_CPUS + 1][LZ4_HASH_SIZE] ALIGNED(64);
+
+static u64 ramdump_slice(u64 src, u64 len, u64 dst, u64 slot)
+{
+    return lz4_compress((const u8 *)src, len, (u8 *)dst, LZ4_WORST_SIZE(len), ramdump_ht[slot]);
+}
+
+s64 ramdump_compress(u64 src, u64 size, void *dst, u64 dst_max)
+{
+    if (!size)
+        return -1;
+
+    u32 nslices = (size + RAMDUMP_SLICE_SIZE - 1) / RAMDUMP_SLICE_SIZE;
+    u64 hdr_size = ALIGN_UP(sizeof(struct ramdump_hdr) + nslices * sizeof(struct ramdump_slice),
+                            64);
+    u64 slice_worst = ALIGN_UP(LZ4_WORST_SIZE((u64)RAMDUMP_SLICE_SIZE), 64);
+
+    if (dst_max < hdr_size + nslices * slice_worst)
+        return -1;
+
+    struct ramdump_hdr *hdr = dst;
+
+    int cpus[RAMDUMP_MAX_CPUS];
+    int ncpus = smp_idle_cpus(CPU_TYPE_UNKNOWN, -1, cpus, RAMDUMP_MAX_CPUS);
+
+    // Secondaries read the source uncached; push our cached view to PoC
+    if (ncpus)
+        dc_civac_range_par((void *)src, size);
+
+    u32 m = 0;
+    while (m < nslices) {
+        u32 assigned[RAMDUMP_MAX_CPUS];
+        struct smp_group group;
+
+        smp_group_init(&group);
+
+        for (int i = 0; i < ncpus && m + 1 < nslices; i++) {
+            u64 off = (u64)m * RAMDUMP_SLICE_SIZE;
+            smp_group_call4(&group, cpus[i], ramdump_slice, src + off,
+                            min((u64)RAMDUMP_SLICE_SIZE, size - off),
+                            (u64)dst + hdr_size + (u64)m * slice_worst, i + 1);
+            assigned[group.ncpus - 1] = m++;
+        }
+
+        // The boot CPU takes the next slice itself instead of idling
+        u64 off = (u64)m * RAMDUMP_SLICE_SIZE;
+        u64 len = min((u64)RAMDUMP_SLICE_SIZE, size - off);
+        u64 dslice = (u64)dst + hdr_size + (u64)m * slice_worst;
+        u64 comp = ramdump_slice(src + off, len, dslice, 0);
+
+        if (!comp) {
+            memcpy((void *)dslice, (void *)(src + off), len);
+            hdr->slice[m].comp_len = 0;
+        } else {
+            hdr->slice[m].comp_len = comp;
+        }
+        hdr->slice[m].raw_len = len;
+        hdr->slice[m].offset = dslice - (u64)dst;
+        dc_cvac_range((void *)dslice, comp ? comp : len);
+        m++;
+
+        smp_group_wait(&group);
+
+        for (int i = 0; i < group.ncpus; i++) {
+            u32 s = assigned[i];
+            u64 slen = min((u64)RAMDUMP_SLICE_SIZE, size - (u64)s * RAMDUMP_SLICE_SIZE);
+
+            comp = group.retval[i];
+            if (!comp) {
+                // Worst-case sizing means this cannot happen, but stay safe
+                void *p = (u8 *)dst + hdr_size + (u64)s * slice_worst;
+                memcpy(p, (void *)(src + (u64)s * RAMDUMP_SLICE_SIZE), slen);
+                dc_cvac_range(p, slen);
+            }
+
+            hdr->slice[s].raw_len = slen;
+            hdr->slice[s].comp_len = comp;
+            hdr->slice[s].offset = hdr_size + (u64)s * slice_worst;
+        }
+    }
+
+    // Drop any stale cached view of what the secondaries wrote
+    if (ncpus)
+        dc_ivac_range_par((u8 *)dst + hdr_size, (u64)nslices * slice_worst);
+
+    hdr->magic = RAMDUMP_MAGIC;
+    hdr->nslices = nslices;
+
+    return hdr_size + (u64)nslices * slice_worst;
+}
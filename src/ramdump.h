@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef RAMDUMP_H
+#define RAMDUMP_H
+
+#include "types.h"
+
+/*
+ * Compressed RAM dumps, invoked via P_DUMP_COMPRESSED: the range is cut into
+ * fixed slices, LZ4-compressed in parallel across idle CPUs into a
+ * caller-provided buffer, and described by a ramdump_hdr the host parses
+ * before bulk-reading only the compressed bytes.
+ */
+
+#define RAMDUMP_MAGIC      0x34504d44 // 'DMP4'
+#define RAMDUMP_SLICE_SIZE SZ_32M
+
+struct ramdump_slice {
+    u64 raw_len;
+    u64 comp_len; // 0: stored uncompressed
+    u64 offset;   // from the start of the output buffer
+};
+
+struct ramdump_hdr {
+    u32 magic;
+    u32 nslices;
+    struct ramdump_slice slice[];
+};
+
+s64 ramdump_compress(u64 src, u64 size, void *dst, u64 dst_max);
+
+#endif
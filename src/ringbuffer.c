@@ -1,6 +1,17 @@
 #include "ringbuffer.h"
 #include "malloc.h"
+#include "string.h"
 #include "types.h"
+#include "utils.h"
+
+/*
+ * Single-producer/single-consumer lock-free ring buffer. The consumer only
+ * stores to read and the producer only stores to write; each side
+ * acquire-loads the other's index and release-stores its own, so the two
+ * sides may run on different cores (e.g. the hv_vuart console relay) without
+ * locking. Data moves in up to two memcpy() chunks per call rather than a
+ * byte at a time.
+ */
 
 ringbuffer_t *ringbuffer_alloc(size_t len)
 {
@@ -30,44 +41,40 @@ void ringbuffer_free(ringbuffer_t *bfr)
 
 size_t ringbuffer_read(u8 *target, size_t len, ringbuffer_t *bfr)
 {
-    size_t read;
+    size_t read = bfr->read;
+    size_t write = __atomic_load_n(&bfr->write, __ATOMIC_ACQUIRE);
+    size_t used = write >= read ? write - read : bfr->len - read + write;
+    size_t count = min(len, used);
+    size_t chunk = min(count, bfr->len - read);
 
-    for (read = 0; read < len; ++read) {
-        if (bfr->read == bfr->write)
-            break;
+    memcpy(target, bfr->buffer + read, chunk);
+    memcpy(target + chunk, bfr->buffer, count - chunk);
 
-        *target = bfr->buffer[bfr->read];
-        target++;
+    __atomic_store_n(&bfr->read, (read + count) % bfr->len, __ATOMIC_RELEASE);
 
-        bfr->read++;
-        bfr->read %= bfr->len;
-    }
-
-    return read;
+    return count;
 }
 
 size_t ringbuffer_write(const u8 *src, size_t len, ringbuffer_t *bfr)
 {
-    size_t written;
-
-    for (written = 0; written < len; ++written) {
-        if (((bfr->write + 1) % bfr->len) == bfr->read)
-            break;
+    size_t write = bfr->write;
+    size_t read = __atomic_load_n(&bfr->read, __ATOMIC_ACQUIRE);
+    size_t used = write >= read ? write - read : bfr->len - read + write;
+    size_t count = min(len, bfr->len - used - 1);
+    size_t chunk = min(count, bfr->len - write);
 
-        bfr->buffer[bfr->write] = *src;
-        src++;
+    memcpy(bfr->buffer + write, src, chunk);
+    memcpy(bfr->buffer, src + chunk, count - chunk);
 
-        bfr->write++;
-        bfr->write %= bfr->len;
-    }
+    __atomic_store_n(&bfr->write, (write + count) % bfr->len, __ATOMIC_RELEASE);
 
-    return written;
+    return count;
 }
 
 size_t ringbuffer_get_used(ringbuffer_t *bfr)
 {
-    size_t read = bfr->read;
-    size_t write = bfr->write;
+    size_t read = __atomic_load_n(&bfr->read, __ATOMIC_ACQUIRE);
+    size_t write = __atomic_load_n(&bfr->write, __ATOMIC_ACQUIRE);
 
     if (write < read)
         write += bfr->len;
@@ -77,5 +84,5 @@ size_t ringbuffer_get_used(ringbuffer_t *bfr)
 
 size_t ringbuffer_get_free(ringbuffer_t *bfr)
 {
-    return bfr->len - ringbuffer_get_used(bfr);
+    return bfr->len - ringbuffer_get_used(bfr) - 1;
 }
@@ -7,18 +7,27 @@
 #include "asc.h"
 #include "dart.h"
 #include "iova.h"
+#include "log.h"
 #include "malloc.h"
+#include "pool.h"
 #include "sart.h"
 #include "string.h"
 #include "types.h"
 #include "utils.h"
 
-#define rtkit_printf(...)                                                                          \
+/* The level check runs before the prefix or any argument is formatted */
+#define rtkit_log(level, ...)                                                                      \
     do {                                                                                           \
-        debug_printf("rtkit(%s): ", rtk->name);                                                    \
-        debug_printf(__VA_ARGS__);                                                                 \
+        if ((level) <= LOG_LEVEL_FLOOR && (level) <= log_levels[LOG_RTKIT]) {                      \
+            debug_printf("rtkit(%s): ", rtk->name);                                                \
+            debug_printf(__VA_ARGS__);                                                             \
+        }                                                                                          \
     } while (0)
 
+#define rtkit_printf(...) rtkit_log(LOG_ERR, __VA_ARGS__)
+#define rtkit_info(...)   rtkit_log(LOG_INFO, __VA_ARGS__)
+#define rtkit_dbg(...)    rtkit_log(LOG_DEBUG, __VA_ARGS__)
+
 #define RTKIT_EP_MGMT     0
 #define RTKIT_EP_CRASHLOG 1
 #define RTKIT_EP_SYSLOG   2
@@ -80,6 +89,12 @@ enum rtkit_power_state {
     RTKIT_POWER_INIT = 0x220,
 };
 
+struct rtkit_ep_handler {
+    u8 ep;
+    rtkit_ep_handler_t handler;
+    void *cookie;
+};
+
 struct rtkit_dev {
     char *name;
 
@@ -100,6 +115,8 @@ struct rtkit_dev {
 
     u32 syslog_cnt, syslog_size;
 
+    struct rtkit_ep_handler ep_handlers[RTKIT_MAX_EP_HANDLERS];
+
     bool crashed;
 };
 
@@ -241,16 +258,34 @@ bool rtkit_unmap(rtkit_dev_t *rtk, u64 dva, size_t sz)
     }
 }
 
+/* Firmware re-requests its buffers on every boot; recycle single-page ones */
+static struct pool rtkit_buf_pool;
+
+static void rtkit_buffer_put(struct rtkit_buffer *bfr)
+{
+    if (bfr->sz == SZ_16K)
+        pool_put(&rtkit_buf_pool, bfr->bfr);
+    else
+        free(bfr->bfr);
+    bfr->bfr = NULL;
+}
+
 bool rtkit_alloc_buffer(rtkit_dev_t *rtk, struct rtkit_buffer *bfr, size_t sz)
 {
-    bfr->bfr = memalign(SZ_16K, sz);
+    sz = ALIGN_UP(sz, 16384);
+
+    if (sz == SZ_16K) {
+        if (!rtkit_buf_pool.obj_size)
+            pool_init(&rtkit_buf_pool, "rtkit-buf", SZ_16K, SZ_16K, 4);
+        bfr->bfr = pool_get(&rtkit_buf_pool);
+    } else {
+        bfr->bfr = memalign(SZ_16K, sz);
+    }
     if (!bfr->bfr) {
         rtkit_printf("unable to allocate %zu buffer\n", sz);
         return false;
     }
 
-    sz = ALIGN_UP(sz, 16384);
-
     bfr->sz = sz;
     if (!rtkit_map(rtk, bfr->bfr, sz, &bfr->dva))
         goto error;
@@ -258,8 +293,7 @@ bool rtkit_alloc_buffer(rtkit_dev_t *rtk, struct rtkit_buffer *bfr, size_t sz)
     return true;
 
 error:
-    free(bfr->bfr);
-    bfr->bfr = NULL;
+    rtkit_buffer_put(bfr);
     return false;
 }
 
@@ -271,7 +305,7 @@ bool rtkit_free_buffer(rtkit_dev_t *rtk, struct rtkit_buffer *bfr)
     if (!rtkit_unmap(rtk, bfr->dva, bfr->sz))
         return false;
 
-    free(bfr->bfr);
+    rtkit_buffer_put(bfr);
 
     return false;
 }
@@ -301,8 +335,8 @@ static bool rtkit_handle_buffer_request(rtkit_dev_t *rtk, struct rtkit_message *
                          addr);
             return false;
         } else {
-            rtkit_printf("pre-allocated buffer (ep 0x%x, dva 0x%lx, phys %p)\n", msg->ep, addr,
-                         bfr->bfr);
+            rtkit_dbg("pre-allocated buffer (ep 0x%x, dva 0x%lx, phys %p)\n", msg->ep, addr,
+                      bfr->bfr);
         }
         return true;
 
@@ -419,9 +453,8 @@ int rtkit_recv(rtkit_dev_t *rtk, struct rtkit_message *msg)
                         u64 index = FIELD_GET(MSG_SYSLOG_LOG_INDEX, msg->msg);
                         u64 stride = rtk->syslog_size + sizeof(struct syslog_log);
                         struct syslog_log *log = rtk->syslog_bfr.bfr + stride * index;
-                        rtkit_printf("syslog: [%s]%s", log->context, log->msg);
-                        if (log->msg[strlen(log->msg) - 1] != '\n')
-                            printf("\n");
+                        rtkit_info("syslog: [%s]%s%s", log->context, log->msg,
+                                   log->msg[strlen(log->msg) - 1] != '\n' ? "\n" : "");
                     }
 #endif
                         if (!asc_send(rtk->asc, &asc_msg))
@@ -476,6 +509,92 @@ int rtkit_recv(rtkit_dev_t *rtk, struct rtkit_message *msg)
     return 0;
 }
 
+bool rtkit_set_ep_handler(rtkit_dev_t *rtk, u8 ep, rtkit_ep_handler_t handler, void *cookie)
+{
+    struct rtkit_ep_handler *free_slot = NULL;
+
+    for (int i = 0; i < RTKIT_MAX_EP_HANDLERS; i++) {
+        struct rtkit_ep_handler *slot = &rtk->ep_handlers[i];
+
+        if (slot->handler && slot->ep == ep) {
+            slot->handler = handler;
+            slot->cookie = cookie;
+            return true;
+        }
+        if (!slot->handler && !free_slot)
+            free_slot = slot;
+    }
+
+    if (!handler)
+        return true;
+
+    if (!free_slot) {
+        rtkit_printf("no free endpoint handler slot for 0x%02x\n", ep);
+        return false;
+    }
+
+    free_slot->ep = ep;
+    free_slot->handler = handler;
+    free_slot->cookie = cookie;
+    return true;
+}
+
+/*
+ * Receive with adaptive backoff, for the power-state wait loops below. The
+ * mailbox is polled at full rate for a short window so fast replies take no
+ * latency hit, then the loop sleeps in WFE between polls; the timer event
+ * stream bounds the wakeup latency to ~1.3us. Any pending message resets the
+ * window, so bursts of progress keep the loop in the fast path, while
+ * firmware that spends a second booting (DCP) no longer has a core hammering
+ * the mailbox register the whole time.
+ */
+#define RTKIT_SPIN_POLLS 256
+
+static int rtkit_recv_backoff(rtkit_dev_t *rtk, struct rtkit_message *msg, u32 *polls)
+{
+    if (rtkit_can_recv(rtk)) {
+        *polls = 0;
+    } else if (++(*polls) > RTKIT_SPIN_POLLS) {
+        enable_event_stream();
+        sysop("wfe");
+    }
+
+    return rtkit_recv(rtk, msg);
+}
+
+int rtkit_poll(rtkit_dev_t *rtk)
+{
+    int count = 0;
+
+    while (rtkit_can_recv(rtk)) {
+        struct rtkit_message msg;
+        int ret = rtkit_recv(rtk, &msg);
+
+        if (ret < 0)
+            return ret;
+        if (ret == 0)
+            break;
+
+        bool handled = false;
+        for (int i = 0; i < RTKIT_MAX_EP_HANDLERS; i++) {
+            struct rtkit_ep_handler *slot = &rtk->ep_handlers[i];
+
+            if (slot->handler && slot->ep == msg.ep) {
+                slot->handler(rtk, &msg, slot->cookie);
+                handled = true;
+                break;
+            }
+        }
+
+        if (!handled)
+            rtkit_printf("unhandled message for endpoint 0x%02x: %lx\n", msg.ep, msg.msg);
+
+        count++;
+    }
+
+    return count;
+}
+
 bool rtkit_start_ep(rtkit_dev_t *rtk, u8 ep)
 {
     struct asc_message msg;
@@ -537,7 +656,7 @@ bool rtkit_boot(rtkit_dev_t *rtk)
         return false;
     }
 
-    rtkit_printf("booting with version %d\n", want_ver);
+    rtkit_info("booting with version %d\n", want_ver);
 
     msg.msg0 = FIELD_PREP(MGMT_TYPE, MGMT_MSG_HELLO_ACK);
     msg.msg0 |= FIELD_PREP(MGMT_MSG_HELLO_MINVER, want_ver);
@@ -634,9 +753,10 @@ bool rtkit_boot(rtkit_dev_t *rtk)
     if (has_oslog && !rtkit_start_ep(rtk, RTKIT_EP_OSLOG))
         return false;
 
+    u32 polls = 0;
     while (rtk->iop_power != RTKIT_POWER_ON) {
         struct rtkit_message rtk_msg;
-        int ret = rtkit_recv(rtk, &rtk_msg);
+        int ret = rtkit_recv_backoff(rtk, &rtk_msg, &polls);
         if (ret == 1)
             rtkit_printf("unexpected message to non-system endpoint 0x%02x during boot: %lx\n",
                          rtk_msg.ep, rtk_msg.msg);
@@ -672,9 +792,10 @@ static bool rtkit_switch_power_state(rtkit_dev_t *rtk, enum rtkit_power_state ta
         return false;
     }
 
+    u32 polls = 0;
     while (rtk->ap_power != RTKIT_POWER_QUIESCED) {
         struct rtkit_message rtk_msg;
-        int ret = rtkit_recv(rtk, &rtk_msg);
+        int ret = rtkit_recv_backoff(rtk, &rtk_msg, &polls);
 
         if (ret > 0) {
             rtkit_printf("unexpected message to non-system endpoint 0x%02x during shutdown: %lx\n",
@@ -692,9 +813,10 @@ static bool rtkit_switch_power_state(rtkit_dev_t *rtk, enum rtkit_power_state ta
         return false;
     }
 
+    polls = 0;
     while (rtk->iop_power != target) {
         struct rtkit_message rtk_msg;
-        int ret = rtkit_recv(rtk, &rtk_msg);
+        int ret = rtkit_recv_backoff(rtk, &rtk_msg, &polls);
 
         if (ret > 0) {
             rtkit_printf("unexpected message to non-system endpoint 0x%02x during shutdown: %lx\n",
@@ -36,6 +36,19 @@ bool rtkit_can_recv(rtkit_dev_t *rtk);
 int rtkit_recv(rtkit_dev_t *rtk, struct rtkit_message *msg);
 bool rtkit_send(rtkit_dev_t *rtk, const struct rtkit_message *msg);
 
+/*
+ * Event-driven dispatch: clients register a callback per application endpoint
+ * and pump the mailbox with rtkit_poll(), which never blocks and dispatches
+ * everything that is pending. System endpoints are still handled internally,
+ * so several endpoints can keep traffic in flight concurrently.
+ */
+#define RTKIT_MAX_EP_HANDLERS 8
+
+typedef void (*rtkit_ep_handler_t)(rtkit_dev_t *rtk, const struct rtkit_message *msg, void *cookie);
+
+bool rtkit_set_ep_handler(rtkit_dev_t *rtk, u8 ep, rtkit_ep_handler_t handler, void *cookie);
+int rtkit_poll(rtkit_dev_t *rtk);
+
 bool rtkit_map(rtkit_dev_t *rtk, void *phys, size_t sz, u64 *dva);
 bool rtkit_unmap(rtkit_dev_t *rtk, u64 dva, size_t sz);
 
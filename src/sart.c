@@ -6,16 +6,27 @@
 #include "string.h"
 #include "utils.h"
 
+#define APPLE_SART_MAX_ENTRIES 16
+
 struct sart_dev {
     uintptr_t base;
     u32 protected_entries;
+    u32 used_entries;
+
+    /*
+     * Shadow of the register file, so adding/removing regions does not have
+     * to scan the registers and adjacent buffers can be merged into a single
+     * entry (the register file only has 16 slots).
+     */
+    struct {
+        u64 paddr;
+        size_t size;
+    } shadow[APPLE_SART_MAX_ENTRIES];
 
     void (*get_entry)(sart_dev_t *sart, int index, u8 *flags, void **paddr, size_t *size);
     bool (*set_entry)(sart_dev_t *sart, int index, u8 flags, void *paddr, size_t size);
 };
 
-#define APPLE_SART_MAX_ENTRIES 16
-
 /* This is probably a bitfield but the exact meaning of each bit is unknown. */
 #define APPLE_SART_FLAGS_ALLOW 0xff
 
@@ -153,9 +164,13 @@ sart_dev_t *sart_init(const char *adt_path)
         size_t sz;
 
         sart->get_entry(sart, i, &flags, &paddr, &sz);
-        if (flags)
+        if (flags) {
             sart->protected_entries |= 1 << i;
+            sart->shadow[i].paddr = (u64)paddr;
+            sart->shadow[i].size = sz;
+        }
     }
+    sart->used_entries = sart->protected_entries;
 
     return sart;
 }
@@ -173,44 +188,95 @@ void sart_free(sart_dev_t *sart)
 
 bool sart_add_allowed_region(sart_dev_t *sart, void *paddr, size_t sz)
 {
-    for (unsigned int i = 0; i < APPLE_SART_MAX_ENTRIES; ++i) {
-        void *e_paddr;
-        u8 e_flags;
-        size_t e_sz;
+    u64 start = (u64)paddr;
 
-        if (sart->protected_entries & (1 << i))
+    /*
+     * Try to merge with an adjacent entry first, so streams of contiguous
+     * buffers do not exhaust the 16 slots.
+     */
+    for (unsigned int i = 0; i < APPLE_SART_MAX_ENTRIES; ++i) {
+        if (!(sart->used_entries & (1 << i)) || (sart->protected_entries & (1 << i)))
             continue;
 
-        sart->get_entry(sart, i, &e_flags, &e_paddr, &e_sz);
-        if (e_flags)
-            continue;
+        if (sart->shadow[i].paddr + sart->shadow[i].size == start) {
+            if (!sart->set_entry(sart, i, APPLE_SART_FLAGS_ALLOW, (void *)sart->shadow[i].paddr,
+                                 sart->shadow[i].size + sz))
+                continue; // merged size out of range, use a fresh slot
+            sart->shadow[i].size += sz;
+            return true;
+        }
+        if (start + sz == sart->shadow[i].paddr) {
+            if (!sart->set_entry(sart, i, APPLE_SART_FLAGS_ALLOW, paddr,
+                                 sart->shadow[i].size + sz))
+                continue;
+            sart->shadow[i].paddr = start;
+            sart->shadow[i].size += sz;
+            return true;
+        }
+    }
 
-        return sart->set_entry(sart, i, APPLE_SART_FLAGS_ALLOW, paddr, sz);
+    u32 free_entries = ~sart->used_entries & (BIT(APPLE_SART_MAX_ENTRIES) - 1);
+    if (!free_entries) {
+        printf("sart: no more free entries\n");
+        return false;
     }
 
-    printf("sart: no more free entries\n");
-    return false;
+    unsigned int i = __builtin_ctz(free_entries);
+    if (!sart->set_entry(sart, i, APPLE_SART_FLAGS_ALLOW, paddr, sz))
+        return false;
+
+    sart->used_entries |= 1 << i;
+    sart->shadow[i].paddr = start;
+    sart->shadow[i].size = sz;
+    return true;
 }
 
 bool sart_remove_allowed_region(sart_dev_t *sart, void *paddr, size_t sz)
 {
-    for (unsigned int i = 0; i < APPLE_SART_MAX_ENTRIES; ++i) {
-        void *e_paddr;
-        u8 e_flags;
-        size_t e_sz;
+    u64 start = (u64)paddr;
 
-        if (sart->protected_entries & (1 << i))
+    for (unsigned int i = 0; i < APPLE_SART_MAX_ENTRIES; ++i) {
+        if (!(sart->used_entries & (1 << i)) || (sart->protected_entries & (1 << i)))
             continue;
 
-        sart->get_entry(sart, i, &e_flags, &e_paddr, &e_sz);
-        if (!e_flags)
-            continue;
-        if (e_paddr != paddr)
-            continue;
-        if (e_sz != sz)
+        u64 e_start = sart->shadow[i].paddr;
+        u64 e_end = e_start + sart->shadow[i].size;
+
+        if (start < e_start || start + sz > e_end)
             continue;
 
-        return sart->set_entry(sart, i, 0, NULL, 0);
+        if (sart->shadow[i].size == sz) {
+            if (!sart->set_entry(sart, i, 0, NULL, 0))
+                return false;
+            sart->used_entries &= ~(1 << i);
+            sart->shadow[i].paddr = 0;
+            sart->shadow[i].size = 0;
+            return true;
+        }
+
+        /*
+         * Merged entries are shrunk from either edge. Removing a buffer from
+         * the middle of a merged entry would need a split into two slots;
+         * this does not happen with the LIFO alloc/free patterns we see.
+         */
+        if (start == e_start) {
+            if (!sart->set_entry(sart, i, APPLE_SART_FLAGS_ALLOW, (void *)(e_start + sz),
+                                 sart->shadow[i].size - sz))
+                return false;
+            sart->shadow[i].paddr = e_start + sz;
+            sart->shadow[i].size -= sz;
+            return true;
+        }
+        if (start + sz == e_end) {
+            if (!sart->set_entry(sart, i, APPLE_SART_FLAGS_ALLOW, (void *)e_start,
+                                 sart->shadow[i].size - sz))
+                return false;
+            sart->shadow[i].size -= sz;
+            return true;
+        }
+
+        printf("sart: cannot split merged entry at 0x%lx\n", e_start);
+        return false;
     }
 
     printf("sart: could not find entry to be removed\n");
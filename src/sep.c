@@ -18,6 +18,9 @@
 
 #define SEP_TIMEOUT 1000
 
+/* In-flight request window; well under the A2I mailbox FIFO depth */
+#define SEP_QUEUE_DEPTH 8
+
 static asc_dev_t *sep_asc = NULL;
 
 int sep_init(void)
@@ -40,19 +43,36 @@ size_t sep_get_random(void *buffer, size_t len)
     if (ret)
         return 0;
 
-    while (len) {
+    /*
+     * Each reply only carries four bytes, so keep a window of requests in
+     * flight instead of serializing on every reply. The ROM endpoint
+     * answers in order (the message format has no tag field to match on),
+     * so replies are consumed in submission order.
+     */
+    size_t total = (len + sizeof(u32) - 1) / sizeof(u32);
+    size_t sent = 0, received = 0;
+
+    while (received < total) {
         struct asc_message reply;
         u32 rng;
         size_t copy;
 
-        if (!asc_send(sep_asc, &msg_getrand))
+        while (sent < total && sent - received < SEP_QUEUE_DEPTH) {
+            if (!asc_send(sep_asc, &msg_getrand))
+                break;
+            sent++;
+        }
+
+        if (sent == received)
             return done;
+
         if (!asc_recv_timeout(sep_asc, &reply, SEP_TIMEOUT))
             return done;
         if (FIELD_GET(SEP_MSG_CMD, reply.msg0) != SEP_REPLY_GETRAND) {
             printf("SEP: unexpected getrand reply: %016lx\n", reply.msg0);
             return done;
         }
+        received++;
 
         rng = FIELD_GET(SEP_MSG_DATA, reply.msg0);
         copy = sizeof(rng);
@@ -2,8 +2,10 @@
 
 #include "adt.h"
 #include "errno.h"
+#include "hash.h"
 #include "malloc.h"
 #include "sio.h"
+#include "string.h"
 #include "types.h"
 #include "utils.h"
 
@@ -21,7 +23,7 @@ static void *alloc_mapped_data(struct sio_data *siodata, size_t size, u64 *iova)
     struct sio_mapping *mapping = &siodata->fwdata[siodata->num_fwdata];
 
 #ifdef MERGE_SIO_FWDATA
-    if (siodata->num_fwdata &&
+    if (siodata->num_fwdata && !(mapping - 1)->shared &&
         ALIGN_UP((mapping - 1)->size, SZ_16K) >= (mapping - 1)->size + size) {
         mapping--;
         *iova = mapping->iova + mapping->size;
@@ -72,6 +74,82 @@ static void *add_fwdata(struct sio_data *siodata, size_t size, u32 param_id)
     return p;
 }
 
+/*
+ * Content-addressed store for the read-only tables: identical content (the
+ * dmashim/map-range/tunables data is frequently the same across SIO
+ * instances) gets a single copy in reserved memory, which the DT fixups then
+ * reference from every consumer. Writable buffers (panic buffer and friends)
+ * never go through here.
+ */
+#define MAX_SHARED_BLOBS 16
+
+static struct {
+    u64 hash;
+    u64 phys;
+    size_t size;
+} blob_store[MAX_SHARED_BLOBS];
+static int num_blobs;
+
+static u64 sio_blob_intern(const void *data, size_t size)
+{
+    u64 hash = xxh64(data, size, 0);
+
+    for (int i = 0; i < num_blobs; i++) {
+        if (blob_store[i].hash == hash && blob_store[i].size == size &&
+            !memcmp((void *)blob_store[i].phys, data, size))
+            return blob_store[i].phys;
+    }
+
+    u64 phys = top_of_memory_alloc(size);
+    if (!phys)
+        return 0;
+
+    memset64((void *)phys, 0, ALIGN_UP(size, SZ_16K));
+    memcpy8((void *)phys, (void *)data, size);
+
+    if (num_blobs < MAX_SHARED_BLOBS) {
+        blob_store[num_blobs].hash = hash;
+        blob_store[num_blobs].phys = phys;
+        blob_store[num_blobs].size = size;
+        num_blobs++;
+    }
+
+    return phys;
+}
+
+static bool add_shared_fwdata(struct sio_data *siodata, const void *data, size_t size, u32 param_id)
+{
+    if (siodata->num_fwdata >= MAX_FWDATA || siodata->num_fwparams + 1 >= MAX_FWPARAMS)
+        return false;
+
+    u64 phys = sio_blob_intern(data, size);
+    if (!phys)
+        return false;
+
+    struct sio_mapping *mapping = &siodata->fwdata[siodata->num_fwdata];
+    u64 iova;
+
+    if (!siodata->num_fwdata++)
+        iova = siodata->iova_base;
+    else
+        iova = ALIGN_UP((mapping - 1)->iova + (mapping - 1)->size, SZ_16K);
+
+    mapping->iova = iova;
+    mapping->phys = phys;
+    mapping->size = ALIGN_UP(size, SZ_4K);
+    mapping->shared = true;
+
+    struct sio_fwparam *param = &siodata->fwparams[siodata->num_fwparams];
+    param->key = param_id;
+    param->value = iova >> 12;
+    param++;
+    param->key = param_id + 1;
+    param->value = size;
+    siodata->num_fwparams += 2;
+
+    return true;
+}
+
 #define PARAM_UNK_000b     0x000b
 #define PARAM_PANIC_BUFFER 0x000f
 #define PARAM_MAP_RANGE    0x001a
@@ -178,24 +256,22 @@ struct sio_data *sio_setup_fwdata(const char *adt_path)
         }
 
         if (!rule->keyed) {
-            u8 *sio_blob = add_fwdata(siodata, len, rule->fw_param);
-            if (!sio_blob)
+            if (!add_shared_fwdata(siodata, adt_blob, len, rule->fw_param))
                 goto err;
-            memcpy8(sio_blob, (void *)adt_blob, len);
             continue;
         }
 
-        int nkeys = find_key_index(rule->keys, 0);
-        u8 *sio_blob = add_fwdata(siodata, nkeys * rule->blobsize, rule->fw_param);
-        if (!sio_blob)
-            goto err;
-
         if (len % (rule->blobsize + 4) != 0) {
             printf("%s: bad length %d of ADT property '%s', expected multiple of %d + 4\n",
                    __func__, len, rule->prop, rule->blobsize);
             goto err;
         }
 
+        int nkeys = find_key_index(rule->keys, 0);
+        u8 *sio_blob = calloc(nkeys, rule->blobsize);
+        if (!sio_blob)
+            goto err;
+
         for (u32 off = 0; off + rule->blobsize <= len; off += (rule->blobsize + 4)) {
             const u8 *p = &adt_blob[off];
             u32 key = *((u32 *)p);
@@ -204,11 +280,17 @@ struct sio_data *sio_setup_fwdata(const char *adt_path)
             if (key_idx >= nkeys) {
                 printf("%s: unknown key %x found in ADT property '%s'\n", __func__, key,
                        rule->prop);
+                free(sio_blob);
                 goto err;
             }
 
             memcpy8(sio_blob + (key_idx * rule->blobsize), (void *)(p + 4), rule->blobsize);
         }
+
+        bool ok = add_shared_fwdata(siodata, sio_blob, nkeys * rule->blobsize, rule->fw_param);
+        free(sio_blob);
+        if (!ok)
+            goto err;
     }
 
     mapping_fixup(siodata);
@@ -227,3 +309,38 @@ err:
 
     return NULL;
 }
+
+#define MAX_SIO_INSTANCES 2
+
+static struct {
+    char path[32];
+    struct sio_data *data;
+} sio_fwdata_cache[MAX_SIO_INSTANCES];
+
+struct sio_data *sio_get_fwdata(const char *adt_path)
+{
+    int i;
+
+    /*
+     * The prepared tables only depend on the (immutable) ADT and permanently
+     * consume top-of-memory pages, so build them once per instance and reuse
+     * the handle when the device tree is rebuilt.
+     */
+    for (i = 0; i < MAX_SIO_INSTANCES; i++) {
+        if (!sio_fwdata_cache[i].data)
+            break;
+        if (!strcmp(sio_fwdata_cache[i].path, adt_path))
+            return sio_fwdata_cache[i].data;
+    }
+
+    struct sio_data *siodata = sio_setup_fwdata(adt_path);
+    if (!siodata)
+        return NULL;
+
+    if (i < MAX_SIO_INSTANCES && strlen(adt_path) < sizeof(sio_fwdata_cache[i].path)) {
+        strcpy(sio_fwdata_cache[i].path, adt_path);
+        sio_fwdata_cache[i].data = siodata;
+    }
+
+    return siodata;
+}
@@ -9,6 +9,7 @@ struct sio_mapping {
     u64 phys;
     u64 iova;
     u64 size;
+    bool shared; // phys pages deduplicated with other instances; never write
 };
 
 struct sio_fwparam {
@@ -16,7 +17,7 @@ struct sio_fwparam {
     u32 value;
 };
 
-#define MAX_FWDATA   6
+#define MAX_FWDATA   8
 #define MAX_FWPARAMS 16
 
 struct sio_data {
@@ -28,5 +29,6 @@ struct sio_data {
 };
 
 struct sio_data *sio_setup_fwdata(const char *adt_path);
+struct sio_data *sio_get_fwdata(const char *adt_path);
 
 #endif
@@ -18,8 +18,8 @@
 #define SMC_MSG_TYPE GENMASK(7, 0)
 #define SMC_MSG_ID   GENMASK(15, 12)
 
-#define SMC_WRITE_KEY_SIZE GENMASK(23, 16)
-#define SMC_WRITE_KEY_KEY  GENMASK(63, 32)
+#define SMC_MSG_SIZE GENMASK(23, 16)
+#define SMC_MSG_KEY  GENMASK(63, 32)
 
 #define SMC_RESULT_RESULT GENMASK(7, 0)
 #define SMC_RESULT_ID     GENMASK(15, 12)
@@ -174,8 +174,133 @@ int smc_write_u32(smc_dev_t *smc, u32 key, u32 value)
 {
     memcpy(smc->shmem, &value, sizeof(value));
     u64 msg = FIELD_PREP(SMC_MSG_TYPE, SMC_WRITE_KEY);
-    msg |= FIELD_PREP(SMC_WRITE_KEY_SIZE, sizeof(value));
-    msg |= FIELD_PREP(SMC_WRITE_KEY_KEY, key);
+    msg |= FIELD_PREP(SMC_MSG_SIZE, sizeof(value));
+    msg |= FIELD_PREP(SMC_MSG_KEY, key);
 
     return smc_cmd(smc, msg);
 }
+
+int smc_read_async(smc_dev_t *smc, u32 key, size_t size)
+{
+    u8 id = smc->msgid++ & 0xF;
+    if (smc->outstanding[id]) {
+        printf("SMC: too many outstanding commands\n");
+        return -1;
+    }
+    smc->outstanding[id] = true;
+
+    u64 msg = FIELD_PREP(SMC_MSG_TYPE, SMC_READ_KEY);
+    msg |= FIELD_PREP(SMC_MSG_ID, id);
+    msg |= FIELD_PREP(SMC_MSG_SIZE, size);
+    msg |= FIELD_PREP(SMC_MSG_KEY, key);
+
+    smc_send(smc, msg);
+
+    return id;
+}
+
+int smc_poll_async(smc_dev_t *smc)
+{
+    int ret;
+    struct rtkit_message msg;
+
+    while ((ret = rtkit_recv(smc->rtkit, &msg)) > 0) {
+        if (msg.ep != SMC_ENDPOINT) {
+            printf("SMC: received message for unexpected endpoint 0x%02x\n", msg.ep);
+            continue;
+        }
+
+        smc_handle_msg(smc, msg.msg);
+    }
+
+    if (ret < 0)
+        printf("SMC: rtkit_recv failed!\n");
+
+    return ret;
+}
+
+s64 smc_wait_async(smc_dev_t *smc, int id, void *buf, size_t size)
+{
+    assert(id >= 0 && id < SMC_NUM_IDS);
+
+    while (smc->outstanding[id]) {
+        int ret = smc_work(smc);
+        if (ret < 0)
+            return ret;
+    }
+
+    u64 result = smc->ret[id];
+    u32 ret = FIELD_GET(SMC_RESULT_RESULT, result);
+    if (ret) {
+        printf("SMC: read[0x%x] failed: %u\n", id, ret);
+        return -(s64)ret;
+    }
+
+    size_t rsize = FIELD_GET(SMC_RESULT_SIZE, result);
+    if (rsize > size)
+        rsize = size;
+
+    if (size <= 4) {
+        u32 value = FIELD_GET(SMC_RESULT_VALUE, result);
+        memcpy(buf, &value, rsize);
+    } else {
+        memcpy(buf, smc->shmem + FIELD_GET(SMC_RESULT_VALUE, result), rsize);
+    }
+
+    return rsize;
+}
+
+s64 smc_read(smc_dev_t *smc, u32 key, void *buf, size_t size)
+{
+    int id = smc_read_async(smc, key, size);
+    if (id < 0)
+        return id;
+
+    return smc_wait_async(smc, id, buf, size);
+}
+
+int smc_read_u32(smc_dev_t *smc, u32 key, u32 *value)
+{
+    *value = 0;
+    s64 ret = smc_read(smc, key, value, sizeof(*value));
+
+    return ret < 0 ? (int)ret : 0;
+}
+
+int smc_read_batch(smc_dev_t *smc, const u32 *keys, const u8 *sizes, u64 *values, size_t count)
+{
+    int ret = 0;
+
+    /*
+     * Pipeline reads over the mailbox instead of one round trip per key.
+     * Keys up to 4 bytes come back inside the result message itself, so
+     * replies cannot clobber each other in shmem; keep one message ID
+     * free so the firmware always has room to make progress.
+     */
+    while (count) {
+        size_t batch = min(count, (size_t)(SMC_NUM_IDS - 1));
+        int ids[SMC_NUM_IDS];
+
+        for (size_t i = 0; i < batch; i++) {
+            assert(sizes[i] <= 4);
+            ids[i] = smc_read_async(smc, keys[i], sizes[i]);
+        }
+
+        for (size_t i = 0; i < batch; i++) {
+            values[i] = 0;
+            s64 rsize = smc_wait_async(smc, ids[i], &values[i], sizes[i]);
+            if (rsize < 0)
+                ret = (int)rsize;
+        }
+
+        if (ret)
+            return ret;
+
+        keys += batch;
+        sizes += batch;
+        values += batch;
+        count -= batch;
+    }
+
+    return 0;
+}
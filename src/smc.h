@@ -10,6 +10,14 @@
 typedef struct smc_dev smc_dev_t;
 
 int smc_write_u32(smc_dev_t *smc, u32 key, u32 value);
+s64 smc_read(smc_dev_t *smc, u32 key, void *buf, size_t size);
+int smc_read_u32(smc_dev_t *smc, u32 key, u32 *value);
+
+/* Pipelined reads: submit returns a message ID, wait collects the value. */
+int smc_read_async(smc_dev_t *smc, u32 key, size_t size);
+int smc_poll_async(smc_dev_t *smc);
+s64 smc_wait_async(smc_dev_t *smc, int id, void *buf, size_t size);
+int smc_read_batch(smc_dev_t *smc, const u32 *keys, const u8 *sizes, u64 *values, size_t count);
 
 smc_dev_t *smc_init(void);
 void smc_shutdown(smc_dev_t *smc);
@@ -3,6 +3,7 @@
 #include "smp.h"
 #include "adt.h"
 #include "cpu_regs.h"
+#include "evtlog.h"
 #include "malloc.h"
 #include "pmgr.h"
 #include "soc.h"
@@ -27,6 +28,26 @@ struct spin_table {
     u64 retval;
 };
 
+/*
+ * Per-CPU work queue: a small multi-producer mailbox ring next to the single
+ * smp_call4() slot. Producers claim a ticket with an atomic add on wptr (so
+ * any CPU with its MMU on can queue), fill the slot, and publish it by writing
+ * func. The secondary drains the ring from its idle loop and publishes each
+ * retval by bumping the slot seq, which doubles as the completion fence.
+ */
+struct smp_work {
+    u64 func;
+    u64 args[4];
+    u64 retval;
+    u64 seq;
+};
+
+struct smp_wq {
+    u64 wptr;
+    u64 rptr;
+    struct smp_work ring[SMP_WQ_SIZE];
+};
+
 void *_reset_stack;
 
 #define DUMMY_STACK_SIZE 0x1000
@@ -37,35 +58,106 @@ u8 *secondary_stacks[MAX_CPUS] = {dummy_stack};
 static bool wfe_mode = false;
 
 static int target_cpu;
+static int target_claimed;
 static int cpu_nodes[MAX_CPUS];
 static struct spin_table spin_table[MAX_CPUS];
+static struct smp_wq smp_wq[MAX_CPUS];
 static u64 pmgr_reg;
 static u64 cpu_start_off;
 
+static struct smp_cluster clusters[MAX_CLUSTERS];
+static int num_clusters;
+static s8 cpu_cluster_idx[MAX_CPUS];
+
 extern u8 _vectors_start[0];
 int boot_cpu_idx = -1;
 u64 boot_cpu_mpidr = 0;
 
-void smp_secondary_entry(void)
+/*
+ * Every secondary-side completion store is followed by a SEV, so waiters on
+ * the boot CPU can sleep in WFE instead of hammering the coherence fabric
+ * with a spin loop. SEV sets the waiter's event register even if it has not
+ * reached its WFE yet, so the check-WFE-recheck pattern cannot miss a wakeup;
+ * the condition is rechecked after every wake since WFE also returns on
+ * unrelated events.
+ */
+#define smp_wait_for(cond)                                                                         \
+    do {                                                                                           \
+        sysop("dmb sy");                                                                           \
+        while (!(cond)) {                                                                          \
+            sysop("wfe");                                                                          \
+            sysop("dmb sy");                                                                       \
+        }                                                                                          \
+        sysop("dmb sy");                                                                           \
+    } while (0)
+
+static bool smp_wq_process(struct smp_wq *wq)
+{
+    bool ran = false;
+
+    while (wq->rptr != wq->wptr) {
+        struct smp_work *work = &wq->ring[wq->rptr & (SMP_WQ_SIZE - 1)];
+        u64 func;
+
+        // The producer bumps wptr before filling the slot, so wait for it
+        while (!(func = work->func))
+            sysop("dmb sy");
+        sysop("dmb sy");
+        work->retval = ((u64(*)(u64 a, u64 b, u64 c, u64 d))func)(work->args[0], work->args[1],
+                                                                  work->args[2], work->args[3]);
+        work->func = 0;
+        sysop("dmb sy");
+        work->seq = wq->rptr + 1;
+        sysop("dmb sy");
+        wq->rptr++;
+        sysop("dsb sy");
+        sysop("sev");
+        ran = true;
+    }
+
+    return ran;
+}
+
+/*
+ * Runs first thing on an incoming secondary, before its (slow, serial) CPU
+ * init: take ownership of the shared boot globals and hand them back to the
+ * boot CPU, so it can release the next core in the cluster while this one
+ * applies its chickens and sets up exceptions concurrently.
+ */
+void smp_secondary_prepare(void)
 {
-    struct spin_table *me = &spin_table[target_cpu];
+    int index = target_cpu;
 
     if (in_el2())
-        msr(TPIDR_EL2, target_cpu);
+        msr(TPIDR_EL2, index);
     else
-        msr(TPIDR_EL1, target_cpu);
+        msr(TPIDR_EL1, index);
 
-    printf("  Index: %d (table: %p)\n\n", target_cpu, me);
+    spin_table[index].mpidr = mrs(MPIDR_EL1) & 0xFFFFFF;
 
-    me->mpidr = mrs(MPIDR_EL1) & 0xFFFFFF;
+    sysop("dmb sy");
+    target_claimed = 1;
+    sysop("dsb sy");
+    sysop("sev");
+}
+
+void smp_secondary_entry(void)
+{
+    int index = smp_id();
+    struct spin_table *me = &spin_table[index];
+
+    printf("  Index: %d (table: %p)\n\n", index, me);
 
     sysop("dmb sy");
     me->flag = 1;
-    sysop("dmb sy");
+    sysop("dsb sy");
+    sysop("sev");
     u64 target;
 
     while (1) {
         while (!(target = me->target)) {
+            if (smp_wq_process(&smp_wq[index]))
+                continue;
             if (wfe_mode) {
                 sysop("wfe");
             } else {
@@ -76,30 +168,40 @@ void smp_secondary_entry(void)
         }
         sysop("dmb sy");
         me->flag++;
-        sysop("dmb sy");
+        sysop("dsb sy");
+        sysop("sev");
         me->retval = ((u64(*)(u64 a, u64 b, u64 c, u64 d))target)(me->args[0], me->args[1],
                                                                   me->args[2], me->args[3]);
         sysop("dmb sy");
         me->target = 0;
-        sysop("dmb sy");
+        sysop("dsb sy");
+        sysop("sev");
     }
 }
 
-static void smp_start_cpu(int index, int die, int cluster, int core, u64 impl, u64 cpu_start_base)
+/*
+ * Power up one core and wait only until it has claimed the shared boot
+ * globals (target_cpu and the reset stack), not until it is fully up; the
+ * rest of its init runs on the core itself, concurrently with its siblings.
+ */
+static int smp_start_cpu_async(int index, int die, int cluster, int core, u64 impl,
+                               u64 cpu_start_base)
 {
     int i;
 
     if (index >= MAX_CPUS)
-        return;
+        return -1;
 
     if (spin_table[index].flag)
-        return;
+        return -1;
 
-    printf("Starting CPU %d (%d:%d:%d)... ", index, die, cluster, core);
+    printf("Starting CPU %d (%d:%d:%d)...\n", index, die, cluster, core);
 
     memset(&spin_table[index], 0, sizeof(struct spin_table));
+    memset(&smp_wq[index], 0, sizeof(struct smp_wq));
 
     target_cpu = index;
+    target_claimed = 0;
     secondary_stacks[index] = memalign(0x4000, SECONDARY_STACK_SIZE);
     _reset_stack = secondary_stacks[index] + SECONDARY_STACK_SIZE;
 
@@ -118,17 +220,41 @@ static void smp_start_cpu(int index, int die, int cluster, int core, u64 impl, u
 
     for (i = 0; i < 100; i++) {
         sysop("dmb ld");
-        if (spin_table[index].flag)
+        if (target_claimed)
             break;
         udelay(1000);
     }
 
-    if (i >= 100)
-        printf("Failed!\n");
-    else
-        printf("  Started.\n");
+    if (i >= 100) {
+        printf("CPU %d failed to start!\n", index);
+        return -1;
+    }
 
-    _reset_stack = dummy_stack + DUMMY_STACK_SIZE;
+    return 0;
+}
+
+/* Barrier: wait for all concurrently released cores of a cluster to come up */
+static void smp_wait_cluster(int *pending, int *npending)
+{
+    for (int j = 0; j < *npending; j++) {
+        int index = pending[j];
+        int i;
+
+        for (i = 0; i < 100; i++) {
+            sysop("dmb ld");
+            if (spin_table[index].flag)
+                break;
+            udelay(1000);
+        }
+
+        if (i >= 100) {
+            printf("CPU %d failed to come up!\n", index);
+        } else {
+            EVT(SMP_CPU_UP, index);
+        }
+    }
+
+    *npending = 0;
 }
 
 static void smp_stop_cpu(int index, int die, int cluster, int core, u64 impl, u64 cpu_start_base,
@@ -178,10 +304,57 @@ static void smp_stop_cpu(int index, int die, int cluster, int core, u64 impl, u6
     }
 }
 
+static void smp_parse_topology(void)
+{
+    num_clusters = 0;
+    memset(cpu_cluster_idx, -1, sizeof(cpu_cluster_idx));
+
+    for (int i = 0; i < MAX_CPUS; i++) {
+        int node = cpu_nodes[i];
+        if (!node)
+            continue;
+
+        u32 reg;
+        if (ADT_GETPROP(adt, node, "reg", &reg) < 0)
+            continue;
+
+        u8 cluster = FIELD_GET(CPU_REG_CLUSTER, reg);
+        u8 die = FIELD_GET(CPU_REG_DIE, reg);
+
+        enum cpu_type type = CPU_TYPE_UNKNOWN;
+        const char *ctype = adt_getprop(adt, node, "cluster-type", NULL);
+        if (ctype && ctype[0] == 'P')
+            type = CPU_TYPE_P;
+        else if (ctype && ctype[0] == 'E')
+            type = CPU_TYPE_E;
+
+        int c;
+        for (c = 0; c < num_clusters; c++)
+            if (clusters[c].die == die && clusters[c].cluster == cluster)
+                break;
+        if (c == num_clusters) {
+            if (num_clusters == MAX_CLUSTERS) {
+                printf("smp: too many clusters, increase MAX_CLUSTERS\n");
+                continue;
+            }
+            clusters[c].die = die;
+            clusters[c].cluster = cluster;
+            clusters[c].type = type;
+            clusters[c].ncpus = 0;
+            num_clusters++;
+        }
+
+        clusters[c].cpus[clusters[c].ncpus++] = i;
+        cpu_cluster_idx[i] = c;
+    }
+}
+
 void smp_start_secondaries(void)
 {
     printf("Starting secondary CPUs...\n");
 
+    EVT(SMP_START, 0);
+
     int pmgr_path[8];
 
     if (adt_path_offset_trace(adt, "/arm-io/pmgr", pmgr_path) < 0) {
@@ -266,6 +439,19 @@ void smp_start_secondaries(void)
         return;
     }
 
+    smp_parse_topology();
+
+    /*
+     * Release all cores of a cluster back to back, pausing only for each
+     * core's brief claim of the shared boot globals, and barrier at cluster
+     * boundaries: each core runs its own chickens/exception setup while its
+     * siblings power up, instead of the boot CPU waiting out every core's
+     * full init in turn.
+     */
+    int pending[MAX_CPUS];
+    int npending = 0;
+    int cur_die = -1, cur_cluster = -1;
+
     for (int i = 0; i < MAX_CPUS; i++) {
 
         if (i == boot_cpu_idx)
@@ -286,10 +472,29 @@ void smp_start_secondaries(void)
         u8 cluster = FIELD_GET(CPU_REG_CLUSTER, reg);
         u8 die = FIELD_GET(CPU_REG_DIE, reg);
 
-        smp_start_cpu(i, die, cluster, core, cpu_impl_reg[0], pmgr_reg + cpu_start_off);
+        if (spin_table[i].flag) {
+            // Already running from a previous call
+            EVT(SMP_CPU_UP, i);
+            continue;
+        }
+
+        if ((die != cur_die || cluster != cur_cluster) && npending)
+            smp_wait_cluster(pending, &npending);
+        cur_die = die;
+        cur_cluster = cluster;
+
+        if (smp_start_cpu_async(i, die, cluster, core, cpu_impl_reg[0],
+                                pmgr_reg + cpu_start_off) == 0)
+            pending[npending++] = i;
     }
 
+    smp_wait_cluster(pending, &npending);
+
+    _reset_stack = dummy_stack + DUMMY_STACK_SIZE;
+
     spin_table[boot_cpu_idx].mpidr = mrs(MPIDR_EL1) & 0xFFFFFF;
+
+    EVT(SMP_DONE, 0);
 }
 
 void smp_stop_secondaries(bool deep_sleep)
@@ -351,8 +556,7 @@ void smp_call4(int cpu, void *func, u64 arg0, u64 arg1, u64 arg2, u64 arg3)
     else
         smp_send_ipi(cpu);
 
-    while (target->flag == flag)
-        sysop("dmb sy");
+    smp_wait_for(target->flag != flag);
 }
 
 u64 smp_wait(int cpu)
@@ -362,12 +566,97 @@ u64 smp_wait(int cpu)
 
     struct spin_table *target = &spin_table[cpu];
 
-    while (target->target)
-        sysop("dmb sy");
+    smp_wait_for(!target->target);
 
     return target->retval;
 }
 
+void smp_group_init(struct smp_group *group)
+{
+    group->ncpus = 0;
+}
+
+void smp_group_call4(struct smp_group *group, int cpu, void *func, u64 arg0, u64 arg1, u64 arg2,
+                     u64 arg3)
+{
+    if (group->ncpus >= MAX_CPUS)
+        return;
+
+    group->cpus[group->ncpus++] = cpu;
+    smp_call4(cpu, func, arg0, arg1, arg2, arg3);
+}
+
+void smp_group_wait(struct smp_group *group)
+{
+    while (1) {
+        bool busy = false;
+
+        sysop("dmb sy");
+        for (int i = 0; i < group->ncpus; i++)
+            if (spin_table[group->cpus[i]].target)
+                busy = true;
+
+        if (!busy)
+            break;
+        sysop("wfe");
+    }
+
+    sysop("dmb sy");
+    for (int i = 0; i < group->ncpus; i++)
+        group->retval[i] = spin_table[group->cpus[i]].retval;
+}
+
+s64 smp_queue_work(int cpu, void *func, u64 arg0, u64 arg1, u64 arg2, u64 arg3)
+{
+    if (cpu >= MAX_CPUS || cpu == boot_cpu_idx || !smp_is_alive(cpu))
+        return -1;
+
+    struct smp_wq *wq = &smp_wq[cpu];
+
+    u64 ticket = __atomic_fetch_add(&wq->wptr, 1, __ATOMIC_ACQ_REL);
+
+    // Wait for our slot to free up if the ring is full
+    smp_wait_for(ticket - wq->rptr < SMP_WQ_SIZE);
+
+    struct smp_work *work = &wq->ring[ticket & (SMP_WQ_SIZE - 1)];
+    work->args[0] = arg0;
+    work->args[1] = arg1;
+    work->args[2] = arg2;
+    work->args[3] = arg3;
+    sysop("dmb sy");
+    work->func = (u64)func;
+    sysop("dsb sy");
+
+    if (wfe_mode)
+        sysop("sev");
+    else
+        smp_send_ipi(cpu);
+
+    return ticket;
+}
+
+u64 smp_work_wait(int cpu, s64 ticket)
+{
+    if (cpu >= MAX_CPUS || ticket < 0)
+        return 0;
+
+    struct smp_work *work = &smp_wq[cpu].ring[ticket & (SMP_WQ_SIZE - 1)];
+
+    smp_wait_for(work->seq == (u64)ticket + 1);
+
+    return work->retval;
+}
+
+void smp_work_flush(int cpu)
+{
+    if (cpu >= MAX_CPUS)
+        return;
+
+    struct smp_wq *wq = &smp_wq[cpu];
+
+    smp_wait_for(wq->rptr == wq->wptr);
+}
+
 void smp_set_wfe_mode(bool new_mode)
 {
     wfe_mode = new_mode;
@@ -388,6 +677,76 @@ bool smp_is_alive(int cpu)
     return spin_table[cpu].flag;
 }
 
+bool smp_is_idle(int cpu)
+{
+    if (cpu >= MAX_CPUS)
+        return false;
+
+    /* Started, and not off running a call (e.g. a guest vCPU) */
+    return spin_table[cpu].flag && !spin_table[cpu].target;
+}
+
+int smp_num_clusters(void)
+{
+    return num_clusters;
+}
+
+const struct smp_cluster *smp_cluster_info(int i)
+{
+    if (i < 0 || i >= num_clusters)
+        return NULL;
+
+    return &clusters[i];
+}
+
+int smp_cpu_cluster(int cpu)
+{
+    if (cpu < 0 || cpu >= MAX_CPUS)
+        return -1;
+
+    return cpu_cluster_idx[cpu];
+}
+
+enum cpu_type smp_cpu_type(int cpu)
+{
+    int c = smp_cpu_cluster(cpu);
+
+    return c < 0 ? CPU_TYPE_UNKNOWN : clusters[c].type;
+}
+
+int smp_idle_cpus(enum cpu_type type, int die, int *cpus, int max)
+{
+    int n = 0;
+
+    /* Before the topology pass has run, fall back to a flat scan */
+    if (!num_clusters) {
+        for (int cpu = 0; cpu < MAX_CPUS && n < max; cpu++)
+            if (cpu != boot_cpu_idx && smp_is_idle(cpu))
+                cpus[n++] = cpu;
+        return n;
+    }
+
+    static const enum cpu_type pref[] = {CPU_TYPE_P, CPU_TYPE_UNKNOWN, CPU_TYPE_E};
+
+    for (unsigned int p = 0; p < ARRAY_SIZE(pref) && n < max; p++) {
+        if (type != CPU_TYPE_UNKNOWN && pref[p] != type)
+            continue;
+        for (int c = 0; c < num_clusters && n < max; c++) {
+            if (clusters[c].type != pref[p])
+                continue;
+            if (die >= 0 && clusters[c].die != die)
+                continue;
+            for (int j = 0; j < clusters[c].ncpus && n < max; j++) {
+                int cpu = clusters[c].cpus[j];
+                if (cpu != boot_cpu_idx && smp_is_idle(cpu))
+                    cpus[n++] = cpu;
+            }
+        }
+    }
+
+    return n;
+}
+
 uint64_t smp_get_mpidr(int cpu)
 {
     if (cpu >= MAX_CPUS)
@@ -11,6 +11,7 @@
 #define SECONDARY_STACK_SIZE 0x10000
 extern u8 *secondary_stacks[MAX_CPUS];
 
+void smp_secondary_prepare(void);
 void smp_secondary_entry(void);
 
 void smp_start_secondaries(void);
@@ -25,7 +26,73 @@ void smp_call4(int cpu, void *func, u64 arg0, u64 arg1, u64 arg2, u64 arg3);
 
 u64 smp_wait(int cpu);
 
+/*
+ * Completion group: dispatch calls to a set of CPUs, then wait for all of
+ * them in a single WFE loop instead of one wait per core. retval[] is filled
+ * in dispatch order once smp_group_wait() returns.
+ */
+struct smp_group {
+    int ncpus;
+    int cpus[MAX_CPUS];
+    u64 retval[MAX_CPUS];
+};
+
+#define smp_group_call0(g, i, f)          smp_group_call4(g, i, f, 0, 0, 0, 0)
+#define smp_group_call1(g, i, f, a)       smp_group_call4(g, i, f, a, 0, 0, 0)
+#define smp_group_call2(g, i, f, a, b)    smp_group_call4(g, i, f, a, b, 0, 0)
+#define smp_group_call3(g, i, f, a, b, c) smp_group_call4(g, i, f, a, b, c, 0)
+
+void smp_group_init(struct smp_group *group);
+void smp_group_call4(struct smp_group *group, int cpu, void *func, u64 arg0, u64 arg1, u64 arg2,
+                     u64 arg3);
+void smp_group_wait(struct smp_group *group);
+
+/* Per-CPU work queue; tickets complete in order, smp_work_flush() is a fence */
+#define SMP_WQ_SIZE 16
+
+s64 smp_queue_work(int cpu, void *func, u64 arg0, u64 arg1, u64 arg2, u64 arg3);
+u64 smp_work_wait(int cpu, s64 ticket);
+void smp_work_flush(int cpu);
+
 bool smp_is_alive(int cpu);
+bool smp_is_idle(int cpu);
+
+/*
+ * CPU topology, parsed from the ADT when the secondaries are brought up. A
+ * cluster is a set of cores sharing an L2; on multi-die parts each cluster
+ * also carries its die index. The type comes from the per-CPU "cluster-type"
+ * ADT property ("P"/"E"), with UNKNOWN for ADTs that lack it.
+ */
+#define MAX_CLUSTERS 12
+
+enum cpu_type {
+    CPU_TYPE_UNKNOWN = 0,
+    CPU_TYPE_E,
+    CPU_TYPE_P,
+};
+
+struct smp_cluster {
+    u8 die;
+    u8 cluster; /* index within the die */
+    enum cpu_type type;
+    int ncpus;
+    int cpus[MAX_CPUS];
+};
+
+int smp_num_clusters(void);
+const struct smp_cluster *smp_cluster_info(int i);
+int smp_cpu_cluster(int cpu); /* index into smp_cluster_info(), or -1 */
+enum cpu_type smp_cpu_type(int cpu);
+
+/*
+ * Gather up to max idle secondaries into cpus[], whole clusters at a time:
+ * P clusters come first so bandwidth-heavy work lands on the big cores, and
+ * cores sharing an L2 end up adjacent in the output so callers that slice a
+ * buffer in order don't split neighbouring lines across dies. type and die
+ * restrict the result; pass CPU_TYPE_UNKNOWN / -1 for no restriction.
+ * Returns the number of CPUs gathered.
+ */
+int smp_idle_cpus(enum cpu_type type, int die, int *cpus, int max);
 uint64_t smp_get_mpidr(int cpu);
 u64 smp_get_release_addr(int cpu);
 void smp_set_wfe_mode(bool new_mode);
@@ -106,10 +106,14 @@ void _start_c(void *boot_args, void *base)
 /* Secondary SMP core boot */
 void _cpu_reset_c(void *stack)
 {
-    if (!is_boot_cpu())
+    if (!is_boot_cpu()) {
+        // Release the shared boot globals first, so the boot CPU can start
+        // our siblings while we go through the init below
+        smp_secondary_prepare();
         uart_puts("RVBAR entry on secondary CPU");
-    else
+    } else {
         uart_puts("RVBAR entry on primary CPU");
+    }
 
     printf("\n  Stack base: %p\n", stack);
     printf("  MPIDR: 0x%lx\n", mrs(MPIDR_EL1));
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: MIT */
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "string.h"
 
@@ -11,6 +12,40 @@ void *memcpy(void *s1, const void *s2, size_t n)
     char *dest = (char *)s1;
     const char *src = (const char *)s2;
 
+    /*
+     * When both pointers can reach mutual 64-bit alignment, copy in 32-byte
+     * blocks (which the compiler turns into ldp/stp pairs). Mutually
+     * misaligned pointers stay on the byte loop, which keeps this safe with
+     * -mstrict-align and for memory that faults on unaligned access.
+     */
+    if (n >= 16 && !(((uintptr_t)dest ^ (uintptr_t)src) & 7)) {
+        while ((uintptr_t)dest & 7) {
+            *dest++ = *src++;
+            n--;
+        }
+
+        uint64_t *d64 = (uint64_t *)dest;
+        const uint64_t *s64 = (const uint64_t *)src;
+
+        while (n >= 32) {
+            uint64_t a = s64[0], b = s64[1], c = s64[2], d = s64[3];
+            d64[0] = a;
+            d64[1] = b;
+            d64[2] = c;
+            d64[3] = d;
+            d64 += 4;
+            s64 += 4;
+            n -= 32;
+        }
+        while (n >= 8) {
+            *d64++ = *s64++;
+            n -= 8;
+        }
+
+        dest = (char *)d64;
+        src = (const char *)s64;
+    }
+
     while (n--) {
         *dest++ = *src++;
     }
@@ -24,9 +59,8 @@ void *memmove(void *s1, const void *s2, size_t n)
     const char *src = (const char *)s2;
 
     if (dest <= src) {
-        while (n--) {
-            *dest++ = *src++;
-        }
+        /* Forward copy trails its reads, so the memcpy fast path is safe */
+        return memcpy(s1, s2, n);
     } else {
         src += n;
         dest += n;
@@ -60,6 +94,35 @@ void *memset(void *s, int c, size_t n)
 {
     unsigned char *p = (unsigned char *)s;
 
+    if (n >= 16) {
+        while ((uintptr_t)p & 7) {
+            *p++ = (unsigned char)c;
+            n--;
+        }
+
+        uint64_t v = (unsigned char)c;
+        v |= v << 8;
+        v |= v << 16;
+        v |= v << 32;
+
+        uint64_t *p64 = (uint64_t *)p;
+
+        while (n >= 32) {
+            p64[0] = v;
+            p64[1] = v;
+            p64[2] = v;
+            p64[3] = v;
+            p64 += 4;
+            n -= 32;
+        }
+        while (n >= 8) {
+            *p64++ = v;
+            n -= 8;
+        }
+
+        p = (unsigned char *)p64;
+    }
+
     while (n--) {
         *p++ = (unsigned char)c;
     }
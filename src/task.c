@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "task.h"
+#include "timer.h"
+#include "utils.h"
+
+struct task {
+    const char *name;
+    task_func_t func;
+    u64 period;   // ticks, 0 = every idle window
+    u64 last_run; // ticks
+};
+
+static struct task tasks[TASK_MAX];
+static int task_count;
+static int task_next;
+
+int task_register(const char *name, task_func_t func, u32 period_us)
+{
+    if (task_count >= TASK_MAX) {
+        printf("task: table full, dropping '%s'\n", name);
+        return -1;
+    }
+
+    tasks[task_count].name = name;
+    tasks[task_count].func = func;
+    tasks[task_count].period = ((u64)period_us) * mrs(CNTFRQ_EL0) / 1000000;
+    tasks[task_count].last_run = get_ticks();
+    task_count++;
+
+    return 0;
+}
+
+void task_run_pending(void)
+{
+    u64 deadline = timeout_calculate(TASK_SLICE_US);
+
+    timer_poll();
+
+    /*
+     * Resume the scan where the last slice left off, so a busy foreground
+     * (short idle windows) still cycles through every task instead of
+     * starving the ones at the end of the table.
+     */
+    for (int i = 0; i < task_count; i++) {
+        struct task *t = &tasks[task_next];
+        u64 now = get_ticks();
+
+        task_next = (task_next + 1) % task_count;
+
+        if (now > deadline)
+            break;
+
+        if (now - t->last_run < t->period)
+            continue;
+
+        t->last_run = now;
+        t->func();
+    }
+}
@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef TASK_H
+#define TASK_H
+
+#include "types.h"
+
+/*
+ * Background maintenance tasks, run from the proxy's idle polling loop.
+ * Each task declares a minimum period; task_run_pending() runs the due
+ * ones round-robin within a bounded time slice per call, so maintenance
+ * work never adds more than one slice of latency to a foreground proxy
+ * request. Tasks must be short and resumable: one that overruns the
+ * slice just pushes the remaining due tasks to the next idle window.
+ */
+
+typedef void (*task_func_t)(void);
+
+#define TASK_MAX      16
+#define TASK_SLICE_US 500
+
+int task_register(const char *name, task_func_t func, u32 period_us);
+void task_run_pending(void);
+
+#endif
@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "telemetry.h"
+#include "hv.h"
+#include "malloc.h"
+#include "measure.h"
+#include "smp.h"
+#include "string.h"
+#include "task.h"
+#include "utils.h"
+
+struct telemetry_page telemetry = {
+    .magic = TELEMETRY_MAGIC,
+    .version = TELEMETRY_VERSION,
+};
+
+/*
+ * Refresh the sampled counters from their subsystems. This runs from the
+ * proxy idle loop, so the heap walk and vCPU stat sweep cost nothing while
+ * requests are in flight; the hot paths only pay for their own counter
+ * increments.
+ */
+static void telemetry_refresh(void)
+{
+    struct malloc_stats mst;
+    struct hv_vcpu_stats hst;
+    struct boot_measurements msr;
+    u64 exits = 0, fast_exits = 0, exit_cycles = 0;
+
+    malloc_get_stats(&mst);
+    measure_read(&msr);
+
+    for (int i = 0; i < MAX_CPUS; i++) {
+        if (hv_get_vcpu_stats(i, &hst, false))
+            continue;
+        for (int j = 0; j < HV_EXIT_TYPES; j++)
+            exits += hst.exits[j];
+        fast_exits += hst.fast_exits;
+        exit_cycles += hst.exit_cycles;
+    }
+
+    telemetry_begin();
+    telemetry.heap_alloc_count = mst.alloc_count;
+    telemetry.heap_free_count = mst.free_count;
+    telemetry.heap_footprint = mst.footprint;
+    telemetry.heap_used_bytes = mst.used_bytes;
+    telemetry.heap_free_bytes = mst.free_bytes;
+    telemetry.heap_largest_free = mst.largest_free;
+    telemetry.hv_exits = exits;
+    telemetry.hv_fast_exits = fast_exits;
+    telemetry.hv_exit_cycles = exit_cycles;
+    telemetry.samples++;
+    telemetry.sample_ticks = get_ticks();
+    telemetry.digest_valid = 0;
+    if (msr.m1n1_done) {
+        memcpy(telemetry.digest_m1n1, msr.m1n1, sizeof(msr.m1n1));
+        telemetry.digest_valid |= BIT(0);
+    }
+    if (msr.adt_done) {
+        memcpy(telemetry.digest_adt, msr.adt, sizeof(msr.adt));
+        telemetry.digest_valid |= BIT(1);
+    }
+    if (msr.payload_done) {
+        memcpy(telemetry.digest_payload, msr.payload, sizeof(msr.payload));
+        telemetry.digest_payload_size = msr.payload_size;
+        telemetry.digest_valid |= BIT(2);
+    }
+    telemetry_end();
+}
+
+void telemetry_init(void)
+{
+    task_register("telemetry", telemetry_refresh, 250000);
+}
@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "types.h"
+#include "utils.h"
+
+/*
+ * One well-known telemetry page for continuous monitoring. The host discovers
+ * it once via P_TELEMETRY_GET and then just bulk-reads the struct as often as
+ * it likes; no proxy opcode round trips per sample. The heavyweight blobs
+ * (event log, exit histograms, heap census) keep their own opcodes — this
+ * page carries the headline counters a dashboard polls every few hundred
+ * milliseconds.
+ *
+ * seq is a seqlock: it is odd while a writer is mid-update, so the host reads
+ * seq, the page, then seq again, and retries on a mismatch or an odd value.
+ * All writers run on the boot CPU (the proxy loop and its idle tasks), so no
+ * writer-side locking is needed beyond the seq brackets.
+ */
+#define TELEMETRY_MAGIC   0x4d4c4554 // 'TELM'
+#define TELEMETRY_VERSION 2
+
+struct telemetry_page {
+    u32 magic;
+    u32 version;
+    u32 seq;
+    u32 reserved;
+
+    /* proxy */
+    u64 proxy_requests;
+
+    /* heap, sampled by the refresh task */
+    u64 heap_alloc_count;
+    u64 heap_free_count;
+    u64 heap_footprint;
+    u64 heap_used_bytes;
+    u64 heap_free_bytes;
+    u64 heap_largest_free;
+
+    /* hypervisor, summed over vCPUs by the refresh task */
+    u64 hv_exits;
+    u64 hv_fast_exits;
+    u64 hv_exit_cycles;
+
+    /* refresh bookkeeping */
+    u64 samples;
+    u64 sample_ticks; // CNTPCT at the last refresh
+
+    /* measured boot digests (SHA-256), copied from measure.c as they land */
+    u8 digest_m1n1[32];
+    u8 digest_adt[32];
+    u8 digest_payload[32];
+    u64 digest_payload_size;
+    u32 digest_valid; // BIT(0) m1n1, BIT(1) adt, BIT(2) payload
+    u32 digest_pad;
+};
+
+extern struct telemetry_page telemetry;
+
+void telemetry_init(void);
+
+/* Bracket direct counter updates from the proxy path with these */
+static inline void telemetry_begin(void)
+{
+    telemetry.seq++;
+    sysop("dmb ish");
+}
+
+static inline void telemetry_end(void)
+{
+    sysop("dmb ish");
+    telemetry.seq++;
+}
+
+#endif
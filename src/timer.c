@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "timer.h"
+#include "utils.h"
+
+#define TIMER_MAX 16
+
+struct swtimer {
+    u64 deadline; // ticks, 0 = slot free
+    timer_func_t func;
+    void *cookie;
+};
+
+static struct swtimer timers[TIMER_MAX];
+static u64 next_deadline; // cached earliest armed deadline, 0 = none
+
+static void update_next(void)
+{
+    u64 next = 0;
+
+    for (int i = 0; i < TIMER_MAX; i++)
+        if (timers[i].deadline && (!next || timers[i].deadline < next))
+            next = timers[i].deadline;
+
+    next_deadline = next;
+}
+
+int timer_register(u32 usec, timer_func_t func, void *cookie)
+{
+    for (int i = 0; i < TIMER_MAX; i++) {
+        if (timers[i].deadline)
+            continue;
+
+        timers[i].deadline = timeout_calculate(usec);
+        timers[i].func = func;
+        timers[i].cookie = cookie;
+
+        if (!next_deadline || timers[i].deadline < next_deadline)
+            next_deadline = timers[i].deadline;
+
+        return i;
+    }
+
+    printf("timer: table full\n");
+    return -1;
+}
+
+void timer_cancel(int id)
+{
+    if (id < 0 || id >= TIMER_MAX)
+        return;
+
+    timers[id].deadline = 0;
+    update_next();
+}
+
+void timer_poll(void)
+{
+    if (!next_deadline || mrs(CNTPCT_EL0) <= next_deadline)
+        return;
+
+    for (int i = 0; i < TIMER_MAX; i++) {
+        if (timers[i].deadline && timeout_expired(timers[i].deadline)) {
+            // Free the slot first so the callback can re-arm itself
+            timers[i].deadline = 0;
+            timers[i].func(timers[i].cookie);
+        }
+    }
+
+    update_next();
+}
+
+u64 timer_next_deadline(void)
+{
+    return next_deadline;
+}
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "types.h"
+
+/*
+ * Central one-shot software timers, polled from the idle loop and other poll
+ * paths. The earliest deadline is cached, so the hot path in timer_poll() is
+ * a single counter read and compare instead of per-user deadline arithmetic.
+ * timer_next_deadline() lets sleep paths compute an exact wakeup instead of
+ * polling on a fixed period.
+ */
+
+typedef void (*timer_func_t)(void *cookie);
+
+/* Arm a one-shot timer; returns an id for timer_cancel(), -1 if full */
+int timer_register(u32 usec, timer_func_t func, void *cookie);
+void timer_cancel(int id);
+/* Fire expired timers; cheap no-op while nothing is due */
+void timer_poll(void);
+/* CNTPCT ticks of the earliest armed timer, 0 = none pending */
+u64 timer_next_deadline(void);
+
+#endif
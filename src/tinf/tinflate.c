@@ -36,16 +36,23 @@
 
 /* -- Internal data structures -- */
 
+/*
+ * Codes up to TINF_FAST_BITS long resolve with a single table lookup of the
+ * next TINF_FAST_BITS bits; longer codes fall back to the bit-by-bit walk.
+ */
+#define TINF_FAST_BITS 9
+
 struct tinf_tree {
 	unsigned short counts[16]; /* Number of codes with a given length */
 	unsigned short symbols[288]; /* Symbols sorted by code */
+	unsigned short fast[1 << TINF_FAST_BITS]; /* (symbol << 4) | length */
 	int max_sym;
 };
 
 struct tinf_data {
 	const unsigned char *source;
 	const unsigned char *source_end;
-	unsigned int tag;
+	unsigned long long tag;
 	int bitcount;
 	int overflow;
 
@@ -65,6 +72,55 @@ static unsigned int read_le16(const unsigned char *p)
 	     | ((unsigned int) p[1] << 8);
 }
 
+static unsigned int read_le32(const unsigned char *p)
+{
+	return ((unsigned int) p[0])
+	     | ((unsigned int) p[1] << 8)
+	     | ((unsigned int) p[2] << 16)
+	     | ((unsigned int) p[3] << 24);
+}
+
+/* Reverse the low len bits of code */
+static unsigned int tinf_reverse(unsigned int code, int len)
+{
+	unsigned int rev = 0;
+
+	while (len--) {
+		rev = (rev << 1) | (code & 1);
+		code >>= 1;
+	}
+
+	return rev;
+}
+
+/*
+ * Build the multi-bit lookup table for codes up to TINF_FAST_BITS long.
+ * Canonical codes are assigned in order of increasing length; the stream
+ * delivers code bits MSB-first, so each code is stored bit-reversed and
+ * replicated across all table slots sharing its low bits.
+ */
+static void tinf_build_fast_table(struct tinf_tree *t)
+{
+	unsigned int code = 0, index = 0;
+	unsigned int i, j;
+	int len;
+
+	for (i = 0; i < (1U << TINF_FAST_BITS); ++i) {
+		t->fast[i] = 0;
+	}
+
+	for (len = 1; len <= TINF_FAST_BITS; ++len) {
+		for (i = 0; i < t->counts[len]; ++i, ++index, ++code) {
+			for (j = tinf_reverse(code, len);
+			     j < (1U << TINF_FAST_BITS);
+			     j += 1U << len) {
+				t->fast[j] = (t->symbols[index] << 4) | len;
+			}
+		}
+		code <<= 1;
+	}
+}
+
 /* Build fixed Huffman trees */
 static void tinf_build_fixed_trees(struct tinf_tree *lt, struct tinf_tree *dt)
 {
@@ -106,6 +162,9 @@ static void tinf_build_fixed_trees(struct tinf_tree *lt, struct tinf_tree *dt)
 	}
 
 	dt->max_sym = 29;
+
+	tinf_build_fast_table(lt);
+	tinf_build_fast_table(dt);
 }
 
 /* Given an array of code lengths, build a tree */
@@ -172,6 +231,8 @@ static int tinf_build_tree(struct tinf_tree *t, const unsigned char *lengths,
 		t->symbols[1] = t->max_sym + 1;
 	}
 
+	tinf_build_fast_table(t);
+
 	return TINF_OK;
 }
 
@@ -181,10 +242,18 @@ static void tinf_refill(struct tinf_data *d, int num)
 {
 	assert(num >= 0 && num <= 32);
 
+	/* Refill a word at a time while there is room and data */
+	while (d->bitcount <= 32
+	    && (d->source_end == 0 || d->source_end - d->source >= 4)) {
+		d->tag |= (unsigned long long) read_le32(d->source) << d->bitcount;
+		d->source += 4;
+		d->bitcount += 32;
+	}
+
 	/* Read bytes until at least num bits available */
 	while (d->bitcount < num) {
 		if (d->source != d->source_end) {
-			d->tag |= (unsigned int) *d->source++ << d->bitcount;
+			d->tag |= (unsigned long long) *d->source++ << d->bitcount;
 		}
 		else {
 			d->overflow = 1;
@@ -192,7 +261,7 @@ static void tinf_refill(struct tinf_data *d, int num)
 		d->bitcount += 8;
 	}
 
-	assert(d->bitcount <= 32);
+	assert(d->bitcount <= 64);
 }
 
 static unsigned int tinf_getbits_no_refill(struct tinf_data *d, int num)
@@ -202,7 +271,7 @@ static unsigned int tinf_getbits_no_refill(struct tinf_data *d, int num)
 	assert(num >= 0 && num <= d->bitcount);
 
 	/* Get bits from tag */
-	bits = d->tag & ((1UL << num) - 1);
+	bits = d->tag & ((1ULL << num) - 1);
 
 	/* Remove bits from tag */
 	d->tag >>= num;
@@ -230,6 +299,25 @@ static int tinf_decode_symbol(struct tinf_data *d, const struct tinf_tree *t)
 	int base = 0, offs = 0;
 	int len;
 
+	/*
+	 * Fast path: resolve short codes with one multi-bit lookup. Skipped
+	 * near the end of the stream, where refilling TINF_FAST_BITS at once
+	 * could flag a spurious overflow.
+	 */
+	if (d->source_end == 0
+	 || d->bitcount + 8 * (d->source_end - d->source) >= TINF_FAST_BITS) {
+		unsigned int entry;
+
+		tinf_refill(d, TINF_FAST_BITS);
+		entry = t->fast[d->tag & ((1U << TINF_FAST_BITS) - 1)];
+
+		if (entry) {
+			d->tag >>= (entry & 15);
+			d->bitcount -= (entry & 15);
+			return entry >> 4;
+		}
+	}
+
 	/*
 	 * Get more bits while code index is above number of codes
 	 *
@@ -486,6 +574,14 @@ static int tinf_inflate_uncompressed_block(struct tinf_data *d)
 {
 	unsigned int length, invlength;
 
+	/*
+	 * Make sure we start on a byte boundary, returning whole bytes the
+	 * bit reader over-read into the tag
+	 */
+	d->source -= d->bitcount >> 3;
+	d->tag = 0;
+	d->bitcount = 0;
+
 	if (d->source_end && d->source_end - d->source < 4) {
 		return TINF_DATA_ERROR;
 	}
@@ -516,10 +612,6 @@ static int tinf_inflate_uncompressed_block(struct tinf_data *d)
 		*d->dest++ = *d->source++;
 	}
 
-	/* Make sure we start next block on a byte boundary */
-	d->tag = 0;
-	d->bitcount = 0;
-
 	return TINF_OK;
 }
 
@@ -615,6 +707,9 @@ int tinf_uncompress(void *dest, unsigned int *destLen,
 		return TINF_DATA_ERROR;
 	}
 
+	/* Return whole bytes the bit reader over-read into the tag */
+	d.source -= d.bitcount >> 3;
+
 	if (sourceLen) {
 		unsigned int slen = d.source - (const unsigned char *)source;
 		if (!*sourceLen)
@@ -79,6 +79,14 @@ int tps6598x_command(tps6598x_dev_t *dev, const char *cmd, const u8 *data_in, si
     return 0;
 }
 
+static bool tps6598x_mask_clear(const u8 *mask)
+{
+    for (size_t i = 0; i < CD3218B12_IRQ_WIDTH; i++)
+        if (mask[i])
+            return false;
+    return true;
+}
+
 int tps6598x_disable_irqs(tps6598x_dev_t *dev, tps6598x_irq_state_t *state)
 {
     size_t read;
@@ -102,10 +110,14 @@ int tps6598x_disable_irqs(tps6598x_dev_t *dev, tps6598x_irq_state_t *state)
         printf("tps6598x: writing TPS_REG_INT_CLEAR1 failed, written: %d\n", written);
         return -1;
     }
-    written = i2c_smbus_write(dev->i2c, dev->addr, TPS_REG_INT_MASK1, zeros, sizeof(zeros));
-    if (written != sizeof(ones)) {
-        printf("tps6598x: writing TPS_REG_INT_MASK1 failed, written: %d\n", written);
-        return -1;
+
+    // the mask we just read doubles as a shadow: skip the write if already clear
+    if (!tps6598x_mask_clear(state->int_mask1)) {
+        written = i2c_smbus_write(dev->i2c, dev->addr, TPS_REG_INT_MASK1, zeros, sizeof(zeros));
+        if (written != sizeof(ones)) {
+            printf("tps6598x: writing TPS_REG_INT_MASK1 failed, written: %d\n", written);
+            return -1;
+        }
     }
 
 #ifdef DEBUG
@@ -126,6 +138,10 @@ int tps6598x_restore_irqs(tps6598x_dev_t *dev, tps6598x_irq_state_t *state)
 {
     int written;
 
+    // the mask register still reads as the saved value if that was all zeros
+    if (tps6598x_mask_clear(state->int_mask1))
+        return 0;
+
     written = i2c_smbus_write(dev->i2c, dev->addr, TPS_REG_INT_MASK1, state->int_mask1,
                               sizeof(state->int_mask1));
     if (written != sizeof(state->int_mask1)) {
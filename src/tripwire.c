@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "tripwire.h"
+#include "string.h"
+#include "utils.h"
+
+/* Boot CPU only, like the other boot instrumentation. Regions may nest. */
+#define TRIPWIRE_MAX_DEPTH 4
+
+struct tripwire_log tripwire_log = {
+    .magic = TRIPWIRE_MAGIC,
+    .ent_size = sizeof(struct tripwire_hit),
+    .max_hits = TRIPWIRE_MAX_HITS,
+};
+
+static struct {
+    const char *tag;
+    u64 start;
+    u64 threshold;
+    u64 caller;
+} trip_stack[TRIPWIRE_MAX_DEPTH];
+static int trip_depth;
+
+void trip_arm(const char *tag, u32 threshold_usec)
+{
+    if (trip_depth >= TRIPWIRE_MAX_DEPTH) {
+        trip_depth++;
+        return;
+    }
+
+    trip_stack[trip_depth].tag = tag;
+    trip_stack[trip_depth].threshold = (mrs(CNTFRQ_EL0) / 1000000) * threshold_usec;
+    trip_stack[trip_depth].caller = (u64)__builtin_return_address(0);
+    trip_stack[trip_depth].start = mrs(CNTPCT_EL0);
+    trip_depth++;
+}
+
+void trip_disarm(void)
+{
+    if (trip_depth <= 0)
+        return;
+
+    if (--trip_depth >= TRIPWIRE_MAX_DEPTH)
+        return;
+
+    u64 duration = mrs(CNTPCT_EL0) - trip_stack[trip_depth].start;
+    if (duration <= trip_stack[trip_depth].threshold)
+        return;
+
+    struct tripwire_hit *hit = &tripwire_log.hits[tripwire_log.count % TRIPWIRE_MAX_HITS];
+    memset(hit->tag, 0, sizeof(hit->tag));
+    strncpy(hit->tag, trip_stack[trip_depth].tag, sizeof(hit->tag) - 1);
+    hit->start = trip_stack[trip_depth].start;
+    hit->duration = duration;
+    hit->caller = trip_stack[trip_depth].caller;
+    tripwire_log.count++;
+}
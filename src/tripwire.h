@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef TRIPWIRE_H
+#define TRIPWIRE_H
+
+#include "types.h"
+
+/*
+ * Latency tripwires: arm a threshold around a code region, and if the region
+ * overruns it, record who stalled and for how long into a ring the host can
+ * read via P_TRIPWIRE_GET. Interrupts are masked throughout m1n1, so there is
+ * no way to snapshot a region mid-stall; the hit records the arming site's
+ * return address, which is enough to attribute tail latency to its caller.
+ */
+
+#define TRIPWIRE_MAGIC    0x50495254 // 'TRIP'
+#define TRIPWIRE_MAX_HITS 64
+
+struct tripwire_hit {
+    char tag[8];
+    u64 start;    // CNTPCT at trip_arm()
+    u64 duration; // ticks spent in the region
+    u64 caller;   // return address of the trip_arm() call
+};
+
+struct tripwire_log {
+    u32 magic;
+    u32 ent_size;
+    u32 max_hits;
+    u32 count; // total hits; the ring keeps the last max_hits
+    struct tripwire_hit hits[TRIPWIRE_MAX_HITS];
+};
+
+extern struct tripwire_log tripwire_log;
+
+void trip_arm(const char *tag, u32 threshold_usec);
+void trip_disarm(void);
+
+#endif
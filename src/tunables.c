@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: MIT */
 
 #include "adt.h"
+#include "memory.h"
 #include "tunables.h"
 #include "types.h"
 #include "utils.h"
@@ -52,19 +53,42 @@ int tunables_apply_global(const char *path, const char *prop)
     if (tunables_adt_find(path, prop, &info, sizeof(struct tunable_global)) < 0)
         return -1;
 
+    /*
+     * Resolve each reg index once up front: adt_get_reg() walks the node's
+     * whole parent chain to translate ranges, and tunable blobs routinely
+     * have hundreds of entries all hitting the same handful of indices. With
+     * the addresses flat, the apply loop is just masked MMIO writes.
+     */
+    u64 addr_cache[32];
+    bool addr_valid[32] = {false};
+
     const struct tunable_global *tunables = (const struct tunable_global *)info.tunable_raw;
     for (u32 i = 0; i < info.tunable_len; ++i) {
         const struct tunable_global *tunable = &tunables[i];
-
         u64 addr;
-        if (adt_get_reg(adt, info.node_path, "reg", tunable->reg_idx, &addr, NULL) < 0) {
-            printf("tunable: Error getting regs with index %d\n", tunable->reg_idx);
-            return -1;
+
+        if (tunable->reg_idx < ARRAY_SIZE(addr_cache) && addr_valid[tunable->reg_idx]) {
+            addr = addr_cache[tunable->reg_idx];
+        } else {
+            if (adt_get_reg(adt, info.node_path, "reg", tunable->reg_idx, &addr, NULL) < 0) {
+                printf("tunable: Error getting regs with index %d\n", tunable->reg_idx);
+                return -1;
+            }
+            if (tunable->reg_idx < ARRAY_SIZE(addr_cache)) {
+                addr_cache[tunable->reg_idx] = addr;
+                addr_valid[tunable->reg_idx] = true;
+            }
         }
 
-        mask32(addr + tunable->offset, tunable->mask, tunable->value);
+        /*
+         * Tunable registers are pure configuration with no side effects to
+         * order against, so post the writes and complete them all at once.
+         */
+        mask32_relaxed(addr + tunable->offset, tunable->mask, tunable->value);
     }
 
+    mmio_sync();
+
     return 0;
 }
 
@@ -88,22 +112,25 @@ int tunables_apply_local_addr(const char *path, const char *prop, uintptr_t base
 
         switch (tunable->size) {
             case 1:
-                mask8(base + tunable->offset, tunable->mask, tunable->value);
+                mask8_relaxed(base + tunable->offset, tunable->mask, tunable->value);
                 break;
             case 2:
-                mask16(base + tunable->offset, tunable->mask, tunable->value);
+                mask16_relaxed(base + tunable->offset, tunable->mask, tunable->value);
                 break;
             case 4:
-                mask32(base + tunable->offset, tunable->mask, tunable->value);
+                mask32_relaxed(base + tunable->offset, tunable->mask, tunable->value);
                 break;
             case 8:
-                mask64(base + tunable->offset, tunable->mask, tunable->value);
+                mask64_relaxed(base + tunable->offset, tunable->mask, tunable->value);
                 break;
             default:
                 printf("tunable: unknown tunable size 0x%08x\n", tunable->size);
                 return -1;
         }
     }
+
+    mmio_sync();
+
     return 0;
 }
 
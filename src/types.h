@@ -56,6 +56,20 @@ typedef s64 ssize_t;
 #define FIELD_PREP(field, val) ((val) * (_FIELD_LSB(field)))
 #define FIELD_GET(field, val)  (((val) & (field)) / _FIELD_LSB(field))
 
+/*
+ * Composed field updates for 32-bit registers. FIELD_PREP() does not mask its
+ * value, so an oversized constant silently corrupts neighbouring fields;
+ * FIELD_UPD() is the checked form: constants that do not fit their field fail
+ * to compile, runtime values are clamped to it. The field mask is packed into
+ * the high half and the shifted value into the low half, so several updates
+ * OR together and apply as a single read-modify-write via upd32() in utils.h.
+ */
+#define _FIELD_BAD(e)         ((u64)sizeof(struct { int _ : 1 - 2 * !!(e); }) * 0)
+#define FIELD_FIT(field, val) (!(FIELD_PREP((u64)(field), (u64)(val)) & ~(u64)(field)))
+#define FIELD_UPD(field, val)                                                                      \
+    (((u64)(field) << 32) | (FIELD_PREP((u64)(field), (u64)(val)) & (u64)(field)) |                \
+     _FIELD_BAD(__builtin_constant_p(val) && !FIELD_FIT(field, val)))
+
 #ifdef __ASSEMBLER__
 
 #define ULONG(x)                         (x)
@@ -10,10 +10,36 @@
 #include "utils.h"
 #include "vsprintf.h"
 
-#define UART_CLOCK 24000000
+#define UART_CLOCK      24000000
+#define UART_FIFO_DEPTH 16
+
+/*
+ * The hardware RX FIFO is only 16 bytes and this UART variant has no flow
+ * control, so at high baud rates it overruns whenever we spend time
+ * processing instead of reading. Drain it eagerly (from the iodev event
+ * path, which the proxy polls between and during requests) into a software
+ * ring deep enough to cover request processing time.
+ */
+#define UART_RX_RING_SIZE 4096
+
+static u8 uart_rx_ring[UART_RX_RING_SIZE];
+static u32 uart_rx_rptr;
+static u32 uart_rx_wptr;
 
 static u64 uart_base = 0;
 
+static void uart_drain_rx(void)
+{
+    if (!uart_base)
+        return;
+
+    while (read32(uart_base + UTRSTAT) & UTRSTAT_RXD) {
+        if (uart_rx_wptr - uart_rx_rptr >= UART_RX_RING_SIZE)
+            break; // Ring full; leave the rest in the FIFO
+        uart_rx_ring[uart_rx_wptr++ % UART_RX_RING_SIZE] = read32(uart_base + URXH);
+    }
+}
+
 int uart_init(void)
 {
     int path[8];
@@ -29,6 +55,9 @@ int uart_init(void)
         return -1;
     }
 
+    // iBoot leaves the FIFO enabled, but make sure (uart_write relies on it)
+    set32(uart_base + UFCON, UFCON_FIFO_ENA);
+
     return 0;
 }
 
@@ -48,10 +77,10 @@ u8 uart_getbyte(void)
     if (!uart_base)
         return 0;
 
-    while (!(read32(uart_base + UTRSTAT) & UTRSTAT_RXD))
-        ;
+    while (uart_rx_rptr == uart_rx_wptr)
+        uart_drain_rx();
 
-    return read32(uart_base + URXH);
+    return uart_rx_ring[uart_rx_rptr++ % UART_RX_RING_SIZE];
 }
 
 void uart_putchar(u8 c)
@@ -79,8 +108,30 @@ void uart_write(const void *buf, size_t count)
 {
     const u8 *p = buf;
 
-    while (count--)
-        uart_putbyte(*p++);
+    if (!uart_base)
+        return;
+
+    /*
+     * Burst-fill the TX FIFO instead of waiting for it to drain empty
+     * before every byte like uart_putbyte() does.
+     */
+    while (count) {
+        u32 fstat = read32(uart_base + UFSTAT);
+
+        if (fstat & UFSTAT_TXFULL) {
+            // Keep RX flowing while we wait for TX FIFO space
+            uart_drain_rx();
+            continue;
+        }
+
+        size_t room = UART_FIFO_DEPTH - FIELD_GET(UFSTAT_TXCNT, fstat);
+        room = min(room, count);
+
+        for (size_t i = 0; i < room; i++)
+            write32(uart_base + UTXH, *p++);
+
+        count -= room;
+    }
 }
 
 size_t uart_read(void *buf, size_t count)
@@ -101,8 +152,16 @@ void uart_setbaud(int baudrate)
     if (!uart_base)
         return;
 
+    /*
+     * The divisor is UBRDIV + 1 + UFRACVAL/16 in units of 16 clocks. The
+     * fractional part matters at multi-Mbaud rates: from a 24MHz clock,
+     * integer-only divisors snap 6Mbaud to 8Mbaud (>30% error).
+     */
+    u32 div16 = (2 * UART_CLOCK / baudrate + 1) / 2; // round(16 * clk / (16 * baud))
+
     uart_flush();
-    write32(uart_base + UBRDIV, ((UART_CLOCK / baudrate + 7) / 16) - 1);
+    write32(uart_base + UBRDIV, div16 / 16 - 1);
+    write32(uart_base + UFRACVAL, div16 % 16);
 }
 
 void uart_flush(void)
@@ -143,6 +202,21 @@ static bool uart_iodev_can_write(void *opaque)
     return true;
 }
 
+static ssize_t uart_iodev_write_room(void *opaque)
+{
+    UNUSED(opaque);
+
+    if (!uart_base)
+        return 0;
+
+    u32 fstat = read32(uart_base + UFSTAT);
+
+    if (fstat & UFSTAT_TXFULL)
+        return 0;
+
+    return UART_FIFO_DEPTH - FIELD_GET(UFSTAT_TXCNT, fstat);
+}
+
 static ssize_t uart_iodev_can_read(void *opaque)
 {
     UNUSED(opaque);
@@ -150,7 +224,14 @@ static ssize_t uart_iodev_can_read(void *opaque)
     if (!uart_base)
         return 0;
 
-    return (read32(uart_base + UTRSTAT) & UTRSTAT_RXD) ? 1 : 0;
+    uart_drain_rx();
+    return uart_rx_wptr - uart_rx_rptr;
+}
+
+static void uart_iodev_handle_events(void *opaque)
+{
+    UNUSED(opaque);
+    uart_drain_rx();
 }
 
 static ssize_t uart_iodev_read(void *opaque, void *buf, size_t len)
@@ -171,6 +252,8 @@ static struct iodev_ops iodev_uart_ops = {
     .can_write = uart_iodev_can_write,
     .read = uart_iodev_read,
     .write = uart_iodev_write,
+    .write_room = uart_iodev_write_room,
+    .handle_events = uart_iodev_handle_events,
 };
 
 struct iodev iodev_uart = {
@@ -10,6 +10,8 @@
 #define UBRDIV   0x028
 #define UFRACVAL 0x02c
 
+#define UFCON_FIFO_ENA BIT(0)
+
 #define UCON_TXTHRESH_ENA BIT(13)
 #define UCON_RXTHRESH_ENA BIT(12)
 #define UCON_RXTO_ENA     BIT(9)
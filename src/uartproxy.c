@@ -4,9 +4,15 @@
 #include "assert.h"
 #include "exception.h"
 #include "iodev.h"
+#include "malloc.h"
+#include "memory.h"
+#include "payload.h"
 #include "proxy.h"
+#include "smp.h"
 #include "string.h"
+#include "task.h"
 #include "types.h"
+#include "usb.h"
 #include "utils.h"
 
 #define REQ_SIZE 64
@@ -21,6 +27,16 @@ typedef struct {
             u64 size;
             u32 dchecksum;
         } mrequest;
+        struct {
+            u64 addr;
+            u64 size;
+            u32 chunk;
+            u32 window;
+        } srequest;
+        struct {
+            u32 count;
+            u32 dchecksum;
+        } brequest;
         u64 features;
     };
     u32 checksum;
@@ -36,6 +52,10 @@ typedef struct {
         struct {
             u32 dchecksum;
         } mreply;
+        struct {
+            u32 completed;
+            u32 dchecksum;
+        } breply;
         struct uartproxy_msg_start start;
         u64 features;
     };
@@ -49,6 +69,13 @@ typedef struct {
     u16 event_type;
 } UartEventHdr;
 
+typedef struct {
+    u32 type;
+    u32 seq;
+    s32 status;
+    u32 checksum;
+} UartStreamAck;
+
 static_assert(sizeof(UartReply) == (REPLY_SIZE + 4), "Invalid UartReply size");
 
 #define REQ_NOP      0x00AA55FF
@@ -57,6 +84,13 @@ static_assert(sizeof(UartReply) == (REPLY_SIZE + 4), "Invalid UartReply size");
 #define REQ_MEMWRITE 0x03AA55FF
 #define REQ_BOOT     0x04AA55FF
 #define REQ_EVENT    0x05AA55FF
+#define REQ_STREAMWR 0x06AA55FF
+#define REQ_STREAMRD 0x07AA55FF
+#define REQ_STREAMZ  0x08AA55FF
+#define REQ_PROXY_BATCH 0x09AA55FF
+
+#define STREAM_MAX_CHUNK SZ_1M
+#define PROXY_BATCH_MAX  1024
 
 #define ST_OK      0
 #define ST_BADCMD  -1
@@ -65,7 +99,12 @@ static_assert(sizeof(UartReply) == (REPLY_SIZE + 4), "Invalid UartReply size");
 #define ST_CSUMERR -4
 
 #define PROXY_FEAT_DISABLE_DATA_CSUMS 0x01
-#define PROXY_FEAT_ALL                (PROXY_FEAT_DISABLE_DATA_CSUMS)
+#define PROXY_FEAT_HW_CRC32           0x02
+#define PROXY_FEAT_EVENT_CHANNEL      0x04
+#define PROXY_FEAT_PROXY_BATCH        0x08
+#define PROXY_FEAT_ALL                                                                             \
+    (PROXY_FEAT_DISABLE_DATA_CSUMS | PROXY_FEAT_HW_CRC32 | PROXY_FEAT_EVENT_CHANNEL |              \
+     PROXY_FEAT_PROXY_BATCH)
 
 static u32 iodev_proxy_buffer[IODEV_MAX];
 
@@ -75,6 +114,8 @@ static u32 iodev_proxy_buffer[IODEV_MAX];
 #define DATA_END_SENTINEL 0xB0CACC10
 
 static bool disable_data_csums = false;
+static bool use_hw_crc32 = false;
+static bool use_event_channel = false;
 
 // I just totally pulled this out of my arse
 // Noinline so that this can be bailed out by exc_guard = EXC_RETURN
@@ -91,18 +132,46 @@ static u32 __attribute__((noinline)) checksum_block(void *start, u32 length, u32
     return sum;
 }
 
+// ARMv8 CRC32 flavor, negotiated via PROXY_FEAT_HW_CRC32. Same constraints as
+// checksum_block(): noinline, no stack usage, so exc_guard can bail out of it.
+static u32 __attribute__((noinline)) crc32_block(void *start, u32 length, u32 init)
+{
+    u32 crc = init;
+    u8 *d = (u8 *)start;
+
+    while (length && ((u64)d & 7)) {
+        __asm__("crc32b %w0, %w0, %w1" : "+r"(crc) : "r"((u32)*d++));
+        length--;
+    }
+    while (length >= 8) {
+        __asm__("crc32x %w0, %w0, %x1" : "+r"(crc) : "r"(*(u64 *)d));
+        d += 8;
+        length -= 8;
+    }
+    while (length--)
+        __asm__("crc32b %w0, %w0, %w1" : "+r"(crc) : "r"((u32)*d++));
+
+    return crc;
+}
+
 static inline u32 checksum_start(void *start, u32 length)
 {
+    if (use_hw_crc32)
+        return crc32_block(start, length, ~0u);
     return checksum_block(start, length, CHECKSUM_INIT);
 }
 
 static inline u32 checksum_add(void *start, u32 length, u32 sum)
 {
+    if (use_hw_crc32)
+        return crc32_block(start, length, sum);
     return checksum_block(start, length, sum);
 }
 
 static inline u32 checksum_finish(u32 sum)
 {
+    if (use_hw_crc32)
+        return ~sum;
     return sum ^ CHECKSUM_FINAL;
 }
 
@@ -120,10 +189,290 @@ static u64 data_checksum(void *start, u32 length)
     return checksum(start, length);
 }
 
+static void uartproxy_send_ack(iodev_id_t iodev, u32 type, u32 seq, s32 status)
+{
+    UartStreamAck ack = {type, seq, status};
+
+    ack.checksum = checksum(&ack, sizeof(ack) - 4);
+    iodev_write(iodev, &ack, sizeof(ack));
+}
+
+static void uartproxy_stream_write(iodev_id_t iodev, UartRequest *request, UartReply *reply)
+{
+    u64 addr = request->srequest.addr;
+    u64 left = request->srequest.size;
+    u32 chunk = request->srequest.chunk;
+    u32 window = request->srequest.window;
+    u32 seq = 0;
+    u32 csum = use_hw_crc32 ? ~0u : CHECKSUM_INIT;
+
+    if (!chunk || chunk > STREAM_MAX_CHUNK || !window || !left) {
+        reply->status = ST_INVAL;
+        return;
+    }
+
+    exc_count = 0;
+    exc_guard = GUARD_SKIP;
+    // Probe for exception guard, as for REQ_MEMWRITE
+    write8(addr, 0);
+    write8(addr + left - 1, 0);
+    exc_guard = GUARD_OFF;
+    if (exc_count) {
+        reply->status = ST_XFRERR;
+        return;
+    }
+
+    while (left) {
+        size_t blk = min(left, (u64)chunk);
+
+        if (iodev_read(iodev, (void *)addr, blk) != (ssize_t)blk) {
+            reply->status = ST_XFRERR;
+            return;
+        }
+        if (!disable_data_csums)
+            csum = checksum_add((void *)addr, blk, csum);
+        addr += blk;
+        left -= blk;
+        seq++;
+
+        // Ack full windows only, so the host can keep many chunks in flight
+        // instead of stalling on a reply per chunk
+        if (!(seq % window) && left)
+            uartproxy_send_ack(iodev, REQ_STREAMWR, seq, ST_OK);
+    }
+
+    reply->mreply.dchecksum = disable_data_csums ? CHECKSUM_SENTINEL : checksum_finish(csum);
+}
+
+/*
+ * Decompressing stream write: the payload is a sequence of independently
+ * compressed gzip/xz members, each prefixed by a small header giving its
+ * compressed size and output placement. Received members are handed off to a
+ * secondary core for decompression while the next one is still arriving, so
+ * unpacking overlaps with the transfer. srequest.chunk bounds the compressed
+ * member size (it sizes the bounce buffers); window acks work per member.
+ */
+static void uartproxy_stream_write_z(iodev_id_t iodev, UartRequest *request, UartReply *reply)
+{
+    u64 dest = request->srequest.addr;
+    u64 left = request->srequest.size;
+    u32 max_comp = request->srequest.chunk;
+    u32 window = request->srequest.window;
+    u32 seq = 0;
+    u64 out_total = 0;
+    u64 dest_lo = ~0UL, dest_hi = 0;
+    int zcpu = -1;
+    int busy = -1;
+    int cur = 0;
+    u8 *bounce[2] = {NULL, NULL};
+    bool ok = true;
+
+    struct {
+        u64 dest_off;
+        u64 dest_size;
+        u64 comp_size;
+    } mh;
+
+    if (!max_comp || max_comp > STREAM_MAX_CHUNK || !window || !left) {
+        reply->status = ST_INVAL;
+        return;
+    }
+
+    smp_start_secondaries();
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++) {
+        if (cpu != boot_cpu_idx && smp_is_alive(cpu)) {
+            zcpu = cpu;
+            break;
+        }
+    }
+
+    bounce[0] = malloc(max_comp);
+    bounce[1] = zcpu >= 0 ? malloc(max_comp) : NULL;
+    if (!bounce[0] || (zcpu >= 0 && !bounce[1])) {
+        free(bounce[0]);
+        free(bounce[1]);
+        reply->status = ST_INVAL;
+        return;
+    }
+
+    while (left && ok) {
+        if (iodev_read(iodev, &mh, sizeof(mh)) != sizeof(mh) || mh.comp_size > max_comp ||
+            mh.comp_size + sizeof(mh) > left) {
+            ok = false;
+            break;
+        }
+        left -= sizeof(mh);
+
+        if (iodev_read(iodev, bounce[cur], mh.comp_size) != (ssize_t)mh.comp_size) {
+            ok = false;
+            break;
+        }
+        left -= mh.comp_size;
+
+        dest_lo = min(dest_lo, dest + mh.dest_off);
+        dest_hi = max(dest_hi, dest + mh.dest_off + mh.dest_size);
+
+        if (zcpu >= 0) {
+            // Reclaim this bounce buffer if the secondary is still chewing on it
+            if (busy == cur) {
+                if (!smp_wait(zcpu))
+                    ok = false;
+                busy = -1;
+            }
+            // The secondary runs with caches off: push the input to PoC first
+            dc_cvac_range(bounce[cur], mh.comp_size);
+            smp_call4(zcpu, payload_decompress_member, (u64)bounce[cur], mh.comp_size,
+                      dest + mh.dest_off, mh.dest_size);
+            busy = cur;
+            out_total += mh.dest_size;
+            cur ^= 1;
+        } else {
+            u64 n = payload_decompress_member((u64)bounce[cur], mh.comp_size, dest + mh.dest_off,
+                                              mh.dest_size);
+            if (!n)
+                ok = false;
+            out_total += n;
+        }
+
+        seq++;
+        if (!(seq % window) && left)
+            uartproxy_send_ack(iodev, REQ_STREAMZ, seq, ST_OK);
+    }
+
+    if (zcpu >= 0 && busy >= 0 && !smp_wait(zcpu))
+        ok = false;
+
+    // Drop any stale cached view of what the secondary wrote
+    if (zcpu >= 0 && dest_lo < dest_hi)
+        dc_ivac_range_par((void *)dest_lo, dest_hi - dest_lo);
+
+    free(bounce[0]);
+    free(bounce[1]);
+
+    if (!ok) {
+        reply->status = ST_XFRERR;
+        return;
+    }
+
+    reply->features = out_total;
+}
+
+static void uartproxy_stream_read(iodev_id_t iodev, UartRequest *request, UartReply *reply)
+{
+    u64 addr = request->srequest.addr;
+    u64 left = request->srequest.size;
+    u32 chunk = request->srequest.chunk;
+    u32 window = request->srequest.window;
+    u32 seq = 0;
+    u64 csum;
+
+    if (!chunk || chunk > STREAM_MAX_CHUNK || !window || !left) {
+        reply->status = ST_INVAL;
+        return;
+    }
+
+    exc_count = 0;
+    exc_guard = GUARD_RETURN;
+    csum = data_checksum((void *)addr, left);
+    exc_guard = GUARD_OFF;
+    if (exc_count) {
+        reply->status = ST_XFRERR;
+        return;
+    }
+
+    while (left) {
+        size_t blk = min(left, (u64)chunk);
+
+        if (iodev_write(iodev, (void *)addr, blk) != (ssize_t)blk) {
+            reply->status = ST_XFRERR;
+            return;
+        }
+        addr += blk;
+        left -= blk;
+        seq++;
+
+        // Wait for a window credit from the host so we don't overrun its buffers
+        if (!(seq % window) && left) {
+            u32 credit;
+            if (iodev_read(iodev, &credit, sizeof(credit)) != sizeof(credit) || credit != seq) {
+                reply->status = ST_XFRERR;
+                return;
+            }
+        }
+    }
+
+    reply->mreply.dchecksum = csum;
+}
+
+/*
+ * Batched proxy requests: one jumbo frame carries up to PROXY_BATCH_MAX
+ * ProxyRequests and a single reply frame is followed by the dense array of
+ * ProxyReplys, so per-request frame and checksum overhead is paid once per
+ * batch instead of once per 64-byte request. Negotiated via
+ * PROXY_FEAT_PROXY_BATCH; mainly a win on USB, where a full batch still fits
+ * in a couple of bulk transfers. Execution stops early if a request fails or
+ * asks the proxy to exit; the completed count tells the host how far we got.
+ */
+static ProxyReply *batch_replies;
+
+static int uartproxy_proxy_batch(iodev_id_t iodev, UartRequest *request, UartReply *reply)
+{
+    u32 count = request->brequest.count;
+    int ret = 0;
+
+    if (!count || count > PROXY_BATCH_MAX) {
+        reply->status = ST_INVAL;
+        return 0;
+    }
+
+    ProxyRequest *reqs = malloc(count * sizeof(*reqs));
+    batch_replies = malloc(count * sizeof(*batch_replies));
+    if (!reqs || !batch_replies) {
+        reply->status = ST_INVAL;
+        goto out;
+    }
+
+    if (iodev_read(iodev, reqs, count * sizeof(*reqs)) != (ssize_t)(count * sizeof(*reqs))) {
+        reply->status = ST_XFRERR;
+        goto out;
+    }
+
+    if (data_checksum(reqs, count * sizeof(*reqs)) != request->brequest.dchecksum) {
+        reply->status = ST_CSUMERR;
+        goto out;
+    }
+
+    u32 done = 0;
+    while (done < count) {
+        ret = proxy_process(&reqs[done], &batch_replies[done]);
+        done++;
+        if (ret != 0)
+            break;
+    }
+
+    reply->breply.completed = done;
+    reply->breply.dchecksum = data_checksum(batch_replies, done * sizeof(ProxyReply));
+
+out:
+    free(reqs);
+    if (reply->status != ST_OK) {
+        free(batch_replies);
+        batch_replies = NULL;
+    }
+    return ret;
+}
+
 iodev_id_t uartproxy_iodev;
 
+static void uartproxy_console_task(void)
+{
+    // Push buffered console output to slow consumers (fb, vuart) while idle
+    iodev_console_kick();
+}
+
 int uartproxy_run(struct uartproxy_msg_start *start)
 {
+    static bool tasks_registered = false;
     int ret;
     int running = 1;
     size_t bytes;
@@ -132,6 +481,11 @@ int uartproxy_run(struct uartproxy_msg_start *start)
 
     iodev_id_t iodev = IODEV_MAX;
 
+    if (!tasks_registered) {
+        task_register("console", uartproxy_console_task, 10000);
+        tasks_registered = true;
+    }
+
     UartRequest request;
     UartReply reply = {REQ_BOOT};
     if (!start) {
@@ -161,8 +515,18 @@ int uartproxy_run(struct uartproxy_msg_start *start)
                     }
                 }
                 iodev++;
-                if (iodev == IODEV_MAX)
+                if (iodev == IODEV_MAX) {
                     iodev = 0;
+                    // A full scan found nothing to read; this is the proxy's
+                    // idle state, so spend a bounded slice on maintenance and
+                    // then sleep until the next timer event instead of
+                    // spinning. The event stream wakes WFE every ~1.3us, so
+                    // request latency is unaffected while the idle core stops
+                    // hammering the iodevs (and the memory system) flat out.
+                    task_run_pending();
+                    enable_event_stream();
+                    sysop("wfe");
+                }
             }
         } else {
             // Stick to the current iodev for exceptions
@@ -208,6 +572,15 @@ int uartproxy_run(struct uartproxy_msg_start *start)
                 }
 
                 disable_data_csums = enabled_features & PROXY_FEAT_DISABLE_DATA_CSUMS;
+                // Takes effect starting with the reply to this request
+                use_hw_crc32 = enabled_features & PROXY_FEAT_HW_CRC32;
+
+                // Out-of-band events need a dedicated USB pipe on the proxy's device
+                if ((enabled_features & PROXY_FEAT_EVENT_CHANNEL) &&
+                    usb_iodev_event_setup(iodev))
+                    enabled_features &= ~PROXY_FEAT_EVENT_CHANNEL;
+                use_event_channel = enabled_features & PROXY_FEAT_EVENT_CHANNEL;
+
                 reply.features = enabled_features;
                 break;
             case REQ_PROXY:
@@ -263,6 +636,22 @@ int uartproxy_run(struct uartproxy_msg_start *start)
                     }
                 }
                 break;
+            case REQ_STREAMWR:
+                uartproxy_stream_write(iodev, &request, &reply);
+                break;
+            case REQ_STREAMRD:
+                uartproxy_stream_read(iodev, &request, &reply);
+                break;
+            case REQ_STREAMZ:
+                uartproxy_stream_write_z(iodev, &request, &reply);
+                break;
+            case REQ_PROXY_BATCH:
+                ret = uartproxy_proxy_batch(iodev, &request, &reply);
+                if (ret != 0)
+                    running = 0;
+                if (ret < 0)
+                    printf("Proxy req error: %d\n", ret);
+                break;
             default:
                 reply.status = ST_BADCMD;
                 break;
@@ -285,15 +674,37 @@ int uartproxy_run(struct uartproxy_msg_start *start)
             }
         }
 
+        if (request.type == REQ_PROXY_BATCH && batch_replies && reply.status == ST_OK)
+            iodev_queue(iodev, batch_replies, reply.breply.completed * sizeof(ProxyReply));
+
         iodev_unlock(uartproxy_iodev);
         // Flush all queued data
         iodev_write(iodev, NULL, 0);
         iodev_flush(iodev);
+
+        if (batch_replies) {
+            // Safe to reclaim only once the queued reply data has hit the wire
+            free(batch_replies);
+            batch_replies = NULL;
+        }
     }
 
     return ret;
 }
 
+/*
+ * Bounded event mode: when the event iodev is saturated (host not draining
+ * fast enough under an exit storm), drop the event and count it instead of
+ * stalling the sender - which in HV context is a vCPU - on backpressure.
+ */
+static bool event_bounded = false;
+u64 uartproxy_event_drops[MAX_CPUS];
+
+void uartproxy_set_event_bounded(bool enable)
+{
+    event_bounded = enable;
+}
+
 void uartproxy_send_event(u16 event_type, void *data, u16 length)
 {
     UartEventHdr hdr;
@@ -309,9 +720,33 @@ void uartproxy_send_event(u16 event_type, void *data, u16 length)
         csum = checksum_start(&hdr, sizeof(UartEventHdr));
         csum = checksum_finish(checksum_add(data, length, csum));
     }
-    iodev_lock(uartproxy_iodev);
-    iodev_queue(uartproxy_iodev, &hdr, sizeof(UartEventHdr));
-    iodev_queue(uartproxy_iodev, data, length);
-    iodev_write(uartproxy_iodev, &csum, sizeof(csum));
-    iodev_unlock(uartproxy_iodev);
+
+    struct iodev_iovec iov[] = {
+        {&hdr, sizeof(UartEventHdr)},
+        {data, length},
+        {&csum, sizeof(csum)},
+    };
+
+    /*
+     * With the event channel negotiated, events bypass the proxy pipe so the
+     * host sees them as soon as they hit the wire, instead of interleaved
+     * with whatever request is in flight.
+     */
+    iodev_id_t iodev = uartproxy_iodev;
+    if (use_event_channel && iodev_can_write(IODEV_USB_EVENT))
+        iodev = IODEV_USB_EVENT;
+
+    if (event_bounded) {
+        ssize_t room = iodev_write_room(iodev);
+        if (room >= 0 && (size_t)room < sizeof(UartEventHdr) + length + sizeof(csum)) {
+            int cpu = smp_id();
+            uartproxy_event_drops[cpu >= 0 && cpu < MAX_CPUS ? cpu : 0]++;
+            return;
+        }
+    }
+
+    iodev_lock(iodev);
+    iodev_queue_sg(iodev, iov, 3);
+    iodev_write(iodev, NULL, 0);
+    iodev_unlock(iodev);
 }
@@ -4,6 +4,7 @@
 #define __UARTPROXY_H__
 
 #include "iodev.h"
+#include "smp.h"
 
 extern iodev_id_t uartproxy_iodev;
 
@@ -42,4 +43,9 @@ struct uartproxy_msg_start {
 int uartproxy_run(struct uartproxy_msg_start *start);
 void uartproxy_send_event(u16 event_type, void *data, u16 length);
 
+/* Drop events instead of blocking on a saturated iodev; drops are counted
+ * per sending CPU */
+void uartproxy_set_event_bounded(bool enable);
+extern u64 uartproxy_event_drops[MAX_CPUS];
+
 #endif
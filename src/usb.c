@@ -2,6 +2,7 @@
 
 #include "usb.h"
 #include "adt.h"
+#include "bootprofile.h"
 #include "dart.h"
 #include "i2c.h"
 #include "iodev.h"
@@ -35,6 +36,17 @@ struct usb_drd_regs {
 
 static tps6598x_irq_state_t tps6598x_irq_state[USB_IODEV_COUNT];
 static bool usb_is_initialized = false;
+static bool usb_handoff = false;
+
+/*
+ * Called when the previous stage passed usb_handoff=1: HPM power and the PHYs
+ * are still up from before the chainload, so skip the bringup that would
+ * power cycle the port and drop the host into a full cold re-enumeration.
+ */
+void usb_set_handoff(void)
+{
+    usb_handoff = true;
+}
 
 static dart_dev_t *usb_dart_init(u32 idx)
 {
@@ -97,17 +109,10 @@ static int usb_drd_get_regs(u32 idx, struct usb_drd_regs *regs)
     return 0;
 }
 
-int usb_phy_bringup(u32 idx)
+static int usb_phy_power_up(u32 idx)
 {
     char path[24];
 
-    if (idx >= USB_IODEV_COUNT)
-        return -1;
-
-    struct usb_drd_regs usb_regs;
-    if (usb_drd_get_regs(idx, &usb_regs) < 0)
-        return -1;
-
     snprintf(path, sizeof(path), FMT_ATC_PATH, idx);
     if (pmgr_adt_power_enable(path) < 0)
         return -1;
@@ -117,24 +122,80 @@ int usb_phy_bringup(u32 idx)
         return -1;
 
     snprintf(path, sizeof(path), FMT_DRD_PATH, idx);
-    if (pmgr_adt_power_enable(path) < 0)
+    return pmgr_adt_power_enable(path);
+}
+
+static void usb_phy_program(const struct usb_drd_regs *usb_regs)
+{
+    write32(usb_regs->atc + 0x08, 0x01c1000f);
+    write32(usb_regs->atc + 0x04, 0x00000003);
+    write32(usb_regs->atc + 0x04, 0x00000000);
+    write32(usb_regs->atc + 0x1c, 0x008c0813);
+    write32(usb_regs->atc + 0x00, 0x00000002);
+
+    write32(usb_regs->drd_regs_unk3 + 0x0c, 0x00000002);
+    write32(usb_regs->drd_regs_unk3 + 0x0c, 0x00000022);
+    write32(usb_regs->drd_regs_unk3 + 0x1c, 0x00000021);
+    write32(usb_regs->drd_regs_unk3 + 0x20, 0x00009332);
+}
+
+int usb_phy_bringup(u32 idx)
+{
+    if (idx >= USB_IODEV_COUNT)
         return -1;
 
-    write32(usb_regs.atc + 0x08, 0x01c1000f);
-    write32(usb_regs.atc + 0x04, 0x00000003);
-    write32(usb_regs.atc + 0x04, 0x00000000);
-    write32(usb_regs.atc + 0x1c, 0x008c0813);
-    write32(usb_regs.atc + 0x00, 0x00000002);
+    struct usb_drd_regs usb_regs;
+    if (usb_drd_get_regs(idx, &usb_regs) < 0)
+        return -1;
+
+    // batch the ATC/DART/DRD chains so their settling times overlap
+    pmgr_power_batch_begin();
+
+    int ret = usb_phy_power_up(idx);
+
+    if (pmgr_power_batch_end() < 0 || ret < 0)
+        return -1;
 
-    write32(usb_regs.drd_regs_unk3 + 0x0c, 0x00000002);
-    write32(usb_regs.drd_regs_unk3 + 0x0c, 0x00000022);
-    write32(usb_regs.drd_regs_unk3 + 0x1c, 0x00000021);
-    write32(usb_regs.drd_regs_unk3 + 0x20, 0x00009332);
+    usb_phy_program(&usb_regs);
 
     return 0;
 }
 
-dwc3_dev_t *usb_iodev_bringup(u32 idx)
+/*
+ * Bring up all ports' PHYs together: kick every port's ATC/DART/DRD power
+ * chain in one batch so the ports' settling times overlap too, then program
+ * the PHYs back to back. If any chain fails to settle, the batch cannot tell
+ * whose it was, so fall back to the sequential per-port path.
+ */
+static void usb_phy_bringup_all(void)
+{
+    struct usb_drd_regs usb_regs[USB_IODEV_COUNT];
+    bool up[USB_IODEV_COUNT];
+    int ret = 0;
+
+    pmgr_power_batch_begin();
+
+    for (u32 idx = 0; idx < USB_IODEV_COUNT; ++idx) {
+        up[idx] = usb_drd_get_regs(idx, &usb_regs[idx]) >= 0 && usb_phy_power_up(idx) >= 0;
+        if (up[idx])
+            ret |= 1;
+    }
+
+    if (pmgr_power_batch_end() < 0) {
+        for (u32 idx = 0; idx < USB_IODEV_COUNT; ++idx)
+            usb_phy_bringup(idx); /* Fails on missing devices, just continue */
+        return;
+    }
+
+    if (!ret)
+        return;
+
+    for (u32 idx = 0; idx < USB_IODEV_COUNT; ++idx)
+        if (up[idx])
+            usb_phy_program(&usb_regs[idx]);
+}
+
+dwc3_dev_t *usb_iodev_bringup(u32 idx, bool adopt)
 {
     dart_dev_t *usb_dart = usb_dart_init(idx);
     if (!usb_dart)
@@ -144,7 +205,10 @@ dwc3_dev_t *usb_iodev_bringup(u32 idx)
     if (usb_drd_get_regs(idx, &usb_reg) < 0)
         return NULL;
 
-    return usb_dwc3_init(usb_reg.drd_regs, usb_dart);
+    if (adopt)
+        return usb_dwc3_init_adopt(usb_reg.drd_regs, usb_dart);
+
+    return usb_dwc3_init_start(usb_reg.drd_regs, usb_dart);
 }
 
 #define USB_IODEV_WRAPPER(name, pipe)                                                              \
@@ -158,6 +222,11 @@ dwc3_dev_t *usb_iodev_bringup(u32 idx)
         return usb_dwc3_can_write(dev, pipe);                                                      \
     }                                                                                              \
                                                                                                    \
+    static ssize_t usb_##name##_write_room(void *dev)                                              \
+    {                                                                                              \
+        return usb_dwc3_write_room(dev, pipe);                                                     \
+    }                                                                                              \
+                                                                                                   \
     static ssize_t usb_##name##_read(void *dev, void *buf, size_t count)                           \
     {                                                                                              \
         return usb_dwc3_read(dev, pipe, buf, count);                                               \
@@ -185,6 +254,7 @@ dwc3_dev_t *usb_iodev_bringup(u32 idx)
 
 USB_IODEV_WRAPPER(0, CDC_ACM_PIPE_0)
 USB_IODEV_WRAPPER(1, CDC_ACM_PIPE_1)
+USB_IODEV_WRAPPER(2, CDC_ACM_PIPE_2)
 
 static struct iodev_ops iodev_usb_ops = {
     .can_read = usb_0_can_read,
@@ -192,6 +262,7 @@ static struct iodev_ops iodev_usb_ops = {
     .read = usb_0_read,
     .write = usb_0_write,
     .queue = usb_0_queue,
+    .write_room = usb_0_write_room,
     .flush = usb_0_flush,
     .handle_events = usb_0_handle_events,
 };
@@ -202,6 +273,7 @@ static struct iodev_ops iodev_usb_sec_ops = {
     .read = usb_1_read,
     .write = usb_1_write,
     .queue = usb_1_queue,
+    .write_room = usb_1_write_room,
     .flush = usb_1_flush,
     .handle_events = usb_1_handle_events,
 };
@@ -212,6 +284,23 @@ struct iodev iodev_usb_vuart = {
     .lock = SPINLOCK_INIT,
 };
 
+static struct iodev_ops iodev_usb_evt_ops = {
+    .can_read = usb_2_can_read,
+    .can_write = usb_2_can_write,
+    .read = usb_2_read,
+    .write = usb_2_write,
+    .queue = usb_2_queue,
+    .write_room = usb_2_write_room,
+    .flush = usb_2_flush,
+    .handle_events = usb_2_handle_events,
+};
+
+struct iodev iodev_usb_event = {
+    .ops = &iodev_usb_evt_ops,
+    .usage = 0,
+    .lock = SPINLOCK_INIT,
+};
+
 static tps6598x_dev_t *hpm_init(i2c_dev_t *i2c, const char *hpm_path)
 {
     tps6598x_dev_t *tps = tps6598x_init(hpm_path, i2c);
@@ -231,8 +320,7 @@ static tps6598x_dev_t *hpm_init(i2c_dev_t *i2c, const char *hpm_path)
 
 void usb_spmi_init(void)
 {
-    for (int idx = 0; idx < USB_IODEV_COUNT; ++idx)
-        usb_phy_bringup(idx); /* Fails on missing devices, just continue */
+    usb_phy_bringup_all();
 
     usb_is_initialized = true;
 }
@@ -244,12 +332,20 @@ void usb_init(void)
     if (usb_is_initialized)
         return;
 
+    if (usb_handoff) {
+        usb_is_initialized = true;
+        return;
+    }
+
+    bootprofile_begin("usb");
+
     /*
      * M3 models do not use i2c, but instead SPMI with a new controller.
      * We can get USB going for now by just bringing up the phys.
      */
     if (adt_path_offset(adt, "/arm-io/nub-spmi-a0/hpm0") > 0) {
         usb_spmi_init();
+        bootprofile_end("usb");
         return;
     }
 
@@ -277,10 +373,10 @@ void usb_init(void)
 
     i2c_shutdown(i2c);
 
-    for (int idx = 0; idx < USB_IODEV_COUNT; ++idx)
-        usb_phy_bringup(idx); /* Fails on missing devices, just continue */
+    usb_phy_bringup_all();
 
     usb_is_initialized = true;
+    bootprofile_end("usb");
 }
 
 void usb_hpm_restore_irqs(bool force)
@@ -317,11 +413,53 @@ void usb_hpm_restore_irqs(bool force)
 
 void usb_iodev_init(void)
 {
+    dwc3_dev_t *devs[USB_IODEV_COUNT];
+    int started = 0;
+
+    if (usb_handoff) {
+        /* Adopted controllers keep their PHY state; no reset settle to wait out */
+        for (int i = 0; i < USB_IODEV_COUNT; i++) {
+            devs[i] = usb_iodev_bringup(i, true);
+            if (devs[i])
+                started++;
+        }
+
+        if (!started)
+            return;
+    } else {
+        /*
+         * Bring all DWC3 cores through their reset sequence in lockstep, so the
+         * three 100ms PHY/core reset settle delays are paid once instead of once
+         * per port.
+         */
+        for (int i = 0; i < USB_IODEV_COUNT; i++) {
+            devs[i] = usb_iodev_bringup(i, false);
+            if (devs[i])
+                started++;
+        }
+
+        if (!started)
+            return;
+
+        mdelay(100);
+        for (int i = 0; i < USB_IODEV_COUNT; i++)
+            if (devs[i])
+                usb_dwc3_init_phy_release(devs[i]);
+        mdelay(100);
+        for (int i = 0; i < USB_IODEV_COUNT; i++)
+            if (devs[i])
+                usb_dwc3_init_core_release(devs[i]);
+        mdelay(100);
+    }
+
     for (int i = 0; i < USB_IODEV_COUNT; i++) {
         dwc3_dev_t *opaque;
         struct iodev *usb_iodev;
 
-        opaque = usb_iodev_bringup(i);
+        if (!devs[i])
+            continue;
+
+        opaque = usb_handoff ? devs[i] : usb_dwc3_init_finish(devs[i]);
         if (!opaque)
             continue;
 
@@ -359,3 +497,12 @@ void usb_iodev_vuart_setup(iodev_id_t iodev)
 
     iodev_usb_vuart.opaque = iodev_get_opaque(iodev);
 }
+
+int usb_iodev_event_setup(iodev_id_t iodev)
+{
+    if (iodev < IODEV_USB0 || iodev >= IODEV_USB0 + USB_IODEV_COUNT)
+        return -1;
+
+    iodev_usb_event.opaque = iodev_get_opaque(iodev);
+    return 0;
+}
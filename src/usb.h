@@ -7,12 +7,14 @@
 #include "types.h"
 #include "usb_dwc3.h"
 
-dwc3_dev_t *usb_bringup(u32 idx);
+dwc3_dev_t *usb_iodev_bringup(u32 idx, bool adopt);
 
 void usb_init(void);
+void usb_set_handoff(void);
 void usb_hpm_restore_irqs(bool force);
 void usb_iodev_init(void);
 void usb_iodev_shutdown(void);
 void usb_iodev_vuart_setup(iodev_id_t iodev);
+int usb_iodev_event_setup(iodev_id_t iodev);
 
 #endif
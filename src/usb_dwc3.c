@@ -12,10 +12,12 @@
 #include "usb_dwc3.h"
 #include "adt.h"
 #include "dart.h"
+#include "dma_pool.h"
 #include "malloc.h"
 #include "memory.h"
 #include "ringbuffer.h"
 #include "string.h"
+#include "tripwire.h"
 #include "types.h"
 #include "usb_dwc3_regs.h"
 #include "usb_types.h"
@@ -44,7 +46,7 @@
 
 #define DWC3_SCRATCHPAD_SIZE SZ_16K
 #define TRB_BUFFER_SIZE      SZ_16K
-#define XFER_BUFFER_SIZE     (SZ_16K * MAX_ENDPOINTS * 2)
+#define XFER_BUFFER_SIZE     (SZ_16K * MAX_ENDPOINTS * 4)
 #define PAD_BUFFER_SIZE      SZ_16K
 
 #define TRBS_PER_EP              (TRB_BUFFER_SIZE / (MAX_ENDPOINTS * sizeof(struct dwc3_trb)))
@@ -75,6 +77,13 @@
 #define USB_LEP_CDC_BULK_OUT_2 8
 #define USB_LEP_CDC_BULK_IN_2  9
 
+/* maps to interrupt endpoint 0x85 */
+#define USB_LEP_CDC_INTR_IN_3 11
+
+/* these map to physical endpoints 0x06 and 0x86 */
+#define USB_LEP_CDC_BULK_OUT_3 12
+#define USB_LEP_CDC_BULK_IN_3  13
+
 /* content doesn't matter at all, this is the setting linux writes by default */
 static const u8 cdc_default_line_coding[] = {0x80, 0x25, 0x00, 0x00, 0x00, 0x00, 0x08};
 
@@ -160,6 +169,12 @@ struct cdc_dev_desc {
     const struct usb_interface_descriptor sec_interface_data;
     const struct usb_endpoint_descriptor sec_endpoint_data_in;
     const struct usb_endpoint_descriptor sec_endpoint_data_out;
+    const struct usb_interface_descriptor evt_interface_management;
+    const struct cdc_union_functional_descriptor evt_cdc_union_func;
+    const struct usb_endpoint_descriptor evt_endpoint_notification;
+    const struct usb_interface_descriptor evt_interface_data;
+    const struct usb_endpoint_descriptor evt_endpoint_data_in;
+    const struct usb_endpoint_descriptor evt_endpoint_data_out;
 } PACKED;
 
 static const struct usb_device_descriptor usb_cdc_device_descriptor = {
@@ -185,7 +200,7 @@ static const struct cdc_dev_desc cdc_configuration_descriptor = {
             .bLength = sizeof(cdc_configuration_descriptor.configuration),
             .bDescriptorType = USB_CONFIGURATION_DESCRIPTOR,
             .wTotalLength = sizeof(cdc_configuration_descriptor),
-            .bNumInterfaces = 4,
+            .bNumInterfaces = 6,
             .bConfigurationValue = 1,
             .iConfiguration = 0,
             .bmAttributes = USB_CONFIGURATION_ATTRIBUTE_RES1 | USB_CONFIGURATION_SELF_POWERED,
@@ -329,6 +344,77 @@ static const struct cdc_dev_desc cdc_configuration_descriptor = {
             .wMaxPacketSize = 512,
             .bInterval = 10,
         },
+
+    /*
+     * CDC ACM interface for the out-of-band proxy event channel
+     */
+
+    .evt_interface_management =
+        {
+            .bLength = sizeof(cdc_configuration_descriptor.evt_interface_management),
+            .bDescriptorType = USB_INTERFACE_DESCRIPTOR,
+            .bInterfaceNumber = 4,
+            .bAlternateSetting = 0,
+            .bNumEndpoints = 1,
+            .bInterfaceClass = CDC_INTERFACE_CLASS,
+            .bInterfaceSubClass = CDC_INTERFACE_SUBCLASS_ACM,
+            .bInterfaceProtocol = CDC_INTERFACE_PROTOCOL_NONE,
+            .iInterface = 0,
+
+        },
+    .evt_cdc_union_func =
+        {
+            .bFunctionLength = sizeof(cdc_configuration_descriptor.evt_cdc_union_func),
+            .bDescriptorType = USB_CDC_INTERFACE_FUNCTIONAL_DESCRIPTOR,
+            .bDescriptorSubtype = USB_CDC_UNION_SUBTYPE,
+            .bControlInterface = 4,
+            .bDataInterface = 5,
+        },
+    /*
+     * we never use this endpoint, but it should exist and always be idle.
+     * it needs to exist in the descriptor though to make hosts correctly recognize
+     * us as a ACM CDC device.
+     */
+    .evt_endpoint_notification =
+        {
+            .bLength = sizeof(cdc_configuration_descriptor.evt_endpoint_notification),
+            .bDescriptorType = USB_ENDPOINT_DESCRIPTOR,
+            .bEndpointAddress = USB_ENDPOINT_ADDR_IN(5),
+            .bmAttributes = USB_ENDPOINT_ATTR_TYPE_INTERRUPT,
+            .wMaxPacketSize = 64,
+            .bInterval = 10,
+
+        },
+    .evt_interface_data =
+        {
+            .bLength = sizeof(cdc_configuration_descriptor.evt_interface_data),
+            .bDescriptorType = USB_INTERFACE_DESCRIPTOR,
+            .bInterfaceNumber = 5,
+            .bAlternateSetting = 0,
+            .bNumEndpoints = 2,
+            .bInterfaceClass = CDC_INTERFACE_CLASS_DATA,
+            .bInterfaceSubClass = 0, // unused
+            .bInterfaceProtocol = 0, // unused
+            .iInterface = 0,
+        },
+    .evt_endpoint_data_in =
+        {
+            .bLength = sizeof(cdc_configuration_descriptor.evt_endpoint_data_in),
+            .bDescriptorType = USB_ENDPOINT_DESCRIPTOR,
+            .bEndpointAddress = USB_ENDPOINT_ADDR_OUT(6),
+            .bmAttributes = USB_ENDPOINT_ATTR_TYPE_BULK,
+            .wMaxPacketSize = 512,
+            .bInterval = 10,
+        },
+    .evt_endpoint_data_out =
+        {
+            .bLength = sizeof(cdc_configuration_descriptor.evt_endpoint_data_out),
+            .bDescriptorType = USB_ENDPOINT_DESCRIPTOR,
+            .bEndpointAddress = USB_ENDPOINT_ADDR_IN(6),
+            .bmAttributes = USB_ENDPOINT_ATTR_TYPE_BULK,
+            .wMaxPacketSize = 512,
+            .bInterval = 10,
+        },
 };
 
 static const struct usb_device_qualifier_descriptor usb_cdc_device_qualifier_descriptor = {
@@ -620,33 +706,30 @@ static void usb_dwc3_ep0_handle_standard_device(dwc3_dev_t *dev,
 {
     switch (setup->raw.bRequest) {
         case USB_REQUEST_SET_ADDRESS:
-            mask32(dev->regs + DWC3_DCFG, DWC3_DCFG_DEVADDR_MASK,
-                   DWC3_DCFG_DEVADDR(setup->set_address.address));
+            upd32(dev->regs + DWC3_DCFG,
+                  FIELD_UPD(DWC3_DCFG_DEVADDR_MASK, setup->set_address.address));
             dev->ep0_state = USB_DWC3_EP0_STATE_DATA_SEND_STATUS;
             break;
 
         case USB_REQUEST_SET_CONFIGURATION:
             switch (setup->set_configuration.configuration) {
                 case 0:
-                    clear32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_BULK_OUT));
-                    clear32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_BULK_IN));
-                    clear32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_INTR_IN));
-                    clear32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_BULK_OUT_2));
-                    clear32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_BULK_IN_2));
-                    clear32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_INTR_IN_2));
-                    dev->ep0_state = USB_DWC3_EP0_STATE_DATA_SEND_STATUS;
-                    for (int i = 0; i < CDC_ACM_PIPE_MAX; i++)
+                    for (int i = 0; i < CDC_ACM_PIPE_MAX; i++) {
+                        clear32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(dev->pipe[i].ep_out));
+                        clear32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(dev->pipe[i].ep_in));
+                        clear32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(dev->pipe[i].ep_intr));
                         dev->pipe[i].ready = false;
+                    }
+                    dev->ep0_state = USB_DWC3_EP0_STATE_DATA_SEND_STATUS;
                     break;
                 case 1:
                     /* we've already configured these endpoints so that we just need to enable them
                      * here */
-                    set32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_BULK_OUT));
-                    set32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_BULK_IN));
-                    set32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_INTR_IN));
-                    set32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_BULK_OUT_2));
-                    set32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_BULK_IN_2));
-                    set32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(USB_LEP_CDC_INTR_IN_2));
+                    for (int i = 0; i < CDC_ACM_PIPE_MAX; i++) {
+                        set32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(dev->pipe[i].ep_out));
+                        set32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(dev->pipe[i].ep_in));
+                        set32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(dev->pipe[i].ep_intr));
+                    }
                     dev->ep0_state = USB_DWC3_EP0_STATE_DATA_SEND_STATUS;
                     break;
                 default:
@@ -895,6 +978,10 @@ ringbuffer_t *usb_dwc3_cdc_get_ringbuffer(dwc3_dev_t *dev, u8 endpoint_number)
             return dev->pipe[CDC_ACM_PIPE_1].device2host;
         case USB_LEP_CDC_BULK_OUT_2:
             return dev->pipe[CDC_ACM_PIPE_1].host2device;
+        case USB_LEP_CDC_BULK_IN_3:
+            return dev->pipe[CDC_ACM_PIPE_2].device2host;
+        case USB_LEP_CDC_BULK_OUT_3:
+            return dev->pipe[CDC_ACM_PIPE_2].host2device;
         default:
             return NULL;
     }
@@ -926,9 +1013,6 @@ static void usb_dwc3_cdc_start_bulk_out_xfer(dwc3_dev_t *dev, u8 endpoint_number
 
 static void usb_dwc3_cdc_start_bulk_in_xfer(dwc3_dev_t *dev, u8 endpoint_number)
 {
-    struct dwc3_trb *trb;
-    uintptr_t trb_iova;
-
     if (dev->endpoints[endpoint_number].xfer_in_progress)
         return;
 
@@ -936,19 +1020,46 @@ static void usb_dwc3_cdc_start_bulk_in_xfer(dwc3_dev_t *dev, u8 endpoint_number)
     if (!device2host)
         return;
 
-    size_t len =
-        ringbuffer_read(dev->endpoints[endpoint_number].xfer_buffer, XFER_SIZE, device2host);
+    size_t len = ringbuffer_read(dev->endpoints[endpoint_number].xfer_buffer,
+                                 XFER_BUFFER_BYTES_PER_EP, device2host);
 
     if (!len && !dev->endpoints[endpoint_number].zlp_pending)
         return;
 
-    trb_iova = usb_dwc3_init_trb(dev, endpoint_number, &trb);
-    trb->ctrl |= DWC3_TRBCTL_NORMAL;
-    trb->size = DWC3_TRB_SIZE_LENGTH(len);
-
-    usb_dwc3_ep_start_transfer(dev, endpoint_number, trb_iova);
+    /*
+     * Queue the whole burst as a chain of TRBs so the controller streams it
+     * back-to-back and raises a single completion interrupt at the end,
+     * instead of one transfer (and one interrupt) per 16K.
+     */
+    struct dwc3_trb *trb = dev->endpoints[endpoint_number].trb;
+    size_t off = 0;
+    do {
+        u32 chunk = min(len - off, (size_t)XFER_SIZE);
+
+        trb->bpl = dev->endpoints[endpoint_number].xfer_buffer_iova + off;
+        trb->bph = 0;
+        trb->size = DWC3_TRB_SIZE_LENGTH(chunk);
+        trb->ctrl = DWC3_TRB_CTRL_HWO | DWC3_TRBCTL_NORMAL;
+
+        off += chunk;
+        if (off < len)
+            trb->ctrl |= DWC3_TRB_CTRL_CHN;
+        else
+            trb->ctrl |= DWC3_TRB_CTRL_ISP_IMI | DWC3_TRB_CTRL_LST;
+        trb++;
+    } while (off < len);
+
+    usb_dwc3_ep_start_transfer(dev, endpoint_number, dev->endpoints[endpoint_number].trb_iova);
     dev->endpoints[endpoint_number].xfer_in_progress = true;
-    dev->endpoints[endpoint_number].zlp_pending = (len % 512) == 0;
+
+    /*
+     * A short packet is only needed to delimit the stream when it pauses on a
+     * max-packet boundary. If more data is already queued, the next burst
+     * continues the host's read immediately and the ZLP would just cost an
+     * extra completion on both sides.
+     */
+    dev->endpoints[endpoint_number].zlp_pending =
+        len != 0 && (len % 512) == 0 && ringbuffer_get_used(device2host) == 0;
 }
 
 static void usb_dwc3_cdc_handle_bulk_out_xfer_done(dwc3_dev_t *dev,
@@ -971,14 +1082,21 @@ static void usb_dwc3_handle_event_ep(dwc3_dev_t *dev, const struct dwc3_event_de
             case USB_LEP_CTRL_IN:
             case USB_LEP_CTRL_OUT:
                 return usb_dwc3_ep0_handle_xfer_done(dev, event);
-            case USB_LEP_CDC_INTR_IN: // [[fallthrough]]
-            case USB_LEP_CDC_INTR_IN_2:
-                return;
-            case USB_LEP_CDC_BULK_IN: // [[fallthrough]]
-            case USB_LEP_CDC_BULK_IN_2:
+            case USB_LEP_CDC_INTR_IN:   // [[fallthrough]]
+            case USB_LEP_CDC_INTR_IN_2: // [[fallthrough]]
+            case USB_LEP_CDC_INTR_IN_3:
                 return;
-            case USB_LEP_CDC_BULK_OUT: // [[fallthrough]]
-            case USB_LEP_CDC_BULK_OUT_2:
+            case USB_LEP_CDC_BULK_IN:   // [[fallthrough]]
+            case USB_LEP_CDC_BULK_IN_2: // [[fallthrough]]
+            case USB_LEP_CDC_BULK_IN_3:
+                /*
+                 * Restart the pipe back-to-back if more data is queued, instead
+                 * of going idle until the controller raises XferNotReady.
+                 */
+                return usb_dwc3_cdc_start_bulk_in_xfer(dev, event.endpoint_number);
+            case USB_LEP_CDC_BULK_OUT:   // [[fallthrough]]
+            case USB_LEP_CDC_BULK_OUT_2: // [[fallthrough]]
+            case USB_LEP_CDC_BULK_OUT_3:
                 return usb_dwc3_cdc_handle_bulk_out_xfer_done(dev, event);
         }
     } else if (event.endpoint_event == DWC3_DEPEVT_XFERNOTREADY) {
@@ -993,14 +1111,17 @@ static void usb_dwc3_handle_event_ep(dwc3_dev_t *dev, const struct dwc3_event_de
             case USB_LEP_CTRL_IN:
             case USB_LEP_CTRL_OUT:
                 return usb_dwc3_ep0_handle_xfer_not_ready(dev, event);
-            case USB_LEP_CDC_INTR_IN: // [[fallthrough]]
-            case USB_LEP_CDC_INTR_IN_2:
+            case USB_LEP_CDC_INTR_IN:   // [[fallthrough]]
+            case USB_LEP_CDC_INTR_IN_2: // [[fallthrough]]
+            case USB_LEP_CDC_INTR_IN_3:
                 return;
-            case USB_LEP_CDC_BULK_IN: // [[fallthrough]]
-            case USB_LEP_CDC_BULK_IN_2:
+            case USB_LEP_CDC_BULK_IN:   // [[fallthrough]]
+            case USB_LEP_CDC_BULK_IN_2: // [[fallthrough]]
+            case USB_LEP_CDC_BULK_IN_3:
                 return usb_dwc3_cdc_start_bulk_in_xfer(dev, event.endpoint_number);
-            case USB_LEP_CDC_BULK_OUT: // [[fallthrough]]
-            case USB_LEP_CDC_BULK_OUT_2:
+            case USB_LEP_CDC_BULK_OUT:   // [[fallthrough]]
+            case USB_LEP_CDC_BULK_OUT_2: // [[fallthrough]]
+            case USB_LEP_CDC_BULK_OUT_3:
                 return usb_dwc3_cdc_start_bulk_out_xfer(dev, event.endpoint_number);
         }
     }
@@ -1023,7 +1144,7 @@ static void usb_dwc3_handle_event_usbrst(dwc3_dev_t *dev)
     }
 
     /* set device address back to zero */
-    mask32(dev->regs + DWC3_DCFG, DWC3_DCFG_DEVADDR_MASK, DWC3_DCFG_DEVADDR(0));
+    upd32(dev->regs + DWC3_DCFG, FIELD_UPD(DWC3_DCFG_DEVADDR_MASK, 0));
 
     /* only keep control endpoints enabled */
     write32(dev->regs + DWC3_DALEPENA, DWC3_DALEPENA_EP(0) | DWC3_DALEPENA_EP(1));
@@ -1078,6 +1199,8 @@ void usb_dwc3_handle_events(dwc3_dev_t *dev)
     if (n_events == 0)
         return;
 
+    trip_arm("usbevt", 1000);
+
     dma_rmb();
 
     const union dwc3_event *evtbuffer = dev->evtbuffer;
@@ -1089,9 +1212,11 @@ void usb_dwc3_handle_events(dwc3_dev_t *dev)
     }
 
     write32(dev->regs + DWC3_GEVNTCOUNT(0), sizeof(union dwc3_event) * n_events);
+
+    trip_disarm();
 }
 
-dwc3_dev_t *usb_dwc3_init(uintptr_t regs, dart_dev_t *dart)
+static dwc3_dev_t *usb_dwc3_init_common(uintptr_t regs, dart_dev_t *dart)
 {
     /* sanity check */
     u32 snpsid = read32(regs + DWC3_GSNPSID);
@@ -1113,26 +1238,23 @@ dwc3_dev_t *usb_dwc3_init(uintptr_t regs, dart_dev_t *dart)
     dev->dart = dart;
 
     /* allocate and map dma buffers */
-    dev->evtbuffer = memalign(SZ_16K, max(DWC3_EVENT_BUFFERS_SIZE, SZ_16K));
+    dev->evtbuffer = dma_pool_alloc(max(DWC3_EVENT_BUFFERS_SIZE, SZ_16K));
     if (!dev->evtbuffer)
         goto error;
 
-    dev->scratchpad = memalign(SZ_16K, max(DWC3_SCRATCHPAD_SIZE, SZ_16K));
+    dev->scratchpad = dma_pool_alloc(max(DWC3_SCRATCHPAD_SIZE, SZ_16K));
     if (!dev->scratchpad)
         goto error;
 
-    dev->trbs = memalign(SZ_16K, TRB_BUFFER_SIZE);
+    dev->trbs = dma_pool_alloc(TRB_BUFFER_SIZE);
     if (!dev->trbs)
         goto error;
 
-    dev->xferbuffer = memalign(SZ_16K, XFER_BUFFER_SIZE);
+    dev->xferbuffer = dma_pool_alloc(XFER_BUFFER_SIZE);
     if (!dev->xferbuffer)
         goto error;
 
     memset(dev->evtbuffer, 0xaa, max(DWC3_EVENT_BUFFERS_SIZE, SZ_16K));
-    memset(dev->scratchpad, 0, max(DWC3_SCRATCHPAD_SIZE, SZ_16K));
-    memset(dev->xferbuffer, 0, XFER_BUFFER_SIZE);
-    memset(dev->trbs, 0, TRB_BUFFER_SIZE);
 
     if (dart_map(dev->dart, EVENT_BUFFER_IOVA, dev->evtbuffer,
                  max(DWC3_EVENT_BUFFERS_SIZE, SZ_16K)))
@@ -1162,26 +1284,47 @@ dwc3_dev_t *usb_dwc3_init(uintptr_t regs, dart_dev_t *dart)
         goto error;
     }
 
+    return dev;
+
+error:
+    usb_dwc3_shutdown(dev);
+    return NULL;
+}
+
+dwc3_dev_t *usb_dwc3_init_start(uintptr_t regs, dart_dev_t *dart)
+{
+    dwc3_dev_t *dev = usb_dwc3_init_common(regs, dart);
+    if (!dev)
+        return NULL;
+
     /* soft reset the core and phy */
     set32(dev->regs + DWC3_GCTL, DWC3_GCTL_CORESOFTRESET);
     set32(dev->regs + DWC3_GUSB3PIPECTL(0), DWC3_GUSB3PIPECTL_PHYSOFTRST);
     set32(dev->regs + DWC3_GUSB2PHYCFG(0), DWC3_GUSB2PHYCFG_PHYSOFTRST);
-    mdelay(100);
+
+    return dev;
+}
+
+void usb_dwc3_init_phy_release(dwc3_dev_t *dev)
+{
     clear32(dev->regs + DWC3_GUSB3PIPECTL(0), DWC3_GUSB3PIPECTL_PHYSOFTRST);
     clear32(dev->regs + DWC3_GUSB2PHYCFG(0), DWC3_GUSB2PHYCFG_PHYSOFTRST);
-    mdelay(100);
-    clear32(dev->regs + DWC3_GCTL, DWC3_GCTL_CORESOFTRESET);
-    mdelay(100);
+}
 
-    /* disable unused features */
-    clear32(dev->regs + DWC3_GCTL, DWC3_GCTL_SCALEDOWN_MASK | DWC3_GCTL_DISSCRAMBLE);
+void usb_dwc3_init_core_release(dwc3_dev_t *dev)
+{
+    clear32(dev->regs + DWC3_GCTL, DWC3_GCTL_CORESOFTRESET);
+}
 
-    /* switch to device-only mode */
-    mask32(dev->regs + DWC3_GCTL, DWC3_GCTL_PRTCAPDIR(DWC3_GCTL_PRTCAP_OTG),
-           DWC3_GCTL_PRTCAPDIR(DWC3_GCTL_PRTCAP_DEVICE));
+dwc3_dev_t *usb_dwc3_init_finish(dwc3_dev_t *dev)
+{
+    /* disable unused features and switch to device-only mode */
+    upd32(dev->regs + DWC3_GCTL,
+          FIELD_UPD(DWC3_GCTL_SCALEDOWN_MASK, 0) | FIELD_UPD(DWC3_GCTL_DISSCRAMBLE, 0) |
+              FIELD_UPD(DWC3_GCTL_PRTCAPDIR(DWC3_GCTL_PRTCAP_OTG), DWC3_GCTL_PRTCAP_DEVICE));
 
     /* stick to USB 2.0 high speed for now */
-    mask32(dev->regs + DWC3_DCFG, DWC3_DCFG_SPEED_MASK, DWC3_DCFG_HIGHSPEED);
+    upd32(dev->regs + DWC3_DCFG, FIELD_UPD(DWC3_DCFG_SPEED_MASK, DWC3_DCFG_HIGHSPEED));
 
     /* setup scratchpad at SCRATCHPAD_IOVA */
     if (usb_dwc3_command(dev, DWC3_DGCMD_SET_SCRATCHPAD_ADDR_LO, SCRATCHPAD_IOVA)) {
@@ -1224,6 +1367,10 @@ dwc3_dev_t *usb_dwc3_init(uintptr_t regs, dart_dev_t *dart)
     dev->pipe[CDC_ACM_PIPE_1].ep_in = USB_LEP_CDC_BULK_IN_2;
     dev->pipe[CDC_ACM_PIPE_1].ep_out = USB_LEP_CDC_BULK_OUT_2;
 
+    dev->pipe[CDC_ACM_PIPE_2].ep_intr = USB_LEP_CDC_INTR_IN_3;
+    dev->pipe[CDC_ACM_PIPE_2].ep_in = USB_LEP_CDC_BULK_IN_3;
+    dev->pipe[CDC_ACM_PIPE_2].ep_out = USB_LEP_CDC_BULK_OUT_3;
+
     for (int i = 0; i < CDC_ACM_PIPE_MAX; i++) {
         dev->pipe[i].host2device = ringbuffer_alloc(CDC_BUFFER_SIZE);
         if (!dev->pipe[i].host2device)
@@ -1260,6 +1407,37 @@ error:
     return NULL;
 }
 
+dwc3_dev_t *usb_dwc3_init(uintptr_t regs, dart_dev_t *dart)
+{
+    dwc3_dev_t *dev = usb_dwc3_init_start(regs, dart);
+    if (!dev)
+        return NULL;
+
+    mdelay(100);
+    usb_dwc3_init_phy_release(dev);
+    mdelay(100);
+    usb_dwc3_init_core_release(dev);
+    mdelay(100);
+
+    return usb_dwc3_init_finish(dev);
+}
+
+/*
+ * Adopt a controller handed over live by a previous stage: the PHY is already
+ * configured and running, so skip the core/PHY soft reset cycle and its
+ * settle delays. The device side still gets a fresh reset (the old stage's
+ * DMA state cannot be carried across images), so the host sees a quick
+ * re-attach rather than a cold plug behind a port power cycle.
+ */
+dwc3_dev_t *usb_dwc3_init_adopt(uintptr_t regs, dart_dev_t *dart)
+{
+    dwc3_dev_t *dev = usb_dwc3_init_common(regs, dart);
+    if (!dev)
+        return NULL;
+
+    return usb_dwc3_init_finish(dev);
+}
+
 void usb_dwc3_shutdown(dwc3_dev_t *dev)
 {
     for (int i = 0; i < CDC_ACM_PIPE_MAX; i++)
@@ -1294,10 +1472,10 @@ void usb_dwc3_shutdown(dwc3_dev_t *dev)
     dart_unmap(dev->dart, SCRATCHPAD_IOVA, max(DWC3_SCRATCHPAD_SIZE, SZ_16K));
     dart_unmap(dev->dart, EVENT_BUFFER_IOVA, max(DWC3_EVENT_BUFFERS_SIZE, SZ_16K));
 
-    free(dev->evtbuffer);
-    free(dev->scratchpad);
-    free(dev->xferbuffer);
-    free(dev->trbs);
+    dma_pool_free(dev->evtbuffer);
+    dma_pool_free(dev->scratchpad);
+    dma_pool_free(dev->xferbuffer);
+    dma_pool_free(dev->trbs);
     for (int i = 0; i < CDC_ACM_PIPE_MAX; i++) {
         ringbuffer_free(dev->pipe[i].device2host);
         ringbuffer_free(dev->pipe[i].host2device);
@@ -1417,6 +1595,18 @@ ssize_t usb_dwc3_can_read(dwc3_dev_t *dev, cdc_acm_pipe_id_t pipe)
     return ringbuffer_get_used(host2device);
 }
 
+ssize_t usb_dwc3_write_room(dwc3_dev_t *dev, cdc_acm_pipe_id_t pipe)
+{
+    if (!dev || !dev->pipe[pipe].ready)
+        return 0;
+
+    ringbuffer_t *device2host = dev->pipe[pipe].device2host;
+    if (!device2host)
+        return 0;
+
+    return ringbuffer_get_free(device2host);
+}
+
 bool usb_dwc3_can_write(dwc3_dev_t *dev, cdc_acm_pipe_id_t pipe)
 {
     (void)pipe;
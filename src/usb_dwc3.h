@@ -11,16 +11,31 @@ typedef struct dwc3_dev dwc3_dev_t;
 typedef enum _cdc_acm_pipe_id_t {
     CDC_ACM_PIPE_0,
     CDC_ACM_PIPE_1,
+    CDC_ACM_PIPE_2,
     CDC_ACM_PIPE_MAX
 } cdc_acm_pipe_id_t;
 
 dwc3_dev_t *usb_dwc3_init(uintptr_t regs, dart_dev_t *dart);
+
+/*
+ * Phased init, so multiple cores can share the PHY reset settle delays:
+ * start() asserts the core/PHY soft resets, then after 100ms settles each for
+ * phy_release() and core_release(), finish() completes device setup.
+ */
+dwc3_dev_t *usb_dwc3_init_start(uintptr_t regs, dart_dev_t *dart);
+void usb_dwc3_init_phy_release(dwc3_dev_t *dev);
+void usb_dwc3_init_core_release(dwc3_dev_t *dev);
+dwc3_dev_t *usb_dwc3_init_finish(dwc3_dev_t *dev);
+
+/* One-step init for a controller handed over live by the previous stage */
+dwc3_dev_t *usb_dwc3_init_adopt(uintptr_t regs, dart_dev_t *dart);
 void usb_dwc3_shutdown(dwc3_dev_t *dev);
 
 void usb_dwc3_handle_events(dwc3_dev_t *dev);
 
 ssize_t usb_dwc3_can_read(dwc3_dev_t *dev, cdc_acm_pipe_id_t pipe);
 bool usb_dwc3_can_write(dwc3_dev_t *dev, cdc_acm_pipe_id_t pipe);
+ssize_t usb_dwc3_write_room(dwc3_dev_t *dev, cdc_acm_pipe_id_t pipe);
 
 u8 usb_dwc3_getbyte(dwc3_dev_t *dev, cdc_acm_pipe_id_t pipe);
 void usb_dwc3_putbyte(dwc3_dev_t *dev, cdc_acm_pipe_id_t pipe, u8 byte);
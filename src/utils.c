@@ -4,8 +4,11 @@
 #include <stdarg.h>
 
 #include "utils.h"
+#include "cpu_regs.h"
 #include "iodev.h"
+#include "log.h"
 #include "smp.h"
+#include "string.h"
 #include "types.h"
 #include "vsprintf.h"
 #include "xnuboot.h"
@@ -73,6 +76,12 @@ int debug_printf(const char *fmt, ...)
     char buffer[512];
     int i;
 
+    va_start(args, fmt);
+    bool binary = log_bin_vprintf(fmt, args);
+    va_end(args);
+    if (binary)
+        return 0;
+
     va_start(args, fmt);
     i = vsnprintf(buffer, sizeof(buffer), fmt, args);
     va_end(args);
@@ -122,6 +131,29 @@ bool timeout_expired(u64 timeout)
     return expired;
 }
 
+/*
+ * Enable the timer event stream so WFE wakes up periodically. EVNTI selects
+ * bit 4 of the counter, which at 24MHz means an event roughly every 1.3us:
+ * cheap enough latency, while keeping the core out of the busy loop.
+ */
+void enable_event_stream(void)
+{
+    static bool enabled = false;
+
+    if (enabled)
+        return;
+
+    if (in_el2()) {
+        reg_mask(CNTHCTL_EL2, CNTHCTL_EVNTI | CNTHCTL_EVNTDIR,
+                 FIELD_PREP(CNTHCTL_EVNTI, 4) | CNTHCTL_EVNTEN);
+    } else {
+        reg_mask(CNTKCTL_EL1, CNTKCTL_EVNTI | CNTKCTL_EVNTDIR,
+                 FIELD_PREP(CNTKCTL_EVNTI, 4) | CNTKCTL_EVNTEN);
+    }
+
+    enabled = true;
+}
+
 void flush_and_reboot(void)
 {
     iodev_console_flush();
@@ -200,3 +232,4 @@ u64 top_of_memory_alloc(size_t size)
 
     return ret;
 }
+
@@ -135,6 +135,12 @@ static inline u32 mask32(u64 addr, u32 clear, u32 set)
     return data;
 }
 
+/* Apply ORed FIELD_UPD() field updates with a single read-modify-write */
+static inline u32 upd32(u64 addr, u64 upd)
+{
+    return mask32(addr, upd >> 32, (u32)upd);
+}
+
 static inline u16 read16(u64 addr)
 {
     u32 data;
@@ -353,6 +359,9 @@ extern char _payload_end[];
  */
 void memcpy128(void *dst, void *src, size_t size);
 void memset64(void *dst, u64 value, size_t size);
+void memset_zva(void *dst, size_t size);
+void memset_stnp(void *dst, u64 value, size_t size);
+void memcpy_stnp(void *dst, void *src, size_t size);
 void memcpy64(void *dst, void *src, size_t size);
 void memset32(void *dst, u32 value, size_t size);
 void memcpy32(void *dst, void *src, size_t size);
@@ -383,6 +392,8 @@ void flush_and_reboot(void) __attribute__((noreturn));
 u64 timeout_calculate(u32 usec);
 bool timeout_expired(u64 timeout);
 
+void enable_event_stream(void);
+
 #define SPINLOCK_ALIGN 64
 
 typedef struct {
@@ -685,14 +685,51 @@ static int getnumsep(int digits)
 
 static int convert(UINTMAX_T value, char *buf, size_t size, int base, int caps)
 {
+    /* Two digits per entry, so decimal conversion needs one division per digit pair. */
+    static const char twodigits[] = "00010203040506070809101112131415161718192021222324"
+                                    "25262728293031323334353637383940414243444546474849"
+                                    "50515253545556575859606162636465666768697071727374"
+                                    "75767778798081828384858687888990919293949596979899";
     const char *digits = caps ? "0123456789ABCDEF" : "0123456789abcdef";
     size_t pos = 0;
 
-    /* We return an unterminated buffer with the digits in reverse order. */
-    do {
-        buf[pos++] = digits[value % base];
-        value /= base;
-    } while (value != 0 && pos < size);
+    /*
+     * We return an unterminated buffer with the digits in reverse order.
+     * This is on the console hot path, so the common bases avoid the
+     * generic per-digit division loop.
+     */
+    switch (base) {
+        case 10:
+            while (value >= 100 && pos + 1 < size) {
+                const char *pair = &twodigits[2 * (value % 100)];
+                value /= 100;
+                buf[pos++] = pair[1];
+                buf[pos++] = pair[0];
+            }
+            do {
+                buf[pos++] = '0' + value % 10;
+                value /= 10;
+            } while (value != 0 && pos < size);
+            break;
+        case 16:
+            do {
+                buf[pos++] = digits[value & 0xf];
+                value >>= 4;
+            } while (value != 0 && pos < size);
+            break;
+        case 8:
+            do {
+                buf[pos++] = '0' + (value & 7);
+                value >>= 3;
+            } while (value != 0 && pos < size);
+            break;
+        default:
+            do {
+                buf[pos++] = digits[value % base];
+                value /= base;
+            } while (value != 0 && pos < size);
+            break;
+    }
 
     return (int)pos;
 }
@@ -4,6 +4,7 @@
 #define MALLOC_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 void *malloc(size_t);
 void free(void *);
@@ -13,4 +14,38 @@ void *realloc_in_place(void *, size_t);
 void *memalign(size_t, size_t);
 int posix_memalign(void **, size_t, size_t);
 
+/* Assert that a latency-critical section performs no heap operations */
+void malloc_noalloc_push(void);
+void malloc_noalloc_pop(void);
+
+/*
+ * Heap introspection (P_MALLOC_STATS): cumulative allocation counters and
+ * per-callsite tallies from the wrappers, plus a fragmentation snapshot
+ * (free/used chunk census) taken by walking the dlmalloc heap.
+ */
+#define MALLOC_SIZE_BUCKETS  24 /* log2(request size); the last is a catch-all */
+#define MALLOC_MAX_CALLSITES 64
+
+struct malloc_callsite {
+    uint64_t pc;    /* allocation call site, 0 = unused slot */
+    uint64_t count; /* allocations from this site */
+    uint64_t bytes; /* bytes requested from this site */
+};
+
+struct malloc_stats {
+    uint64_t alloc_count;
+    uint64_t free_count;
+    uint64_t footprint;     /* bytes obtained from heapblock */
+    uint64_t max_footprint;
+    uint64_t used_chunks;
+    uint64_t used_bytes;
+    uint64_t free_chunks;
+    uint64_t free_bytes;
+    uint64_t largest_free;
+    uint64_t size_hist[MALLOC_SIZE_BUCKETS];
+    struct malloc_callsite callsites[MALLOC_MAX_CALLSITES];
+};
+
+void malloc_get_stats(struct malloc_stats *st);
+
 #endif